@@ -9,23 +9,105 @@ CxxPreProcessorScanner::CxxPreProcessorScanner(const wxFileName& filename, size_
     : m_scanner(NULL)
     , m_filename(filename)
     , m_options(options)
+    , m_cachedIndex(0)
+    , m_inPPLine(false)
+    , m_lastRecorded(false)
 {
+    // Comments and whitespace are returned by the lexer only when asked for, they are never cached
+    bool useCache = !(m_options & (kLexerOpt_ReturnComments | kLexerOpt_ReturnWhitespace));
+    wxFileName fn = m_filename;
+    if(fn.IsRelative()) {
+        fn.MakeAbsolute();
+    }
+    wxString path = fn.GetFullPath();
+    CxxPreProcessorScannerCache::Stamp stamp;
+    if(useCache) {
+        stamp = CxxPreProcessorScannerCache::GetStamp(path);
+        m_cached = CxxPreProcessorScannerCache::Get().Find(path, stamp);
+        if(m_cached) {
+            return;
+        }
+    }
+
     m_scanner = ::LexerNew(m_filename, m_options);
     wxASSERT(m_scanner);
+    if(m_scanner && useCache && stamp.IsOk()) {
+        m_recording.reset(new CxxPreProcessorScannerCache::Entry());
+        m_recording->filename = path;
+        m_recording->stamp = stamp;
+    }
 }
 
 CxxPreProcessorScanner::~CxxPreProcessorScanner()
 {
+    if(m_recording) {
+        // The scan may have stopped before the end of the file (e.g. on a parse error), but the file may be
+        // included later with other macros defined: the cache needs all of it
+        CxxLexerToken token;
+        while(NextToken(token)) {
+        }
+        CxxPreProcessorScannerCache::Get().Insert(m_recording);
+    }
     if(m_scanner) {
         ::LexerDestroy(&m_scanner);
     }
 }
 
+bool CxxPreProcessorScanner::NextToken(CxxLexerToken& token)
+{
+    if(m_cached) {
+        if(m_cachedIndex >= m_cached->tokens.size()) {
+            return false;
+        }
+        const CxxPreProcessorScannerCache::Token& cachedToken = m_cached->tokens[m_cachedIndex++];
+        token.SetType(cachedToken.type);
+        token.SetText(const_cast<char*>(cachedToken.text.c_str()));
+        return true;
+    }
+
+    if(!m_scanner || !::LexerNext(m_scanner, token)) {
+        return false;
+    }
+    if(m_recording) {
+        // This scanner only looks at the pre processor lines: a directive, and everything that follows it
+        // until the lexer leaves the pre processor state
+        int type = token.GetType();
+        bool isPPToken = (type >= T_PP_DEFINE && type <= T_PP_LTEQ);
+        m_lastRecorded = isPPToken || m_inPPLine;
+        if(m_lastRecorded) {
+            CxxPreProcessorScannerCache::Token cachedToken;
+            cachedToken.type = type;
+            cachedToken.text = token.GetText() ? token.GetText() : "";
+            m_recording->tokens.push_back(cachedToken);
+        }
+        if(isPPToken) {
+            m_inPPLine = (type != T_PP_STATE_EXIT);
+        }
+    }
+    return true;
+}
+
+void CxxPreProcessorScanner::UngetToken()
+{
+    if(m_cached) {
+        if(m_cachedIndex > 0) {
+            --m_cachedIndex;
+        }
+        return;
+    }
+    ::LexerUnget(m_scanner);
+    if(m_recording && m_lastRecorded && !m_recording->tokens.empty()) {
+        // It will be recorded again when it is read again
+        m_recording->tokens.pop_back();
+        m_lastRecorded = false;
+    }
+}
+
 void CxxPreProcessorScanner::GetRestOfPPLine(wxString& rest, bool collectNumberOnly)
 {
     CxxLexerToken token;
     bool numberFound = false;
-    while(m_scanner && ::LexerNext(m_scanner, token) && token.GetType() != T_PP_STATE_EXIT) {
+    while(NextToken(token) && token.GetType() != T_PP_STATE_EXIT) {
         if(!numberFound && collectNumberOnly) {
             if(token.GetType() == T_PP_DEC_NUMBER || token.GetType() == T_PP_OCTAL_NUMBER ||
                token.GetType() == T_PP_HEX_NUMBER || token.GetType() == T_PP_FLOAT_NUMBER) {
@@ -43,7 +125,7 @@ bool CxxPreProcessorScanner::ConsumeBlock()
 {
     CxxLexerToken token;
     int depth = 1;
-    while(m_scanner && ::LexerNext(m_scanner, token)) {
+    while(NextToken(token)) {
         switch(token.GetType()) {
         case T_PP_ENDIF:
             depth--;
@@ -69,7 +151,7 @@ void CxxPreProcessorScanner::Parse(CxxPreProcessor* pp)
     CxxLexerToken token;
     bool searchingForBranch = false;
     CxxPreProcessorToken::Map_t& ppTable = pp->GetTokens();
-    while(m_scanner && ::LexerNext(m_scanner, token)) {
+    while(NextToken(token)) {
         // Pre Processor state
         switch(token.GetType()) {
         case T_PP_INCLUDE_FILENAME: {
@@ -160,7 +242,7 @@ void CxxPreProcessorScanner::Parse(CxxPreProcessor* pp)
             return;
         }
         case T_PP_DEFINE: {
-            if(!::LexerNext(m_scanner, token) || token.GetType() != T_PP_IDENTIFIER) {
+            if(!NextToken(token) || token.GetType() != T_PP_IDENTIFIER) {
                 // Recover
                 wxString dummy;
                 GetRestOfPPLine(dummy);
@@ -187,7 +269,7 @@ void CxxPreProcessorScanner::Parse(CxxPreProcessor* pp)
 bool CxxPreProcessorScanner::CheckIfDefined(const CxxPreProcessorToken::Map_t& table)
 {
     CxxLexerToken token;
-    if(m_scanner && ::LexerNext(m_scanner, token)) {
+    if(NextToken(token)) {
         if(token.GetType() == T_PP_STATE_EXIT) {
             return false;
         }
@@ -231,7 +313,7 @@ bool CxxPreProcessorScanner::CheckIf(const CxxPreProcessorToken::Map_t& table)
     CxxPreProcessorExpression* cur = new CxxPreProcessorExpression(false);
     ExpressionLocker locker(cur);
     CxxPreProcessorExpression* head = cur;
-    while(m_scanner && ::LexerNext(m_scanner, token)) {
+    while(NextToken(token)) {
         if(token.GetType() == T_PP_STATE_EXIT) {
             bool res = head->IsTrue();
             return res;
@@ -331,7 +413,7 @@ bool CxxPreProcessorScanner::ConsumeCurrentBranch()
     // T_PP_ELIF
     // T_PP_ELSE
     // T_PP_ENDIF
-    while(m_scanner && ::LexerNext(m_scanner, token)) {
+    while(NextToken(token)) {
         switch(token.GetType()) {
         case T_PP_IF:
         case T_PP_IFDEF:
@@ -347,7 +429,7 @@ bool CxxPreProcessorScanner::ConsumeCurrentBranch()
         case T_PP_ELIF:
         case T_PP_ELSE:
             if(depth == 1) {
-                ::LexerUnget(m_scanner);
+                UngetToken();
                 return true;
             }
             break;
@@ -360,7 +442,7 @@ bool CxxPreProcessorScanner::ConsumeCurrentBranch()
 
 void CxxPreProcessorScanner::ReadUntilMatch(int type, CxxLexerToken& token)
 {
-    while(m_scanner && ::LexerNext(m_scanner, token)) {
+    while(NextToken(token)) {
         if(token.GetType() == type) {
             return;
         } else if(token.GetType() == T_PP_STATE_EXIT) {
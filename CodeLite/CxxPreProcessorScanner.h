@@ -27,6 +27,7 @@
 #define CXXPREPROCESSORSCANNER_H
 
 #include "CxxLexerAPI.h"
+#include "CxxPreProcessorScannerCache.h"
 #include <wx/string.h>
 #include <list>
 #include <wx/sharedptr.h>
@@ -39,11 +40,27 @@ protected:
     Scanner_t m_scanner;
     wxFileName m_filename;
     size_t m_options;
+
+    // When the file is in the cache, its tokens are replayed instead of lexing it
+    CxxPreProcessorScannerCache::Entry::Ptr_t m_cached;
+    size_t m_cachedIndex;
+    // Otherwise, the tokens are recorded for the cache while lexing
+    CxxPreProcessorScannerCache::Entry::Ptr_t m_recording;
+    bool m_inPPLine;
+    bool m_lastRecorded;
     
 public:
     typedef wxSharedPtr<CxxPreProcessorScanner> Ptr_t;
     
 private:
+    /**
+     * @brief read the next token, from the cache or from the lexer
+     */
+    bool NextToken(CxxLexerToken& token);
+    /**
+     * @brief return the last token read to the stream
+     */
+    void UngetToken();
     /**
      * @brief run the scanner until we reach the closing #endif
      * directive
@@ -76,7 +93,7 @@ public:
      * @brief return true if we got a valid scanner
      */
     bool IsNull() const {
-        return m_scanner == NULL;;
+        return m_scanner == NULL && !m_cached;
     }
     
     virtual ~CxxPreProcessorScanner();
@@ -0,0 +1,211 @@
+#include "CxxPreProcessorScannerCache.h"
+#include "file_logger.h"
+#include <stdint.h>
+#include <string.h>
+#include <wx/ffile.h>
+#include <wx/filefn.h>
+
+// The cache file is a local file: numbers are written in the native byte order
+#define CACHE_FILE_MAGIC "CXXPPC"
+#define CACHE_FILE_VERSION 1
+// Entries not used for this long (in seconds) are not saved
+#define CACHE_MAX_AGE (30 * 24 * 60 * 60)
+
+namespace
+{
+template <typename T> void Write(std::string& buffer, T value) { buffer.append((const char*)&value, sizeof(T)); }
+
+void WriteString(std::string& buffer, const std::string& str)
+{
+    Write<uint32_t>(buffer, str.length());
+    buffer.append(str);
+}
+
+struct Reader {
+    const std::string& buffer;
+    size_t pos = 0;
+    bool ok = true;
+
+    Reader(const std::string& b)
+        : buffer(b)
+    {
+    }
+
+    template <typename T> T Read()
+    {
+        T value = 0;
+        if(!ok || (buffer.length() - pos) < sizeof(T)) {
+            ok = false;
+            return value;
+        }
+        memcpy(&value, buffer.c_str() + pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+    void ReadString(std::string& str)
+    {
+        uint32_t len = Read<uint32_t>();
+        if(!ok || (buffer.length() - pos) < len) {
+            ok = false;
+            return;
+        }
+        str.assign(buffer, pos, len);
+        pos += len;
+    }
+};
+} // namespace
+
+CxxPreProcessorScannerCache::CxxPreProcessorScannerCache() {}
+
+CxxPreProcessorScannerCache::~CxxPreProcessorScannerCache() {}
+
+CxxPreProcessorScannerCache& CxxPreProcessorScannerCache::Get()
+{
+    static CxxPreProcessorScannerCache cache;
+    return cache;
+}
+
+CxxPreProcessorScannerCache::Stamp CxxPreProcessorScannerCache::GetStamp(const wxString& filename)
+{
+    Stamp stamp;
+    wxStructStat buff;
+    if(wxStat(filename, &buff) == 0) {
+        stamp.lastModified = buff.st_mtime;
+        stamp.fileSize = buff.st_size;
+    }
+    return stamp;
+}
+
+CxxPreProcessorScannerCache::Entry::Ptr_t CxxPreProcessorScannerCache::Find(const wxString& filename,
+                                                                           const Stamp& stamp)
+{
+    wxCriticalSectionLocker locker(m_cs);
+    std::unordered_map<wxString, Entry::Ptr_t>::iterator iter = m_entries.find(filename);
+    if(iter == m_entries.end() || !stamp.IsOk()) { return Entry::Ptr_t(nullptr); }
+    if(!(iter->second->stamp == stamp)) {
+        // The file was modified since it was scanned
+        m_entries.erase(iter);
+        m_modified = true;
+        return Entry::Ptr_t(nullptr);
+    }
+    iter->second->lastUsed = time(NULL);
+    return iter->second;
+}
+
+void CxxPreProcessorScannerCache::Insert(Entry::Ptr_t entry)
+{
+    if(!entry || !entry->stamp.IsOk()) { return; }
+    entry->lastUsed = time(NULL);
+    wxCriticalSectionLocker locker(m_cs);
+    m_entries[entry->filename] = entry;
+    m_modified = true;
+}
+
+bool CxxPreProcessorScannerCache::IsModified()
+{
+    wxCriticalSectionLocker locker(m_cs);
+    return m_modified;
+}
+
+void CxxPreProcessorScannerCache::Clear()
+{
+    wxCriticalSectionLocker locker(m_cs);
+    m_entries.clear();
+    m_modified = false;
+}
+
+bool CxxPreProcessorScannerCache::Load(const wxFileName& cacheFile)
+{
+    std::string buffer;
+    {
+        wxFFile fp(cacheFile.GetFullPath(), "rb");
+        if(!fp.IsOpened()) { return false; }
+        wxFileOffset len = fp.Length();
+        if(len <= 0) { return false; }
+        buffer.resize(len);
+        if(fp.Read(&buffer[0], len) != (size_t)len) { return false; }
+    }
+
+    Reader reader(buffer);
+    if(buffer.compare(0, strlen(CACHE_FILE_MAGIC), CACHE_FILE_MAGIC) != 0) { return false; }
+    reader.pos = strlen(CACHE_FILE_MAGIC);
+    if(reader.Read<uint32_t>() != CACHE_FILE_VERSION) {
+        clDEBUG() << "Pre processor cache" << cacheFile << "was written by another version. Ignoring it" << clEndl;
+        return false;
+    }
+
+    std::vector<Entry::Ptr_t> entries;
+    uint32_t count = reader.Read<uint32_t>();
+    std::string filename;
+    for(uint32_t i = 0; reader.ok && i < count; ++i) {
+        Entry::Ptr_t entry(new Entry());
+        reader.ReadString(filename);
+        entry->filename = wxString::FromUTF8(filename.c_str(), filename.length());
+        entry->stamp.lastModified = reader.Read<int64_t>();
+        entry->stamp.fileSize = reader.Read<int64_t>();
+        entry->lastUsed = reader.Read<int64_t>();
+        uint32_t numTokens = reader.Read<uint32_t>();
+        for(uint32_t t = 0; reader.ok && t < numTokens; ++t) {
+            Token token;
+            token.type = reader.Read<int32_t>();
+            reader.ReadString(token.text);
+            entry->tokens.push_back(token);
+        }
+        entries.push_back(entry);
+    }
+
+    if(!reader.ok) {
+        clWARNING() << "Pre processor cache" << cacheFile << "is corrupted. Ignoring it" << clEndl;
+        return false;
+    }
+
+    wxCriticalSectionLocker locker(m_cs);
+    for(Entry::Ptr_t entry : entries) {
+        // Do not replace what was scanned while the cache was loading
+        m_entries.insert({ entry->filename, entry });
+    }
+    clDEBUG() << "Loaded" << entries.size() << "entries from the pre processor cache" << cacheFile << clEndl;
+    return true;
+}
+
+bool CxxPreProcessorScannerCache::Save(const wxFileName& cacheFile)
+{
+    std::string buffer(CACHE_FILE_MAGIC);
+    Write<uint32_t>(buffer, CACHE_FILE_VERSION);
+    {
+        wxCriticalSectionLocker locker(m_cs);
+        time_t oldest = time(NULL) - CACHE_MAX_AGE;
+        std::vector<Entry::Ptr_t> entries;
+        entries.reserve(m_entries.size());
+        for(const auto& vt : m_entries) {
+            if(vt.second->lastUsed >= oldest) { entries.push_back(vt.second); }
+        }
+
+        Write<uint32_t>(buffer, entries.size());
+        for(Entry::Ptr_t entry : entries) {
+            WriteString(buffer, entry->filename.mb_str(wxConvUTF8).data());
+            Write<int64_t>(buffer, entry->stamp.lastModified);
+            Write<int64_t>(buffer, entry->stamp.fileSize);
+            Write<int64_t>(buffer, entry->lastUsed);
+            Write<uint32_t>(buffer, entry->tokens.size());
+            for(const Token& token : entry->tokens) {
+                Write<int32_t>(buffer, token.type);
+                WriteString(buffer, token.text);
+            }
+        }
+        m_modified = false;
+    }
+
+    // Write to a temporary file first, so a crash can not leave a truncated cache behind
+    wxFileName tmpFile(cacheFile);
+    tmpFile.SetFullName(cacheFile.GetFullName() + ".tmp");
+    {
+        wxFFile fp(tmpFile.GetFullPath(), "wb");
+        if(!fp.IsOpened() || fp.Write(buffer.c_str(), buffer.length()) != buffer.length()) {
+            clWARNING() << "Failed to write the pre processor cache" << tmpFile << clEndl;
+            return false;
+        }
+    }
+    return ::wxRenameFile(tmpFile.GetFullPath(), cacheFile.GetFullPath(), true);
+}
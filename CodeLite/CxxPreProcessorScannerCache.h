@@ -0,0 +1,91 @@
+#ifndef CXXPREPROCESSORSCANNERCACHE_H
+#define CXXPREPROCESSORSCANNERCACHE_H
+
+#include "codelite_exports.h"
+#include "wxStringHash.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <wx/filename.h>
+#include <wx/sharedptr.h>
+#include <wx/thread.h>
+
+/**
+ * @brief the pre processor lines (#define, #include, #if...) of the files scanned by CxxPreProcessorScanner.
+ * The outcome of scanning a header depends on the macros defined before it is included, so the cache keeps
+ * the tokens of these lines rather than the outcome: replaying them against the current macros gives the same
+ * result as lexing the whole file again. The cache is shared by all the scanners (a header is lexed once, no
+ * matter how many files include it) and it can be saved to the disk to be reused in the next session
+ */
+class WXDLLIMPEXP_CL CxxPreProcessorScannerCache
+{
+public:
+    struct Token {
+        int type = 0;
+        std::string text;
+    };
+
+    struct Stamp {
+        time_t lastModified = 0;
+        long long fileSize = -1;
+        bool operator==(const Stamp& other) const
+        {
+            return lastModified == other.lastModified && fileSize == other.fileSize;
+        }
+        bool IsOk() const { return fileSize >= 0; }
+    };
+
+    struct Entry {
+        wxString filename;
+        Stamp stamp;
+        time_t lastUsed = 0;
+        std::vector<Token> tokens;
+        typedef wxSharedPtr<Entry> Ptr_t;
+    };
+
+protected:
+    std::unordered_map<wxString, Entry::Ptr_t> m_entries;
+    wxCriticalSection m_cs;
+    bool m_modified = false;
+
+public:
+    CxxPreProcessorScannerCache();
+    virtual ~CxxPreProcessorScannerCache();
+
+    static CxxPreProcessorScannerCache& Get();
+
+    /**
+     * @brief return the size and modification time of a file
+     */
+    static Stamp GetStamp(const wxString& filename);
+
+    /**
+     * @brief return the entry of 'filename', null if there is none or if it was recorded for another
+     * version of the file than 'stamp'
+     */
+    Entry::Ptr_t Find(const wxString& filename, const Stamp& stamp);
+
+    /**
+     * @brief add an entry, replacing the one recorded for the same file
+     */
+    void Insert(Entry::Ptr_t entry);
+
+    /**
+     * @brief load the entries saved by Save(). The entries already in the cache are kept
+     */
+    bool Load(const wxFileName& cacheFile);
+
+    /**
+     * @brief save the cache. Entries not used for a long time are not saved
+     */
+    bool Save(const wxFileName& cacheFile);
+
+    /**
+     * @brief was an entry added since the cache was loaded or saved?
+     */
+    bool IsModified();
+
+    void Clear();
+};
+
+#endif // CXXPREPROCESSORSCANNERCACHE_H
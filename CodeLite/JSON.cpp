@@ -382,12 +382,22 @@ wxArrayString JSONItem::toArrayString(const wxArrayString& defaultValue) const
     if(_json->type != cJSON_Array) { return defaultValue; }
 
     wxArrayString arr;
-    for(int i = 0; i < arraySize(); i++) {
-        arr.Add(arrayItem(i).toString());
+    for(JSONItem item : *this) {
+        arr.Add(item.toString());
     }
     return arr;
 }
 
+std::vector<JSONItem> JSONItem::arrayItems() const
+{
+    std::vector<JSONItem> items;
+    if(!_json || _json->type != cJSON_Array) { return items; }
+    for(JSONItem item : *this) {
+        items.push_back(item);
+    }
+    return items;
+}
+
 bool JSONItem::hasNamedObject(const wxString& name) const
 {
     if(!_json) { return false; }
@@ -478,9 +488,9 @@ wxStringMap_t JSONItem::toStringMap() const
 
     if(_json->type != cJSON_Array) { return res; }
 
-    for(int i = 0; i < arraySize(); ++i) {
-        wxString key = arrayItem(i).namedObject("key").toString();
-        wxString val = arrayItem(i).namedObject("value").toString();
+    for(JSONItem item : *this) {
+        wxString key = item.namedObject("key").toString();
+        wxString val = item.namedObject("value").toString();
         res.insert(std::make_pair(key, val));
     }
     return res;
@@ -32,6 +32,7 @@
 #include <wx/gdicmn.h>
 #include "codelite_exports.h"
 #include <map>
+#include <vector>
 #include "cJSON.h"
 #if wxUSE_GUI
 #include <wx/arrstr.h>
@@ -64,6 +65,37 @@ public:
     JSONItem firstChild();
     JSONItem nextChild();
 
+    /**
+     * @brief iterate over the items of an array (or the properties of an object), O(1) per item:
+     *     for(JSONItem item : arr) { ... }
+     */
+    class const_iterator
+    {
+        cJSON* m_node;
+
+    public:
+        explicit const_iterator(cJSON* node)
+            : m_node(node)
+        {
+        }
+        JSONItem operator*() const { return JSONItem(m_node); }
+        const_iterator& operator++()
+        {
+            m_node = m_node->next;
+            return *this;
+        }
+        bool operator==(const const_iterator& other) const { return m_node == other.m_node; }
+        bool operator!=(const const_iterator& other) const { return m_node != other.m_node; }
+    };
+    const_iterator begin() const { return const_iterator(_json ? _json->child : NULL); }
+    const_iterator end() const { return const_iterator(NULL); }
+
+    /**
+     * @brief return the items of this array, collected in a single pass. Use this instead of
+     * arrayItem() to access the items by index
+     */
+    std::vector<JSONItem> arrayItems() const;
+
     // Setters
     ////////////////////////////////////////////////
     void setName(const wxString& _name) { this->_name = _name; }
@@ -80,6 +112,10 @@ public:
     bool toBool(bool defaultValue = false) const;
     wxString toString(const wxString& defaultValue = wxEmptyString) const;
     wxArrayString toArrayString(const wxArrayString& defaultValue = wxArrayString()) const;
+    /**
+     * @brief return the item at 'pos'. cJSON arrays are linked lists: this walks the array from its first
+     * item. To visit all the items, iterate over the array or use arrayItems()
+     */
     JSONItem arrayItem(int pos) const;
 
     // Retuen the object type
@@ -0,0 +1,299 @@
+#include "JSONStreamReader.h"
+#include "clFileContent.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Deeper documents are rejected rather than overflowing the stack
+#define JSON_STREAM_MAX_DEPTH 512
+
+namespace
+{
+int HexValue(char ch)
+{
+    if(ch >= '0' && ch <= '9') { return ch - '0'; }
+    if(ch >= 'a' && ch <= 'f') { return ch - 'a' + 10; }
+    if(ch >= 'A' && ch <= 'F') { return ch - 'A' + 10; }
+    return -1;
+}
+
+void AppendUTF8(std::string& str, unsigned long cp)
+{
+    if(cp < 0x80) {
+        str += (char)cp;
+    } else if(cp < 0x800) {
+        str += (char)(0xC0 | (cp >> 6));
+        str += (char)(0x80 | (cp & 0x3F));
+    } else if(cp < 0x10000) {
+        str += (char)(0xE0 | (cp >> 12));
+        str += (char)(0x80 | ((cp >> 6) & 0x3F));
+        str += (char)(0x80 | (cp & 0x3F));
+    } else {
+        str += (char)(0xF0 | (cp >> 18));
+        str += (char)(0x80 | ((cp >> 12) & 0x3F));
+        str += (char)(0x80 | ((cp >> 6) & 0x3F));
+        str += (char)(0x80 | (cp & 0x3F));
+    }
+}
+} // namespace
+
+JSONStreamReader::JSONStreamReader(Handler* handler)
+    : m_handler(handler)
+{
+}
+
+JSONStreamReader::~JSONStreamReader() {}
+
+bool JSONStreamReader::ParseFile(const wxString& filename)
+{
+    clFileContent file;
+    if(!file.Open(filename)) {
+        m_error = "Failed to open file: " + filename;
+        return false;
+    }
+    return Parse(file.GetData(), file.GetSize());
+}
+
+bool JSONStreamReader::Parse(const char* buffer, size_t length)
+{
+    m_begin = m_pos = buffer;
+    m_end = buffer + length;
+    m_stopped = false;
+    m_error.clear();
+
+    // Skip the UTF-8 BOM
+    if(length >= 3 && memcmp(buffer, "\xEF\xBB\xBF", 3) == 0) { m_pos += 3; }
+
+    if(!ReadValue(0)) { return false; }
+    SkipWhitespace();
+    if(m_pos != m_end) { return Error("Unexpected data after the document"); }
+    return true;
+}
+
+bool JSONStreamReader::Error(const wxString& message)
+{
+    if(m_error.empty() && !m_stopped) {
+        m_error << message << " at offset " << (unsigned long)(m_pos - m_begin);
+    }
+    return false;
+}
+
+void JSONStreamReader::SkipWhitespace()
+{
+    while(m_pos < m_end && (*m_pos == ' ' || *m_pos == '\n' || *m_pos == '\r' || *m_pos == '\t')) {
+        ++m_pos;
+    }
+}
+
+// Calls the handler and remembers whether it asked to stop
+#define NOTIFY(call)               \
+    if(!m_handler->call) {         \
+        m_stopped = true;          \
+        return false;              \
+    }
+
+bool JSONStreamReader::ReadValue(int depth)
+{
+    SkipWhitespace();
+    if(m_pos == m_end) { return Error("Unexpected end of document"); }
+
+    switch(*m_pos) {
+    case '{':
+        return ReadObject(depth + 1);
+    case '[':
+        return ReadArray(depth + 1);
+    case '"':
+        if(!ReadString(m_string)) { return false; }
+        NOTIFY(OnString(m_string));
+        return true;
+    case 't':
+        if(!ReadLiteral("true", 4)) { return false; }
+        NOTIFY(OnBool(true));
+        return true;
+    case 'f':
+        if(!ReadLiteral("false", 5)) { return false; }
+        NOTIFY(OnBool(false));
+        return true;
+    case 'n':
+        if(!ReadLiteral("null", 4)) { return false; }
+        NOTIFY(OnNull());
+        return true;
+    default:
+        return ReadNumber();
+    }
+}
+
+bool JSONStreamReader::ReadObject(int depth)
+{
+    if(depth > JSON_STREAM_MAX_DEPTH) { return Error("Document is nested too deeply"); }
+    ++m_pos; // '{'
+    NOTIFY(OnStartObject());
+
+    SkipWhitespace();
+    if(m_pos < m_end && *m_pos == '}') {
+        ++m_pos;
+        NOTIFY(OnEndObject());
+        return true;
+    }
+
+    while(true) {
+        SkipWhitespace();
+        if(m_pos == m_end || *m_pos != '"') { return Error("Expected a property name"); }
+        if(!ReadString(m_string)) { return false; }
+        NOTIFY(OnKey(m_string));
+
+        SkipWhitespace();
+        if(m_pos == m_end || *m_pos != ':') { return Error("Expected ':'"); }
+        ++m_pos;
+        if(!ReadValue(depth)) { return false; }
+
+        SkipWhitespace();
+        if(m_pos == m_end) { return Error("Unexpected end of document"); }
+        if(*m_pos == ',') {
+            ++m_pos;
+        } else if(*m_pos == '}') {
+            ++m_pos;
+            NOTIFY(OnEndObject());
+            return true;
+        } else {
+            return Error("Expected ',' or '}'");
+        }
+    }
+}
+
+bool JSONStreamReader::ReadArray(int depth)
+{
+    if(depth > JSON_STREAM_MAX_DEPTH) { return Error("Document is nested too deeply"); }
+    ++m_pos; // '['
+    NOTIFY(OnStartArray());
+
+    SkipWhitespace();
+    if(m_pos < m_end && *m_pos == ']') {
+        ++m_pos;
+        NOTIFY(OnEndArray());
+        return true;
+    }
+
+    while(true) {
+        if(!ReadValue(depth)) { return false; }
+
+        SkipWhitespace();
+        if(m_pos == m_end) { return Error("Unexpected end of document"); }
+        if(*m_pos == ',') {
+            ++m_pos;
+        } else if(*m_pos == ']') {
+            ++m_pos;
+            NOTIFY(OnEndArray());
+            return true;
+        } else {
+            return Error("Expected ',' or ']'");
+        }
+    }
+}
+
+bool JSONStreamReader::ReadString(std::string& str)
+{
+    str.clear();
+    ++m_pos; // the opening quote
+    while(m_pos < m_end) {
+        // Copy the run of plain characters at once
+        const char* start = m_pos;
+        while(m_pos < m_end && *m_pos != '"' && *m_pos != '\\') {
+            ++m_pos;
+        }
+        str.append(start, m_pos - start);
+        if(m_pos == m_end) { break; }
+
+        if(*m_pos == '"') {
+            ++m_pos;
+            return true;
+        }
+
+        // An escape sequence
+        if(++m_pos == m_end) { break; }
+        char ch = *m_pos++;
+        switch(ch) {
+        case '"':
+        case '\\':
+        case '/':
+            str += ch;
+            break;
+        case 'b':
+            str += '\b';
+            break;
+        case 'f':
+            str += '\f';
+            break;
+        case 'n':
+            str += '\n';
+            break;
+        case 'r':
+            str += '\r';
+            break;
+        case 't':
+            str += '\t';
+            break;
+        case 'u': {
+            unsigned long cp = 0;
+            for(int i = 0; i < 4; ++i) {
+                int hex = (m_pos < m_end) ? HexValue(*m_pos) : -1;
+                if(hex < 0) { return Error("Invalid \\u escape sequence"); }
+                cp = (cp << 4) | hex;
+                ++m_pos;
+            }
+            // A surrogate pair encodes a code point above the BMP
+            if(cp >= 0xD800 && cp <= 0xDBFF && (m_end - m_pos) >= 6 && m_pos[0] == '\\' && m_pos[1] == 'u') {
+                unsigned long low = 0;
+                bool ok = true;
+                for(int i = 2; i < 6 && ok; ++i) {
+                    int hex = HexValue(m_pos[i]);
+                    ok = hex >= 0;
+                    low = (low << 4) | hex;
+                }
+                if(ok && low >= 0xDC00 && low <= 0xDFFF) {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    m_pos += 6;
+                }
+            }
+            // A surrogate without its pair is not a character: it has no UTF-8 encoding
+            if(cp >= 0xD800 && cp <= 0xDFFF) { cp = 0xFFFD; }
+            AppendUTF8(str, cp);
+            break;
+        }
+        default:
+            return Error("Invalid escape sequence");
+        }
+    }
+    return Error("Unterminated string");
+}
+
+bool JSONStreamReader::ReadNumber()
+{
+    const char* start = m_pos;
+    if(m_pos < m_end && *m_pos == '-') { ++m_pos; }
+    while(m_pos < m_end && ((*m_pos >= '0' && *m_pos <= '9') || *m_pos == '.' || *m_pos == 'e' || *m_pos == 'E' ||
+                            *m_pos == '+' || *m_pos == '-')) {
+        ++m_pos;
+    }
+    if(m_pos == start || (m_pos - start == 1 && *start == '-')) {
+        m_pos = start;
+        return Error("Unexpected character");
+    }
+
+    // strtod needs a terminated string, and numbers are short
+    std::string number(start, m_pos - start);
+    char* endp = nullptr;
+    double value = strtod(number.c_str(), &endp);
+    if(*endp != 0) {
+        m_pos = start;
+        return Error("Invalid number");
+    }
+    NOTIFY(OnNumber(value));
+    return true;
+}
+
+bool JSONStreamReader::ReadLiteral(const char* literal, size_t len)
+{
+    if((size_t)(m_end - m_pos) < len || memcmp(m_pos, literal, len) != 0) { return Error("Unexpected character"); }
+    m_pos += len;
+    return true;
+}
@@ -0,0 +1,82 @@
+#ifndef JSONSTREAMREADER_H
+#define JSONSTREAMREADER_H
+
+#include "codelite_exports.h"
+#include <string>
+#include <wx/string.h>
+
+/**
+ * @class JSONStreamReader
+ * @brief a SAX style JSON reader: the document is reported to a Handler as a sequence of events
+ * (start object, key, value, end object...) and no tree is built. Use this for large documents
+ * (e.g. compile_commands.json) where only a few fields are needed. Strings are reported as UTF-8
+ * with their escape sequences already decoded
+ */
+class WXDLLIMPEXP_CL JSONStreamReader
+{
+public:
+    /**
+     * @brief receives the document events. Each callback returns false to stop reading.
+     * The strings passed to OnKey() and OnString() are only valid during the call
+     */
+    class WXDLLIMPEXP_CL Handler
+    {
+    public:
+        virtual ~Handler() {}
+        virtual bool OnStartObject() { return true; }
+        virtual bool OnEndObject() { return true; }
+        virtual bool OnStartArray() { return true; }
+        virtual bool OnEndArray() { return true; }
+        virtual bool OnKey(const std::string& WXUNUSED(key)) { return true; }
+        virtual bool OnString(const std::string& WXUNUSED(value)) { return true; }
+        virtual bool OnNumber(double WXUNUSED(value)) { return true; }
+        virtual bool OnBool(bool WXUNUSED(value)) { return true; }
+        virtual bool OnNull() { return true; }
+    };
+
+protected:
+    Handler* m_handler;
+    const char* m_begin = nullptr;
+    const char* m_pos = nullptr;
+    const char* m_end = nullptr;
+    bool m_stopped = false;
+    wxString m_error;
+    std::string m_string; // reused for every key and string value
+
+protected:
+    bool ReadValue(int depth);
+    bool ReadObject(int depth);
+    bool ReadArray(int depth);
+    bool ReadString(std::string& str);
+    bool ReadNumber();
+    bool ReadLiteral(const char* literal, size_t len);
+    void SkipWhitespace();
+    bool Error(const wxString& message);
+
+public:
+    JSONStreamReader(Handler* handler);
+    virtual ~JSONStreamReader();
+
+    /**
+     * @brief read the document in 'buffer'
+     * @return false if the document is not valid JSON or the handler stopped reading. See GetError()
+     */
+    bool Parse(const char* buffer, size_t length);
+
+    /**
+     * @brief read the document in 'filename'. The file content is read as raw bytes, without any conversion
+     */
+    bool ParseFile(const wxString& filename);
+
+    /**
+     * @brief did the handler stop the reading?
+     */
+    bool IsStopped() const { return m_stopped; }
+
+    /**
+     * @brief the reason Parse() failed, including the offset of the error
+     */
+    const wxString& GetError() const { return m_error; }
+};
+
+#endif // JSONSTREAMREADER_H
@@ -0,0 +1,16 @@
+#include "CancelRequest.h"
+
+LSP::CancelRequest::CancelRequest(int id)
+{
+    SetMethod("$/cancelRequest");
+    m_params.reset(new CancelParams());
+    m_params->As<CancelParams>()->SetId(id);
+}
+
+LSP::CancelRequest::~CancelRequest() {}
+
+void LSP::CancelRequest::BuildUID()
+{
+    if(!m_uuid.IsEmpty()) { return; }
+    m_uuid << GetMethod() << ":" << m_params->As<CancelParams>()->GetId();
+}
@@ -0,0 +1,23 @@
+#ifndef CANCELREQUEST_H
+#define CANCELREQUEST_H
+
+#include "LSP/RequestMessage.h"
+
+namespace LSP
+{
+
+/**
+ * @brief the "$/cancelRequest" notification: tell the server that we are no longer interested in the reply
+ * of request 'id'
+ */
+class WXDLLIMPEXP_CL CancelRequest : public LSP::RequestMessage
+{
+public:
+    CancelRequest(int id);
+    virtual ~CancelRequest();
+    void BuildUID();
+};
+
+}; // namespace LSP
+
+#endif // CANCELREQUEST_H
@@ -25,10 +25,9 @@ void LSP::CompletionRequest::OnResponse(const LSP::ResponseMessage& response, wx
     if(!items.isOk() || !items.isArray()) { return; }
 
     CompletionItem::Vec_t completions;
-    const int itemsCount = items.arraySize();
-    for(int i = 0; i < itemsCount; ++i) {
+    for(JSONItem item : items) {
         CompletionItem::Ptr_t completionItem(new CompletionItem());
-        completionItem->FromJSON(items.arrayItem(i));
+        completionItem->FromJSON(item);
         completions.push_back(completionItem);
     }
     
@@ -1,13 +1,22 @@
 #include "LSP/DidChangeTextDocumentRequest.h"
 
+namespace
+{
+int GetNextVersion()
+{
+    // didOpen sends version 1
+    static int counter = 1;
+    return ++counter;
+}
+} // namespace
+
 LSP::DidChangeTextDocumentRequest::DidChangeTextDocumentRequest(const wxFileName& filename, const wxString& fileContent)
 {
-    static int counter = 0;
     SetMethod("textDocument/didChange");
     m_params.reset(new DidChangeTextDocumentParams());
 
     VersionedTextDocumentIdentifier id;
-    id.SetVersion(++counter);
+    id.SetVersion(GetNextVersion());
     id.SetFilename(filename);
     m_params->As<DidChangeTextDocumentParams>()->SetTextDocument(id);
 
@@ -18,6 +27,22 @@ LSP::DidChangeTextDocumentRequest::DidChangeTextDocumentRequest(const wxFileName
     m_uuid << GetMethod() << ":" << filename.GetFullPath();
 }
 
+LSP::DidChangeTextDocumentRequest::DidChangeTextDocumentRequest(
+    const wxFileName& filename, const std::vector<LSP::TextDocumentContentChangeEvent>& changes)
+{
+    SetMethod("textDocument/didChange");
+    m_params.reset(new DidChangeTextDocumentParams());
+
+    // Versions only need to increase, a single counter for all the documents does that
+    VersionedTextDocumentIdentifier id;
+    id.SetVersion(GetNextVersion());
+    id.SetFilename(filename);
+    m_params->As<DidChangeTextDocumentParams>()->SetTextDocument(id);
+    m_params->As<DidChangeTextDocumentParams>()->SetContentChanges(changes);
+
+    m_uuid << GetMethod() << ":" << filename.GetFullPath();
+}
+
 LSP::DidChangeTextDocumentRequest::~DidChangeTextDocumentRequest() {}
 
 void LSP::DidChangeTextDocumentRequest::BuildUID()
@@ -3,6 +3,8 @@
 
 #include <wx/filename.h>
 #include "LSP/RequestMessage.h"
+#include "LSP/basic_types.h"
+#include <vector>
 
 namespace LSP
 {
@@ -11,6 +13,11 @@ class WXDLLIMPEXP_CL DidChangeTextDocumentRequest : public LSP::RequestMessage
 {
 public:
     DidChangeTextDocumentRequest(const wxFileName& filename, const wxString& fileContent);
+    /**
+     * @brief incremental change: 'changes' are applied in order to the document
+     */
+    DidChangeTextDocumentRequest(const wxFileName& filename,
+                                 const std::vector<LSP::TextDocumentContentChangeEvent>& changes);
     virtual ~DidChangeTextDocumentRequest();
     void BuildUID();
 };
@@ -6,6 +6,7 @@ LSP::InitializeRequest::InitializeRequest(const wxString& rootUri)
     SetMethod("initialize");
     m_processId = ::wxGetProcessId();
     m_rootUri = rootUri;
+    SetNeedsReply(true);
 }
 
 LSP::InitializeRequest::~InitializeRequest() {}
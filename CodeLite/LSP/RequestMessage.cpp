@@ -12,7 +12,8 @@ LSP::RequestMessage::~RequestMessage() {}
 JSONItem LSP::RequestMessage::ToJSON(const wxString& name) const
 {
     JSONItem json = Message::ToJSON(name);
-    json.addProperty("id", GetId());
+    // Notifications (messages that do not expect a reply) carry no id
+    if(IsNeedsReply()) { json.addProperty("id", GetId()); }
     json.addProperty("method", GetMethod());
     if(m_params) { json.append(m_params->ToJSON("params")); }
     return json;
@@ -36,6 +36,17 @@ LSP::ResponseMessage::ResponseMessage(wxString& message)
     }
 }
 
+LSP::ResponseMessage::ResponseMessage(const std::string& payload)
+{
+    m_json.reset(new JSON(cJSON_Parse(payload.c_str())));
+    if(!m_json->isOk()) {
+        m_json.reset(nullptr);
+    } else {
+        m_jsonMessage = wxString::FromUTF8(payload.c_str(), payload.length());
+        FromJSON(m_json->toElement());
+    }
+}
+
 LSP::ResponseMessage::~ResponseMessage() {}
 
 std::string LSP::ResponseMessage::ToString() const { return ""; }
@@ -20,8 +20,15 @@ protected:
      */
     int ReadHeaders(const wxString& message, wxStringMap_t& headers);
 
+public:
+    typedef wxSharedPtr<LSP::ResponseMessage> Ptr_t;
+
 public:
     ResponseMessage(wxString& message);
+    /**
+     * @brief construct the response from its UTF-8 JSON payload (a message already stripped of its headers)
+     */
+    ResponseMessage(const std::string& payload);
     virtual ~ResponseMessage();
     virtual JSONItem ToJSON(const wxString& name) const;
     virtual void FromJSON(const JSONItem& json);
@@ -81,11 +81,17 @@ JSONItem TextDocumentItem::ToJSON(const wxString& name) const
 //===----------------------------------------------------------------------------------
 // TextDocumentContentChangeEvent
 //===----------------------------------------------------------------------------------
-void TextDocumentContentChangeEvent::FromJSON(const JSONItem& json) { m_text = json.namedObject("text").toString(); }
+void TextDocumentContentChangeEvent::FromJSON(const JSONItem& json)
+{
+    m_text = json.namedObject("text").toString();
+    m_hasRange = json.hasNamedObject("range");
+    if(m_hasRange) { m_range.FromJSON(json.namedObject("range")); }
+}
 
 JSONItem TextDocumentContentChangeEvent::ToJSON(const wxString& name) const
 {
     JSONItem json = JSONItem::createObject(name);
+    if(m_hasRange) { json.append(m_range.ToJSON("range")); }
     json.addProperty("text", m_text);
     return json;
 }
@@ -8,31 +8,6 @@
 
 namespace LSP
 {
-//===----------------------------------------------------------------------------------
-// TextDocumentContentChangeEvent
-//===----------------------------------------------------------------------------------
-class WXDLLIMPEXP_CL TextDocumentContentChangeEvent : public Serializable
-{
-    wxString m_text;
-
-public:
-    virtual JSONItem ToJSON(const wxString& name) const;
-    virtual void FromJSON(const JSONItem& json);
-
-    TextDocumentContentChangeEvent() {}
-    TextDocumentContentChangeEvent(const wxString& text)
-        : m_text(text)
-    {
-    }
-    virtual ~TextDocumentContentChangeEvent() {}
-    TextDocumentContentChangeEvent& SetText(const wxString& text)
-    {
-        this->m_text = text;
-        return *this;
-    }
-    const wxString& GetText() const { return m_text; }
-};
-
 //===----------------------------------------------------------------------------------
 // TextDocumentIdentifier
 //===----------------------------------------------------------------------------------
@@ -146,6 +121,50 @@ public:
     const Position& GetStart() const { return m_start; }
 };
 
+//===----------------------------------------------------------------------------------
+// TextDocumentContentChangeEvent
+//===----------------------------------------------------------------------------------
+class WXDLLIMPEXP_CL TextDocumentContentChangeEvent : public Serializable
+{
+    wxString m_text;
+    Range m_range;
+    bool m_hasRange = false;
+
+public:
+    virtual JSONItem ToJSON(const wxString& name) const;
+    virtual void FromJSON(const JSONItem& json);
+
+    TextDocumentContentChangeEvent() {}
+    TextDocumentContentChangeEvent(const wxString& text)
+        : m_text(text)
+    {
+    }
+    /**
+     * @brief an incremental change: replace 'range' with 'text'
+     */
+    TextDocumentContentChangeEvent(const Range& range, const wxString& text)
+        : m_text(text)
+        , m_range(range)
+        , m_hasRange(true)
+    {
+    }
+    virtual ~TextDocumentContentChangeEvent() {}
+    TextDocumentContentChangeEvent& SetText(const wxString& text)
+    {
+        this->m_text = text;
+        return *this;
+    }
+    const wxString& GetText() const { return m_text; }
+    TextDocumentContentChangeEvent& SetRange(const Range& range)
+    {
+        this->m_range = range;
+        this->m_hasRange = true;
+        return *this;
+    }
+    const Range& GetRange() const { return m_range; }
+    bool HasRange() const { return m_hasRange; }
+};
+
 class WXDLLIMPEXP_CL Location : public Serializable
 {
     wxString m_uri;
@@ -1 +1,113 @@
 #include "clJSONRPC.h"
+#include "file_logger.h"
+#include <stdlib.h>
+
+#define HEADERS_END "\r\n\r\n"
+#define HEADERS_END_LEN 4
+
+namespace
+{
+bool IsContentLength(const char* name, size_t len)
+{
+    static const char header[] = "content-length";
+    if(len != sizeof(header) - 1) { return false; }
+    for(size_t i = 0; i < len; ++i) {
+        char ch = name[i];
+        if(ch >= 'A' && ch <= 'Z') { ch += ('a' - 'A'); }
+        if(ch != header[i]) { return false; }
+    }
+    return true;
+}
+} // namespace
+
+clJSONRPCFramer::clJSONRPCFramer() {}
+
+clJSONRPCFramer::~clJSONRPCFramer() {}
+
+void clJSONRPCFramer::Append(const char* data, size_t len)
+{
+    // Drop the consumed data before growing the buffer. Moving the leftovers only when they are
+    // smaller than what is dropped keeps the cost linear in the number of bytes received
+    if(m_offset == m_buffer.length()) {
+        m_buffer.clear();
+        m_payloadStart = m_scanPos = m_offset = 0;
+    } else if(m_offset > (m_buffer.length() / 2)) {
+        m_buffer.erase(0, m_offset);
+        m_scanPos -= m_offset;
+        if(m_contentLength >= 0) { m_payloadStart -= m_offset; }
+        m_offset = 0;
+    }
+    m_buffer.append(data, len);
+}
+
+bool clJSONRPCFramer::Next(std::string& payload)
+{
+    while(true) {
+        if(m_contentLength < 0) {
+            size_t where = m_buffer.find(HEADERS_END, m_scanPos);
+            if(where == std::string::npos) {
+                // The separator may be split between two reads
+                if(m_buffer.length() >= (m_offset + HEADERS_END_LEN - 1)) {
+                    m_scanPos = m_buffer.length() - (HEADERS_END_LEN - 1);
+                }
+                return false;
+            }
+            m_contentLength = ParseContentLength(m_buffer.c_str() + m_offset, where - m_offset);
+            m_payloadStart = where + HEADERS_END_LEN;
+            if(m_contentLength < 0) {
+                clWARNING() << "JSON-RPC: message without a valid Content-Length header. Skipping it" << clEndl;
+                m_offset = m_scanPos = m_payloadStart;
+                continue;
+            }
+        }
+
+        if((m_buffer.length() - m_payloadStart) < (size_t)m_contentLength) { return false; }
+        payload.assign(m_buffer, m_payloadStart, m_contentLength);
+        m_offset = m_scanPos = m_payloadStart + m_contentLength;
+        m_contentLength = -1;
+        return true;
+    }
+}
+
+void clJSONRPCFramer::Clear()
+{
+    m_buffer.clear();
+    m_offset = m_scanPos = m_payloadStart = 0;
+    m_contentLength = -1;
+}
+
+long clJSONRPCFramer::ParseContentLength(const char* headers, size_t len)
+{
+    long contentLength = -1;
+    size_t lineStart = 0;
+    while(lineStart < len) {
+        size_t lineEnd = lineStart;
+        while(lineEnd < len && headers[lineEnd] != '\n') {
+            ++lineEnd;
+        }
+        // "Name: value", possibly followed by '\r'
+        size_t colon = lineStart;
+        while(colon < lineEnd && headers[colon] != ':') {
+            ++colon;
+        }
+        size_t nameStart = lineStart;
+        while(nameStart < colon && (headers[nameStart] == ' ' || headers[nameStart] == '\r')) {
+            ++nameStart;
+        }
+        size_t nameEnd = colon;
+        while(nameEnd > nameStart && headers[nameEnd - 1] == ' ') {
+            --nameEnd;
+        }
+        if(colon < lineEnd && IsContentLength(headers + nameStart, nameEnd - nameStart)) {
+            std::string value(headers + colon + 1, lineEnd - colon - 1);
+            char* end = nullptr;
+            long n = strtol(value.c_str(), &end, 10);
+            while(end && (*end == ' ' || *end == '\r')) {
+                ++end;
+            }
+            contentLength = (end && *end == 0 && end != value.c_str() && n >= 0) ? n : -1;
+        }
+        lineStart = lineEnd + 1;
+    }
+    return contentLength;
+}
@@ -1,4 +1,54 @@
 #ifndef CLJSONRPC_H
 #define CLJSONRPC_H
 
+#include "codelite_exports.h"
+#include <string>
+
+/**
+ * @brief split a JSON-RPC byte stream into messages. Each message is a set of headers ("Name: value\r\n")
+ * followed by an empty line and a payload of "Content-Length" bytes.
+ * The stream is kept as bytes: a read may end in the middle of a multi-byte UTF-8 character, and
+ * "Content-Length" counts bytes, not characters. Every byte is examined once: the search for the end of
+ * the headers resumes where the previous one stopped, and once the headers are read, the framer simply
+ * waits for the payload to complete
+ */
+class WXDLLIMPEXP_CL clJSONRPCFramer
+{
+    std::string m_buffer;
+    size_t m_offset = 0;       // start of the data not consumed yet
+    size_t m_scanPos = 0;      // where to resume the search for the end of the headers
+    size_t m_payloadStart = 0; // start of the payload, once its headers were read
+    long m_contentLength = -1; // size of the payload, once its headers were read
+
+protected:
+    static long ParseContentLength(const char* headers, size_t len);
+
+public:
+    clJSONRPCFramer();
+    virtual ~clJSONRPCFramer();
+
+    /**
+     * @brief add data read from the stream
+     */
+    void Append(const char* data, size_t len);
+    void Append(const std::string& data) { Append(data.c_str(), data.length()); }
+
+    /**
+     * @brief extract the payload of the next complete message. Call it until it returns false to drain all
+     * the messages received so far
+     * @return false when no complete message is available
+     */
+    bool Next(std::string& payload);
+
+    /**
+     * @brief discard everything received so far
+     */
+    void Clear();
+
+    /**
+     * @brief number of bytes received that do not form a complete message yet
+     */
+    size_t GetPendingBytes() const { return m_buffer.length() - m_offset; }
+};
+
 #endif // CLJSONRPC_H
@@ -112,4 +112,16 @@ JSONItem CompletionParams::ToJSON(const wxString& name) const
     JSONItem json = TextDocumentPositionParams::ToJSON(name);
     return json;
 }
+
+//===----------------------------------------------------------------------------------
+// CancelParams
+//===----------------------------------------------------------------------------------
+void CancelParams::FromJSON(const JSONItem& json) { m_id = json.namedObject("id").toInt(); }
+
+JSONItem CancelParams::ToJSON(const wxString& name) const
+{
+    JSONItem json = JSONItem::createObject(name);
+    json.addProperty("id", m_id);
+    return json;
+}
 }; // namespace LSP
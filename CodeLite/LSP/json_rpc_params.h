@@ -156,5 +156,26 @@ public:
     const wxString& GetText() const { return m_text; }
 };
 
+//===----------------------------------------------------------------------------------
+// CancelParams
+//===----------------------------------------------------------------------------------
+class WXDLLIMPEXP_CL CancelParams : public Params
+{
+    int m_id = wxNOT_FOUND;
+
+public:
+    CancelParams() {}
+    virtual ~CancelParams() {}
+
+    virtual void FromJSON(const JSONItem& json);
+    virtual JSONItem ToJSON(const wxString& name) const;
+    CancelParams& SetId(int id)
+    {
+        this->m_id = id;
+        return *this;
+    }
+    int GetId() const { return m_id; }
+};
+
 };     // namespace LSP
 #endif // JSONRPC_PARAMS_H
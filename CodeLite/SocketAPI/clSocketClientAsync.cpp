@@ -230,12 +230,15 @@ void clSocketAsyncThread::BufferLoop(clSocketBase::Ptr_t socket)
             }
 
             // timeout, test to see if we got something on the socket
-            wxString buffer;
+            wxMemoryBuffer buffer;
             if(socket->SelectReadMS(5) == clSocketBase::kSuccess) {
                 int rc = socket->Read(buffer);
                 if(rc == clSocketBase::kSuccess) {
+                    // A read may end in the middle of a multi-byte character: keep the bytes as they were
+                    // received for consumers that need an exact byte stream (e.g. Content-Length framing)
                     clCommandEvent event(wxEVT_ASYNC_SOCKET_INPUT);
-                    event.SetString(buffer);
+                    event.SetStringRaw(std::string((const char*)buffer.GetData(), buffer.GetDataLen()));
+                    event.SetString(wxString((const char*)buffer.GetData(), wxConvUTF8, buffer.GetDataLen()));
                     m_sink->AddPendingEvent(event);
 
                 } else if(rc == clSocketBase::kError) {
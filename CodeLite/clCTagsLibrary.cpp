@@ -0,0 +1,86 @@
+#include "clCTagsLibrary.h"
+#include "cl_standard_paths.h"
+#include "file_logger.h"
+#include <wx/filename.h>
+#include <wx/utils.h>
+
+clCTagsLibrary::clCTagsLibrary() {}
+
+clCTagsLibrary::~clCTagsLibrary() { Unload(); }
+
+wxString clCTagsLibrary::GetDefaultLibraryPath()
+{
+    wxString libname;
+    libname << "libctags" << wxDynamicLibrary::GetDllExt(wxDL_LIBRARY);
+#ifdef __WXGTK__
+    wxFileName fn(clStandardPaths::Get().GetPluginsDirectory(), libname);
+#else
+    wxFileName fn(clStandardPaths::Get().GetBinFolder(), libname);
+#endif
+    return fn.GetFullPath();
+}
+
+bool clCTagsLibrary::Load(const wxString& path)
+{
+    wxMutexLocker locker(m_mutex);
+    if(m_makeTags) { return true; }
+
+    wxLogNull noLog;
+    if(!m_library.Load(path, wxDL_NOW)) {
+        clWARNING() << "Could not load ctags library:" << path << clEndl;
+        return false;
+    }
+
+    m_makeTags = (MakeTagsFunc_t)m_library.GetSymbol("ctags_make_tags_ex");
+    m_free = (FreeFunc_t)m_library.GetSymbol("ctags_free");
+    m_shutdown = (ShutdownFunc_t)m_library.GetSymbol("ctags_shutdown");
+    if(!m_makeTags || !m_free || !m_shutdown) {
+        clWARNING() << "ctags library" << path << "does not export the required API" << clEndl;
+        m_makeTags = nullptr;
+        m_free = nullptr;
+        m_shutdown = nullptr;
+        m_library.Unload();
+        return false;
+    }
+
+    // ctags writes its output to a file before we read it back. Use a file per process
+    wxFileName tagsFile(clStandardPaths::Get().GetUserDataDir(), wxString() << "ctags." << wxGetProcessId() << ".tags");
+    tagsFile.AppendDir("tmp");
+    tagsFile.Mkdir(wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+    m_tagsFile = tagsFile.GetFullPath();
+
+    clDEBUG() << "Loaded ctags library:" << path << clEndl;
+    return true;
+}
+
+void clCTagsLibrary::Unload()
+{
+    wxMutexLocker locker(m_mutex);
+    if(!m_makeTags) { return; }
+
+    m_shutdown();
+    m_makeTags = nullptr;
+    m_free = nullptr;
+    m_shutdown = nullptr;
+    m_library.Unload();
+
+    if(wxFileName::FileExists(m_tagsFile)) {
+        wxLogNull noLog;
+        ::wxRemoveFile(m_tagsFile);
+    }
+}
+
+bool clCTagsLibrary::SourceToTags(const wxString& ctagsOptions, const wxString& filename, std::string& tags)
+{
+    wxMutexLocker locker(m_mutex);
+    if(!m_makeTags) { return false; }
+
+    char* output = m_makeTags(ctagsOptions.mb_str(wxConvUTF8).data(), filename.mb_str(wxConvUTF8).data(),
+                              m_tagsFile.mb_str(wxConvUTF8).data());
+    tags.clear();
+    if(output) {
+        tags = output;
+        m_free(output);
+    }
+    return true;
+}
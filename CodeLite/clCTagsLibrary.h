@@ -0,0 +1,55 @@
+#ifndef CLCTAGSLIBRARY_H
+#define CLCTAGSLIBRARY_H
+
+#include "codelite_exports.h"
+#include <string>
+#include <wx/dynlib.h>
+#include <wx/string.h>
+#include <wx/thread.h>
+
+/**
+ * @class clCTagsLibrary
+ * @brief run libctags in-process (loaded from the 'libctags' shared library) instead of
+ * sending the request to the codelite_indexer process.
+ * libctags keeps its state in global variables, so all calls are serialized.
+ * Note that a fatal error inside libctags terminates the calling process: this is why
+ * the out-of-process indexer remains the default
+ */
+class WXDLLIMPEXP_CL clCTagsLibrary
+{
+    typedef char* (*MakeTagsFunc_t)(const char*, const char*, const char*);
+    typedef void (*FreeFunc_t)(char*);
+    typedef void (*ShutdownFunc_t)();
+
+    wxDynamicLibrary m_library;
+    MakeTagsFunc_t m_makeTags = nullptr;
+    FreeFunc_t m_free = nullptr;
+    ShutdownFunc_t m_shutdown = nullptr;
+    wxString m_tagsFile;
+    wxMutex m_mutex;
+
+public:
+    clCTagsLibrary();
+    virtual ~clCTagsLibrary();
+
+    /**
+     * @brief return the default location of the libctags shared library
+     */
+    static wxString GetDefaultLibraryPath();
+
+    /**
+     * @brief load the library and resolve its API. Does nothing if already loaded
+     */
+    bool Load(const wxString& path = GetDefaultLibraryPath());
+    void Unload();
+    bool IsLoaded() const { return m_makeTags != nullptr; }
+
+    /**
+     * @brief parse 'filename' and return the ctags output
+     * @param ctagsOptions ctags command line options
+     * @return false if the library is not loaded
+     */
+    bool SourceToTags(const wxString& ctagsOptions, const wxString& filename, std::string& tags);
+};
+
+#endif // CLCTAGSLIBRARY_H
@@ -0,0 +1,49 @@
+#include "clFileContent.h"
+#include "file_logger.h"
+#include <wx/file.h>
+
+clFileContent::clFileContent() {}
+
+clFileContent::~clFileContent() { Close(); }
+
+bool clFileContent::Open(const wxString& filename)
+{
+    Close();
+    wxFile fp(filename, wxFile::read);
+    if(!fp.IsOpened()) {
+        clDEBUG() << "clFileContent: failed to open file:" << filename << clEndl;
+        return false;
+    }
+
+    wxFileOffset len = fp.Length();
+    if(len < 0) { return false; }
+
+    // The length is only a hint: the file may be truncated or extended by another process while it is read.
+    // Read until the end of the file is reached. The extra byte lets the read that hits the end of the file
+    // return 0 without growing the buffer
+    size_t used = 0;
+    m_buffer.resize((size_t)len + 1);
+    while(true) {
+        if(used == m_buffer.size()) { m_buffer.resize(m_buffer.size() * 2); }
+        ssize_t count = fp.Read(&m_buffer[used], m_buffer.size() - used);
+        if(count == wxInvalidOffset) {
+            clDEBUG() << "clFileContent: failed to read file:" << filename << clEndl;
+            Close();
+            return false;
+        }
+        if(count == 0) { break; }
+        used += (size_t)count;
+    }
+    m_buffer.resize(used);
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+    return true;
+}
+
+void clFileContent::Close()
+{
+    // release the memory, clear() keeps the capacity
+    std::string().swap(m_buffer);
+    m_data = nullptr;
+    m_size = 0;
+}
@@ -0,0 +1,46 @@
+#ifndef CLFILECONTENT_H
+#define CLFILECONTENT_H
+
+#include "codelite_exports.h"
+#include <string>
+#include <wx/string.h>
+
+/**
+ * @class clFileContent
+ * @brief the content of a file as raw bytes. Open() reads the whole file into memory, so don't use it for
+ * files larger than the memory you are willing to spend on them.
+ * The file is not memory mapped: accessing a mapping of a file that another process truncates (e.g. a log
+ * file rotated while it is searched) kills the process with SIGBUS
+ */
+class WXDLLIMPEXP_CL clFileContent
+{
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+    std::string m_buffer;
+
+    clFileContent(const clFileContent&) = delete;
+    clFileContent& operator=(const clFileContent&) = delete;
+
+public:
+    clFileContent();
+    virtual ~clFileContent();
+
+    /**
+     * @brief open the file and make its content available through GetData()
+     * @return false if the file could not be opened or read
+     */
+    bool Open(const wxString& filename);
+
+    /**
+     * @brief release the buffer
+     */
+    void Close();
+
+    /**
+     * @brief the file content. The content is not NULL terminated, use GetSize()
+     */
+    const char* GetData() const { return m_data; }
+    size_t GetSize() const { return m_size; }
+};
+
+#endif // CLFILECONTENT_H
@@ -1,7 +1,23 @@
 #include "clFileSystemWatcher.h"
+#include "clFilesCollector.h"
+#include "file_logger.h"
+#include "fileutils.h"
 #include <algorithm>
 #include <set>
-#include "fileutils.h"
+#include <wx/filefn.h>
+#if CL_FSW_USE_INOTIFY
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <string>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#endif
 
 wxDEFINE_EVENT(wxEVT_FILE_MODIFIED, clFileSystemEvent);
 wxDEFINE_EVENT(wxEVT_FILE_NOT_FOUND, clFileSystemEvent);
@@ -9,10 +25,264 @@ wxDEFINE_EVENT(wxEVT_FILE_NOT_FOUND, clFileSystemEvent);
 // In milliseconds
 #define FILE_CHECK_INTERVAL 500
 
+#if CL_FSW_USE_TIMER
+namespace
+{
+bool GetFileStamp(const wxString& path, time_t& lastModified, size_t& fileSize)
+{
+    wxStructStat st;
+    if(wxStat(path, &st) != 0) { return false; }
+    lastModified = st.st_mtime;
+    fileSize = st.st_size;
+    return true;
+}
+} // namespace
+#endif
+
+#if CL_FSW_USE_INOTIFY
+// Events arriving within this time (in milliseconds) are delivered together
+#define INOTIFY_BATCH_DELAY 50
+#define INOTIFY_FOLDER_EVENTS                                                                                   \
+    (IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | \
+     IN_MOVE_SELF | IN_ONLYDIR)
+
+struct clInotifyEvent {
+    int wd;
+    uint32_t mask;
+    std::string name;
+};
+
+namespace
+{
+wxString JoinPath(const wxString& folder, const wxString& name)
+{
+    return folder.EndsWith("/") ? folder + name : folder + "/" + name;
+}
+
+/**
+ * List the folders found under 'root' (including 'root') and optionally, their files.
+ * Symbolic links to folders are not followed
+ */
+void WalkFolder(const wxString& root, std::vector<wxString>& folders, std::vector<wxString>* files)
+{
+    std::vector<wxString> queue;
+    queue.push_back(root);
+    while(!queue.empty()) {
+        wxString folder = queue.back();
+        queue.pop_back();
+
+        DIR* dir = ::opendir(folder.fn_str());
+        if(!dir) { continue; }
+        folders.push_back(folder);
+
+        struct dirent* ent = NULL;
+        while((ent = ::readdir(dir)) != NULL) {
+            const char* name = ent->d_name;
+            if(name[0] == '.' && (name[1] == 0 || (name[1] == '.' && name[2] == 0))) { continue; }
+
+            bool isDir = (ent->d_type == DT_DIR);
+            if(ent->d_type == DT_UNKNOWN) {
+                struct stat st;
+                isDir = (::fstatat(::dirfd(dir), name, &st, AT_SYMLINK_NOFOLLOW) == 0) && S_ISDIR(st.st_mode);
+            }
+            wxString path = JoinPath(folder, wxString(name, *wxConvFileName));
+            if(isDir) {
+                queue.push_back(path);
+            } else if(files) {
+                files->push_back(path);
+            }
+        }
+        ::closedir(dir);
+    }
+}
+} // namespace
+
+/**
+ * @class clInotifyWatcher
+ * @brief the Linux backend. Folders are watched (not files): a thread waits for their events and
+ * passes them to clFileSystemWatcher on the main thread, which keeps the events of the files it watches.
+ * The folder of a watched file is reference counted, the folders added with AddFolder() are watched
+ * until they are deleted or the watcher is stopped
+ */
+class clInotifyWatcher
+{
+    struct Folder {
+        int wd = -1;
+        size_t refs = 0;
+        bool tree = false;
+    };
+
+    clFileSystemWatcher* m_owner;
+    size_t m_generation;
+    int m_fd = -1;
+    int m_wakeupPipe[2] = { -1, -1 };
+    std::thread* m_thread = nullptr;
+    std::map<wxString, Folder> m_folders;
+    std::unordered_map<int, wxString> m_paths;
+
+protected:
+    void ReaderThread();
+
+public:
+    clInotifyWatcher(clFileSystemWatcher* owner, size_t generation)
+        : m_owner(owner)
+        , m_generation(generation)
+    {
+    }
+    ~clInotifyWatcher();
+
+    /**
+     * @brief create the inotify instance and start reading its events
+     */
+    bool Start();
+
+    /**
+     * @brief watch a folder. 'tree' folders are part of a folder added with AddFolder(), any other folder
+     * is watched until RemoveFolder() was called once for every AddFolder()
+     */
+    bool AddFolder(const wxString& path, bool tree);
+    void RemoveFolder(const wxString& path);
+
+    /**
+     * @brief stop watching the folder of a given watch descriptor
+     */
+    void Forget(int wd);
+
+    /**
+     * @brief return the folder of a watch descriptor (empty if it is no longer watched)
+     */
+    wxString GetFolder(int wd) const;
+};
+
+clInotifyWatcher::~clInotifyWatcher()
+{
+    if(m_thread) {
+        // Wake up the thread and wait for it
+        char c = 0;
+        if(::write(m_wakeupPipe[1], &c, 1) < 0) {
+            clWARNING() << "inotify: failed to wake up the watcher thread" << clEndl;
+        }
+        m_thread->join();
+        wxDELETE(m_thread);
+    }
+    // Closing the inotify instance removes all of its watches
+    for(int fd : { m_fd, m_wakeupPipe[0], m_wakeupPipe[1] }) {
+        if(fd != -1) { ::close(fd); }
+    }
+}
+
+bool clInotifyWatcher::Start()
+{
+    m_fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(m_fd == -1) {
+        clWARNING() << "inotify_init1 failed:" << strerror(errno) << clEndl;
+        return false;
+    }
+    if(::pipe2(m_wakeupPipe, O_CLOEXEC) != 0) {
+        clWARNING() << "inotify: failed to create a pipe:" << strerror(errno) << clEndl;
+        return false;
+    }
+    m_thread = new std::thread(&clInotifyWatcher::ReaderThread, this);
+    return true;
+}
+
+void clInotifyWatcher::ReaderThread()
+{
+    alignas(struct inotify_event) char buffer[64 * 1024];
+    struct pollfd fds[2];
+    fds[0].fd = m_fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = m_wakeupPipe[0];
+    fds[1].events = POLLIN;
+
+    while(true) {
+        fds[0].revents = fds[1].revents = 0;
+        if(::poll(fds, 2, -1) < 0) {
+            if(errno == EINTR) { continue; }
+            clWARNING() << "inotify: poll failed:" << strerror(errno) << clEndl;
+            break;
+        }
+        if(fds[1].revents) { break; }
+
+        // Let a burst of events (e.g. a file being written in chunks) complete, unless we are being stopped
+        fds[1].revents = 0;
+        if(::poll(&fds[1], 1, INOTIFY_BATCH_DELAY) > 0) { break; }
+
+        std::vector<clInotifyEvent> events;
+        ssize_t len = 0;
+        // The descriptor is non blocking: read until there is nothing left
+        while((len = ::read(m_fd, buffer, sizeof(buffer))) > 0) {
+            for(char* ptr = buffer; ptr < buffer + len;) {
+                const struct inotify_event* ev = reinterpret_cast<const struct inotify_event*>(ptr);
+                clInotifyEvent event;
+                event.wd = ev->wd;
+                event.mask = ev->mask;
+                if(ev->len) { event.name = ev->name; }
+                events.push_back(event);
+                ptr += sizeof(struct inotify_event) + ev->len;
+            }
+        }
+        if(len < 0 && errno != EAGAIN && errno != EINTR) {
+            clWARNING() << "inotify: read failed:" << strerror(errno) << clEndl;
+            break;
+        }
+        if(!events.empty()) { m_owner->CallAfter(&clFileSystemWatcher::OnInotifyEvents, m_generation, events); }
+    }
+}
+
+bool clInotifyWatcher::AddFolder(const wxString& path, bool tree)
+{
+    std::map<wxString, Folder>::iterator iter = m_folders.find(path);
+    if(iter == m_folders.end()) {
+        int wd = ::inotify_add_watch(m_fd, path.fn_str(), INOTIFY_FOLDER_EVENTS);
+        if(wd == -1) {
+            clDEBUG() << "inotify: can't watch" << path << ":" << strerror(errno) << clEndl;
+            return false;
+        }
+        iter = m_folders.insert(std::make_pair(path, Folder())).first;
+        iter->second.wd = wd;
+        m_paths[wd] = path;
+    }
+    if(tree) {
+        iter->second.tree = true;
+    } else {
+        ++iter->second.refs;
+    }
+    return true;
+}
+
+void clInotifyWatcher::RemoveFolder(const wxString& path)
+{
+    std::map<wxString, Folder>::iterator iter = m_folders.find(path);
+    if(iter == m_folders.end() || iter->second.refs == 0) { return; }
+    if(--iter->second.refs == 0 && !iter->second.tree) { Forget(iter->second.wd); }
+}
+
+void clInotifyWatcher::Forget(int wd)
+{
+    std::unordered_map<int, wxString>::iterator iter = m_paths.find(wd);
+    if(iter == m_paths.end()) { return; }
+    // Fails harmlessly when the kernel already removed the watch
+    ::inotify_rm_watch(m_fd, wd);
+    m_folders.erase(iter->second);
+    m_paths.erase(iter);
+}
+
+wxString clInotifyWatcher::GetFolder(int wd) const
+{
+    std::unordered_map<int, wxString>::const_iterator iter = m_paths.find(wd);
+    return iter == m_paths.end() ? wxString() : iter->second;
+}
+#endif
+
 clFileSystemWatcher::clFileSystemWatcher()
     : m_owner(NULL)
 #if CL_FSW_USE_TIMER
     , m_timer(NULL)
+#if CL_FSW_USE_INOTIFY
+    , m_inotify(NULL)
+    , m_inotifyGeneration(0)
+#endif
 #endif
 {
 #if CL_FSW_USE_TIMER
@@ -38,12 +308,10 @@ void clFileSystemWatcher::SetFile(const wxFileName& filename)
 {
 #if CL_FSW_USE_TIMER
     if(filename.Exists()) {
-        m_files.clear();
-        File f;
-        f.filename = filename;
-        f.lastModified = FileUtils::GetFileModificationTime(filename);
-        f.file_size = FileUtils::GetFileSize(filename);
-        m_files.insert(std::make_pair(filename.GetFullPath(), f));
+        bool running = IsRunning();
+        Clear();
+        AddFile(filename);
+        if(running) { Start(); }
     }
 #else
     m_watcher.RemoveAll();
@@ -54,11 +322,54 @@ void clFileSystemWatcher::SetFile(const wxFileName& filename)
 #endif
 }
 
+void clFileSystemWatcher::AddFile(const wxFileName& filename)
+{
+#if CL_FSW_USE_TIMER
+    File f;
+    f.filename = filename;
+    if(m_files.count(filename.GetFullPath()) ||
+       !GetFileStamp(filename.GetFullPath(), f.lastModified, f.file_size)) {
+        return;
+    }
+    m_files.insert(std::make_pair(filename.GetFullPath(), f));
+#if CL_FSW_USE_INOTIFY
+    if(m_inotify) { m_inotify->AddFolder(filename.GetPath(), false); }
+#endif
+#else
+    SetFile(filename);
+#endif
+}
+
+void clFileSystemWatcher::AddFolder(const wxString& folder)
+{
+#if CL_FSW_USE_TIMER
+    wxString path = wxFileName::DirName(folder).GetPath();
+    if(m_folders.count(path) || !wxFileName::DirExists(path)) { return; }
+    m_folders.insert(path);
+    DoAddFolderFiles(path);
+#else
+    wxUnusedVar(folder);
+#endif
+}
+
 void clFileSystemWatcher::Start()
 {
 #if CL_FSW_USE_TIMER
     Stop();
 
+#if CL_FSW_USE_INOTIFY
+    m_inotify = new clInotifyWatcher(this, ++m_inotifyGeneration);
+    if(m_inotify->Start()) {
+        for(const File::Map_t::value_type& p : m_files) {
+            if(!p.second.fromFolder) { m_inotify->AddFolder(p.second.filename.GetPath(), false); }
+        }
+        DoRescan();
+        return;
+    }
+    clWARNING() << "clFileSystemWatcher: inotify is not available, polling the files instead" << clEndl;
+    wxDELETE(m_inotify);
+#endif
+
     m_timer = new wxTimer(this);
     m_timer->Start(FILE_CHECK_INTERVAL, true);
 #else
@@ -72,6 +383,9 @@ void clFileSystemWatcher::Stop()
         m_timer->Stop();
     }
     wxDELETE(m_timer);
+#if CL_FSW_USE_INOTIFY
+    wxDELETE(m_inotify);
+#endif
 #else
     m_watcher.RemoveAll();
 #endif
@@ -82,6 +396,7 @@ void clFileSystemWatcher::Clear()
 #if CL_FSW_USE_TIMER
     Stop();
     m_files.clear();
+    m_folders.clear();
 #else
     m_watcher.RemoveAll();
 #endif
@@ -90,57 +405,199 @@ void clFileSystemWatcher::Clear()
 #if CL_FSW_USE_TIMER
 void clFileSystemWatcher::OnTimer(wxTimerEvent& event)
 {
-    std::set<wxString> nonExistingFiles;
-    std::for_each(m_files.begin(), m_files.end(), [&](const std::pair<wxString, clFileSystemWatcher::File>& p) {
-        const File& f = p.second;
-        const wxFileName& fn = f.filename;
-        if(!fn.Exists()) {
+    DoCheckFiles();
+    if(m_timer) {
+        m_timer->Start(FILE_CHECK_INTERVAL, true);
+    }
+}
 
-            // fire file not found event
-            if(GetOwner()) {
-                clFileSystemEvent evt(wxEVT_FILE_NOT_FOUND);
-                evt.SetPath(fn.GetFullPath());
-                GetOwner()->AddPendingEvent(evt);
-            }
+void clFileSystemWatcher::DoCheckFiles()
+{
+    File::Map_t::iterator iter = m_files.begin();
+    while(iter != m_files.end()) {
+        File& f = iter->second;
+        time_t lastModified = 0;
+        size_t fileSize = 0;
+        if(!GetFileStamp(iter->first, lastModified, fileSize)) {
+            // fire file not found event and stop watching the file
+            NotifyNotFound(iter->first);
+            iter = DoRemoveFile(iter);
+            continue;
+        }
+
+        // Only entries that changed are updated
+        if(f.lastModified != lastModified || f.file_size != fileSize) {
+            f.lastModified = lastModified;
+            f.file_size = fileSize;
+            NotifyModified(iter->first);
+        }
+        ++iter;
+    }
+}
 
-            // add the missing file to a set
-            nonExistingFiles.insert(fn.GetFullPath());
-        } else {
-            
-#ifdef __WXMSW__
-            size_t prev_value = f.file_size;
-            size_t curr_value = FileUtils::GetFileSize(fn);
+void clFileSystemWatcher::DoAddFolderFiles(const wxString& folder)
+{
+    std::vector<wxString> files;
+#if CL_FSW_USE_INOTIFY
+    if(m_inotify) {
+        DoWatchFolder(folder, &files);
+    } else {
+        std::vector<wxString> folders;
+        WalkFolder(folder, folders, &files);
+    }
 #else
-            time_t prev_value = f.lastModified;
-            time_t curr_value = FileUtils::GetFileModificationTime(fn);
+    clFilesScanner scanner;
+    scanner.Scan(folder, files);
 #endif
+    for(const wxString& file : files) {
+        File f;
+        f.filename = file;
+        f.fromFolder = true;
+        if(GetFileStamp(file, f.lastModified, f.file_size)) { m_files.insert(std::make_pair(file, f)); }
+    }
+}
 
-            if(prev_value != curr_value) {
-                // Fire a modified event
-                if(GetOwner()) {
-                    clFileSystemEvent evt(wxEVT_FILE_MODIFIED);
-                    evt.SetPath(fn.GetFullPath());
-                    GetOwner()->AddPendingEvent(evt);
-                }
-            }
-#ifdef __WXMSW__
-            File updatdFile = f;
-            updatdFile.file_size = curr_value;
-#else
-            // Always update the last modified timestamp
-            File updatdFile = f;
-            updatdFile.lastModified = curr_value;
+clFileSystemWatcher::File::Map_t::iterator clFileSystemWatcher::DoRemoveFile(File::Map_t::iterator iter)
+{
+#if CL_FSW_USE_INOTIFY
+    if(m_inotify && !iter->second.fromFolder) { m_inotify->RemoveFolder(iter->second.filename.GetPath()); }
 #endif
-            m_files[fn.GetFullPath()] = updatdFile;
-        }
+    return m_files.erase(iter);
+}
+
+bool clFileSystemWatcher::IsInFolder(const wxString& path) const
+{
+    return std::any_of(m_folders.begin(), m_folders.end(), [&](const wxString& folder) {
+        return path.StartsWith(folder) && path.length() > folder.length() &&
+               (folder.EndsWith(wxFILE_SEP_PATH) || path[folder.length()] == wxFILE_SEP_PATH);
     });
+}
+
+void clFileSystemWatcher::NotifyModified(const wxString& path)
+{
+    if(GetOwner()) {
+        clFileSystemEvent evt(wxEVT_FILE_MODIFIED);
+        evt.SetPath(path);
+        GetOwner()->AddPendingEvent(evt);
+    }
+}
 
-    // Remove the non existing files
-    std::for_each(nonExistingFiles.begin(), nonExistingFiles.end(), [&](const wxString& fn) { m_files.erase(fn); });
+void clFileSystemWatcher::NotifyNotFound(const wxString& path)
+{
+    if(GetOwner()) {
+        clFileSystemEvent evt(wxEVT_FILE_NOT_FOUND);
+        evt.SetPath(path);
+        GetOwner()->AddPendingEvent(evt);
+    }
+}
+#endif
 
-    if(m_timer) {
-        m_timer->Start(FILE_CHECK_INTERVAL, true);
+#if CL_FSW_USE_INOTIFY
+void clFileSystemWatcher::OnInotifyEvents(size_t generation, const std::vector<clInotifyEvent>& events)
+{
+    // Events queued before the watcher was stopped (or restarted) are ignored
+    if(!m_inotify || generation != m_inotifyGeneration) { return; }
+
+    // Collect the paths touched by the events, then check the current state of each one of them
+    std::set<wxString> touched;
+    bool overflow = false;
+    for(const clInotifyEvent& event : events) {
+        if(event.mask & IN_Q_OVERFLOW) {
+            overflow = true;
+            continue;
+        }
+
+        wxString folder = m_inotify->GetFolder(event.wd);
+        if(folder.empty()) { continue; }
+        if(event.mask & IN_IGNORED) {
+            m_inotify->Forget(event.wd);
+            continue;
+        }
+
+        if(event.mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+            // The folder is gone: check the files we watch in it
+            wxString prefix = JoinPath(folder, "");
+            for(const File::Map_t::value_type& p : m_files) {
+                if(p.first.StartsWith(prefix)) { touched.insert(p.first); }
+            }
+            m_inotify->Forget(event.wd);
+            continue;
+        }
+
+        if(event.name.empty()) { continue; }
+        wxString path = JoinPath(folder, wxString(event.name.c_str(), *wxConvFileName));
+        if(event.mask & IN_ISDIR) {
+            if((event.mask & (IN_CREATE | IN_MOVED_TO)) && IsInFolder(path)) {
+                // A new folder: watch it and report the files already created in it
+                std::vector<wxString> files;
+                DoWatchFolder(path, &files);
+                touched.insert(files.begin(), files.end());
+            }
+            continue;
+        }
+        touched.insert(path);
     }
+
+    if(overflow) {
+        // Events were lost, compare everything we know with the file system
+        clDEBUG() << "clFileSystemWatcher: inotify queue overflow, rescanning" << clEndl;
+        DoRescan();
+    }
+
+    for(const wxString& path : touched) {
+        File f;
+        bool exists = GetFileStamp(path, f.lastModified, f.file_size);
+        File::Map_t::iterator iter = m_files.find(path);
+        if(iter != m_files.end()) {
+            if(!exists) {
+                NotifyNotFound(path);
+                DoRemoveFile(iter);
+            } else {
+                iter->second.lastModified = f.lastModified;
+                iter->second.file_size = f.file_size;
+                NotifyModified(path);
+            }
+
+        } else if(exists && IsInFolder(path) && !wxFileName::DirExists(path)) {
+            // A new file in a watched folder
+            f.filename = path;
+            f.fromFolder = true;
+            m_files.insert(std::make_pair(path, f));
+            NotifyModified(path);
+        }
+    }
+}
+
+void clFileSystemWatcher::DoWatchFolder(const wxString& folder, std::vector<wxString>* files)
+{
+    std::vector<wxString> folders;
+    WalkFolder(folder, folders, files);
+    for(const wxString& path : folders) {
+        m_inotify->AddFolder(path, true);
+    }
+}
+
+void clFileSystemWatcher::DoRescan()
+{
+    // Pick up the folders and files created while we were not watching
+    std::set<wxString> folderFiles;
+    for(const wxString& folder : m_folders) {
+        std::vector<wxString> files;
+        DoWatchFolder(folder, &files);
+        folderFiles.insert(files.begin(), files.end());
+    }
+    for(const wxString& path : folderFiles) {
+        if(m_files.count(path)) { continue; }
+        File f;
+        f.filename = path;
+        f.fromFolder = true;
+        if(GetFileStamp(path, f.lastModified, f.file_size)) {
+            m_files.insert(std::make_pair(path, f));
+            NotifyModified(path);
+        }
+    }
+    // And the ones that were modified or deleted
+    DoCheckFiles();
 }
 #endif
 
@@ -163,8 +620,9 @@ void clFileSystemWatcher::OnFileModified(wxFileSystemWatcherEvent& event)
 void clFileSystemWatcher::RemoveFile(const wxFileName& filename)
 {
 #if CL_FSW_USE_TIMER
-    if(m_files.count(filename.GetFullPath())) {
-        m_files.erase(filename.GetFullPath());
+    File::Map_t::iterator iter = m_files.find(filename.GetFullPath());
+    if(iter != m_files.end()) {
+        DoRemoveFile(iter);
     }
 #endif
 }
@@ -172,6 +630,9 @@ void clFileSystemWatcher::RemoveFile(const wxFileName& filename)
 bool clFileSystemWatcher::IsRunning() const
 {
 #if CL_FSW_USE_TIMER
+#if CL_FSW_USE_INOTIFY
+    if(m_inotify) { return true; }
+#endif
     return m_timer;
 #else
     return m_watcher.GetWatchedPathsCount();
@@ -3,7 +3,9 @@
 
 #include "codelite_exports.h"
 #include "clFileSystemEvent.h"
+#include "macros.h"
 #include <map>
+#include <vector>
 #include <wx/timer.h>
 #include <wx/filename.h>
 
@@ -13,24 +15,42 @@
 #define CL_FSW_USE_TIMER 1
 #endif
 
+// On Linux, the watcher is driven by inotify events. The timer is only used when inotify is not available
+#if CL_FSW_USE_TIMER && defined(__linux__)
+#define CL_FSW_USE_INOTIFY 1
+#else
+#define CL_FSW_USE_INOTIFY 0
+#endif
+
 #if !CL_FSW_USE_TIMER
 #include <wx/fswatcher.h>
 #endif
 
+#if CL_FSW_USE_INOTIFY
+class clInotifyWatcher;
+struct clInotifyEvent;
+#endif
+
 class WXDLLIMPEXP_CL clFileSystemWatcher : public wxEvtHandler
 {
 public:
     struct File {
         wxFileName filename;
-        time_t lastModified;
-        size_t file_size;
+        time_t lastModified = 0;
+        size_t file_size = 0;
+        bool fromFolder = false; // found in a folder added with AddFolder()
         typedef std::map<wxString, File> Map_t;
     };
 
     wxEvtHandler* m_owner;
 #if CL_FSW_USE_TIMER
     clFileSystemWatcher::File::Map_t m_files;
+    wxStringSet_t m_folders;
     wxTimer* m_timer;
+#if CL_FSW_USE_INOTIFY
+    clInotifyWatcher* m_inotify;
+    size_t m_inotifyGeneration;
+#endif
 #else
     wxFileSystemWatcher m_watcher;
     wxFileName m_watchedFile;
@@ -42,6 +62,18 @@ public:
 protected:
 #if CL_FSW_USE_TIMER
     void OnTimer(wxTimerEvent& event);
+    void DoCheckFiles();
+    void DoAddFolderFiles(const wxString& folder);
+    File::Map_t::iterator DoRemoveFile(File::Map_t::iterator iter);
+    bool IsInFolder(const wxString& path) const;
+    void NotifyModified(const wxString& path);
+    void NotifyNotFound(const wxString& path);
+#if CL_FSW_USE_INOTIFY
+    friend class clInotifyWatcher;
+    void OnInotifyEvents(size_t generation, const std::vector<clInotifyEvent>& events);
+    void DoWatchFolder(const wxString& folder, std::vector<wxString>* files);
+    void DoRescan();
+#endif
 #else
     void OnFileModified(wxFileSystemWatcherEvent& event);
 #endif
@@ -54,10 +86,22 @@ public:
     wxEvtHandler* GetOwner() { return m_owner; }
 
     /**
-     * @brief add a file to watch
+     * @brief replace the watch list with 'filename'
      */
     void SetFile(const wxFileName& filename);
 
+    /**
+     * @brief add a file to the watch list
+     */
+    void AddFile(const wxFileName& filename);
+
+    /**
+     * @brief watch all the files found under 'folder', recursively. On Linux, files created later
+     * in the folder are watched as well. When polling (no inotify), only the files that exist when
+     * the folder is added are watched
+     */
+    void AddFolder(const wxString& folder);
+
     /**
      * @brief remove file from the watch list
      */
@@ -66,7 +110,7 @@ public:
     /**
      * @brief start to watching list of files.
      * This object fires the following events (clFileSystemEvent):
-     * wxEVT_FILE_MODIFIED, wxEVT_FILE_DELETED
+     * wxEVT_FILE_MODIFIED, wxEVT_FILE_NOT_FOUND
      */
     void Start();
 
@@ -1,10 +1,108 @@
 #include "clFilesCollector.h"
 #include "file_logger.h"
 #include "fileutils.h"
-#include <queue>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 #include <wx/dir.h>
 #include <wx/filename.h>
+#include <wx/thread.h>
 #include <wx/tokenzr.h>
+#ifndef __WXMSW__
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+// Files are passed to the callback in batches of this size
+#define FILES_SCANNER_BATCH_SIZE 500
+// Scanning folders is bound by the file system, more threads than this do not help
+#define FILES_SCANNER_MAX_THREADS 8
+
+namespace
+{
+struct ScanFolder {
+    wxString path;     // the path as reported to the caller
+    wxString realPath; // symbolic links resolved, this is what the excluded folders are compared with
+    std::vector<wxString> linkParents; // real path of the folders holding the links followed to get here
+};
+
+struct FolderEntry {
+    wxString name;
+    bool isDir = false;
+    bool isLink = false;
+};
+
+/**
+ * List the content of 'path'. On POSIX systems the entry type comes from readdir() and only
+ * symbolic links (and file systems without d_type) cost an extra fstatat() relative to the folder
+ */
+bool ListFolder(const wxString& path, std::vector<FolderEntry>& entries)
+{
+    entries.clear();
+#ifndef __WXMSW__
+    DIR* dir = ::opendir(path.fn_str());
+    if(!dir) { return false; }
+
+    int fd = ::dirfd(dir);
+    struct dirent* ent = NULL;
+    while((ent = ::readdir(dir)) != NULL) {
+        const char* name = ent->d_name;
+        if(name[0] == '.' && (name[1] == 0 || (name[1] == '.' && name[2] == 0))) { continue; }
+
+        FolderEntry entry;
+        struct stat st;
+        switch(ent->d_type) {
+        case DT_DIR:
+            entry.isDir = true;
+            break;
+        case DT_UNKNOWN:
+            if(::fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) { break; }
+            if(!S_ISLNK(st.st_mode)) {
+                entry.isDir = S_ISDIR(st.st_mode);
+                break;
+            }
+        // fall through
+        case DT_LNK:
+            // Symbolic links are followed, like wxFileName::DirExists() does
+            entry.isLink = true;
+            entry.isDir = (::fstatat(fd, name, &st, 0) == 0) && S_ISDIR(st.st_mode);
+            break;
+        default:
+            break;
+        }
+        entry.name = wxString(name, *wxConvFileName);
+        entries.push_back(entry);
+    }
+    ::closedir(dir);
+#else
+    wxDir dir(path);
+    if(!dir.IsOpened()) { return false; }
+
+    wxString filename;
+    bool cont = dir.GetFirst(&filename);
+    while(cont) {
+        FolderEntry entry;
+        entry.name = filename;
+        entry.isDir = wxFileName::DirExists(dir.GetNameWithSep() + filename);
+        entries.push_back(entry);
+        cont = dir.GetNext(&filename);
+    }
+#endif
+    return true;
+}
+
+/// Is 'path' equal to 'parent' or one of its sub folders?
+bool IsSameOrSubFolder(const wxString& path, const wxString& parent)
+{
+    if(!path.StartsWith(parent)) { return false; }
+    return path.length() == parent.length() || path[parent.length()] == wxFILE_SEP_PATH ||
+           parent.EndsWith(wxFILE_SEP_PATH);
+}
+} // namespace
 
 clFilesScanner::clFilesScanner() {}
 
@@ -14,6 +112,19 @@ size_t clFilesScanner::Scan(const wxString& rootFolder, std::vector<wxString>& f
                             const wxString& excludeFilespec, const wxStringSet_t& excludeFolders)
 {
     filesOutput.clear();
+    // A single scanner keeps the files in a stable order: folders are scanned breadth first, in their listing order
+    Scan(rootFolder,
+         [&](const std::vector<wxString>& files) {
+             filesOutput.insert(filesOutput.end(), files.begin(), files.end());
+             return true;
+         },
+         filespec, excludeFilespec, excludeFolders, 1);
+    return filesOutput.size();
+}
+
+size_t clFilesScanner::Scan(const wxString& rootFolder, const FilesCallback_t& callback, const wxString& filespec,
+                            const wxString& excludeFilespec, const wxStringSet_t& excludeFolders, size_t threads)
+{
     if(!wxFileName::DirExists(rootFolder)) {
         clDEBUG() << "clFilesScanner: No such dir:" << rootFolder << clEndl;
         return 0;
@@ -21,35 +132,122 @@ size_t clFilesScanner::Scan(const wxString& rootFolder, std::vector<wxString>& f
 
     wxArrayString specArr = ::wxStringTokenize(filespec.Lower(), ";,|", wxTOKEN_STRTOK);
     wxArrayString excludeSpecArr = ::wxStringTokenize(excludeFilespec.Lower(), ";,|", wxTOKEN_STRTOK);
-    std::queue<wxString> Q;
-    Q.push(rootFolder);
-
-    while(!Q.empty()) {
-        wxString dirpath = Q.front();
-        Q.pop();
-
-        wxDir dir(dirpath);
-        if(!dir.IsOpened()) { continue; }
-
-        wxString filename;
-        bool cont = dir.GetFirst(&filename);
-        while(cont) {
-            // Check to see if this is a folder
-            wxString fullpath;
-            fullpath << dir.GetNameWithSep() << filename;
-            bool isDirectory = wxFileName::DirExists(fullpath);
-            // Use FileUtils::RealPath() here to cope with symlinks on Linux
-            if(isDirectory && (excludeFolders.count(FileUtils::RealPath(fullpath)) == 0)) {
-                // Traverse into this folder
-                Q.push(fullpath);
-            } else if(!isDirectory && FileUtils::WildMatch(excludeSpecArr, filename)) {
+
+    if(threads == 0) {
+        int cpus = wxThread::GetCPUCount();
+        threads = (cpus > 0) ? std::min((size_t)cpus, (size_t)FILES_SCANNER_MAX_THREADS) : 1;
+    }
+
+    // Folders waiting to be scanned. The scan is complete when the queue is empty and no thread
+    // is busy scanning a folder (which could add more folders to the queue)
+    std::mutex queueLock;
+    std::condition_variable queueCond;
+    std::deque<ScanFolder> queue;
+    size_t busy = 0;
+    std::atomic_bool stop(false);
+
+    std::mutex callbackLock;
+    size_t filesFound = 0;
+
+    ScanFolder root;
+    root.path = rootFolder;
+    // Use FileUtils::RealPath() here to cope with symlinks on Linux
+    root.realPath = FileUtils::RealPath(rootFolder);
+    queue.push_back(root);
+
+    auto flush = [&](std::vector<wxString>& batch) {
+        if(batch.empty()) { return; }
+        std::lock_guard<std::mutex> locker(callbackLock);
+        if(!stop.load()) {
+            filesFound += batch.size();
+            if(!callback(batch)) {
+                std::lock_guard<std::mutex> queueLocker(queueLock);
+                stop.store(true);
+                queueCond.notify_all();
+            }
+        }
+        batch.clear();
+    };
+
+    auto scanFolder = [&](const ScanFolder& folder, std::vector<FolderEntry>& entries,
+                          std::vector<ScanFolder>& subFolders, std::vector<wxString>& batch) {
+        if(!ListFolder(folder.path, entries)) { return; }
+
+        wxString prefix = folder.path;
+        if(!prefix.EndsWith(wxFILE_SEP_PATH)) { prefix << wxFILE_SEP_PATH; }
+        wxString realPrefix = folder.realPath;
+        if(!realPrefix.EndsWith(wxFILE_SEP_PATH)) { realPrefix << wxFILE_SEP_PATH; }
+
+        for(const FolderEntry& entry : entries) {
+            if(entry.isDir) {
+                ScanFolder subFolder;
+                subFolder.path = prefix + entry.name;
+                // Only symbolic links need resolving, any other folder is located below its parent real path
+                subFolder.realPath = entry.isLink ? FileUtils::RealPath(subFolder.path) : realPrefix + entry.name;
+                if(excludeFolders.count(subFolder.realPath)) { continue; }
+
+                subFolder.linkParents = folder.linkParents;
+                if(entry.isLink) {
+                    // A link to a folder that leads back here would be followed forever
+                    bool loop = std::any_of(
+                        folder.linkParents.begin(), folder.linkParents.end(),
+                        [&](const wxString& path) { return IsSameOrSubFolder(path, subFolder.realPath); });
+                    if(loop || IsSameOrSubFolder(folder.realPath, subFolder.realPath)) { continue; }
+                    subFolder.linkParents.push_back(folder.realPath);
+                }
+                subFolders.push_back(subFolder);
+
+            } else if(FileUtils::WildMatch(excludeSpecArr, entry.name)) {
                 // Do nothing
-            } else if(!isDirectory && FileUtils::WildMatch(specArr, filename)) {
+            } else if(FileUtils::WildMatch(specArr, entry.name)) {
                 // Include this file
-                filesOutput.push_back(fullpath);
+                batch.push_back(prefix + entry.name);
             }
-            cont = dir.GetNext(&filename);
         }
+    };
+
+    auto worker = [&]() {
+        std::vector<wxString> batch;
+        std::vector<FolderEntry> entries;
+        std::vector<ScanFolder> subFolders;
+
+        std::unique_lock<std::mutex> locker(queueLock);
+        while(true) {
+            if(queue.empty() && busy > 0 && !batch.empty()) {
+                // Nothing to do for now: deliver what we have before waiting
+                locker.unlock();
+                flush(batch);
+                locker.lock();
+            }
+            queueCond.wait(locker, [&]() { return stop.load() || !queue.empty() || busy == 0; });
+            if(stop.load() || queue.empty()) { break; }
+
+            ScanFolder folder = queue.front();
+            queue.pop_front();
+            ++busy;
+            locker.unlock();
+
+            subFolders.clear();
+            scanFolder(folder, entries, subFolders, batch);
+            if(batch.size() >= FILES_SCANNER_BATCH_SIZE) { flush(batch); }
+
+            locker.lock();
+            --busy;
+            queue.insert(queue.end(), subFolders.begin(), subFolders.end());
+            queueCond.notify_all();
+        }
+        locker.unlock();
+        flush(batch);
+    };
+
+    // The calling thread is one of the scanners
+    std::vector<std::thread> pool;
+    for(size_t i = 1; i < threads; ++i) {
+        pool.push_back(std::thread(worker));
     }
-    return filesOutput.size();
-}
\ No newline at end of file
+    worker();
+    for(std::thread& thr : pool) {
+        thr.join();
+    }
+    return filesFound;
+}
@@ -3,17 +3,26 @@
 
 #include "codelite_exports.h"
 #include "macros.h"
+#include <functional>
 #include <vector>
 #include <wx/string.h>
 
 class WXDLLIMPEXP_CL clFilesScanner
 {
+public:
+    /**
+     * @brief receives the files found by the scan, in batches. Batches are delivered from the scanner
+     * threads, one at a time. Return false to stop the scan
+     */
+    typedef std::function<bool(const std::vector<wxString>&)> FilesCallback_t;
+
 public:
     clFilesScanner();
     virtual ~clFilesScanner();
 
     /**
-     * @brief collect all files matching a given pattern from a root folder
+     * @brief collect all files matching a given pattern from a root folder. The folders are scanned by the calling
+     * thread, breadth first
      * @param rootFolder the scan root folder
      * @param filesOutput [output] output result full path entries
      * @param filespec files spec
@@ -22,6 +31,16 @@ public:
      */
     size_t Scan(const wxString& rootFolder, std::vector<wxString>& filesOutput, const wxString& filespec = "",
                 const wxString& excludeFilespec = "", const wxStringSet_t& excludeFolders = wxStringSet_t());
+
+    /**
+     * @brief same as above, but the matching files are passed to 'callback' while the scan is running.
+     * Sub folders are scanned in parallel, so the files are not delivered in any particular order
+     * @param threads number of threads scanning folders (0 means: pick one based on the number of CPUs)
+     * @return number of files found
+     */
+    size_t Scan(const wxString& rootFolder, const FilesCallback_t& callback, const wxString& filespec = "",
+                const wxString& excludeFilespec = "", const wxStringSet_t& excludeFolders = wxStringSet_t(),
+                size_t threads = 0);
 };
 
 #endif // CLFILESCOLLECTOR_H
@@ -0,0 +1,995 @@
+#include "clRegexEngine.h"
+#include <vector>
+#include <wx/regex.h>
+#include <wx/wxcrt.h>
+
+namespace
+{
+//----------------------------------------------------------------
+// wxRegEx backend
+//----------------------------------------------------------------
+
+class clWxRegexEngine : public clRegexEngine
+{
+    wxRegEx m_regex;
+
+public:
+    clWxRegexEngine()
+        : clRegexEngine(kWxRegEx)
+    {
+    }
+    virtual ~clWxRegexEngine() {}
+
+    bool Compile(const wxString& pattern, bool matchCase)
+    {
+#ifndef __WXMAC__
+        int flags = wxRE_ADVANCED;
+#else
+        int flags = wxRE_DEFAULT;
+#endif
+        // '.' and '[^...]' do not match newlines, '^' and '$' match at line boundaries
+        flags |= wxRE_NEWLINE;
+        if(!matchCase) flags |= wxRE_ICASE;
+        return m_regex.Compile(pattern, flags);
+    }
+
+    bool IsValid() const { return m_regex.IsValid(); }
+
+    bool Find(const wxString& text, size_t from, size_t& start, size_t& len)
+    {
+        if(!m_regex.IsValid() || from > text.length()) { return false; }
+        const wxChar* buffer = text.wx_str();
+        int flags = (from > 0 && buffer[from - 1] != '\n') ? wxRE_NOTBOL : 0;
+        if(!m_regex.Matches(buffer + from, flags, text.length() - from)) { return false; }
+        if(!m_regex.GetMatch(&start, &len)) { return false; }
+        start += from;
+        return true;
+    }
+};
+
+//----------------------------------------------------------------
+// Linear backend
+//----------------------------------------------------------------
+
+enum eClassFlags {
+    kClassDigit = (1 << 0),
+    kClassWord = (1 << 1),
+    kClassSpace = (1 << 2),
+    kClassAlpha = (1 << 3),
+    kClassAlnum = (1 << 4),
+    kClassUpper = (1 << 5),
+    kClassLower = (1 << 6),
+    kClassXDigit = (1 << 7),
+    kClassPunct = (1 << 8),
+};
+
+enum eAssertion {
+    kLineBegin,
+    kLineEnd,
+    kWordBoundary,
+    kNotWordBoundary,
+    kWordBegin,
+    kWordEnd,
+};
+
+inline bool IsWordChar(wxChar ch) { return ch == '_' || wxIsalnum(ch); }
+
+struct CharClass {
+    std::vector<std::pair<wxChar, wxChar> > ranges;
+    int flags = 0;
+    bool negated = false;
+
+    bool DoContains(wxChar ch) const
+    {
+        for(size_t i = 0; i < ranges.size(); ++i) {
+            if(ch >= ranges[i].first && ch <= ranges[i].second) { return true; }
+        }
+        if(flags == 0) { return false; }
+        if((flags & kClassDigit) && wxIsdigit(ch)) { return true; }
+        if((flags & kClassWord) && IsWordChar(ch)) { return true; }
+        if((flags & kClassSpace) && wxIsspace(ch)) { return true; }
+        if((flags & kClassAlpha) && wxIsalpha(ch)) { return true; }
+        if((flags & kClassAlnum) && wxIsalnum(ch)) { return true; }
+        if((flags & kClassUpper) && wxIsupper(ch)) { return true; }
+        if((flags & kClassLower) && wxIslower(ch)) { return true; }
+        if((flags & kClassXDigit) && wxIsxdigit(ch)) { return true; }
+        if((flags & kClassPunct) && wxIspunct(ch)) { return true; }
+        return false;
+    }
+
+    bool Contains(wxChar ch, bool ignoreCase) const
+    {
+        bool found = DoContains(ch);
+        if(!found && ignoreCase) { found = DoContains(wxTolower(ch)) || DoContains(wxToupper(ch)); }
+        return found != negated;
+    }
+};
+
+/// Regular expression syntax tree
+struct Node {
+    enum eKind {
+        kEmpty,
+        kLiteral,
+        kAnyChar,
+        kCharClass,
+        kAssert,
+        kConcat,
+        kAlternate,
+        kRepeat,
+    };
+    typedef std::shared_ptr<Node> Ptr_t;
+
+    eKind kind;
+    wxChar ch = 0;
+    int index = 0; // kCharClass: class index, kAssert: the assertion
+    int min = 0;
+    int max = 0; // -1: unbounded
+    bool greedy = true;
+    std::vector<Node::Ptr_t> children;
+
+    Node(eKind k)
+        : kind(k)
+    {
+    }
+};
+
+// Counted repetitions are expanded: keep the programs small. wxRegEx rejects bounds above 255 anyway
+#define REGEX_MAX_REPEAT 255
+#define REGEX_MAX_INSTRUCTIONS 20000
+
+/**
+ * Parse the advanced regular expressions (ARE) syntax of wxRegEx, escapes included (e.g. '\y' is a word
+ * boundary and '\b' a backspace). Anything else (back references, look-around, constraint escapes
+ * inside brackets, invalid bounds) makes the parse fail so the caller can fall back to wxRegEx
+ */
+class RegexParser
+{
+    const wxString& m_pattern;
+    size_t m_pos = 0;
+    std::vector<CharClass>& m_classes;
+    bool m_failed = false;
+    bool m_hasGreedy = false;
+    bool m_hasLazy = false;
+    bool m_hasAlternation = false;
+
+    bool AtEnd() const { return m_pos >= m_pattern.length(); }
+    wxChar Peek() const { return AtEnd() ? 0 : (wxChar)m_pattern[m_pos]; }
+
+    Node::Ptr_t Fail()
+    {
+        m_failed = true;
+        return Node::Ptr_t(new Node(Node::kEmpty));
+    }
+
+    Node::Ptr_t MakeClass(const CharClass& cc)
+    {
+        Node::Ptr_t node(new Node(Node::kCharClass));
+        node->index = (int)m_classes.size();
+        m_classes.push_back(cc);
+        return node;
+    }
+
+    Node::Ptr_t MakeAssert(int assertion)
+    {
+        Node::Ptr_t node(new Node(Node::kAssert));
+        node->index = assertion;
+        return node;
+    }
+
+    /// Parse between 'minDigits' and 'maxDigits' hexadecimal digits
+    bool ParseHex(size_t minDigits, size_t maxDigits, wxChar& ch)
+    {
+        unsigned long value = 0;
+        size_t digits = 0;
+        while(digits < maxDigits && !AtEnd() && wxIsxdigit(Peek())) {
+            wxChar c = wxTolower(m_pattern[m_pos++]);
+            value = value * 16 + (wxIsdigit(c) ? c - '0' : c - 'a' + 10);
+            // Not a character
+            if(value > 0x10FFFF || (sizeof(wxChar) == 2 && value > 0xFFFF)) { return false; }
+            ++digits;
+        }
+        if(digits < minDigits) { return false; }
+        ch = (wxChar)value;
+        return true;
+    }
+
+    bool IsQuantifier() const
+    {
+        wxChar c = Peek();
+        return c == '*' || c == '+' || c == '?' ||
+               (c == '{' && m_pos + 1 < m_pattern.length() && wxIsdigit(m_pattern[m_pos + 1]));
+    }
+
+    /// Parse the escape following a '\'. Return the class flags for \d, \w, \s (negated flag is set for
+    /// their upper case forms), 0 for a literal character stored in 'ch' and -1 on error
+    int ParseEscape(wxChar& ch, bool& negated)
+    {
+        negated = false;
+        if(AtEnd()) { return -1; }
+        wxChar c = m_pattern[m_pos++];
+        switch(c) {
+        case 'd':
+        case 'D':
+            negated = (c == 'D');
+            return kClassDigit;
+        case 'w':
+        case 'W':
+            negated = (c == 'W');
+            return kClassWord;
+        case 's':
+        case 'S':
+            negated = (c == 'S');
+            return kClassSpace;
+        case 'n':
+            ch = '\n';
+            return 0;
+        case 't':
+            ch = '\t';
+            return 0;
+        case 'r':
+            ch = '\r';
+            return 0;
+        case 'f':
+            ch = '\f';
+            return 0;
+        case 'v':
+            ch = '\v';
+            return 0;
+        case 'b':
+            ch = '\b';
+            return 0;
+        case 'x':
+            // As many digits as there are, like wxRegEx
+            return ParseHex(1, m_pattern.length(), ch) ? 0 : -1;
+        case 'u':
+            return ParseHex(4, 4, ch) ? 0 : -1;
+        default:
+            // Escaped punctuation is a literal, any other escape is not supported
+            if(wxIsalnum(c)) { return -1; }
+            ch = c;
+            return 0;
+        }
+    }
+
+    Node::Ptr_t ParseClass()
+    {
+        CharClass cc;
+        if(Peek() == '^') {
+            cc.negated = true;
+            ++m_pos;
+        }
+
+        bool first = true;
+        while(!AtEnd() && (Peek() != ']' || first)) {
+            first = false;
+            wxChar from = m_pattern[m_pos++];
+            if(from == '[' && Peek() == ':') {
+                // POSIX class
+                size_t end = m_pattern.find(":]", m_pos + 1);
+                if(end == wxString::npos) { return Fail(); }
+                wxString name = m_pattern.Mid(m_pos + 1, end - m_pos - 1);
+                m_pos = end + 2;
+                if(name == "digit") {
+                    cc.flags |= kClassDigit;
+                } else if(name == "alpha") {
+                    cc.flags |= kClassAlpha;
+                } else if(name == "alnum") {
+                    cc.flags |= kClassAlnum;
+                } else if(name == "space") {
+                    cc.flags |= kClassSpace;
+                } else if(name == "upper") {
+                    cc.flags |= kClassUpper;
+                } else if(name == "lower") {
+                    cc.flags |= kClassLower;
+                } else if(name == "xdigit") {
+                    cc.flags |= kClassXDigit;
+                } else if(name == "punct") {
+                    cc.flags |= kClassPunct;
+                } else {
+                    return Fail();
+                }
+                continue;
+
+            } else if(from == '\\') {
+                bool negated;
+                int flags = ParseEscape(from, negated);
+                if(flags < 0 || negated) { return Fail(); }
+                if(flags) {
+                    cc.flags |= flags;
+                    continue;
+                }
+            }
+
+            wxChar to = from;
+            if(Peek() == '-' && m_pos + 1 < m_pattern.length() && m_pattern[m_pos + 1] != ']') {
+                ++m_pos;
+                to = m_pattern[m_pos++];
+                if(to == '\\') {
+                    bool negated;
+                    if(ParseEscape(to, negated) != 0) { return Fail(); }
+                } else if(to == '[') {
+                    return Fail();
+                }
+                if(to < from) { return Fail(); }
+            }
+            cc.ranges.push_back(std::make_pair(from, to));
+        }
+
+        if(AtEnd()) { return Fail(); }
+        ++m_pos; // ']'
+        return MakeClass(cc);
+    }
+
+    /// Parse an escape outside of a bracket expression: a constraint, a class or a literal
+    Node::Ptr_t ParseBackslash()
+    {
+        switch(Peek()) {
+        case 'y':
+            ++m_pos;
+            return MakeAssert(kWordBoundary);
+        case 'Y':
+            ++m_pos;
+            return MakeAssert(kNotWordBoundary);
+        case 'm':
+            ++m_pos;
+            return MakeAssert(kWordBegin);
+        case 'M':
+            ++m_pos;
+            return MakeAssert(kWordEnd);
+        default:
+            break;
+        }
+
+        wxChar ch = 0;
+        bool negated;
+        int flags = ParseEscape(ch, negated);
+        if(flags < 0) { return Fail(); }
+        if(flags) {
+            CharClass cc;
+            cc.flags = flags;
+            cc.negated = negated;
+            return MakeClass(cc);
+        }
+        Node::Ptr_t node(new Node(Node::kLiteral));
+        node->ch = ch;
+        return node;
+    }
+
+    Node::Ptr_t ParseAtom()
+    {
+        wxChar c = m_pattern[m_pos++];
+        switch(c) {
+        case '(': {
+            if(Peek() == '?') {
+                // Only non capturing groups are supported
+                if(m_pos + 1 >= m_pattern.length() || m_pattern[m_pos + 1] != ':') { return Fail(); }
+                m_pos += 2;
+            }
+            Node::Ptr_t node = ParseAlternate();
+            if(Peek() != ')') { return Fail(); }
+            ++m_pos;
+            return node;
+        }
+        case '[':
+            return ParseClass();
+        case '.':
+            return Node::Ptr_t(new Node(Node::kAnyChar));
+        case '^':
+            return MakeAssert(kLineBegin);
+        case '$':
+            return MakeAssert(kLineEnd);
+        case '*':
+        case '+':
+        case '?':
+            // Nothing to repeat
+            return Fail();
+        case '{':
+            // A '{' followed by a digit starts a bound, with nothing to repeat
+            if(wxIsdigit(Peek())) { return Fail(); }
+            break;
+        case '\\':
+            return ParseBackslash();
+        default:
+            break;
+        }
+
+        Node::Ptr_t node(new Node(Node::kLiteral));
+        node->ch = c;
+        return node;
+    }
+
+    /// Parse a "{n}", "{n,}" or "{n,m}" quantifier. A '{' that does not start one is a literal
+    bool ParseBraces(int& min, int& max)
+    {
+        size_t end = m_pattern.find('}', m_pos);
+        if(end == wxString::npos) { return false; }
+        wxString spec = m_pattern.Mid(m_pos + 1, end - m_pos - 1);
+        wxString minStr = spec.BeforeFirst(',');
+        long n, m;
+        if(minStr.IsEmpty() || !minStr.ToLong(&n)) { return false; }
+        if(spec.Find(',') == wxNOT_FOUND) {
+            m = n;
+        } else if(spec.AfterFirst(',').IsEmpty()) {
+            m = -1;
+        } else if(!spec.AfterFirst(',').ToLong(&m)) {
+            return false;
+        }
+        m_pos = end + 1;
+        if(n < 0 || n > REGEX_MAX_REPEAT || m > REGEX_MAX_REPEAT || (m != -1 && m < n)) {
+            m_failed = true;
+            return true;
+        }
+        min = (int)n;
+        max = (int)m;
+        return true;
+    }
+
+    Node::Ptr_t ParseRepeat()
+    {
+        Node::Ptr_t atom = ParseAtom();
+        while(!AtEnd() && !m_failed) {
+            int min, max;
+            wxChar c = Peek();
+            if(c == '*') {
+                min = 0;
+                max = -1;
+                ++m_pos;
+            } else if(c == '+') {
+                min = 1;
+                max = -1;
+                ++m_pos;
+            } else if(c == '?') {
+                min = 0;
+                max = 1;
+                ++m_pos;
+            } else if(c == '{' && IsQuantifier()) {
+                // wxRegEx rejects an invalid bound
+                if(!ParseBraces(min, max)) { m_failed = true; }
+                if(m_failed) { break; }
+            } else {
+                break;
+            }
+
+            Node::Ptr_t node(new Node(Node::kRepeat));
+            node->min = min;
+            node->max = max;
+            if(Peek() == '?') {
+                node->greedy = false;
+                ++m_pos;
+            }
+            (node->greedy ? m_hasGreedy : m_hasLazy) = true;
+            node->children.push_back(atom);
+            atom = node;
+
+            // A quantifier can not be quantified ("a**")
+            if(IsQuantifier()) { m_failed = true; }
+        }
+        return atom;
+    }
+
+    Node::Ptr_t ParseConcat()
+    {
+        Node::Ptr_t node(new Node(Node::kConcat));
+        while(!AtEnd() && !m_failed && Peek() != '|' && Peek() != ')') {
+            node->children.push_back(ParseRepeat());
+        }
+        return node;
+    }
+
+    Node::Ptr_t ParseAlternate()
+    {
+        Node::Ptr_t first = ParseConcat();
+        if(Peek() != '|') { return first; }
+
+        m_hasAlternation = true;
+        Node::Ptr_t node(new Node(Node::kAlternate));
+        node->children.push_back(first);
+        while(!m_failed && Peek() == '|') {
+            ++m_pos;
+            node->children.push_back(ParseConcat());
+        }
+        return node;
+    }
+
+public:
+    RegexParser(const wxString& pattern, std::vector<CharClass>& classes)
+        : m_pattern(pattern)
+        , m_classes(classes)
+    {
+    }
+
+    Node::Ptr_t Parse()
+    {
+        Node::Ptr_t node = ParseAlternate();
+        // An unbalanced ')'
+        if(!AtEnd()) { m_failed = true; }
+        return m_failed ? Node::Ptr_t() : node;
+    }
+
+    /**
+     * @brief does the whole expression prefer the longest match (rather than the shortest one) among the
+     * matches starting at the leftmost position? wxRegEx takes the preference of the first quantifier with
+     * one, and an alternation prefers the longest match. When lazy quantifiers are mixed with greedy ones or
+     * with an alternation, the preference depends on where they appear: 'ambiguous' is set
+     */
+    bool PrefersLongest(bool& ambiguous) const
+    {
+        ambiguous = m_hasLazy && (m_hasGreedy || m_hasAlternation);
+        return !m_hasLazy;
+    }
+};
+
+/**
+ * Regular expressions compiled into a program for a Pike VM: every character of the text is
+ * examined once by each live thread, and there is at most one thread per instruction.
+ * Like wxRegEx, the match is the one starting first in the text, and among those the longest
+ * (or the shortest, for expressions using only lazy quantifiers)
+ */
+class clLinearRegexEngine : public clRegexEngine
+{
+    enum eOpcode {
+        kChar,
+        kAny,
+        kClass,
+        kSplit,
+        kJmp,
+        kAssert,
+        kMatch,
+    };
+
+    struct Instruction {
+        eOpcode op;
+        wxChar ch;
+        int x; // kJmp, kSplit: preferred target. kClass: the class index. kAssert: the assertion
+        int y; // kSplit: second target
+
+        Instruction(eOpcode o, int a = 0, int b = 0, wxChar c = 0)
+            : op(o)
+            , ch(c)
+            , x(a)
+            , y(b)
+        {
+        }
+    };
+
+    /// The threads of one step: instructions in priority order, each with the start of its match
+    struct ThreadList {
+        std::vector<int> pcs;
+        std::vector<size_t> starts;
+        std::vector<unsigned> marks;
+        unsigned generation = 1;
+
+        void Reset(size_t size)
+        {
+            pcs.clear();
+            starts.clear();
+            marks.assign(size, 0);
+            generation = 1;
+        }
+
+        void Clear()
+        {
+            pcs.clear();
+            starts.clear();
+            if(++generation == 0) {
+                marks.assign(marks.size(), 0);
+                generation = 1;
+            }
+        }
+    };
+
+    std::vector<Instruction> m_program;
+    std::vector<CharClass> m_classes;
+    std::vector<int> m_stack;
+    wxString m_prefix; // literal every match starts with (case sensitive patterns)
+    bool m_ignoreCase = false;
+    bool m_longest = true;
+    bool m_valid = false;
+    ThreadList m_clist;
+    ThreadList m_nlist;
+
+    int Emit(const Instruction& ins)
+    {
+        m_program.push_back(ins);
+        return (int)m_program.size() - 1;
+    }
+
+    bool DoCompile(Node::Ptr_t node)
+    {
+        if(m_program.size() > REGEX_MAX_INSTRUCTIONS) { return false; }
+        switch(node->kind) {
+        case Node::kEmpty:
+            return true;
+        case Node::kLiteral:
+            Emit(Instruction(kChar, 0, 0, m_ignoreCase ? (wxChar)wxTolower(node->ch) : node->ch));
+            return true;
+        case Node::kAnyChar:
+            Emit(Instruction(kAny));
+            return true;
+        case Node::kCharClass:
+            Emit(Instruction(kClass, node->index));
+            return true;
+        case Node::kAssert:
+            Emit(Instruction(kAssert, node->index));
+            return true;
+        case Node::kConcat:
+            for(size_t i = 0; i < node->children.size(); ++i) {
+                if(!DoCompile(node->children[i])) { return false; }
+            }
+            return true;
+        case Node::kAlternate: {
+            // split L1, L2; L1: e1; jmp end; L2: split ... ; Ln: en; end:
+            std::vector<int> jumps;
+            for(size_t i = 0; i < node->children.size(); ++i) {
+                int split = -1;
+                if(i + 1 < node->children.size()) { split = Emit(Instruction(kSplit)); }
+                if(split != -1) { m_program[split].x = split + 1; }
+                if(!DoCompile(node->children[i])) { return false; }
+                if(split != -1) {
+                    jumps.push_back(Emit(Instruction(kJmp)));
+                    m_program[split].y = (int)m_program.size();
+                }
+            }
+            for(size_t i = 0; i < jumps.size(); ++i) {
+                m_program[jumps[i]].x = (int)m_program.size();
+            }
+            return true;
+        }
+        case Node::kRepeat: {
+            Node::Ptr_t body = node->children[0];
+            for(int i = 0; i < node->min; ++i) {
+                if(!DoCompile(body)) { return false; }
+            }
+            if(node->max == -1) {
+                // L: split body, end; body; jmp L; end:
+                int split = Emit(Instruction(kSplit));
+                if(!DoCompile(body)) { return false; }
+                Emit(Instruction(kJmp, split));
+                int end = (int)m_program.size();
+                m_program[split].x = node->greedy ? split + 1 : end;
+                m_program[split].y = node->greedy ? end : split + 1;
+            } else {
+                // Optional copies: split body, end; body; split body, end; body ... end:
+                std::vector<int> splits;
+                for(int i = node->min; i < node->max; ++i) {
+                    splits.push_back(Emit(Instruction(kSplit)));
+                    if(!DoCompile(body)) { return false; }
+                }
+                int end = (int)m_program.size();
+                for(size_t i = 0; i < splits.size(); ++i) {
+                    m_program[splits[i]].x = node->greedy ? splits[i] + 1 : end;
+                    m_program[splits[i]].y = node->greedy ? end : splits[i] + 1;
+                }
+            }
+            return true;
+        }
+        }
+        return false;
+    }
+
+    bool CheckAssertion(int assertion, const wxChar* text, size_t len, size_t pos) const
+    {
+        switch(assertion) {
+        case kLineBegin:
+            return pos == 0 || text[pos - 1] == '\n';
+        case kLineEnd:
+            return pos == len || text[pos] == '\n';
+        case kWordBoundary:
+        case kNotWordBoundary: {
+            bool before = pos > 0 && IsWordChar(text[pos - 1]);
+            bool after = pos < len && IsWordChar(text[pos]);
+            return (before != after) == (assertion == kWordBoundary);
+        }
+        case kWordBegin:
+            return (pos == 0 || !IsWordChar(text[pos - 1])) && (pos < len && IsWordChar(text[pos]));
+        case kWordEnd:
+            return (pos > 0 && IsWordChar(text[pos - 1])) && (pos == len || !IsWordChar(text[pos]));
+        }
+        return false;
+    }
+
+    /// Add the thread at 'pc' and everything reachable from it without consuming a character
+    void AddThread(ThreadList& list, int pc, size_t start, const wxChar* text, size_t len, size_t pos)
+    {
+        m_stack.clear();
+        m_stack.push_back(pc);
+        while(!m_stack.empty()) {
+            pc = m_stack.back();
+            m_stack.pop_back();
+            if(list.marks[pc] == list.generation) { continue; }
+            list.marks[pc] = list.generation;
+
+            const Instruction& ins = m_program[pc];
+            switch(ins.op) {
+            case kJmp:
+                m_stack.push_back(ins.x);
+                break;
+            case kSplit:
+                // 'x' has the priority: it is popped first
+                m_stack.push_back(ins.y);
+                m_stack.push_back(ins.x);
+                break;
+            case kAssert:
+                if(CheckAssertion(ins.x, text, len, pos)) { m_stack.push_back(pc + 1); }
+                break;
+            default:
+                list.pcs.push_back(pc);
+                list.starts.push_back(start);
+                break;
+            }
+        }
+    }
+
+public:
+    clLinearRegexEngine()
+        : clRegexEngine(kLinear)
+    {
+    }
+    virtual ~clLinearRegexEngine() {}
+
+    bool Compile(const wxString& pattern, bool matchCase)
+    {
+        m_valid = false;
+        m_program.clear();
+        m_classes.clear();
+        m_prefix.clear();
+        m_ignoreCase = !matchCase;
+
+        RegexParser parser(pattern, m_classes);
+        Node::Ptr_t root = parser.Parse();
+        bool ambiguous = false;
+        if(root) { m_longest = parser.PrefersLongest(ambiguous); }
+        if(!root || ambiguous || !DoCompile(root) || m_program.size() > REGEX_MAX_INSTRUCTIONS) {
+            m_program.clear();
+            return false;
+        }
+        Emit(Instruction(kMatch));
+
+        // A literal prefix lets Find() skip to the candidate positions
+        if(!m_ignoreCase) {
+            for(size_t i = 0; i < m_program.size() && m_program[i].op == kChar; ++i) {
+                m_prefix << m_program[i].ch;
+            }
+        }
+
+        m_clist.Reset(m_program.size());
+        m_nlist.Reset(m_program.size());
+        m_valid = true;
+        return true;
+    }
+
+    bool IsValid() const { return m_valid; }
+
+    bool Find(const wxString& text, size_t from, size_t& start, size_t& len)
+    {
+        if(!m_valid || from > text.length()) { return false; }
+
+        const wxChar* buffer = text.wx_str();
+        size_t textLen = text.length();
+        bool matched = false;
+
+        m_clist.Clear();
+        for(size_t pos = from;; ++pos) {
+            if(!matched) {
+                if(m_clist.pcs.empty() && !m_prefix.IsEmpty()) {
+                    pos = text.find(m_prefix, pos);
+                    if(pos == wxString::npos) { break; }
+                }
+                // Threads are kept in the order of their start position: a thread starting here is
+                // dropped when it reaches an instruction already reached by a thread that started earlier
+                AddThread(m_clist, 0, pos, buffer, textLen, pos);
+            }
+            bool atEnd = (pos >= textLen);
+            if(m_clist.pcs.empty()) {
+                if(matched || atEnd) { break; }
+                // Nothing alive (e.g. a failed '^'): try again from the next position
+                m_clist.Clear();
+                continue;
+            }
+
+            wxChar ch = atEnd ? 0 : buffer[pos];
+            // Matches never span lines
+            bool canConsume = !atEnd && ch != '\n';
+            wxChar folded = (canConsume && m_ignoreCase) ? (wxChar)wxTolower(ch) : ch;
+
+            m_nlist.Clear();
+            for(size_t i = 0; i < m_clist.pcs.size(); ++i) {
+                size_t threadStart = m_clist.starts[i];
+                // Once a match is found, only the threads that may still find a better one are kept:
+                // those that started before it, and for the longest match those that started with it
+                if(matched && (threadStart > start || (threadStart == start && !m_longest))) { continue; }
+
+                const Instruction& ins = m_program[m_clist.pcs[i]];
+                bool advance = false;
+                switch(ins.op) {
+                case kChar:
+                    advance = canConsume && ins.ch == folded;
+                    break;
+                case kAny:
+                    advance = canConsume;
+                    break;
+                case kClass:
+                    advance = canConsume && m_classes[ins.x].Contains(ch, m_ignoreCase);
+                    break;
+                case kMatch:
+                    // The matches of a thread are found in increasing length
+                    if(!matched || threadStart < start || (threadStart == start && m_longest)) {
+                        start = threadStart;
+                        len = pos - threadStart;
+                    }
+                    matched = true;
+                    break;
+                default:
+                    break;
+                }
+                if(advance) { AddThread(m_nlist, m_clist.pcs[i] + 1, threadStart, buffer, textLen, pos + 1); }
+            }
+            std::swap(m_clist, m_nlist);
+            if(atEnd) { break; }
+        }
+        return matched;
+    }
+};
+
+//----------------------------------------------------------------
+// Required literal
+//----------------------------------------------------------------
+
+struct LiteralRun {
+    wxString run;  // the literal being collected
+    wxString best; // the longest literal found so far at this level (including the nested groups)
+    bool alternation = false;
+
+    void Break()
+    {
+        if(run.length() > best.length()) { best = run; }
+        run.clear();
+    }
+};
+} // namespace
+
+clRegexEngine::Ptr_t clRegexEngine::New(eType type)
+{
+    switch(type) {
+    case kLinear:
+        return clRegexEngine::Ptr_t(new clLinearRegexEngine());
+    case kWxRegEx:
+    default:
+        return clRegexEngine::Ptr_t(new clWxRegexEngine());
+    }
+}
+
+clRegexEngine::Ptr_t clRegexEngine::New(const wxString& pattern, bool matchCase)
+{
+    clRegexEngine::Ptr_t engine = New(kLinear);
+    if(engine->Compile(pattern, matchCase)) { return engine; }
+
+    engine = New(kWxRegEx);
+    engine->Compile(pattern, matchCase);
+    return engine;
+}
+
+wxString clRegexEngine::GetRequiredLiteral(const wxString& pattern)
+{
+    // Directors ("***=" and "***:") change the meaning of the whole pattern
+    if(pattern.StartsWith("***")) { return ""; }
+
+    // One entry per open group. A group that contains an alternation or that may be skipped (its quantifier
+    // allows zero matches) does not require any of its literals
+    std::vector<LiteralRun> levels(1);
+    bool lastWasLiteral = false;
+    size_t i = 0;
+    while(i < pattern.length()) {
+        wxChar ch = pattern[i];
+        LiteralRun& level = levels.back();
+        switch(ch) {
+        case '\\':
+            if(i + 1 == pattern.length()) { return ""; }
+            if(wxIsalnum(pattern[i + 1])) {
+                // A class shorthand, a back reference or a constraint escape
+                level.Break();
+                lastWasLiteral = false;
+            } else {
+                level.run << (wxChar)wxTolower(pattern[i + 1]);
+                lastWasLiteral = true;
+            }
+            i += 2;
+            break;
+        case '[': {
+            // Skip the bracket expression: a ']' right after "[" or "[^" is part of it
+            ++i;
+            if(i < pattern.length() && pattern[i] == '^') { ++i; }
+            if(i < pattern.length() && pattern[i] == ']') { ++i; }
+            while(i < pattern.length() && pattern[i] != ']') {
+                if(pattern[i] == '[' && i + 1 < pattern.length() &&
+                   (pattern[i + 1] == ':' || pattern[i + 1] == '.' || pattern[i + 1] == '=')) {
+                    // [:alpha:], [.x.] or [=x=]
+                    int end = pattern.find(wxString() << pattern[i + 1] << ']', i + 2);
+                    if(end == wxNOT_FOUND) { return ""; }
+                    i = end + 2;
+                } else {
+                    ++i;
+                }
+            }
+            if(i == pattern.length()) { return ""; }
+            ++i;
+            level.Break();
+            lastWasLiteral = false;
+            break;
+        }
+        case '(':
+            // Lookaheads, non capturing groups and embedded options: don't bother
+            if(i + 1 < pattern.length() && pattern[i + 1] == '?') { return ""; }
+            level.Break();
+            levels.push_back(LiteralRun());
+            lastWasLiteral = false;
+            ++i;
+            break;
+        case ')': {
+            if(levels.size() == 1) { return ""; }
+            LiteralRun group = levels.back();
+            levels.pop_back();
+            group.Break();
+            ++i;
+
+            bool optional = false;
+            if(i < pattern.length()) {
+                wxChar next = pattern[i];
+                optional = next == '?' || next == '*' ||
+                           (next == '{' && i + 1 < pattern.length() && pattern[i + 1] == '0');
+            }
+            if(!group.alternation && !optional && group.best.length() > levels.back().best.length()) {
+                levels.back().best = group.best;
+            }
+            lastWasLiteral = false;
+            break;
+        }
+        case '|':
+            if(levels.size() == 1) { return ""; }
+            level.alternation = true;
+            level.Break();
+            lastWasLiteral = false;
+            ++i;
+            break;
+        case '*':
+        case '?':
+        case '{': {
+            // The previous atom may be skipped: it is not part of the literal
+            bool optional = ch != '{' || (i + 1 < pattern.length() && pattern[i + 1] == '0');
+            if(lastWasLiteral && optional) { level.run.RemoveLast(); }
+            level.Break();
+            lastWasLiteral = false;
+            if(ch == '{') {
+                int end = pattern.find('}', i);
+                if(end == wxNOT_FOUND) { return ""; }
+                i = end + 1;
+            } else {
+                ++i;
+            }
+            break;
+        }
+        case '+':
+            // The previous atom is required, but what follows it is not adjacent to it
+            level.Break();
+            lastWasLiteral = false;
+            ++i;
+            break;
+        case '.':
+        case '^':
+        case '$':
+            level.Break();
+            lastWasLiteral = false;
+            ++i;
+            break;
+        default:
+            level.run << (wxChar)wxTolower(ch);
+            lastWasLiteral = true;
+            ++i;
+            break;
+        }
+    }
+
+    if(levels.size() != 1) { return ""; }
+    levels.back().Break();
+    return levels.back().best;
+}
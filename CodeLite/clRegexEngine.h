@@ -0,0 +1,73 @@
+#ifndef CLREGEXENGINE_H
+#define CLREGEXENGINE_H
+
+#include "codelite_exports.h"
+#include <memory>
+#include <wx/string.h>
+
+/**
+ * @class clRegexEngine
+ * @brief a regular expression backend used to search a whole buffer at once.
+ * '^' and '$' match at line boundaries. The linear engine never matches a '\n', so searching a
+ * buffer gives the same matches as searching each of its lines. Both engines use the wxRegEx (ARE)
+ * syntax and report the same match: the leftmost one, and among those the longest (or the shortest when
+ * the expression prefers it)
+ */
+class WXDLLIMPEXP_CL clRegexEngine
+{
+public:
+    enum eType {
+        kWxRegEx, // wxRegEx (backtracking)
+        kLinear,  // NFA simulation: linear in the size of the text, no back references or look-ahead
+    };
+    typedef std::shared_ptr<clRegexEngine> Ptr_t;
+
+protected:
+    eType m_type;
+
+public:
+    clRegexEngine(eType type)
+        : m_type(type)
+    {
+    }
+    virtual ~clRegexEngine() {}
+
+    eType GetType() const { return m_type; }
+
+    /**
+     * @brief compile 'pattern'
+     * @return false if the pattern is invalid or not supported by this engine
+     */
+    virtual bool Compile(const wxString& pattern, bool matchCase) = 0;
+
+    /**
+     * @brief was the last call to Compile() successful?
+     */
+    virtual bool IsValid() const = 0;
+
+    /**
+     * @brief find the first match in 'text', starting from the character at 'from'
+     * @param start [output] the match position, in characters from the start of 'text'
+     * @param len [output] the match length, in characters
+     */
+    virtual bool Find(const wxString& text, size_t from, size_t& start, size_t& len) = 0;
+
+    /**
+     * @brief create an engine of a given type
+     */
+    static clRegexEngine::Ptr_t New(eType type);
+
+    /**
+     * @brief create an engine for 'pattern': the linear engine when it supports the pattern,
+     * wxRegEx otherwise (e.g. back references, or lazy quantifiers mixed with greedy ones)
+     */
+    static clRegexEngine::Ptr_t New(const wxString& pattern, bool matchCase);
+
+    /**
+     * @brief return the longest literal (lower case) that any text matching 'pattern' must contain,
+     * or an empty string if none could be found. A line that does not contain it can't match 'pattern'
+     */
+    static wxString GetRequiredLiteral(const wxString& pattern);
+};
+
+#endif // CLREGEXENGINE_H
@@ -0,0 +1,232 @@
+#include "clTrace.h"
+#include "file_logger.h"
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <wx/ffile.h>
+#include <wx/thread.h>
+#include <wx/utils.h>
+
+// Spans kept per thread. Once full, the oldest spans are overwritten
+#define TRACE_THREAD_BUFFER_SIZE (64 * 1024)
+
+namespace
+{
+struct Span {
+    const char* category = nullptr;
+    const char* name = nullptr; // a string literal, or null when 'asyncName' is used
+    std::string asyncName;
+    uint64_t start = 0;
+    uint64_t duration = 0;
+};
+
+struct ThreadBuffer {
+    std::mutex lock; // contended only while exporting
+    std::vector<Span> spans;
+    size_t next = 0; // where the next span goes once the buffer is full
+    unsigned long tid = 0;
+    std::string name;
+    bool dead = false; // the thread exited: no more spans will be added
+
+    void Add(Span& span)
+    {
+        std::lock_guard<std::mutex> locker(lock);
+        if(spans.size() < TRACE_THREAD_BUFFER_SIZE) {
+            spans.push_back(std::move(span));
+        } else {
+            spans[next] = std::move(span);
+            next = (next + 1) % TRACE_THREAD_BUFFER_SIZE;
+        }
+    }
+    typedef std::shared_ptr<ThreadBuffer> Ptr_t;
+};
+
+const std::chrono::steady_clock::time_point s_epoch = std::chrono::steady_clock::now();
+
+// The buffers outlive their threads, so the spans of a finished thread can still be exported.
+// The buffer of a finished thread is released once its spans were exported or cleared
+std::mutex s_buffersLock;
+std::vector<ThreadBuffer::Ptr_t> s_buffers;
+
+/// Marks the buffer of the thread as dead when the thread exits
+struct ThreadBufferOwner {
+    ThreadBuffer* buffer = nullptr;
+
+    ~ThreadBufferOwner()
+    {
+        if(buffer) {
+            std::lock_guard<std::mutex> locker(buffer->lock);
+            buffer->dead = true;
+        }
+    }
+};
+thread_local ThreadBufferOwner t_owner;
+
+ThreadBuffer* GetThreadBuffer()
+{
+    if(!t_owner.buffer) {
+        ThreadBuffer::Ptr_t buffer(new ThreadBuffer());
+        buffer->tid = wxThread::GetCurrentId();
+        if(wxThread::IsMain()) { buffer->name = "Main thread"; }
+        std::lock_guard<std::mutex> locker(s_buffersLock);
+        s_buffers.push_back(buffer);
+        t_owner.buffer = buffer.get();
+    }
+    return t_owner.buffer;
+}
+
+/// Remove the buffers in 'released' from the list of buffers
+void ReleaseBuffers(const std::vector<ThreadBuffer::Ptr_t>& released)
+{
+    if(released.empty()) { return; }
+    std::lock_guard<std::mutex> locker(s_buffersLock);
+    for(ThreadBuffer::Ptr_t buffer : released) {
+        std::vector<ThreadBuffer::Ptr_t>::iterator iter = std::find(s_buffers.begin(), s_buffers.end(), buffer);
+        if(iter != s_buffers.end()) { s_buffers.erase(iter); }
+    }
+}
+
+void AppendEscaped(std::string& json, const char* str)
+{
+    for(; *str; ++str) {
+        unsigned char ch = *str;
+        if(ch == '"' || ch == '\\') {
+            json += '\\';
+            json += ch;
+        } else if(ch < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", ch);
+            json += buf;
+        } else {
+            json += ch;
+        }
+    }
+}
+
+void AppendEvent(std::string& json, const char* phase, const char* category, const char* name, uint64_t ts,
+                 unsigned long pid, unsigned long tid, const char* extra)
+{
+    if(json.back() == '}') { json += ",\n"; }
+    json += "{\"ph\":\"";
+    json += phase;
+    json += "\",\"cat\":\"";
+    AppendEscaped(json, category);
+    json += "\",\"name\":\"";
+    AppendEscaped(json, name);
+    json += "\",\"ts\":" + std::to_string(ts);
+    json += ",\"pid\":" + std::to_string(pid);
+    json += ",\"tid\":" + std::to_string(tid);
+    json += extra;
+    json += "}";
+}
+} // namespace
+
+std::atomic_bool clTrace::ms_enabled(false);
+
+void clTrace::Enable(bool enable)
+{
+    ms_enabled.store(enable);
+    clDEBUG() << "Tracing is" << (enable ? "enabled" : "disabled") << clEndl;
+}
+
+uint64_t clTrace::Now()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - s_epoch)
+        .count();
+}
+
+void clTrace::Record(const char* category, const char* name, uint64_t start, uint64_t duration)
+{
+    Span span;
+    span.category = category;
+    span.name = name;
+    span.start = start;
+    span.duration = duration;
+    GetThreadBuffer()->Add(span);
+}
+
+void clTrace::RecordAsync(const char* category, const wxString& name, uint64_t start, uint64_t duration)
+{
+    if(!IsEnabled()) { return; }
+    Span span;
+    span.category = category;
+    span.asyncName = name.mb_str(wxConvUTF8).data();
+    span.start = start;
+    span.duration = duration;
+    GetThreadBuffer()->Add(span);
+}
+
+void clTrace::SetThreadName(const wxString& name)
+{
+    ThreadBuffer* buffer = GetThreadBuffer();
+    std::lock_guard<std::mutex> locker(buffer->lock);
+    buffer->name = name.mb_str(wxConvUTF8).data();
+}
+
+bool clTrace::Export(const wxString& filename)
+{
+    std::vector<ThreadBuffer::Ptr_t> buffers;
+    {
+        std::lock_guard<std::mutex> locker(s_buffersLock);
+        buffers = s_buffers;
+    }
+
+    unsigned long pid = ::wxGetProcessId();
+    size_t asyncId = 0;
+    size_t count = 0;
+    std::vector<ThreadBuffer::Ptr_t> released; // buffers of finished threads, fully exported
+    std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    for(ThreadBuffer::Ptr_t buffer : buffers) {
+        std::lock_guard<std::mutex> locker(buffer->lock);
+        if(buffer->dead) { released.push_back(buffer); }
+        if(!buffer->name.empty()) {
+            std::string args = ",\"args\":{\"name\":\"";
+            AppendEscaped(args, buffer->name.c_str());
+            args += "\"}";
+            AppendEvent(json, "M", "__metadata", "thread_name", 0, pid, buffer->tid, args.c_str());
+        }
+
+        for(const Span& span : buffer->spans) {
+            if(span.name) {
+                std::string dur = ",\"dur\":" + std::to_string(span.duration);
+                AppendEvent(json, "X", span.category, span.name, span.start, pid, buffer->tid, dur.c_str());
+            } else {
+                // An async span is a begin/end pair sharing an id
+                std::string id = ",\"id\":" + std::to_string(++asyncId);
+                AppendEvent(json, "b", span.category, span.asyncName.c_str(), span.start, pid, buffer->tid,
+                            id.c_str());
+                AppendEvent(json, "e", span.category, span.asyncName.c_str(), span.start + span.duration, pid,
+                            buffer->tid, id.c_str());
+            }
+            ++count;
+        }
+    }
+    json += "\n]}\n";
+
+    wxFFile fp(filename, "wb");
+    if(!fp.IsOpened() || fp.Write(json.c_str(), json.length()) != json.length()) {
+        clWARNING() << "Failed to write trace file" << filename << clEndl;
+        return false;
+    }
+    ReleaseBuffers(released);
+    clDEBUG() << "Exported" << count << "trace spans to" << filename << clEndl;
+    return true;
+}
+
+void clTrace::Clear()
+{
+    std::lock_guard<std::mutex> locker(s_buffersLock);
+    std::vector<ThreadBuffer::Ptr_t> alive;
+    for(ThreadBuffer::Ptr_t buffer : s_buffers) {
+        std::lock_guard<std::mutex> bufferLocker(buffer->lock);
+        if(buffer->dead) { continue; }
+        buffer->spans.clear();
+        buffer->next = 0;
+        alive.push_back(buffer);
+    }
+    s_buffers.swap(alive);
+}
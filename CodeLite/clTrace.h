@@ -0,0 +1,98 @@
+#ifndef CLTRACE_H
+#define CLTRACE_H
+
+#include "codelite_exports.h"
+#include <atomic>
+#include <stdint.h>
+#include <wx/string.h>
+
+/**
+ * @class clTrace
+ * @brief a light weight tracer. Spans (a name, a start time and a duration) are recorded by any thread and
+ * exported in the Chrome trace event format (open the file in chrome://tracing or https://ui.perfetto.dev).
+ * Each thread records into a buffer of its own that keeps its most recent spans. When tracing is disabled,
+ * a span costs a single atomic load.
+ *
+ * Usage:
+ *     void Foo::Bar()
+ *     {
+ *         CL_TRACE_SCOPE("editor", "Foo::Bar");
+ *         ...
+ *     }
+ */
+class WXDLLIMPEXP_CL clTrace
+{
+    static std::atomic_bool ms_enabled;
+
+public:
+    /**
+     * @brief start/stop recording. The spans recorded so far are kept
+     */
+    static void Enable(bool enable);
+    static bool IsEnabled() { return ms_enabled.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief microseconds since the tracer was initialized
+     */
+    static uint64_t Now();
+
+    /**
+     * @brief record a span of the calling thread. 'category' and 'name' must be string literals:
+     * only their address is kept
+     */
+    static void Record(const char* category, const char* name, uint64_t start, uint64_t duration);
+
+    /**
+     * @brief record a span that does not nest with the other spans of the thread, e.g. a request sent
+     * to a server and its reply. Such spans are displayed on their own track
+     */
+    static void RecordAsync(const char* category, const wxString& name, uint64_t start, uint64_t duration);
+
+    /**
+     * @brief name the calling thread in the exported trace
+     */
+    static void SetThreadName(const wxString& name);
+
+    /**
+     * @brief write the spans recorded by all the threads into 'filename'
+     */
+    static bool Export(const wxString& filename);
+
+    /**
+     * @brief discard the recorded spans
+     */
+    static void Clear();
+};
+
+/**
+ * @class clTraceScope
+ * @brief record the lifetime of this object as a span
+ */
+class WXDLLIMPEXP_CL clTraceScope
+{
+    const char* m_category;
+    const char* m_name;
+    uint64_t m_start;
+    bool m_active;
+
+public:
+    clTraceScope(const char* category, const char* name)
+        : m_category(category)
+        , m_name(name)
+        , m_start(0)
+        , m_active(clTrace::IsEnabled())
+    {
+        if(m_active) { m_start = clTrace::Now(); }
+    }
+
+    ~clTraceScope()
+    {
+        if(m_active) { clTrace::Record(m_category, m_name, m_start, clTrace::Now() - m_start); }
+    }
+};
+
+#define CL_TRACE_CONCAT_INNER(a, b) a##b
+#define CL_TRACE_CONCAT(a, b) CL_TRACE_CONCAT_INNER(a, b)
+#define CL_TRACE_SCOPE(category, name) clTraceScope CL_TRACE_CONCAT(__traceScope, __LINE__)(category, name)
+
+#endif // CLTRACE_H
@@ -57,6 +57,7 @@ public:
 #define kConfigLLDBTooltipW "LLDBTooltipW"
 #define kConfigLLDBTooltipH "LLDBTooltipH"
 #define kConfigBuildAutoScroll "build-auto-scroll"
+#define kConfigBuildOutputMaxLines "build-output-max-lines"
 #define kConfigCreateVirtualFoldersOnDisk "CreateVirtualFoldersOnDisk"
 #define kConfigLogVerbosity "LogVerbosity"
 #define kConfigRedirectLogOutput "RedirectLogOutput"
@@ -26,6 +26,7 @@
 #include "CxxVariable.h"
 #include "CxxVariableScanner.h"
 #include "asyncprocess.h"
+#include "clTrace.h"
 #include "cl_indexer_reply.h"
 #include "cl_indexer_request.h"
 #include "cl_standard_paths.h"
@@ -139,7 +140,6 @@ TagsManager* TagsManagerST::Get()
 TagsManager::TagsManager()
     : wxEvtHandler()
     , m_codeliteIndexerPath(wxT("codelite_indexer"))
-    , m_codeliteIndexerProcess(NULL)
     , m_canRestartIndexer(true)
     , m_lang(NULL)
     , m_evtHandler(NULL)
@@ -164,29 +164,27 @@ TagsManager::TagsManager()
 TagsManager::~TagsManager()
 {
     m_symbolsCache.reset(nullptr);
-    if(m_codeliteIndexerProcess) {
 
-        // Dont kill the indexer process, just terminate the
-        // reader-thread (this is done by deleting the indexer object)
-        m_canRestartIndexer = false;
+    // Dont kill the indexer processes, just terminate the
+    // reader-threads (this is done by deleting the indexer objects)
+    m_canRestartIndexer = false;
+    for(size_t i = 0; i < m_indexerProcesses.size(); ++i) {
+        IProcess* indexer = m_indexerProcesses.at(i);
+        if(!indexer) { continue; }
 
 #ifndef __WXMSW__
-        m_codeliteIndexerProcess->Terminate();
+        indexer->Terminate();
 #endif
-        delete m_codeliteIndexerProcess;
+        delete indexer;
 
 #ifndef __WXMSW__
         // Clear the socket file
-        std::stringstream s;
-        s << wxGetProcessId();
-
-        char channel_name[1024];
-        memset(channel_name, 0, sizeof(channel_name));
-        sprintf(channel_name, PIPE_NAME, s.str().c_str());
-        ::unlink(channel_name);
-        ::remove(channel_name);
+        const wxCharBuffer channel_name = DoGetIndexerChannelName(i).mb_str(wxConvUTF8);
+        ::unlink(channel_name.data());
+        ::remove(channel_name.data());
 #endif
     }
+    m_indexerProcesses.clear();
 }
 
 void TagsManager::OpenDatabase(const wxFileName& fileName)
@@ -226,7 +224,7 @@ TagTreePtr TagsManager::ParseSourceFile(const wxFileName& fp, std::vector<Commen
 {
     wxString tags;
 
-    if(!m_codeliteIndexerProcess) {
+    if(!IsIndexerRunning() && !IsInProcessParsing()) {
         clWARNING() << "Indexer process is not running..." << clEndl;
         return TagTreePtr(NULL);
     }
@@ -292,60 +290,154 @@ void TagsManager::Delete(const wxFileName& path, const wxString& fileName)
 // Process Handling of CTAGS
 //--------------------------------------------------------
 
-void TagsManager::StartCodeLiteIndexer()
+size_t TagsManager::GetIndexerCount() const
 {
-    if(!m_canRestartIndexer) return;
+    // an indexer process per parser thread
+    size_t count = m_tagsOptions.GetParserThreads();
+    return (count == 0) ? TagsOptionsData::GetDefaultParserThreads() : count;
+}
 
-    // Run ctags process
-    wxString cmd;
-    wxString ctagsCmd;
+bool TagsManager::IsIndexerRunning()
+{
+    wxCriticalSectionLocker locker(m_indexersLocker);
+    return !m_indexerProcesses.empty() && m_indexerProcesses.at(0);
+}
 
-    // build the command, we surround ctags name with double quatations
-    wxString uid;
-    uid << wxGetProcessId();
+void TagsManager::StartCodeLiteIndexer()
+{
+    if(!m_canRestartIndexer) return;
 
     if(m_codeliteIndexerPath.FileExists() == false) {
         CL_ERROR(wxT("ERROR: Could not locate indexer: %s"), m_codeliteIndexerPath.GetFullPath().c_str());
-        m_codeliteIndexerProcess = NULL;
         return;
     }
 
-    // concatenate the PID to identifies this channel to this instance of codelite
-    cmd << wxT("\"") << m_codeliteIndexerPath.GetFullPath() << wxT("\" ") << uid << wxT(" --pid");
-    m_codeliteIndexerProcess =
-        CreateAsyncProcess(this, cmd, IProcessCreateDefault, clStandardPaths::Get().GetUserDataDir());
+    wxCriticalSectionLocker locker(m_indexersLocker);
+    size_t count = GetIndexerCount();
+    if(m_indexerProcesses.size() < count) { m_indexerProcesses.resize(count, NULL); }
+    for(size_t i = 0; i < count; ++i) {
+        if(m_indexerProcesses.at(i)) { continue; }
+
+        // Run ctags process
+        // build the command, we surround ctags name with double quatations
+        // concatenate the PID to identifies this channel to this instance of codelite
+        wxString cmd;
+        cmd << wxT("\"") << m_codeliteIndexerPath.GetFullPath() << wxT("\" ") << DoGetIndexerUID(i) << wxT(" --pid");
+        m_indexerProcesses.at(i) =
+            CreateAsyncProcess(this, cmd, IProcessCreateDefault, clStandardPaths::Get().GetUserDataDir());
+    }
 }
 
 void TagsManager::RestartCodeLiteIndexer()
 {
-    if(m_codeliteIndexerProcess) { m_codeliteIndexerProcess->Terminate(); }
+    wxCriticalSectionLocker locker(m_indexersLocker);
+    for(size_t i = 0; i < m_indexerProcesses.size(); ++i) {
+        if(m_indexerProcesses.at(i)) { m_indexerProcesses.at(i)->Terminate(); }
+    }
 
     // no need to call StartCodeLiteIndexer(), since it will be called automatically
     // by the termination handler
 }
 
+void TagsManager::RestartCodeLiteIndexer(size_t indexer)
+{
+    // The process is deleted by the termination handler (main thread) under the same lock
+    wxCriticalSectionLocker locker(m_indexersLocker);
+    if(indexer < m_indexerProcesses.size() && m_indexerProcesses.at(indexer)) {
+        m_indexerProcesses.at(indexer)->Terminate();
+    }
+}
+
 void TagsManager::SetCodeLiteIndexerPath(const wxString& path) { m_codeliteIndexerPath = path; }
 
 void TagsManager::OnIndexerTerminated(clProcessEvent& event)
 {
-    wxUnusedVar(event);
-    wxDELETE(m_codeliteIndexerProcess);
+    {
+        wxCriticalSectionLocker locker(m_indexersLocker);
+        std::vector<IProcess*>::iterator iter =
+            std::find(m_indexerProcesses.begin(), m_indexerProcesses.end(), event.GetProcess());
+        if(iter != m_indexerProcesses.end()) { wxDELETE(*iter); }
+
+        // the number of parser threads was reduced: forget the indexers that are no longer needed
+        size_t count = GetIndexerCount();
+        while(m_indexerProcesses.size() > count && !m_indexerProcesses.back()) {
+            m_indexerProcesses.pop_back();
+        }
+    }
     StartCodeLiteIndexer();
 }
 
 //---------------------------------------------------------------------
 // Parsing
 //---------------------------------------------------------------------
-void TagsManager::SourceToTags(const wxFileName& source, wxString& tags)
+wxString TagsManager::DoGetIndexerUID(size_t indexer) const
 {
-    std::stringstream s;
-    s << wxGetProcessId();
+    // The indexer reads our PID from the start of its UID
+    wxString uid;
+    uid << wxGetProcessId();
+    if(indexer > 0) { uid << "_" << indexer; }
+    return uid;
+}
 
+wxString TagsManager::DoGetIndexerChannelName(size_t indexer) const
+{
     char channel_name[1024];
     memset(channel_name, 0, sizeof(channel_name));
-    sprintf(channel_name, PIPE_NAME, s.str().c_str());
+    sprintf(channel_name, PIPE_NAME, DoGetIndexerUID(indexer).mb_str(wxConvUTF8).data());
+    return channel_name;
+}
 
-    clNamedPipeClient client(channel_name);
+wxString TagsManager::DoGetIndexerCtagsOptions() const
+{
+    wxString ctagsCmd;
+    ctagsCmd << wxT(" ") << m_tagsOptions.ToString()
+             << wxT(" --excmd=pattern --sort=no --fields=aKmSsnit --c-kinds=+p --C++-kinds=+p ");
+    return ctagsCmd;
+}
+
+wxString TagsManager::DoConvertIndexerTags(const std::string& tags, wxFontEncoding encoding) const
+{
+    // convert the data into wxString
+    wxString str;
+    if(encoding == wxFONTENCODING_DEFAULT || encoding == wxFONTENCODING_SYSTEM)
+        str = wxString(tags.c_str(), wxConvUTF8);
+    else
+        str = wxString(tags.c_str(), wxCSConv(encoding));
+    if(str.empty()) { str = wxString::From8BitData(tags.c_str()); }
+    return str;
+}
+
+TagsManager::ParseSettings TagsManager::GetParseSettings()
+{
+    wxCriticalSectionLocker locker(m_optionsLocker);
+    ParseSettings settings;
+    settings.ctagsOptions = DoGetIndexerCtagsOptions();
+    settings.encoding = m_encoding;
+    settings.inProcess = (m_tagsOptions.GetFlags() & CC_PARSE_IN_PROCESS) && m_ctagsLibrary.IsLoaded();
+    settings.indexerCount = GetIndexerCount();
+    return settings;
+}
+
+bool TagsManager::IsInProcessParsing() { return GetParseSettings().inProcess; }
+
+bool TagsManager::DoSourceToTagsInProcess(const wxString& filename, wxString& tags, const ParseSettings& settings)
+{
+    if(!settings.inProcess) { return false; }
+
+    std::string output;
+    if(!m_ctagsLibrary.SourceToTags(settings.ctagsOptions, filename, output)) { return false; }
+    tags = DoConvertIndexerTags(output, settings.encoding);
+    return true;
+}
+
+void TagsManager::SourceToTags(const wxFileName& source, wxString& tags)
+{
+    const ParseSettings settings = GetParseSettings();
+
+    // Parse the file in-process when possible, otherwise send it to the indexer
+    if(DoSourceToTagsInProcess(source.GetFullPath(), tags, settings)) { return; }
+
+    clNamedPipeClient client(DoGetIndexerChannelName(0).mb_str(wxConvUTF8).data());
 
     // Build a request for the indexer
     clIndexerRequest req;
@@ -358,12 +450,9 @@ void TagsManager::SourceToTags(const wxFileName& source, wxString& tags)
     req.setFiles(files);
 
     // set ctags options to be used
-    wxString ctagsCmd;
-    ctagsCmd << wxT(" ") << m_tagsOptions.ToString()
-             << wxT(" --excmd=pattern --sort=no --fields=aKmSsnit --c-kinds=+p --C++-kinds=+p ");
-    req.setCtagOptions(ctagsCmd.mb_str(wxConvUTF8).data());
+    req.setCtagOptions(settings.ctagsOptions.mb_str(wxConvUTF8).data());
 
-    clDEBUG1() << "Sending CTAGS command:" << ctagsCmd << clEndl;
+    clDEBUG1() << "Sending CTAGS command:" << settings.ctagsOptions << clEndl;
     // connect to the indexer
     if(!client.connect()) {
         clWARNING() << "Failed to connect to indexer process. Indexer ID:" << wxGetProcessId() << clEndl;
@@ -383,7 +472,7 @@ void TagsManager::SourceToTags(const wxFileName& source, wxString& tags)
         std::string errmsg;
         if(!clIndexerProtocol::ReadReply(&client, reply, errmsg)) {
             clWARNING() << "Failed to read indexer reply: " << (wxString() << errmsg) << clEndl;
-            RestartCodeLiteIndexer();
+            RestartCodeLiteIndexer(0);
             return;
         }
     } catch(std::bad_alloc& ex) {
@@ -394,16 +483,78 @@ void TagsManager::SourceToTags(const wxFileName& source, wxString& tags)
 
     clDEBUG1() << "SourceToTags: [" << reply.getTags() << "]" << clEndl;
 
-    // convert the data into wxString
-    if(m_encoding == wxFONTENCODING_DEFAULT || m_encoding == wxFONTENCODING_SYSTEM)
-        tags = wxString(reply.getTags().c_str(), wxConvUTF8);
-    else
-        tags = wxString(reply.getTags().c_str(), wxCSConv(m_encoding));
-    if(tags.empty()) { tags = wxString::From8BitData(reply.getTags().c_str()); }
-
+    tags = DoConvertIndexerTags(reply.getTags(), settings.encoding);
     clDEBUG1() << "Tags:\n" << tags << clEndl;
 }
 
+void TagsManager::SourceToTags(const wxArrayString& sources, wxArrayString& tags)
+{
+    SourceToTags(sources, tags, GetParseSettings(), 0);
+}
+
+void TagsManager::SourceToTags(const wxArrayString& sources, wxArrayString& tags, const ParseSettings& settings,
+                               size_t indexer)
+{
+    tags.Clear();
+    if(sources.IsEmpty()) { return; }
+
+    // make sure that the output always matches the input
+    tags.Add(wxEmptyString, sources.GetCount());
+
+    if(settings.inProcess) {
+        for(size_t i = 0; i < sources.GetCount(); ++i) {
+            DoSourceToTagsInProcess(sources.Item(i), tags.Item(i), settings);
+        }
+        return;
+    }
+
+    clNamedPipeClient client(DoGetIndexerChannelName(indexer).mb_str(wxConvUTF8).data());
+
+    // Build a batch request: the indexer replies with a message per file
+    clIndexerRequest req;
+    req.setCmd(clIndexerRequest::CLI_PARSE_BATCH);
+
+    std::vector<std::string> files;
+    files.reserve(sources.GetCount());
+    for(size_t i = 0; i < sources.GetCount(); ++i) {
+        files.push_back(sources.Item(i).mb_str(wxConvUTF8).data());
+    }
+    req.setFiles(files);
+    req.setCtagOptions(settings.ctagsOptions.mb_str(wxConvUTF8).data());
+
+    // connect to the indexer
+    if(!client.connect()) {
+        clWARNING() << "Failed to connect to indexer process. Indexer ID:" << DoGetIndexerUID(indexer) << clEndl;
+        return;
+    }
+
+    // send the request
+    if(!clIndexerProtocol::SendRequest(&client, req)) {
+        clWARNING() << "Failed to send request to indexer. Indexer ID:" << DoGetIndexerUID(indexer) << clEndl;
+        return;
+    }
+
+    // read the replies, they arrive in the same order as the files were sent
+    clDEBUG1() << "SourceToTags: reading" << sources.GetCount() << "indexer replies" << clEndl;
+    for(size_t i = 0; i < sources.GetCount(); ++i) {
+        clIndexerReply reply;
+        try {
+            std::string errmsg;
+            if(!clIndexerProtocol::ReadReply(&client, reply, errmsg)) {
+                clWARNING() << "Failed to read indexer reply: " << (wxString() << errmsg) << clEndl;
+                RestartCodeLiteIndexer(indexer);
+                return;
+            }
+        } catch(std::bad_alloc& ex) {
+            clWARNING() << "std::bad_alloc exception caught" << clEndl;
+            return;
+        }
+        if(reply.getCompletionCode() == 1) {
+            tags.Item(i) = DoConvertIndexerTags(reply.getTags(), settings.encoding);
+        }
+    }
+}
+
 TagTreePtr TagsManager::TreeFromTags(const wxString& tags, int& count)
 {
     // Load the records and build a language tree
@@ -496,6 +647,7 @@ bool TagsManager::WordCompletionCandidates(const wxFileName& fileName, int linen
                                            const wxString& text, const wxString& word,
                                            std::vector<TagEntryPtr>& candidates)
 {
+    CL_TRACE_SCOPE("tags", "TagsManager::WordCompletionCandidates");
     PERF_START("WordCompletionCandidates");
 
     candidates.clear();
@@ -642,6 +794,7 @@ bool TagsManager::WordCompletionCandidates(const wxFileName& fileName, int linen
 bool TagsManager::AutoCompleteCandidates(const wxFileName& fileName, int lineno, const wxString& expr,
                                          const wxString& text, std::vector<TagEntryPtr>& candidates)
 {
+    CL_TRACE_SCOPE("tags", "TagsManager::AutoCompleteCandidates");
     PERF_START("AutoCompleteCandidates");
 
     candidates.clear();
@@ -862,6 +1015,7 @@ void TagsManager::GetLocalTags(const wxString& name, const wxString& scope, std:
 void TagsManager::GetHoverTip(const wxFileName& fileName, int lineno, const wxString& expr, const wxString& word,
                               const wxString& text, std::vector<wxString>& tips)
 {
+    CL_TRACE_SCOPE("tags", "TagsManager::GetHoverTip");
     wxString path;
     wxString typeName, typeScope, tmp;
     std::vector<TagEntryPtr> tmpCandidates, candidates;
@@ -918,6 +1072,7 @@ void TagsManager::GetHoverTip(const wxFileName& fileName, int lineno, const wxSt
 void TagsManager::FindImplDecl(const wxFileName& fileName, int lineno, const wxString& expr, const wxString& word,
                                const wxString& text, std::vector<TagEntryPtr>& tags, bool imp, bool workspaceOnly)
 {
+    CL_TRACE_SCOPE("tags", "TagsManager::FindImplDecl");
     // Don't attempt to parse non valid ctags file
     if(!IsValidCtagsFile(fileName)) { return; }
 
@@ -1112,6 +1267,7 @@ void TagsManager::FilterDeclarations(const std::vector<TagEntryPtr>& src, std::v
 clCallTipPtr TagsManager::GetFunctionTip(const wxFileName& fileName, int lineno, const wxString& expr,
                                          const wxString& text, const wxString& word)
 {
+    CL_TRACE_SCOPE("tags", "TagsManager::GetFunctionTip");
     wxString path;
     wxString typeName, typeScope, tmp;
     std::vector<TagEntryPtr> tips;
@@ -1208,6 +1364,7 @@ clCallTipPtr TagsManager::GetFunctionTip(const wxFileName& fileName, int lineno,
 //-----------------------------------------------------------------------------
 void TagsManager::OpenType(std::vector<TagEntryPtr>& tags)
 {
+    CL_TRACE_SCOPE("tags", "TagsManager::OpenType");
     wxArrayString kinds;
     kinds.Add(wxT("class"));
     kinds.Add(wxT("namespace"));
@@ -1221,6 +1378,7 @@ void TagsManager::OpenType(std::vector<TagEntryPtr>& tags)
 
 void TagsManager::FindSymbol(const wxString& name, std::vector<TagEntryPtr>& tags)
 {
+    CL_TRACE_SCOPE("tags", "TagsManager::FindSymbol");
     // since we dont get a scope, we better user a search that only uses the
     // name (GetTagsByScopeAndName) is optimized to search the global tags table
     GetDatabase()->GetTagsByName(name, tags, true);
@@ -1314,6 +1472,7 @@ void TagsManager::RetagFiles(const std::vector<wxFileName>& files, RetagType typ
 
 void TagsManager::FindByNameAndScope(const wxString& name, const wxString& scope, std::vector<TagEntryPtr>& tags)
 {
+    CL_TRACE_SCOPE("tags", "TagsManager::FindByNameAndScope");
     wxString _name = DoReplaceMacros(name);
     wxString _scope = DoReplaceMacros(scope);
     DoFindByNameAndScope(_name, _scope, tags);
@@ -1679,7 +1838,15 @@ bool TagsManager::GetParseComments() { return m_parseComments; }
 
 void TagsManager::SetCtagsOptions(const TagsOptionsData& options)
 {
-    m_tagsOptions = options;
+    {
+        // The parser threads copy the options (see GetParseSettings())
+        wxCriticalSectionLocker locker(m_optionsLocker);
+        m_tagsOptions = options;
+        if(m_tagsOptions.GetFlags() & CC_PARSE_IN_PROCESS) {
+            // On failure, we keep using the codelite_indexer process
+            m_ctagsLibrary.Load();
+        }
+    }
     RestartCodeLiteIndexer();
     m_parseComments = m_tagsOptions.GetFlags() & CC_PARSE_COMMENTS ? true : false;
     ITagsStoragePtr db = GetDatabase();
@@ -2424,6 +2591,8 @@ void TagsManager::GetUnOverridedParentVirtualFunctions(const wxString& scopeName
 
 void TagsManager::ClearTagsCache() { GetDatabase()->ClearCache(); }
 
+void TagsManager::ClearTagsCache(const wxString& filename) { GetDatabase()->ClearCache(filename); }
+
 void TagsManager::SetProjectPaths(const wxArrayString& paths)
 {
     m_projectPaths.Clear();
@@ -2637,7 +2806,11 @@ wxString TagsManager::WrapLines(const wxString& str)
     return wrappedString;
 }
 
-void TagsManager::SetEncoding(const wxFontEncoding& encoding) { m_encoding = encoding; }
+void TagsManager::SetEncoding(const wxFontEncoding& encoding)
+{
+    wxCriticalSectionLocker locker(m_optionsLocker);
+    m_encoding = encoding;
+}
 
 wxArrayString TagsManager::BreakToOuterScopes(const wxString& scope)
 {
@@ -2876,7 +3049,7 @@ void TagsManager::GetCXXKeywords(wxArrayString& words)
 
 TagEntryPtrVector_t TagsManager::ParseBuffer(const wxString& content, const wxString& filename)
 {
-    if(!m_codeliteIndexerProcess) { return TagEntryPtrVector_t(); }
+    if(!IsIndexerRunning() && !IsInProcessParsing()) { return TagEntryPtrVector_t(); }
 
     // Write the content into temporary file
     wxString tmpfilename = wxFileName::CreateTempFileName("ctagstemp");
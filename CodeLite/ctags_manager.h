@@ -26,6 +26,7 @@
 #ifndef CODELITE_CTAGS_MANAGER_H
 #define CODELITE_CTAGS_MANAGER_H
 
+#include "clCTagsLibrary.h"
 #include "clCxxFileCacheSymbols.h"
 #include "cl_calltip.h"
 #include "cl_command_event.h"
@@ -144,7 +145,8 @@ public:
 
 private:
     wxFileName m_codeliteIndexerPath;
-    IProcess* m_codeliteIndexerProcess;
+    std::vector<IProcess*> m_indexerProcesses; // an indexer process per parser thread
+    wxCriticalSection m_indexersLocker;
     wxString m_ctagsCmd;
     wxStopWatch m_watch;
     TagsOptionsData m_tagsOptions;
@@ -158,12 +160,14 @@ private:
     wxStringSet_t m_CppIgnoreKeyWords;
     wxArrayString m_projectPaths;
     wxFontEncoding m_encoding;
+    wxCriticalSection m_optionsLocker; // m_tagsOptions and m_encoding, read by the parser threads
     wxFileName m_dbFile;
 
 #if USE_TAGS_SQLITE3
     ITagsStoragePtr m_db;
 #endif
     clCxxFileCacheSymbols::Ptr_t m_symbolsCache;
+    clCTagsLibrary m_ctagsLibrary;
 
 public:
     /**
@@ -294,15 +298,26 @@ public:
     void Delete(const wxFileName& path, const wxString& fileName);
 
     /**
-     * Start a codelite_indexer process
+     * Start the codelite_indexer processes that are not running. libctags is not thread safe, so
+     * an indexer process is started per parser thread
      */
     void StartCodeLiteIndexer();
 
     /**
-     * Restart ctags process.
+     * Restart all the indexer processes.
      */
     void RestartCodeLiteIndexer();
 
+    /**
+     * @brief restart the indexer process 'indexer' only. Can be called from any thread
+     */
+    void RestartCodeLiteIndexer(size_t indexer);
+
+    /**
+     * @brief the number of indexer processes
+     */
+    size_t GetIndexerCount() const;
+
     /**
      * Test if filename matches the current ctags file spec.
      * @param filename file name to test
@@ -525,6 +540,30 @@ public:
      */
     wxString GetScopeName(const wxString& scope);
 
+    /**
+     * @class ParseSettings
+     * @brief a copy of the options used to parse files. A parser thread takes it once and is not affected by
+     * SetCtagsOptions() while it runs
+     */
+    struct ParseSettings {
+        wxString ctagsOptions;
+        wxFontEncoding encoding;
+        bool inProcess;
+        size_t indexerCount;
+
+        ParseSettings()
+            : encoding(wxFONTENCODING_DEFAULT)
+            , inProcess(false)
+            , indexerCount(1)
+        {
+        }
+    };
+
+    /**
+     * @brief return a copy of the current parse settings. Can be called from any thread
+     */
+    ParseSettings GetParseSettings();
+
     /**
      * Pass a source file to ctags process, wait for it to process it and return the output.
      * @param source Source file name
@@ -532,6 +571,19 @@ public:
      */
     void SourceToTags(const wxFileName& source, wxString& tags);
 
+    /**
+     * @brief parse a list of files using a single request to the indexer process
+     * @param sources list of files to parse
+     * @param tags [output] ctags output, tags.Item(i) holds the tags of sources.Item(i) (empty string on error)
+     */
+    void SourceToTags(const wxArrayString& sources, wxArrayString& tags);
+
+    /**
+     * @brief same as above, using 'settings' and the indexer process 'indexer' (< settings.indexerCount)
+     */
+    void SourceToTags(const wxArrayString& sources, wxArrayString& tags, const ParseSettings& settings,
+                      size_t indexer);
+
     /**
      * return list of files from the database(s). The returned list is ordered
      * by name (ascending)
@@ -803,6 +855,11 @@ public:
      */
     void ClearTagsCache();
 
+    /**
+     * @brief clear the cached results affected by a change in 'filename'
+     */
+    void ClearTagsCache(const wxString& filename);
+
     /**
      * @brief return true of v1 cotnains the same tags as v2
      */
@@ -919,6 +976,13 @@ protected:
     wxString DoReplaceMacrosFromDatabase(const wxString& name);
     void DoSortByVisibility(TagEntryPtrVector_t& tags);
     void GetScopesByScopeName(const wxString& scopeName, wxArrayString& scopes);
+    wxString DoGetIndexerUID(size_t indexer) const;
+    wxString DoGetIndexerChannelName(size_t indexer) const;
+    bool IsIndexerRunning();
+    wxString DoGetIndexerCtagsOptions() const;
+    wxString DoConvertIndexerTags(const std::string& tags, wxFontEncoding encoding) const;
+    bool IsInProcessParsing();
+    bool DoSourceToTagsInProcess(const wxString& filename, wxString& tags, const ParseSettings& settings);
 };
 
 /// create the singleton typedef
@@ -25,13 +25,241 @@
 
 #include "cl_standard_paths.h"
 #include "file_logger.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <sys/time.h>
+#include <thread>
 #include <wx/crt.h>
+#include <wx/filefn.h>
 #include <wx/filename.h>
 #include <wx/log.h>
 #include <wx/stdpaths.h>
 #include <wx/utils.h>
 
+// Number of lines that can be queued in asynchronous mode. When the queue is full, lines are dropped
+#define ASYNC_LOG_QUEUE_SIZE 8192
+// The writer thread checks the queue at least this often (in milliseconds)
+#define ASYNC_LOG_INTERVAL 100
+#define ASYNC_LOG_DEFAULT_MAX_SIZE (10 * 1024 * 1024)
+
+namespace
+{
+/**
+ * @brief a bounded, lock-free queue of log lines with many producers and a single consumer.
+ * Each slot carries a sequence number telling whether it is free for the producer of a given position or
+ * holds the line of that position for the consumer
+ */
+class LogLinesQueue
+{
+    struct Slot {
+        std::atomic<size_t> sequence;
+        std::string line;
+    };
+    std::unique_ptr<Slot[]> m_slots;
+    size_t m_mask;
+    std::atomic<size_t> m_head; // next position to write (producers)
+    size_t m_tail;              // next position to read (consumer)
+
+public:
+    /// 'size' must be a power of 2
+    LogLinesQueue(size_t size)
+        : m_slots(new Slot[size])
+        , m_mask(size - 1)
+        , m_head(0)
+        , m_tail(0)
+    {
+        for(size_t i = 0; i < size; ++i) {
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool Push(std::string&& line)
+    {
+        size_t pos = m_head.load(std::memory_order_relaxed);
+        while(true) {
+            Slot& slot = m_slots[pos & m_mask];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            long diff = (long)(sequence - pos);
+            if(diff == 0) {
+                // The slot is free, claim it
+                if(m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.line = std::move(line);
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if(diff < 0) {
+                // The consumer did not free this slot yet: the queue is full
+                return false;
+            } else {
+                // Another producer claimed it
+                pos = m_head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /// Called from the consumer thread only
+    bool Pop(std::string& line)
+    {
+        Slot& slot = m_slots[m_tail & m_mask];
+        size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if(sequence != (m_tail + 1)) { return false; }
+        line.swap(slot.line);
+        slot.line.clear();
+        slot.sequence.store(m_tail + m_mask + 1, std::memory_order_release);
+        ++m_tail;
+        return true;
+    }
+};
+
+/**
+ * @brief writes the lines queued by the threads logging, in batches, and rotates the log file
+ */
+class AsyncLogWriter
+{
+    LogLinesQueue m_queue;
+    std::atomic_bool m_active;
+    std::atomic<int> m_pushing; // Push() calls in progress
+    std::atomic<size_t> m_dropped;
+    std::atomic_bool m_signaled;
+    std::atomic<size_t> m_maxFileSize;
+    std::mutex m_lock;
+    std::condition_variable m_cond;
+    bool m_shutdown = false;
+    std::thread* m_thread = nullptr;
+    wxString m_logfile;
+    FILE* m_fp = nullptr;
+    long m_fileSize = 0;
+
+    void Run()
+    {
+        std::string batch;
+        while(true) {
+            bool shutdown = false;
+            {
+                std::unique_lock<std::mutex> locker(m_lock);
+                m_cond.wait_for(locker, std::chrono::milliseconds(ASYNC_LOG_INTERVAL),
+                                [&]() { return m_shutdown || m_signaled.load(); });
+                shutdown = m_shutdown;
+            }
+            m_signaled.store(false);
+            WriteQueued(batch);
+            if(shutdown) { break; }
+        }
+    }
+
+    void WriteQueued(std::string& batch)
+    {
+        batch.clear();
+        std::string line;
+        while(m_queue.Pop(line)) {
+            batch.append(line);
+        }
+        size_t dropped = m_dropped.exchange(0);
+        if(dropped) {
+            batch.append(wxString::Format("Log queue full: %lu lines dropped\n", (unsigned long)dropped).ToStdString());
+        }
+        if(batch.empty()) { return; }
+
+        if(!m_fp) {
+            m_fp = wxFopen(m_logfile, wxT("a+"));
+            if(!m_fp) { return; }
+            fseek(m_fp, 0, SEEK_END);
+            m_fileSize = ftell(m_fp);
+        }
+        fwrite(batch.c_str(), 1, batch.length(), m_fp);
+        fflush(m_fp);
+        m_fileSize += batch.length();
+
+        size_t maxFileSize = m_maxFileSize.load();
+        if(maxFileSize && (size_t)m_fileSize >= maxFileSize) {
+            // Rotate: the next batch starts a new file
+            fclose(m_fp);
+            m_fp = nullptr;
+            ::wxRenameFile(m_logfile, m_logfile + ".1", true);
+        }
+    }
+
+public:
+    AsyncLogWriter()
+        : m_queue(ASYNC_LOG_QUEUE_SIZE)
+        , m_active(false)
+        , m_pushing(0)
+        , m_dropped(0)
+        , m_signaled(false)
+        , m_maxFileSize(ASYNC_LOG_DEFAULT_MAX_SIZE)
+    {
+    }
+
+    ~AsyncLogWriter() { Stop(); }
+
+    bool IsActive() const { return m_active.load(); }
+    void SetMaxFileSize(size_t bytes) { m_maxFileSize.store(bytes); }
+
+    void Start(const wxString& logfile)
+    {
+        if(m_thread) { return; }
+        m_logfile = logfile;
+        m_shutdown = false;
+        m_thread = new std::thread([this]() { Run(); });
+        m_active.store(true);
+    }
+
+    void Stop()
+    {
+        if(!m_thread) { return; }
+        m_active.store(false);
+        // A Push() that found the writer active must complete before the queue is drained for the last time
+        while(m_pushing.load() > 0) {
+            std::this_thread::yield();
+        }
+        {
+            std::lock_guard<std::mutex> locker(m_lock);
+            m_shutdown = true;
+            m_cond.notify_one();
+        }
+        m_thread->join();
+        wxDELETE(m_thread);
+
+        // Lines queued while the thread was stopping
+        std::string batch;
+        WriteQueued(batch);
+        if(m_fp) {
+            fclose(m_fp);
+            m_fp = nullptr;
+        }
+    }
+
+    /// Called from any thread. Return false if the writer is not active: the line must be written by the caller
+    bool Push(const wxString& line)
+    {
+        std::string data(line.mb_str(wxConvUTF8).data());
+        m_pushing.fetch_add(1);
+        if(!m_active.load()) {
+            m_pushing.fetch_sub(1);
+            return false;
+        }
+        if(!m_queue.Push(std::move(data))) {
+            m_dropped.fetch_add(1);
+        } else if(!m_signaled.exchange(true)) {
+            // Wake up the writer once per batch, the lines that follow are written along with this one
+            m_cond.notify_one();
+        }
+        m_pushing.fetch_sub(1);
+        return true;
+    }
+};
+
+AsyncLogWriter& GetAsyncLogWriter()
+{
+    static AsyncLogWriter writer;
+    return writer;
+}
+} // namespace
+
 int FileLogger::m_verbosity = FileLogger::Error;
 wxString FileLogger::m_logfile;
 std::unordered_map<wxThreadIdType, wxString> FileLogger::m_threads;
@@ -39,34 +267,50 @@ wxCriticalSection FileLogger::m_cs;
 
 FileLogger::FileLogger(int requestedVerbo)
     : _requestedLogLevel(requestedVerbo)
-    , m_fp(NULL)
 {
-    m_fp = wxFopen(m_logfile, wxT("a+"));
 }
 
 FileLogger::~FileLogger()
 {
-    if(m_fp) {
-        // flush any content that remain
-        Flush();
-        fclose(m_fp);
-        m_fp = NULL;
-    }
+    // flush any content that remain
+    Flush();
 }
 
 void FileLogger::AddLogLine(const wxString& msg, int verbosity)
 {
     if(msg.IsEmpty()) return;
-    if((m_verbosity >= verbosity) && m_fp) {
+    if(m_verbosity >= verbosity) {
         wxString formattedMsg = Prefix(verbosity);
         formattedMsg << " " << msg;
         formattedMsg.Trim().Trim(false);
         formattedMsg << wxT("\n");
-        wxFprintf(m_fp, wxT("%s"), formattedMsg.c_str());
-        fflush(m_fp);
+        Write(formattedMsg);
     }
 }
 
+void FileLogger::Write(const wxString& line)
+{
+    if(GetAsyncLogWriter().Push(line)) { return; }
+
+    FILE* fp = wxFopen(m_logfile, wxT("a+"));
+    if(!fp) { return; }
+    wxFprintf(fp, wxT("%s"), line);
+    fclose(fp);
+}
+
+void FileLogger::SetAsync(bool async)
+{
+    if(async) {
+        GetAsyncLogWriter().Start(m_logfile);
+    } else {
+        GetAsyncLogWriter().Stop();
+    }
+}
+
+bool FileLogger::IsAsync() { return GetAsyncLogWriter().IsActive(); }
+
+void FileLogger::SetMaxFileSize(size_t bytes) { GetAsyncLogWriter().SetMaxFileSize(bytes); }
+
 void FileLogger::SetVerbosity(int level)
 {
     if(level > FileLogger::Warning) {
@@ -136,8 +380,8 @@ void FileLogger::AddLogLine(const wxArrayString& arr, int verbosity)
 void FileLogger::Flush()
 {
     if(m_buffer.IsEmpty()) { return; }
-    wxFprintf(m_fp, "%s\n", m_buffer);
-    fflush(m_fp);
+    m_buffer << "\n";
+    Write(m_buffer);
     m_buffer.Clear();
 }
 
@@ -46,13 +46,16 @@ protected:
     static int m_verbosity;
     static wxString m_logfile;
     int _requestedLogLevel;
-    FILE* m_fp;
     wxString m_buffer;
     static std::unordered_map<wxThreadIdType, wxString> m_threads;
     static wxCriticalSection m_cs;
 
 protected:
     static wxString GetCurrentThreadName();
+    /**
+     * @brief write a complete line (including its terminating new line) to the log file
+     */
+    static void Write(const wxString& line);
 
 public:
     FileLogger(int requestedVerbo);
@@ -77,6 +80,15 @@ public:
      */
     static wxString Prefix(int verbosity);
 
+    /**
+     * @brief start the line with the log entry prefix. Nothing is computed when the line is not logged
+     */
+    FileLogger& AddPrefix()
+    {
+        if(GetRequestedLogLevel() <= m_verbosity) { m_buffer << Prefix(GetRequestedLogLevel()); }
+        return *this;
+    }
+
     void AddLogLine(const wxString& msg, int verbosity);
     /**
      * @brief print array into the log file
@@ -96,6 +108,20 @@ public:
      * @brief open the log file
      */
     static void OpenLog(const wxString& fullName, int verbosity);
+
+    /**
+     * @brief when enabled, the threads logging only queue their lines and a background thread writes them
+     * to the log file, in batches. In this mode, the log file is rotated when it grows above the size set with
+     * SetMaxFileSize(). Call it after OpenLog(). Disabling it writes the lines still queued
+     */
+    static void SetAsync(bool async);
+    static bool IsAsync();
+
+    /**
+     * @brief in asynchronous mode, the log file is renamed to <log file>.1 (replacing the previous one)
+     * when it grows above 'bytes'. 0 means: never
+     */
+    static void SetMaxFileSize(size_t bytes);
     // Various util methods
     static wxString GetVerbosityAsString(int verbosity);
     static int GetVerbosityAsNumber(const wxString& verbosity);
@@ -188,11 +214,11 @@ template <typename T> FileLogger& operator<<(FileLogger& logger, const T& obj)
 #define CL_DEBUG1_ARR(arr) FileLogger(FileLogger::Developer).AddLogLine(arr, FileLogger::Developer);
 
 // New API
-#define clDEBUG() FileLogger(FileLogger::Dbg) << FileLogger::Prefix(FileLogger::Dbg)
-#define clDEBUG1() FileLogger(FileLogger::Developer) << FileLogger::Prefix(FileLogger::Developer)
-#define clERROR() FileLogger(FileLogger::Error) << FileLogger::Prefix(FileLogger::Error)
-#define clWARNING() FileLogger(FileLogger::Warning) << FileLogger::Prefix(FileLogger::Warning)
-#define clSYSTEM() FileLogger(FileLogger::System) << FileLogger::Prefix(FileLogger::System)
+#define clDEBUG() FileLogger(FileLogger::Dbg).AddPrefix()
+#define clDEBUG1() FileLogger(FileLogger::Developer).AddPrefix()
+#define clERROR() FileLogger(FileLogger::Error).AddPrefix()
+#define clWARNING() FileLogger(FileLogger::Warning).AddPrefix()
+#define clSYSTEM() FileLogger(FileLogger::System).AddPrefix()
 
 // A replacement for wxLogMessage
 #define clLogMessage(msg) clDEBUG() << msg
@@ -541,6 +541,44 @@ unsigned int FileUtils::UTF8Length(const wchar_t* uptr, unsigned int tlen)
     return len;
 }
 
+bool FileUtils::IsValidUTF8(const char* buffer, size_t len)
+{
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(buffer);
+    const unsigned char* end = p + len;
+    while(p < end) {
+        unsigned char ch = *p;
+        if(ch < 0x80) {
+            ++p;
+            continue;
+        }
+
+        // The number of continuation bytes and the range allowed for the first of them
+        size_t count;
+        unsigned char low = 0x80, high = 0xBF;
+        if(ch >= 0xC2 && ch <= 0xDF) {
+            count = 1;
+        } else if(ch >= 0xE0 && ch <= 0xEF) {
+            count = 2;
+            if(ch == 0xE0) { low = 0xA0; }  // overlong
+            if(ch == 0xED) { high = 0x9F; } // surrogates
+        } else if(ch >= 0xF0 && ch <= 0xF4) {
+            count = 3;
+            if(ch == 0xF0) { low = 0x90; }  // overlong
+            if(ch == 0xF4) { high = 0x8F; } // above U+10FFFF
+        } else {
+            return false;
+        }
+
+        if((size_t)(end - p) <= count) { return false; }
+        if(p[1] < low || p[1] > high) { return false; }
+        for(size_t i = 2; i <= count; ++i) {
+            if((p[i] & 0xC0) != 0x80) { return false; }
+        }
+        p += count + 1;
+    }
+    return true;
+}
+
 // This is readlink on steroids: it also makes-absolute, and dereferences any symlinked dirs in the path
 wxString FileUtils::RealPath(const wxString& filepath)
 {
@@ -220,6 +220,12 @@ public:
 
     static unsigned int UTF8Length(const wchar_t* uptr, unsigned int tlen);
 
+    /**
+     * @brief is 'buffer' a valid UTF-8 text? (overlong forms, surrogates and code points above U+10FFFF
+     * are rejected)
+     */
+    static bool IsValidUTF8(const char* buffer, size_t len);
+
     /**
      * @brief (on Linux) makes-absolute filepath, and dereferences it and any symlinked dirs in the path
      */
@@ -73,6 +73,11 @@ public:
      */
     virtual void ClearCache() = 0;
 
+    /**
+     * @brief clear the cached results affected by a change in 'filename'
+     */
+    virtual void ClearCache(const wxString& filename) = 0;
+
     /**
      * Return the currently opened database.
      * @return Currently open database
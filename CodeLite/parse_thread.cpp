@@ -24,6 +24,7 @@
 //////////////////////////////////////////////////////////////////////////////
 #include "CxxScannerTokens.h"
 #include "CxxVariableScanner.h"
+#include "clTrace.h"
 #include "cl_command_event.h"
 #include "cl_standard_paths.h"
 #include "cpp_scanner.h"
@@ -37,9 +38,13 @@
 #include "pptable.h"
 #include "precompiled_header.h"
 #include "tags_storage_sqlite3.h"
+#include <algorithm>
+#include <atomic>
 #include <set>
 #include <tags_options_data.h>
+#include <thread>
 #include <wx/ffile.h>
+#include <wx/msgqueue.h>
 #include <wx/stopwatch.h>
 #include <wx/tokenzr.h>
 #include "fileextmanager.h"
@@ -54,6 +59,9 @@
         }                                                                                                     \
     }
 
+// Number of files sent to the indexer in a single request
+#define PARSE_BATCH_SIZE 32
+
 // ClientData is set to wxString* which must be deleted by the handler
 wxDEFINE_EVENT(wxEVT_PARSE_THREAD_MESSAGE, wxCommandEvent);
 // ClientData is set to std::set<std::string> *newSet which must deleted by the handler
@@ -94,8 +102,30 @@ static const wxString& WriteCodeLiteCCHelperFile()
     return filepath;
 }
 
+namespace
+{
+// The symbols defined in 'filename', used to tell whether re-parsing the file added new symbols
+void GetFileSymbols(const wxString& filename, ITagsStoragePtr db, wxStringSet_t& symbols)
+{
+    std::vector<TagEntryPtr> tags;
+    db->SelectTagsByFile(filename, tags);
+    for(size_t i = 0; i < tags.size(); ++i) {
+        symbols.insert(tags[i]->GetKind() + "|" + tags[i]->GetPath() + "|" + tags[i]->GetSignature());
+    }
+}
+
+// A single file parsed by one of the retagging workers
+struct ParsedFile {
+    wxString filename;
+    TagTreePtr tree;
+    bool skipped = false;
+};
+} // namespace
+
 ParseThread::ParseThread()
     : WorkerThread()
+    , m_crawlerEnabled(true)
+    , m_parserWorkers(0)
 {
 }
 
@@ -106,6 +136,7 @@ void ParseThread::ProcessRequest(ThreadRequest* request)
     // request is delete by the parent WorkerThread after this method is completed
     ParseRequest* req = (ParseRequest*)request;
     FileLogger::RegisterThread(wxThread::GetCurrentId(), "C++ Parser Thread");
+    clTrace::SetThreadName("C++ Parser Thread");
     
     // Filter non C++ files
     if(!req->_workspaceFiles.empty()) {
@@ -122,6 +153,8 @@ void ParseThread::ProcessRequest(ThreadRequest* request)
 
     clDEBUG1() << "include paths:\n" << inc;
 
+    DoCheckNamesIndex(req->getDbfile());
+
     switch(req->getType()) {
     case ParseRequest::PR_PARSEINCLUDES:
         ProcessIncludes(req);
@@ -154,19 +187,32 @@ void ParseThread::ProcessRequest(ThreadRequest* request)
     DoNotifyReady(req->_evtHandler, req->getType());
 }
 
-void ParseThread::ParseIncludeFiles(ParseRequest* req, const wxString& filename, ITagsStoragePtr db)
+void ParseThread::DoCheckNamesIndex(const wxString& dbfile)
+{
+    // Databases created before the tag names index existed get their index built here, once, rather than
+    // when the database is opened (which is also done by the main thread)
+    if(dbfile.IsEmpty() || m_checkedDatabases.count(dbfile)) { return; }
+    m_checkedDatabases.insert(dbfile);
+
+    TagsStorageSQLite* storage = new TagsStorageSQLite();
+    ITagsStoragePtr db(storage);
+    db->OpenDatabase(dbfile);
+    storage->RebuildNamesIndexIfNeeded();
+}
+
+size_t ParseThread::ParseIncludeFiles(ParseRequest* req, const wxString& filename, ITagsStoragePtr db)
 {
     wxArrayString arrFiles;
     GetFileListToParse(filename, arrFiles);
     int initalCount = arrFiles.GetCount();
 
-    TEST_DESTROY();
+    if(TestDestroy()) { return 0; }
 
     DEBUG_MESSAGE(wxString::Format(wxT("Files that need parse %u"), (unsigned int)arrFiles.GetCount()));
     TagsManagerST::Get()->FilterNonNeededFilesForRetaging(arrFiles, db);
     DEBUG_MESSAGE(wxString::Format(wxT("Actual files that need parse %u"), (unsigned int)arrFiles.GetCount()));
 
-    ParseAndStoreFiles(req, arrFiles, initalCount, db);
+    return ParseAndStoreFiles(req, arrFiles, initalCount, db);
 }
 
 TagTreePtr ParseThread::DoTreeFromTags(const wxString& tags, int& count)
@@ -203,6 +249,18 @@ void ParseThread::SetSearchPaths(const wxArrayString& paths, const wxArrayString
     }
 }
 
+void ParseThread::SetParserWorkers(size_t workers)
+{
+    wxCriticalSectionLocker locker(m_cs);
+    m_parserWorkers = workers;
+}
+
+size_t ParseThread::GetParserWorkers()
+{
+    wxCriticalSectionLocker locker(m_cs);
+    return m_parserWorkers;
+}
+
 bool ParseThread::IsCrawlerEnabled()
 {
     wxCriticalSectionLocker locker(m_cs);
@@ -223,6 +281,7 @@ void ParseThread::GetSearchPaths(wxArrayString& paths, wxArrayString& excludePat
 
 void ParseThread::ProcessIncludes(ParseRequest* req)
 {
+    CL_TRACE_SCOPE("parser", "ParseThread::ProcessIncludes");
     std::set<wxString>* newSet = new std::set<wxString>();
     FindIncludedFiles(req, newSet);
 
@@ -237,6 +296,7 @@ void ParseThread::ProcessIncludes(ParseRequest* req)
 
 void ParseThread::ProcessSimple(ParseRequest* req)
 {
+    CL_TRACE_SCOPE("parser", "ParseThread::ProcessSimple");
     wxString dbfile = req->getDbfile();
     wxString file = req->getFile();
 
@@ -252,6 +312,11 @@ void ParseThread::ProcessSimple(ParseRequest* req)
     ITagsStoragePtr db(new TagsStorageSQLite());
     db->OpenDatabase(dbfile);
 
+    // remember the symbols of the file before replacing them
+    wxStringSet_t oldSymbols;
+    db->SetUseCache(false);
+    GetFileSymbols(req->getFile(), db, oldSymbols);
+
     // convert the file content into tags
     wxString tags;
     wxString file_name(req->getFile());
@@ -279,12 +344,26 @@ void ParseThread::ProcessSimple(ParseRequest* req)
     db->Commit();
 
     // Parse the saved file to get a list of files to include
-    ParseIncludeFiles(req, file, db);
+    size_t includedFilesStored = ParseIncludeFiles(req, file, db);
 
     // If there is no event handler set to handle this comaprison
     // results, then nothing more to be done
     if(req->_evtHandler) {
+        // If the file did not gain new symbols, only the cached results holding tags of this file
+        // are affected. A new symbol may belong to any cached query, and so may the tags of the
+        // included files that were (re)stored: clear the whole cache
+        wxStringSet_t newSymbols;
+        GetFileSymbols(file_name, db, newSymbols);
+        bool symbolsAdded = false;
+        for(const wxString& symbol : newSymbols) {
+            if(oldSymbols.count(symbol) == 0) {
+                symbolsAdded = true;
+                break;
+            }
+        }
+
         wxCommandEvent clearCacheEvent(wxEVT_PARSE_THREAD_CLEAR_TAGS_CACHE);
+        if(!symbolsAdded && includedFilesStored == 0) { clearCacheEvent.SetString(file); }
         req->_evtHandler->AddPendingEvent(clearCacheEvent);
 
         wxCommandEvent retaggingCompletedEvent(wxEVT_PARSE_THREAD_RETAGGING_COMPLETED);
@@ -335,21 +414,33 @@ void ParseThread::GetFileListToParse(const wxString& filename, wxArrayString& ar
     });
 }
 
-void ParseThread::ParseAndStoreFiles(ParseRequest* req, const wxArrayString& arrFiles, int initalCount,
-                                     ITagsStoragePtr db)
+size_t ParseThread::ParseAndStoreFiles(ParseRequest* req, const wxArrayString& arrFiles, int initalCount,
+                                       ITagsStoragePtr db)
 {
     // Loop over the files and parse them
     int totalSymbols(0);
+    size_t storedFiles(0);
     DEBUG_MESSAGE(wxString::Format(wxT("Parsing and saving files to database....")));
-    for(size_t i = 0; i < arrFiles.GetCount(); i++) {
+    for(size_t i = 0; i < arrFiles.GetCount(); i += PARSE_BATCH_SIZE) {
 
         // give a shutdown request a chance
-        TEST_DESTROY();
+        if(TestDestroy()) { return storedFiles; }
+
+        // Parse the files in batches to reduce the number of round trips to the indexer
+        wxArrayString batch;
+        for(size_t j = i; j < arrFiles.GetCount() && j < (i + PARSE_BATCH_SIZE); ++j) {
+            batch.Add(arrFiles.Item(j));
+        }
 
-        wxString tags; // output
-        TagsManagerST::Get()->SourceToTags(arrFiles.Item(i), tags);
+        wxArrayString batchTags; // output
+        TagsManagerST::Get()->SourceToTags(batch, batchTags);
 
-        if(tags.IsEmpty() == false) { DoStoreTags(tags, arrFiles.Item(i), totalSymbols, db); }
+        for(size_t j = 0; j < batchTags.GetCount(); ++j) {
+            if(batchTags.Item(j).IsEmpty() == false) {
+                DoStoreTags(batchTags.Item(j), batch.Item(j), totalSymbols, db);
+                ++storedFiles;
+            }
+        }
     }
 
     DEBUG_MESSAGE(wxString(wxT("Done")));
@@ -374,10 +465,12 @@ void ParseThread::ParseAndStoreFiles(ParseRequest* req, const wxArrayString& arr
             req->_evtHandler->AddPendingEvent(clearCacheEvent);
         }
     }
+    return storedFiles;
 }
 
 void ParseThread::ProcessDeleteTagsOfFiles(ParseRequest* req)
 {
+    CL_TRACE_SCOPE("parser", "ParseThread::ProcessDeleteTagsOfFiles");
     DEBUG_MESSAGE(wxString(wxT("ParseThread::ProcessDeleteTagsOfFile")));
     if(req->_workspaceFiles.empty()) return;
 
@@ -402,6 +495,7 @@ void ParseThread::ProcessDeleteTagsOfFiles(ParseRequest* req)
 
 void ParseThread::ProcessParseAndStore(ParseRequest* req)
 {
+    CL_TRACE_SCOPE("parser", "ParseThread::ProcessParseAndStore");
     wxString dbfile = req->getDbfile();
 
     // convert the file to tags
@@ -426,48 +520,55 @@ void ParseThread::ProcessParseAndStore(ParseRequest* req)
     req->_workspaceFiles.insert(req->_workspaceFiles.begin(), hackfile.ToStdString());
     PPTable::Instance()->Clear();
 
-    for(size_t i = 0; i < maxVal; i++) {
-
-        // give a shutdown request a chance
-        if(TestDestroy()) {
-            // Do an ordered shutdown:
-            // rollback any transaction
-            // and close the database
-            db->Rollback();
-            return;
-        }
-
-        wxFileName curFile(wxString(req->_workspaceFiles[i].c_str(), wxConvUTF8));
-
-        // Skip binary files
-        if(TagsManagerST::Get()->IsBinaryFile(curFile.GetFullPath())) {
-            DEBUG_MESSAGE(wxString::Format(wxT("Skipping binary file %s"), curFile.GetFullPath().c_str()));
-            continue;
-        }
-
-        // Send notification to the main window with our progress report
-        precent = (int)((i / maxVal) * 100);
-
-        if(req->_evtHandler && lastPercentageReported != precent) {
-            lastPercentageReported = precent;
-            wxCommandEvent retaggingProgressEvent(wxEVT_PARSE_THREAD_RETAGGING_PROGRESS);
-            retaggingProgressEvent.SetInt((int)precent);
-            req->_evtHandler->AddPendingEvent(retaggingProgressEvent);
-        }
-
-        TagTreePtr tree = TagsManagerST::Get()->ParseSourceFile(curFile);
-        PPScan(curFile.GetFullPath(), false);
-
-        db->Store(tree, wxFileName(), false);
-        if(db->InsertFileEntry(curFile.GetFullPath(), (int)time(NULL)) == TagExist) {
-            db->UpdateFileEntry(curFile.GetFullPath(), (int)time(NULL));
-        }
-
-        if(i % 50 == 0) {
-            // Commit what we got so far
-            db->Commit();
-            // Start a new transaction
-            db->Begin();
+    size_t workers = GetParserWorkers();
+    if(workers == 0) { workers = TagsOptionsData::GetDefaultParserThreads(); }
+
+    if(workers > 1) {
+        if(!DoParseAndStoreParallel(req, db, workers)) { return; }
+    } else {
+        for(size_t i = 0; i < maxVal; i++) {
+
+            // give a shutdown request a chance
+            if(TestDestroy()) {
+                // Do an ordered shutdown:
+                // rollback any transaction
+                // and close the database
+                db->Rollback();
+                return;
+            }
+
+            wxFileName curFile(wxString(req->_workspaceFiles[i].c_str(), wxConvUTF8));
+
+            // Skip binary files
+            if(TagsManagerST::Get()->IsBinaryFile(curFile.GetFullPath())) {
+                DEBUG_MESSAGE(wxString::Format(wxT("Skipping binary file %s"), curFile.GetFullPath().c_str()));
+                continue;
+            }
+
+            // Send notification to the main window with our progress report
+            precent = (int)((i / maxVal) * 100);
+
+            if(req->_evtHandler && lastPercentageReported != precent) {
+                lastPercentageReported = precent;
+                wxCommandEvent retaggingProgressEvent(wxEVT_PARSE_THREAD_RETAGGING_PROGRESS);
+                retaggingProgressEvent.SetInt((int)precent);
+                req->_evtHandler->AddPendingEvent(retaggingProgressEvent);
+            }
+
+            TagTreePtr tree = TagsManagerST::Get()->ParseSourceFile(curFile);
+            PPScan(curFile.GetFullPath(), false);
+
+            db->Store(tree, wxFileName(), false);
+            if(db->InsertFileEntry(curFile.GetFullPath(), (int)time(NULL)) == TagExist) {
+                db->UpdateFileEntry(curFile.GetFullPath(), (int)time(NULL));
+            }
+
+            if(i % 50 == 0) {
+                // Commit what we got so far
+                db->Commit();
+                // Start a new transaction
+                db->Begin();
+            }
         }
     }
 
@@ -494,6 +595,122 @@ void ParseThread::ProcessParseAndStore(ParseRequest* req)
     }
 }
 
+bool ParseThread::DoParseAndStoreParallel(ParseRequest* req, ITagsStoragePtr db, size_t workers)
+{
+    const std::vector<std::string>& files = req->_workspaceFiles;
+    const size_t totalFiles = files.size();
+    if(workers > totalFiles) { workers = totalFiles; }
+
+    clDEBUG() << "Retagging" << totalFiles << "files using" << workers << "parser threads" << clEndl;
+
+    // The workers share a copy of the parse settings: SetCtagsOptions() may be called while they run.
+    // Each worker sends its files to its own indexer process, so restarting an indexer that failed
+    // only affects the worker using it
+    const TagsManager::ParseSettings settings = TagsManagerST::Get()->GetParseSettings();
+
+    // The workers only parse files, all database access is done from this thread
+    std::atomic_size_t nextFile(0);
+    std::atomic_bool stopWorkers(false);
+    wxMessageQueue<ParsedFile*> results;
+
+    std::vector<std::thread> pool;
+    pool.reserve(workers);
+    for(size_t w = 0; w < workers; ++w) {
+        const size_t indexer = w % settings.indexerCount;
+        pool.push_back(std::thread([&, indexer]() {
+            FileLoggerNameRegistrar registrar("C++ Parser Worker");
+            while(!stopWorkers.load()) {
+                // Each worker claims a batch of files which is sent to the indexer in a single request
+                size_t first = nextFile.fetch_add(PARSE_BATCH_SIZE);
+                if(first >= totalFiles) { break; }
+                size_t last = std::min(first + PARSE_BATCH_SIZE, totalFiles);
+
+                std::vector<ParsedFile*> parsedFiles;
+                wxArrayString batch;
+                for(size_t index = first; index < last; ++index) {
+                    ParsedFile* parsedFile = new ParsedFile();
+                    parsedFile->filename = wxString(files[index].c_str(), wxConvUTF8);
+                    parsedFile->skipped = TagsManagerST::Get()->IsBinaryFile(parsedFile->filename);
+                    if(!parsedFile->skipped) { batch.Add(parsedFile->filename); }
+                    parsedFiles.push_back(parsedFile);
+                }
+
+                wxArrayString batchTags;
+                TagsManagerST::Get()->SourceToTags(batch, batchTags, settings, indexer);
+
+                size_t tagsIndex = 0;
+                for(ParsedFile* parsedFile : parsedFiles) {
+                    if(!parsedFile->skipped && tagsIndex < batchTags.GetCount()) {
+                        int count = 0;
+                        parsedFile->tree = TagsManagerST::Get()->TreeFromTags(batchTags.Item(tagsIndex++), count);
+                    }
+                    results.Post(parsedFile);
+                }
+            }
+        }));
+    }
+
+    auto JoinWorkers = [&]() {
+        stopWorkers.store(true);
+        for(std::thread& thr : pool) {
+            thr.join();
+        }
+        // Free any result that was not consumed
+        ParsedFile* parsedFile = nullptr;
+        while(results.ReceiveTimeout(0, parsedFile) == wxMSGQUEUE_NO_ERROR) {
+            wxDELETE(parsedFile);
+        }
+    };
+
+    int lastPercentageReported(0);
+    size_t stored(0);
+    size_t received(0);
+    while(received < totalFiles) {
+        // give a shutdown request a chance
+        if(TestDestroy()) {
+            JoinWorkers();
+            db->Rollback();
+            return false;
+        }
+
+        ParsedFile* parsedFile = nullptr;
+        if(results.ReceiveTimeout(50, parsedFile) != wxMSGQUEUE_NO_ERROR) { continue; }
+        std::unique_ptr<ParsedFile> result(parsedFile);
+        ++received;
+
+        // Send notification to the main window with our progress report
+        int precent = (int)(((double)received / (double)totalFiles) * 100);
+        if(req->_evtHandler && lastPercentageReported != precent) {
+            lastPercentageReported = precent;
+            wxCommandEvent retaggingProgressEvent(wxEVT_PARSE_THREAD_RETAGGING_PROGRESS);
+            retaggingProgressEvent.SetInt(precent);
+            req->_evtHandler->AddPendingEvent(retaggingProgressEvent);
+        }
+
+        if(result->skipped) {
+            DEBUG_MESSAGE(wxString::Format(wxT("Skipping binary file %s"), result->filename.c_str()));
+            continue;
+        }
+
+        // The pre-processor table is a global object, so we scan the macros from this thread only
+        PPScan(result->filename, false);
+
+        db->Store(result->tree, wxFileName(), false);
+        if(db->InsertFileEntry(result->filename, (int)time(NULL)) == TagExist) {
+            db->UpdateFileEntry(result->filename, (int)time(NULL));
+        }
+
+        if(++stored % 50 == 0) {
+            // Commit what we got so far
+            db->Commit();
+            // Start a new transaction
+            db->Begin();
+        }
+    }
+    JoinWorkers();
+    return true;
+}
+
 void ParseThread::FindIncludedFiles(ParseRequest* req, std::set<wxString>* newSet)
 {
     wxArrayString searchPaths, excludePaths, filteredFileList;
@@ -586,6 +803,7 @@ ParseThread* ParseThreadST::Get()
 
 void ParseThread::ProcessSimpleNoIncludes(ParseRequest* req)
 {
+    CL_TRACE_SCOPE("parser", "ParseThread::ProcessSimpleNoIncludes");
     std::vector<std::string> files = req->_workspaceFiles;
     wxString dbfile = req->getDbfile();
 
@@ -614,6 +832,7 @@ void ParseThread::ProcessSimpleNoIncludes(ParseRequest* req)
 
 void ParseThread::ProcessIncludeStatements(ParseRequest* req)
 {
+    CL_TRACE_SCOPE("parser", "ParseThread::ProcessIncludeStatements");
     fcFileOpener::Set_t* matches = new fcFileOpener::Set_t;
     {
         wxString file = req->getFile();
@@ -651,6 +870,7 @@ void ParseThread::DoNotifyReady(wxEvtHandler* caller, int requestType)
 
 void ParseThread::ProcessColourRequest(ParseRequest* req)
 {
+    CL_TRACE_SCOPE("parser", "ParseThread::ProcessColourRequest");
     CxxTokenizer tokenizer;
     // read the file content
     wxString content;
@@ -701,6 +921,7 @@ void ParseThread::ProcessColourRequest(ParseRequest* req)
 
 void ParseThread::ProcessSourceToTags(ParseRequest* req)
 {
+    CL_TRACE_SCOPE("parser", "ParseThread::ProcessSourceToTags");
     wxFileName filename(req->getFile());
     if(TagsManagerST::Get()->IsBinaryFile(filename.GetFullPath())) { return; }
 
@@ -125,10 +125,18 @@ class WXDLLIMPEXP_CL ParseThread : public WorkerThread
     wxArrayString m_searchPaths;
     wxArrayString m_excludePaths;
     bool m_crawlerEnabled;
+    size_t m_parserWorkers;
     wxCriticalSection m_cs;
+    wxStringSet_t m_checkedDatabases; // databases whose tag names index was checked
 
 public:
     void SetCrawlerEnabeld(bool b);
+    /**
+     * @brief set the number of threads used when retagging the workspace.
+     * 0 means: TagsOptionsData::GetDefaultParserThreads(), 1 means: parse the files sequentially on the parser thread
+     */
+    void SetParserWorkers(size_t workers);
+    size_t GetParserWorkers();
     void SetSearchPaths(const wxArrayString& paths, const wxArrayString& exlucdePaths);
     void GetSearchPaths(wxArrayString& paths, wxArrayString& excludePaths);
     bool IsCrawlerEnabled();
@@ -147,6 +155,7 @@ private:
     void DoStoreTags(const wxString& tags, const wxString& filename, int& count, ITagsStoragePtr db);
     TagTreePtr DoTreeFromTags(const wxString& tags, int& count);
     void DoNotifyReady(wxEvtHandler* caller, int requestType);
+    void DoCheckNamesIndex(const wxString& dbfile);
 
 private:
     /**
@@ -159,19 +168,26 @@ private:
      * include files that should be tagged and inserted into
      * the external database
      * @param filename
+     * @return the number of included files whose tags were stored
      */
-    void ParseIncludeFiles(ParseRequest* req, const wxString& filename, ITagsStoragePtr db);
+    size_t ParseIncludeFiles(ParseRequest* req, const wxString& filename, ITagsStoragePtr db);
 
     void ProcessSimple(ParseRequest* req);
     void ProcessSourceToTags(ParseRequest* req);
     void ProcessIncludes(ParseRequest* req);
     void ProcessParseAndStore(ParseRequest* req);
+    /**
+     * @brief parse the request files using a pool of 'workers' threads. The results are stored into the database
+     * by the calling thread (the parser thread), which is the only thread that writes to 'db'
+     * @return false if the thread was requested to terminate while processing the files
+     */
+    bool DoParseAndStoreParallel(ParseRequest* req, ITagsStoragePtr db, size_t workers);
     void ProcessDeleteTagsOfFiles(ParseRequest* req);
     void ProcessSimpleNoIncludes(ParseRequest* req);
     void ProcessIncludeStatements(ParseRequest* req);
     void ProcessColourRequest(ParseRequest* req);
     void GetFileListToParse(const wxString& filename, wxArrayString& arrFiles);
-    void ParseAndStoreFiles(ParseRequest* req, const wxArrayString& arrFiles, int initalCount, ITagsStoragePtr db);
+    size_t ParseAndStoreFiles(ParseRequest* req, const wxArrayString& arrFiles, int initalCount, ITagsStoragePtr db);
 
     void FindIncludedFiles(ParseRequest* req, std::set<wxString>* newSet);
 };
@@ -187,6 +203,8 @@ public:
 wxDECLARE_EXPORTED_EVENT(WXDLLIMPEXP_CL, wxEVT_PARSE_THREAD_MESSAGE, wxCommandEvent);
 // ClientData is set to std::set<std::string> *newSet which must deleted by the handler
 wxDECLARE_EXPORTED_EVENT(WXDLLIMPEXP_CL, wxEVT_PARSE_THREAD_SCAN_INCLUDES_DONE, wxCommandEvent);
+// GetString() is set to the re-parsed file when only the cached results of that file are affected,
+// it is empty when the whole cache should be cleared
 wxDECLARE_EXPORTED_EVENT(WXDLLIMPEXP_CL, wxEVT_PARSE_THREAD_CLEAR_TAGS_CACHE, wxCommandEvent);
 wxDECLARE_EXPORTED_EVENT(WXDLLIMPEXP_CL, wxEVT_PARSE_THREAD_RETAGGING_PROGRESS, wxCommandEvent);
 wxDECLARE_EXPORTED_EVENT(WXDLLIMPEXP_CL, wxEVT_PARSE_THREAD_RETAGGING_COMPLETED, wxCommandEvent);
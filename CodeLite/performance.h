@@ -58,6 +58,9 @@
 // The <elapsed> element shows the time spent for the entire block it is in, and includes an optional "unaccounted"
 // attribute for any ticks not counted by inner blocks (so you know how much time you're missing from profiled
 //  subfunctions).
+//
+// These macros are compiled in on demand. To trace a running CodeLite (on any platform), use the spans of
+// clTrace.h instead: they are recorded when enabled from the Help menu and exported as a Chrome trace.
 
 #include "codelite_exports.h"
 
@@ -22,21 +22,29 @@
 //
 //////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////
+#include "clFileContent.h"
 #include "clFilesCollector.h"
+#include "clTrace.h"
 #include "cppwordscanner.h"
 #include "dirtraverser.h"
+#include "file_logger.h"
 #include "fileutils.h"
 #include "macros.h"
 #include "search_thread.h"
 #include "wx/event.h"
 #include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <map>
 #include <set>
+#include <string.h>
+#include <thread>
 #include <wx/dir.h>
 #if wxUSE_GUI
 #include <wx/fontmap.h>
 #endif
 #include <wx/log.h>
+#include <wx/msgqueue.h>
 #include <wx/tokenzr.h>
 #include <wx/txtstrm.h>
 #include <wx/wfstream.h>
@@ -58,6 +66,107 @@ wxDEFINE_EVENT(wxEVT_SEARCH_THREAD_SEARCHSTARTED, wxCommandEvent);
     }                                         \
     wxThread::Sleep(1);
 
+namespace
+{
+// The matches of a single file, searched by one of the search workers
+struct SearchFileResults {
+    size_t index = 0;
+    SearchResultList results;
+    bool failed = false;
+};
+
+/**
+ * Boyer-Moore-Horspool search over raw bytes. When ignoring case, the pattern must be
+ * lower case ASCII: the text is folded with an ASCII table while it is scanned
+ */
+class ByteSearcher
+{
+    std::string m_pattern;
+    bool m_ignoreCase;
+    size_t m_skip[256];
+    unsigned char m_fold[256];
+
+    bool Equals(const unsigned char* text, size_t len) const
+    {
+        if(!m_ignoreCase) { return memcmp(text, m_pattern.c_str(), len) == 0; }
+        for(size_t i = 0; i < len; ++i) {
+            if(m_fold[text[i]] != (unsigned char)m_pattern[i]) { return false; }
+        }
+        return true;
+    }
+
+public:
+    ByteSearcher(const std::string& pattern, bool ignoreCase)
+        : m_pattern(pattern)
+        , m_ignoreCase(ignoreCase)
+    {
+        for(size_t i = 0; i < 256; ++i) {
+            m_fold[i] = (ignoreCase && i >= 'A' && i <= 'Z') ? (unsigned char)(i - 'A' + 'a') : (unsigned char)i;
+            m_skip[i] = m_pattern.length();
+        }
+        for(size_t i = 0; i + 1 < m_pattern.length(); ++i) {
+            m_skip[(unsigned char)m_pattern[i]] = m_pattern.length() - 1 - i;
+        }
+    }
+
+    /**
+     * Return a pointer to the first occurrence of the pattern in the range [begin, end) or nullptr
+     */
+    const char* Find(const char* begin, const char* end) const
+    {
+        size_t len = m_pattern.length();
+        if(len == 0 || (size_t)(end - begin) < len) { return nullptr; }
+
+        const char* last = end - len;
+        if(!m_ignoreCase && len < 4) {
+            // The skip distance is too short to pay off: let memchr (vectorized by the C library) find the
+            // candidates
+            for(const char* p = begin; p <= last; ++p) {
+                p = (const char*)memchr(p, m_pattern[0], last - p + 1);
+                if(!p) { return nullptr; }
+                if(Equals((const unsigned char*)p, len)) { return p; }
+            }
+            return nullptr;
+        }
+
+        unsigned char lastCh = m_pattern[len - 1];
+        for(const unsigned char* p = (const unsigned char*)begin; p <= (const unsigned char*)last;) {
+            unsigned char ch = m_fold[p[len - 1]];
+            if(ch == lastCh && Equals(p, len - 1)) { return (const char*)p; }
+            p += m_skip[ch];
+        }
+        return nullptr;
+    }
+};
+
+/**
+ * Return the length, in wxString characters, of the UTF-8 text in the range [begin, end)
+ */
+int UTF8CharsCount(const char* begin, const char* end)
+{
+    int count = 0;
+    for(const unsigned char* p = (const unsigned char*)begin; p < (const unsigned char*)end; ++p) {
+        // count everything but continuation bytes
+        count += ((*p & 0xC0) != 0x80);
+#if SIZEOF_WCHAR_T == 2
+        // characters outside the BMP are stored as surrogate pairs
+        count += (*p >= 0xF0);
+#endif
+    }
+    return count;
+}
+
+bool IsUTF8Encoding(const SearchData* data)
+{
+#if wxUSE_GUI
+    return wxFontMapper::GetEncodingFromName(data->GetEncoding()) == wxFONTENCODING_UTF8;
+#else
+    wxUnusedVar(data);
+    return false;
+#endif
+}
+} // namespace
+
 //----------------------------------------------------------------
 // SearchData
 //----------------------------------------------------------------
@@ -94,7 +203,6 @@ SearchData& SearchData::Copy(const SearchData& other)
 SearchThread::SearchThread()
     : WorkerThread()
     , m_wordChars(wxT("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_"))
-    , m_reExpr(wxT(""))
 {
     IndexWordChars();
 }
@@ -115,29 +223,18 @@ void SearchThread::SetWordChars(const wxString& chars)
     IndexWordChars();
 }
 
-wxRegEx& SearchThread::GetRegex(const wxString& expr, bool matchCase)
-{
-    if(m_reExpr == expr && matchCase == m_matchCase) {
-        return m_regex;
-    } else {
-        m_reExpr = expr;
-        m_matchCase = matchCase;
-#ifndef __WXMAC__
-        int flags = wxRE_ADVANCED;
-#else
-        int flags = wxRE_DEFAULT;
-#endif
+void SearchThread::PerformSearch(const SearchData& data) { Add(new SearchData(data)); }
 
-        if(!matchCase) flags |= wxRE_ICASE;
-        m_regex.Compile(m_reExpr, flags);
-    }
-    return m_regex;
+bool SearchThread::SearchFile(const wxString& fileName, const SearchData& data, SearchResultList& results)
+{
+    clRegexEngine::Ptr_t re;
+    if(data.IsRegularExpression()) { re = clRegexEngine::New(data.GetFindString(), data.IsMatchCase()); }
+    return DoSearchFile(fileName, &data, results, re);
 }
 
-void SearchThread::PerformSearch(const SearchData& data) { Add(new SearchData(data)); }
-
 void SearchThread::ProcessRequest(ThreadRequest* req)
 {
+    CL_TRACE_SCOPE("search", "SearchThread::ProcessRequest");
     wxStopWatch sw;
     m_summary = SearchSummary();
     DoSearchFiles(req);
@@ -164,10 +261,13 @@ void SearchThread::GetFiles(const SearchData* data, wxArrayString& files)
     for(size_t i = 0; i < rootDirs.size(); ++i) {
         // make sure it's really a dir (not a fifo, etc.)
         clFilesScanner scanner;
-        std::vector<wxString> filesV;
-        if(scanner.Scan(rootDirs.Item(i), filesV, data->GetExtensions())) {
-            std::for_each(filesV.begin(), filesV.end(), [&](const wxString& file) { scannedFiles.insert(file); });
-        }
+        scanner.Scan(rootDirs.Item(i),
+                     [&](const std::vector<wxString>& filesV) {
+                         scannedFiles.insert(filesV.begin(), filesV.end());
+                         // Stop collecting files if the search was cancelled
+                         return !TestStopSearch();
+                     },
+                     data->GetExtensions());
     }
 
     files.clear();
@@ -206,9 +306,40 @@ void SearchThread::DoSearchFiles(ThreadRequest* req)
         }
     }
 
-    for(size_t i = 0; i < fileList.Count(); i++) {
-        m_summary.SetNumFileScanned((int)i + 1);
+    if(fileList.IsEmpty()) { return; }
+
+    int cpus = wxThread::GetCPUCount();
+    size_t workers = (cpus > 0) ? std::min((size_t)cpus, fileList.size()) : 1;
+    clDEBUG1() << "Searching" << fileList.size() << "files using" << workers << "threads" << clEndl;
+
+    // The workers search the files, this thread delivers their matches in the order of fileList
+    std::atomic_size_t nextFile(0);
+    std::atomic_bool stopWorkers(false);
+    wxMessageQueue<SearchFileResults*> queue;
+
+    std::vector<std::thread> pool;
+    pool.reserve(workers);
+    for(size_t w = 0; w < workers; ++w) {
+        pool.push_back(std::thread([&]() {
+            // The regex engines keep matching state, each worker uses its own
+            clRegexEngine::Ptr_t re;
+            if(data->IsRegularExpression()) { re = clRegexEngine::New(data->GetFindString(), data->IsMatchCase()); }
+            while(!stopWorkers.load()) {
+                size_t index = nextFile.fetch_add(1);
+                if(index >= fileList.size()) { break; }
+
+                SearchFileResults* fileResults = new SearchFileResults();
+                fileResults->index = index;
+                fileResults->failed = !DoSearchFile(fileList.Item(index), data, fileResults->results, re);
+                queue.Post(fileResults);
+            }
+        }));
+    }
 
+    // Files completed ahead of their turn
+    std::map<size_t, SearchFileResults*> pending;
+    size_t nextToDeliver = 0;
+    while(nextToDeliver < fileList.size()) {
         // give user chance to cancel the search ...
         if(TestStopSearch()) {
             // Send cancel event
@@ -216,7 +347,38 @@ void SearchThread::DoSearchFiles(ThreadRequest* req)
             StopSearch(false);
             break;
         }
-        DoSearchFile(fileList.Item(i), data);
+
+        SearchFileResults* fileResults = nullptr;
+        if(queue.ReceiveTimeout(50, fileResults) != wxMSGQUEUE_NO_ERROR) { continue; }
+        pending.insert(std::make_pair(fileResults->index, fileResults));
+
+        while(!pending.empty() && pending.begin()->first == nextToDeliver) {
+            fileResults = pending.begin()->second;
+            pending.erase(pending.begin());
+
+            m_summary.SetNumFileScanned((int)++nextToDeliver);
+            if(fileResults->failed) { m_summary.GetFailedFiles().Add(fileList.Item(fileResults->index)); }
+            if(!fileResults->results.empty()) {
+                m_summary.SetNumMatchesFound(m_summary.GetNumMatchesFound() + (int)fileResults->results.size());
+                m_results.splice(m_results.end(), fileResults->results);
+                SendEvent(wxEVT_SEARCH_THREAD_MATCHFOUND, data->GetOwner());
+            }
+            wxDELETE(fileResults);
+        }
+    }
+
+    stopWorkers.store(true);
+    for(std::thread& thr : pool) {
+        thr.join();
+    }
+
+    // Release the results of a cancelled search
+    for(auto& p : pending) {
+        delete p.second;
+    }
+    SearchFileResults* fileResults = nullptr;
+    while(queue.ReceiveTimeout(0, fileResults) == wxMSGQUEUE_NO_ERROR) {
+        delete fileResults;
     }
 }
 
@@ -236,14 +398,22 @@ void SearchThread::StopSearch(bool stop)
     m_stopSearch = stop;
 }
 
-void SearchThread::DoSearchFile(const wxString& fileName, const SearchData* data)
+bool SearchThread::DoSearchFile(const wxString& fileName, const SearchData* data, SearchResultList& results,
+                                clRegexEngine::Ptr_t re)
 {
+    CL_TRACE_SCOPE("search", "SearchThread::DoSearchFile");
     // Process single lines
     int lineNumber = 1;
-    if(!wxFileName::FileExists(fileName)) { return; }
+    if(!wxFileName::FileExists(fileName)) { return true; }
 
     size_t size = FileUtils::GetFileSize(fileName);
-    if(size == 0) { return; }
+    if(size == 0) { return true; }
+
+    // Plain text searches in UTF-8 files scan the raw file content instead of converting it
+    if(!data->IsRegularExpression() && IsUTF8Encoding(data) && DoSearchFileUTF8(fileName, data, results)) {
+        return true;
+    }
+
     wxString fileData;
     fileData.Alloc(size);
 
@@ -251,15 +421,9 @@ void SearchThread::DoSearchFile(const wxString& fileName, const SearchData* data
     // support for other encoding
     wxFontEncoding enc = wxFontMapper::GetEncodingFromName(data->GetEncoding().c_str());
     wxCSConv fontEncConv(enc);
-    if(!FileUtils::ReadFileContent(fileName, fileData, fontEncConv)) {
-        m_summary.GetFailedFiles().Add(fileName);
-        return;
-    }
+    if(!FileUtils::ReadFileContent(fileName, fileData, fontEncConv)) { return false; }
 #else
-    if(!FileUtils::ReadFileContent(fileName, fileData, wxConvLibc)) {
-        m_summary.GetFailedFiles().Add(fileName);
-        return;
-    }
+    if(!FileUtils::ReadFileContent(fileName, fileData, wxConvLibc)) { return false; }
 #endif
     // take a wild guess and see if we really need to construct
     // a TextStatesPtr object (it is quite an expensive operation)
@@ -273,8 +437,6 @@ void SearchThread::DoSearchFile(const wxString& fileName, const SearchData* data
         shouldCreateStates = (tmpData.MakeLower().Find(data->GetFindString()) != wxNOT_FOUND);
     }
 
-    wxStringTokenizer tkz(fileData, wxT("\n"), wxTOKEN_RET_EMPTY_ALL);
-
     // Incase one of the C++ options is enabled,
     // create a text states object
     TextStatesPtr states(NULL);
@@ -283,135 +445,206 @@ void SearchThread::DoSearchFile(const wxString& fileName, const SearchData* data
         states = scanner.states();
     }
 
-    int lineOffset = 0;
     if(data->IsRegularExpression()) {
-        // regular expression search
-        while(tkz.HasMoreTokens()) {
-            // Read the next line
-            wxString line = tkz.NextToken();
-            DoSearchLineRE(line, lineNumber, lineOffset, fileName, data, states);
-            lineOffset += line.Length() + 1;
-            lineNumber++;
-        }
+        // regular expression search, over the whole file
+        DoSearchFileRE(fileData, fileName, data, re, states, results);
     } else {
         // simple search
         wxString findString;
         wxArrayString filters;
-        findString = data->GetFindString();
-        if(data->IsEnablePipeSupport()) {
-            if(data->GetFindString().Find('|') != wxNOT_FOUND) {
-                findString = data->GetFindString().BeforeFirst('|');
-
-                wxString filtersString = data->GetFindString().AfterFirst('|');
-                filters = ::wxStringTokenize(filtersString, "|", wxTOKEN_STRTOK);
-                if(!data->IsMatchCase()) {
-                    for(size_t i = 0; i < filters.size(); ++i) {
-                        filters.Item(i).MakeLower();
-                    }
-                }
-            }
-        }
-
-        if(!data->IsMatchCase()) { findString.MakeLower(); }
+        GetFindWhat(data, findString, filters);
 
+        int lineOffset = 0;
+        wxStringTokenizer tkz(fileData, wxT("\n"), wxTOKEN_RET_EMPTY_ALL);
         while(tkz.HasMoreTokens()) {
 
             // Read the next line
             wxString line = tkz.NextToken();
-            DoSearchLine(line, lineNumber, lineOffset, fileName, data, findString, filters, states);
+            DoSearchLine(line, lineNumber, lineOffset, fileName, data, findString, filters, states, results);
             lineOffset += line.Length() + 1;
             lineNumber++;
         }
     }
+    return true;
+}
+
+void SearchThread::GetFindWhat(const SearchData* data, wxString& findWhat, wxArrayString& filters)
+{
+    findWhat = data->GetFindString();
+    filters.clear();
+    if(data->IsEnablePipeSupport()) {
+        if(data->GetFindString().Find('|') != wxNOT_FOUND) {
+            findWhat = data->GetFindString().BeforeFirst('|');
+
+            wxString filtersString = data->GetFindString().AfterFirst('|');
+            filters = ::wxStringTokenize(filtersString, "|", wxTOKEN_STRTOK);
+            if(!data->IsMatchCase()) {
+                for(size_t i = 0; i < filters.size(); ++i) {
+                    filters.Item(i).MakeLower();
+                }
+            }
+        }
+    }
 
-    if(m_results.empty() == false) { SendEvent(wxEVT_SEARCH_THREAD_MATCHFOUND, data->GetOwner()); }
+    if(!data->IsMatchCase()) { findWhat.MakeLower(); }
 }
 
-void SearchThread::DoSearchLineRE(const wxString& line, const int lineNum, const int lineOffset,
-                                  const wxString& fileName, const SearchData* data, TextStatesPtr statesPtr)
+bool SearchThread::DoSearchFileUTF8(const wxString& fileName, const SearchData* data, SearchResultList& results)
 {
-    wxRegEx& re = GetRegex(data->GetFindString(), data->IsMatchCase());
-    size_t col = 0;
-    int iCorrectedCol = 0;
-    int iCorrectedLen = 0;
-    wxString modLine = line;
-    if(re.IsValid()) {
-        while(re.Matches(modLine)) {
-            size_t start, len;
-            re.GetMatch(&start, &len);
-            col += start;
+    wxString findWhat;
+    wxArrayString filters;
+    GetFindWhat(data, findWhat, filters);
+
+    // The bytes are folded with an ASCII table, so a case insensitive search requires an ASCII pattern
+    wxCharBuffer pattern = findWhat.utf8_str();
+    std::string bytes(pattern.data(), pattern.length());
+    if(bytes.empty()) { return false; }
+    if(!data->IsMatchCase() &&
+       std::any_of(bytes.begin(), bytes.end(), [](char ch) { return (unsigned char)ch >= 0x80; })) {
+        return false;
+    }
 
-            // Notify our match
-            // correct search Pos and Length owing to non plain ASCII multibyte characters
-            iCorrectedCol = FileUtils::UTF8Length(line.c_str(), col);
-            iCorrectedLen = FileUtils::UTF8Length(line.c_str(), col + len) - iCorrectedCol;
-            SearchResult result;
-            result.SetPosition(lineOffset + col);
-            result.SetColumnInChars((int)col);
-            result.SetColumn(iCorrectedCol);
-            result.SetLineNumber(lineNum);
-            result.SetPattern(line);
-            result.SetFileName(fileName);
-            result.SetLenInChars((int)len);
-            result.SetLen(iCorrectedLen);
-            result.SetFlags(data->m_flags);
-            result.SetFindWhat(data->GetFindString());
+    // If the file can not be opened, let DoSearchFile report it
+    clFileContent file;
+    if(!file.Open(fileName)) { return false; }
 
-            // Make sure our match is not on a comment
-            int position(wxNOT_FOUND);
-            bool canAdd(true);
+    ByteSearcher searcher(bytes, !data->IsMatchCase());
+    const char* end = file.GetData() + file.GetSize();
+    const char* lineStart = file.GetData();
+    const char* offsetStart = lineStart; // lineOffset is the number of characters up to this point
+    int lineNumber = 1;
+    int lineOffset = 0;
 
-            if(statesPtr) {
-                position = statesPtr->LineToPos(lineNum - 1);
-                position += iCorrectedCol;
-            }
+    size_t resultsCount = results.size();
 
-            if(statesPtr && position != wxNOT_FOUND && data->GetSkipComments()) {
-                if(statesPtr->states.size() > (size_t)position) {
-                    short state = statesPtr->states.at(position).state;
-                    if(state == CppWordScanner::STATE_CPP_COMMENT || state == CppWordScanner::STATE_C_COMMENT) {
-                        canAdd = false;
-                    }
-                }
+    const char* match = searcher.Find(lineStart, end);
+    while(match) {
+        // Advance to the line containing the match
+        const char* nl = (const char*)memchr(lineStart, '\n', match - lineStart);
+        while(nl) {
+            ++lineNumber;
+            lineStart = nl + 1;
+            nl = (const char*)memchr(lineStart, '\n', match - lineStart);
+        }
+        lineOffset += UTF8CharsCount(offsetStart, lineStart);
+        offsetStart = lineStart;
+
+        const char* lineEnd = (const char*)memchr(match, '\n', end - match);
+        if(!lineEnd) { lineEnd = end; }
+
+        // Only lines containing a match are decoded
+        wxString line = wxString::FromUTF8(lineStart, lineEnd - lineStart);
+        if(line.IsEmpty()) {
+            // Not a valid UTF-8 file: discard this file's matches, the caller will convert it
+            while(results.size() > resultsCount) {
+                results.pop_back();
             }
+            return false;
+        }
+        DoSearchLine(line, lineNumber, lineOffset, fileName, data, findWhat, filters, NULL, results);
 
-            if(statesPtr && position != wxNOT_FOUND && data->GetSkipStrings()) {
-                if(statesPtr->states.size() > (size_t)position) {
-                    short state = statesPtr->states.at(position).state;
-                    if(state == CppWordScanner::STATE_DQ_STRING || state == CppWordScanner::STATE_SINGLE_STRING) {
-                        canAdd = false;
-                    }
+        if(lineEnd == end) { break; }
+        ++lineNumber;
+        lineOffset += (int)line.Length() + 1;
+        lineStart = offsetStart = lineEnd + 1;
+        match = searcher.Find(lineStart, end);
+    }
+    return true;
+}
+
+void SearchThread::DoSearchFileRE(const wxString& fileData, const wxString& fileName, const SearchData* data,
+                                  clRegexEngine::Ptr_t re, TextStatesPtr statesPtr, SearchResultList& results)
+{
+    if(!re || !re->IsValid()) { return; }
+
+    int lineNum = 1;
+    size_t lineOffset = 0; // the start of line 'lineNum'
+    size_t from = 0;
+    size_t start, len;
+    int iCorrectedCol = 0;
+    int iCorrectedLen = 0;
+    while(from <= fileData.length() && re->Find(fileData, from, start, len)) {
+        // Advance to the line containing the match
+        size_t lineEnd = fileData.find('\n', lineOffset);
+        while(lineEnd != wxString::npos && lineEnd < start) {
+            ++lineNum;
+            lineOffset = lineEnd + 1;
+            lineEnd = fileData.find('\n', lineOffset);
+        }
+        if(lineEnd == wxString::npos) { lineEnd = fileData.length(); }
+
+        // Empty matches are not reported, and a match is reported on the line it starts on
+        if(start + len > lineEnd) { len = lineEnd - start; }
+        if(len == 0) {
+            from = start + 1;
+            continue;
+        }
+        from = start + len;
+
+        wxString line = fileData.Mid(lineOffset, lineEnd - lineOffset);
+        size_t col = start - lineOffset;
+
+        // Notify our match
+        // correct search Pos and Length owing to non plain ASCII multibyte characters
+        iCorrectedCol = FileUtils::UTF8Length(line.c_str(), col);
+        iCorrectedLen = FileUtils::UTF8Length(line.c_str(), col + len) - iCorrectedCol;
+        SearchResult result;
+        result.SetPosition((int)(lineOffset + col));
+        result.SetColumnInChars((int)col);
+        result.SetColumn(iCorrectedCol);
+        result.SetLineNumber(lineNum);
+        result.SetPattern(line);
+        result.SetFileName(fileName);
+        result.SetLenInChars((int)len);
+        result.SetLen(iCorrectedLen);
+        result.SetFlags(data->m_flags);
+        result.SetFindWhat(data->GetFindString());
+
+        // Make sure our match is not on a comment
+        int position(wxNOT_FOUND);
+        bool canAdd(true);
+
+        if(statesPtr) {
+            position = statesPtr->LineToPos(lineNum - 1);
+            position += iCorrectedCol;
+        }
+
+        if(statesPtr && position != wxNOT_FOUND && data->GetSkipComments()) {
+            if(statesPtr->states.size() > (size_t)position) {
+                short state = statesPtr->states.at(position).state;
+                if(state == CppWordScanner::STATE_CPP_COMMENT || state == CppWordScanner::STATE_C_COMMENT) {
+                    canAdd = false;
                 }
             }
+        }
 
-            result.SetMatchState(CppWordScanner::STATE_NORMAL);
-            if(canAdd && statesPtr && position != wxNOT_FOUND && data->GetColourComments()) {
-                // set the match state
-                if(statesPtr->states.size() > (size_t)position) {
-                    short state = statesPtr->states.at(position).state;
-                    if(state == CppWordScanner::STATE_C_COMMENT || state == CppWordScanner::STATE_CPP_COMMENT) {
-                        result.SetMatchState(state);
-                    }
+        if(statesPtr && position != wxNOT_FOUND && data->GetSkipStrings()) {
+            if(statesPtr->states.size() > (size_t)position) {
+                short state = statesPtr->states.at(position).state;
+                if(state == CppWordScanner::STATE_DQ_STRING || state == CppWordScanner::STATE_SINGLE_STRING) {
+                    canAdd = false;
                 }
             }
+        }
 
-            if(canAdd) {
-                m_results.push_back(result);
-                m_summary.SetNumMatchesFound(m_summary.GetNumMatchesFound() + 1);
+        result.SetMatchState(CppWordScanner::STATE_NORMAL);
+        if(canAdd && statesPtr && position != wxNOT_FOUND && data->GetColourComments()) {
+            // set the match state
+            if(statesPtr->states.size() > (size_t)position) {
+                short state = statesPtr->states.at(position).state;
+                if(state == CppWordScanner::STATE_C_COMMENT || state == CppWordScanner::STATE_CPP_COMMENT) {
+                    result.SetMatchState(state);
+                }
             }
-
-            col += len;
-
-            // adjust the line
-            if(line.Length() - col <= 0) break;
-            modLine = modLine.Right(line.Length() - col);
         }
+
+        if(canAdd) { results.push_back(result); }
     }
 }
 
 void SearchThread::DoSearchLine(const wxString& line, const int lineNum, const int lineOffset, const wxString& fileName,
                                 const SearchData* data, const wxString& findWhat, const wxArrayString& filters,
-                                TextStatesPtr statesPtr)
+                                TextStatesPtr statesPtr, SearchResultList& results)
 {
     wxString modLine = line;
 
@@ -522,10 +755,7 @@ void SearchThread::DoSearchLine(const wxString& line, const int lineNum, const i
                 }
             }
 
-            if(canAdd) {
-                m_results.push_back(result);
-                m_summary.SetNumMatchesFound(m_summary.GetNumMatchesFound() + 1);
-            }
+            if(canAdd) { results.push_back(result); }
 
             if(!AdjustLine(modLine, pos, findWhat)) { break; }
             col += (int)findWhat.Length();
@@ -563,7 +793,6 @@ void SearchThread::SendEvent(wxEventType type, wxEvtHandler* owner)
     } else if(type == wxEVT_SEARCH_THREAD_MATCHFOUND) {
         // a match event, but we did not meet the minimum number of files
         counter++;
-        wxThread::Sleep(10);
 
     } else if((type == wxEVT_SEARCH_THREAD_SEARCHEND) || (type == wxEVT_SEARCH_THREAD_SEARCHCANCELED)) {
         // search eneded, if we got any matches "buffed" send them before the
@@ -25,6 +25,7 @@
 #ifndef SEARCH_THREAD_H
 #define SEARCH_THREAD_H
 
+#include "clRegexEngine.h"
 #include "codelite_exports.h"
 #include "cppwordscanner.h"
 #include "singleton.h"
@@ -328,9 +329,6 @@ class WXDLLIMPEXP_CL SearchThread : public WorkerThread
     SearchResultList m_results;
     bool m_stopSearch;
     SearchSummary m_summary;
-    wxString m_reExpr;
-    wxRegEx m_regex;
-    bool m_matchCase;
     wxCriticalSection m_cs;
 
 public:
@@ -370,6 +368,13 @@ public:
      */
     void SetWordChars(const wxString& chars);
 
+    /**
+     * Search a single file, the matches are appended to 'results'. This is what each of the search
+     * workers does with the files of a search
+     * \return false if the file could not be read
+     */
+    bool SearchFile(const wxString& fileName, const SearchData& data, SearchResultList& results);
+
 private:
     /**
      * Return files to search
@@ -387,29 +392,38 @@ private:
     bool TestStopSearch();
 
     /**
-     * Do the actual search operation
+     * Do the actual search operation. The files are searched by a pool of threads (one per CPU),
+     * their matches are sent to the owner in the order of the files list
      * \param data inpunt contains information about the search
      */
     void DoSearchFiles(ThreadRequest* data);
 
-    // Perform search on a single file
-    void DoSearchFile(const wxString& fileName, const SearchData* data);
+    // Perform search on a single file, the matches are appended to 'results'.
+    // Called from the search workers: it must not touch the members updated during a search
+    // Return false if the file could not be read
+    bool DoSearchFile(const wxString& fileName, const SearchData* data, SearchResultList& results,
+                      clRegexEngine::Ptr_t re);
+
+    // Perform a plain text search on a UTF-8 file by scanning its raw bytes: only the lines containing
+    // a match are decoded. Return false if the file must be searched by DoSearchFile instead
+    bool DoSearchFileUTF8(const wxString& fileName, const SearchData* data, SearchResultList& results);
+
+    // Split the find string into the string to search for and the pipe filters
+    void GetFindWhat(const SearchData* data, wxString& findWhat, wxArrayString& filters);
 
     // Perform search on a line
     void DoSearchLine(const wxString& line, const int lineNum, const int lineOffset, const wxString& fileName,
                       const SearchData* data, const wxString& findWhat, const wxArrayString& filters,
-                      TextStatesPtr statesPtr);
+                      TextStatesPtr statesPtr, SearchResultList& results);
 
-    // Perform search on a line using regular expression
-    void DoSearchLineRE(const wxString& line, const int lineNum, const int lineOffset, const wxString& fileName,
-                        const SearchData* data, TextStatesPtr statesPtr);
+    // Perform a regular expression search on the whole file content. A match is reported on the
+    // line it starts on
+    void DoSearchFileRE(const wxString& fileData, const wxString& fileName, const SearchData* data,
+                        clRegexEngine::Ptr_t re, TextStatesPtr statesPtr, SearchResultList& results);
 
     // Send an event to the notified window
     void SendEvent(wxEventType type, wxEvtHandler* owner);
 
-    // return a compiled regex object for the expression
-    wxRegEx& GetRegex(const wxString& expr, bool matchCase);
-
     // Internal function
     bool AdjustLine(wxString& line, int& pos, const wxString& findString);
 
@@ -30,6 +30,10 @@
 #include <set>
 #include "cl_config.h"
 #include "ctags_manager.h"
+#include <wx/thread.h>
+
+// The parser threads (and indexer processes) used when the user did not choose their number
+#define MAX_DEFAULT_PARSER_THREADS ((size_t)4)
 
 wxString TagsOptionsData::CLANG_CACHE_LAZY = "Lazy";
 wxString TagsOptionsData::CLANG_CACHE_ON_FILE_LOAD = "On File Load";
@@ -84,6 +88,7 @@ TagsOptionsData::TagsOptionsData()
     , m_clangBinary(wxT(""))
     , m_clangCachePolicy(TagsOptionsData::CLANG_CACHE_ON_FILE_LOAD)
     , m_ccNumberOfDisplayItems(500)
+    , m_parserThreads(0)
     , m_version(0)
 {
     // Initialize defaults
@@ -391,6 +396,7 @@ void TagsOptionsData::FromJSON(const JSONItem& json)
     m_clangMacros = json.namedObject(wxT("m_clangMacros")).toString();
     m_clangCachePolicy = json.namedObject(wxT("m_clangCachePolicy")).toString();
     m_ccNumberOfDisplayItems = json.namedObject(wxT("m_ccNumberOfDisplayItems")).toSize_t(m_ccNumberOfDisplayItems);
+    m_parserThreads = json.namedObject(wxT("m_parserThreads")).toSize_t(m_parserThreads);
 
     if(!m_fileSpec.Contains("*.hxx")) {
         m_fileSpec = "*.cpp;*.cc;*.cxx;*.h;*.hpp;*.c;*.c++;*.tcc;*.hxx;*.h++";
@@ -424,6 +430,7 @@ JSONItem TagsOptionsData::ToJSON() const
     json.addProperty("m_clangMacros", m_clangMacros);
     json.addProperty("m_clangCachePolicy", m_clangCachePolicy);
     json.addProperty("m_ccNumberOfDisplayItems", m_ccNumberOfDisplayItems);
+    json.addProperty("m_parserThreads", m_parserThreads);
     return json;
 }
 
@@ -457,3 +464,10 @@ void TagsOptionsData::SyncData()
     DoUpdateTokensWxMap();
     DoUpdateTokensWxMapReversed();
 }
+
+size_t TagsOptionsData::GetDefaultParserThreads()
+{
+    int cpus = wxThread::GetCPUCount();
+    if(cpus <= 0) { return 1; }
+    return wxMin((size_t)cpus, MAX_DEFAULT_PARSER_THREADS);
+}
@@ -51,7 +51,10 @@ enum CodeCompletionOpts {
     CC_ACCURATE_SCOPE_RESOLVING = 0x00008000,
     CC_DEEP_SCAN_USING_NAMESPACE_RESOLVING = 0x00010000,
     CC_IS_CASE_SENSITIVE = 0x00020000,
-    CC_KEEP_FUNCTION_SIGNATURE_UNFORMATTED = 0x00040000
+    CC_KEEP_FUNCTION_SIGNATURE_UNFORMATTED = 0x00040000,
+    // Run libctags inside CodeLite instead of the codelite_indexer process. Off by default:
+    // a fatal error in libctags terminates the calling process
+    CC_PARSE_IN_PROCESS = 0x00080000
 };
 
 enum CodeCompletionColourOpts {
@@ -105,6 +108,7 @@ protected:
     wxString m_clangMacros;
     wxString m_clangCachePolicy;
     size_t m_ccNumberOfDisplayItems;
+    size_t m_parserThreads;
     size_t m_version;
 
 public:
@@ -135,6 +139,17 @@ public:
         this->m_ccNumberOfDisplayItems = ccNumberOfDisplayItems;
     }
     size_t GetCcNumberOfDisplayItems() const { return m_ccNumberOfDisplayItems; }
+    /**
+     * @brief number of threads used to parse the files when retagging the workspace
+     * (0 means: GetDefaultParserThreads())
+     */
+    void SetParserThreads(size_t parserThreads) { this->m_parserThreads = parserThreads; }
+    size_t GetParserThreads() const { return m_parserThreads; }
+    /**
+     * @brief the number of parser threads used by default: the number of CPUs, up to 4. Each parser thread
+     * has its own codelite_indexer process, so the default is kept low on machines with many CPUs
+     */
+    static size_t GetDefaultParserThreads();
     void SetClangCachePolicy(const wxString& clangCachePolicy) { this->m_clangCachePolicy = clangCachePolicy; }
     const wxString& GetClangCachePolicy() const { return m_clangCachePolicy; }
     void SetClangMacros(const wxString& clangMacros) { this->m_clangMacros = clangMacros; }
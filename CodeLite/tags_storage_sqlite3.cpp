@@ -24,12 +24,124 @@
 //////////////////////////////////////////////////////////////////////////////
 #include "file_logger.h"
 #include "fileutils.h"
+#include "macros.h"
 #include "precompiled_header.h"
 #include "tags_storage_sqlite3.h"
 #include <algorithm>
 #include <wx/longlong.h>
 #include <wx/tokenzr.h>
 
+// Substring searches use at most this number of trigrams from the searched string: the
+// candidates are verified with LIKE anyway, more trigrams only make the query longer
+#define MAX_SEARCH_TRIGRAMS 8
+
+namespace
+{
+void GetTrigrams(const wxString& str, std::vector<wxString>& trigrams)
+{
+    wxString lcStr = str.Lower();
+    wxStringSet_t unique;
+    for(size_t i = 0; (i + 3) <= lcStr.length(); ++i) {
+        wxString trigram = lcStr.Mid(i, 3);
+        if(unique.insert(trigram).second) { trigrams.push_back(trigram); }
+    }
+}
+} // namespace
+
+// Default upper bound on the memory used by the query results cache
+#define TAGS_CACHE_DEFAULT_MAX_BYTES (64 * 1024 * 1024)
+
+// Upper bound on the number of compiled statements kept per connection. Queries with IN
+// lists produce one statement per list length, so the set is not strictly fixed
+#define MAX_CACHED_STATEMENTS 500
+
+//-------------------------------------------------
+// clSqliteQuery
+//-------------------------------------------------
+clSqliteQuery& clSqliteQuery::Bind(const wxString& value)
+{
+    Param p;
+    p.isInt = false;
+    p.str = value;
+    p.num = 0;
+    m_params.push_back(p);
+    return *this;
+}
+
+clSqliteQuery& clSqliteQuery::Bind(int value)
+{
+    Param p;
+    p.isInt = true;
+    p.num = value;
+    m_params.push_back(p);
+    return *this;
+}
+
+clSqliteQuery& clSqliteQuery::BindList(const wxArrayString& values)
+{
+    for(size_t i = 0; i < values.GetCount(); ++i) {
+        m_sql << (i == 0 ? "?" : ",?");
+        Bind(values.Item(i));
+    }
+    return *this;
+}
+
+void clSqliteQuery::BindTo(wxSQLite3Statement& statement) const
+{
+    for(size_t i = 0; i < m_params.size(); ++i) {
+        const Param& p = m_params[i];
+        if(p.isInt) {
+            statement.Bind((int)i + 1, p.num);
+        } else {
+            statement.Bind((int)i + 1, p.str);
+        }
+    }
+}
+
+wxString clSqliteQuery::GetCacheKey() const
+{
+    wxString key = m_sql;
+    for(size_t i = 0; i < m_params.size(); ++i) {
+        key << "\x01";
+        if(m_params[i].isInt) {
+            key << m_params[i].num;
+        } else {
+            key << m_params[i].str;
+        }
+    }
+    return key;
+}
+
+//-------------------------------------------------
+// clSqliteDB
+//-------------------------------------------------
+clSqliteDB::Statement_t clSqliteDB::GetCachedStatement(const wxString& sql)
+{
+    std::unordered_map<wxString, StatementList_t::iterator>::iterator iter = m_statements.find(sql);
+    if(iter != m_statements.end()) {
+        // move it to the front of the list
+        m_lru.splice(m_lru.begin(), m_lru, iter->second);
+
+        // make sure that the statement is not left in the middle of an older query
+        Statement_t statement = iter->second->second;
+        statement->Reset();
+        return statement;
+    }
+
+    // PrepareStatement may throw, so compile the statement before adding an entry
+    Statement_t statement(new wxSQLite3Statement(PrepareStatement(sql)));
+    m_lru.push_front(std::make_pair(sql, statement));
+    m_statements.insert(std::make_pair(sql, m_lru.begin()));
+
+    // evict the least recently used statement. If it is still in use, it is finalized when its last user
+    // releases it
+    if(m_lru.size() > MAX_CACHED_STATEMENTS) {
+        m_statements.erase(m_lru.back().first);
+        m_lru.pop_back();
+    }
+    return statement;
+}
+
 //-------------------------------------------------
 // Tags database class implementation
 //-------------------------------------------------
@@ -176,6 +288,19 @@ void TagsStorageSQLite::CreateSchema()
         sql = wxT("CREATE INDEX IF NOT EXISTS MACROS_NAME on MACROS(name);");
         m_db->ExecuteUpdate(sql);
 
+        // The tag names substring index
+        sql = wxT("create table if not exists TAG_NAMES (ID INTEGER PRIMARY KEY AUTOINCREMENT, name string);");
+        m_db->ExecuteUpdate(sql);
+
+        sql = wxT("CREATE UNIQUE INDEX IF NOT EXISTS TAG_NAMES_NAME on TAG_NAMES(name);");
+        m_db->ExecuteUpdate(sql);
+
+        sql = wxT("create table if not exists NAME_TRIGRAMS (trigram text, name_id integer);");
+        m_db->ExecuteUpdate(sql);
+
+        sql = wxT("CREATE INDEX IF NOT EXISTS NAME_TRIGRAMS_IDX on NAME_TRIGRAMS(trigram, name_id);");
+        m_db->ExecuteUpdate(sql);
+
         sql = wxT("CREATE INDEX IF NOT EXISTS SIMPLE_MACROS_FILE on SIMPLE_MACROS(file);");
         m_db->ExecuteUpdate(sql);
 
@@ -193,6 +318,122 @@ void TagsStorageSQLite::CreateSchema()
     }
 }
 
+void TagsStorageSQLite::RebuildNamesIndexIfNeeded()
+{
+    try {
+        // Databases created before the names index existed have tags but no indexed names
+        if(m_db->ExecuteScalar(wxT("select count(*) from (select 1 from TAG_NAMES limit 1)")) == 0 &&
+           m_db->ExecuteScalar(wxT("select count(*) from (select 1 from TAGS limit 1)")) > 0) {
+            RebuildNamesIndex();
+        }
+    } catch(wxSQLite3Exception& e) {
+        clWARNING() << "Failed to check the tag names index:" << e.GetMessage() << clEndl;
+    }
+}
+
+void TagsStorageSQLite::RebuildNamesIndex()
+{
+    // Don't interfere with a transaction opened by the caller
+    bool ownTransaction = m_db->GetAutoCommit();
+    try {
+        clDEBUG() << "Building tag names index" << clEndl;
+        if(ownTransaction) { m_db->Begin(); }
+        m_db->ExecuteUpdate(wxT("delete from NAME_TRIGRAMS"));
+        m_db->ExecuteUpdate(wxT("delete from TAG_NAMES"));
+
+        wxArrayString names;
+        wxSQLite3ResultSet res = m_db->ExecuteQuery(wxT("select distinct name from TAGS"));
+        while(res.NextRow()) {
+            names.Add(res.GetString(0));
+        }
+        res.Finalize();
+
+        for(size_t i = 0; i < names.size(); ++i) {
+            DoAddNameToIndex(names.Item(i));
+        }
+        if(ownTransaction) { m_db->Commit(); }
+        clDEBUG() << "Indexed" << names.size() << "tag names" << clEndl;
+
+    } catch(wxSQLite3Exception& e) {
+        clWARNING() << "Failed to build tag names index:" << e.GetMessage() << clEndl;
+        try {
+            if(ownTransaction) { m_db->Rollback(); }
+        } catch(wxSQLite3Exception& WXUNUSED(e1)) {
+        }
+    }
+}
+
+void TagsStorageSQLite::DoAddNameToIndex(const wxString& name)
+{
+    clSqliteDB::Statement_t insertName =
+        m_db->GetCachedStatement(wxT("INSERT OR IGNORE INTO TAG_NAMES VALUES (NULL, ?)"));
+    insertName->Bind(1, name);
+    if(insertName->ExecuteUpdate() == 0) {
+        // already indexed
+        return;
+    }
+
+    wxLongLong nameId = m_db->GetLastRowId();
+    std::vector<wxString> trigrams;
+    GetTrigrams(name, trigrams);
+
+    clSqliteDB::Statement_t insertTrigram = m_db->GetCachedStatement(wxT("INSERT INTO NAME_TRIGRAMS VALUES (?, ?)"));
+    for(size_t i = 0; i < trigrams.size(); ++i) {
+        insertTrigram->Bind(1, trigrams[i]);
+        insertTrigram->Bind(2, nameId);
+        insertTrigram->ExecuteUpdate();
+    }
+}
+
+void TagsStorageSQLite::DoCollectNamesToPrune(const wxString& where)
+{
+    wxString sql;
+    sql << "select distinct name from tags where " << where;
+    wxSQLite3ResultSet res = m_db->ExecuteQuery(sql);
+    while(res.NextRow()) {
+        m_namesToPrune.insert(res.GetString(0));
+    }
+}
+
+void TagsStorageSQLite::DoPruneNamesIndex()
+{
+    // A file is usually deleted and stored again in the same transaction: only the names that no tag uses
+    // anymore are removed
+    if(m_namesToPrune.empty()) { return; }
+    wxStringSet_t names;
+    names.swap(m_namesToPrune);
+
+    clSqliteDB::Statement_t selectUnused = m_db->GetCachedStatement(
+        wxT("select ID from TAG_NAMES where name=? and not exists (select 1 from TAGS where TAGS.name=?)"));
+    clSqliteDB::Statement_t deleteTrigram =
+        m_db->GetCachedStatement(wxT("delete from NAME_TRIGRAMS where trigram=? and name_id=?"));
+    clSqliteDB::Statement_t deleteName = m_db->GetCachedStatement(wxT("delete from TAG_NAMES where ID=?"));
+
+    std::vector<wxString> trigrams;
+    for(const wxString& name : names) {
+        wxLongLong nameId;
+        {
+            clSqliteStatementResetter resetter(selectUnused);
+            selectUnused->Bind(1, name);
+            selectUnused->Bind(2, name);
+            wxSQLite3ResultSet res = selectUnused->ExecuteQuery();
+            if(!res.NextRow()) { continue; }
+            nameId = res.GetInt64(0);
+        }
+
+        // the trigrams are deleted through their (trigram, name_id) index
+        trigrams.clear();
+        GetTrigrams(name, trigrams);
+        for(size_t i = 0; i < trigrams.size(); ++i) {
+            deleteTrigram->Bind(1, trigrams[i]);
+            deleteTrigram->Bind(2, nameId);
+            deleteTrigram->ExecuteUpdate();
+        }
+        deleteName->Bind(1, nameId);
+        deleteName->ExecuteUpdate();
+    }
+}
+
 void TagsStorageSQLite::RecreateDatabase()
 {
     try {
@@ -217,6 +458,8 @@ void TagsStorageSQLite::RecreateDatabase()
             m_db->ExecuteUpdate(wxT("DROP TABLE IF EXISTS MACROS"));
             m_db->ExecuteUpdate(wxT("DROP TABLE IF EXISTS SIMPLE_MACROS"));
             m_db->ExecuteUpdate(wxT("DROP TABLE IF EXISTS GLOBAL_TAGS"));
+            m_db->ExecuteUpdate(wxT("DROP TABLE IF EXISTS TAG_NAMES"));
+            m_db->ExecuteUpdate(wxT("DROP TABLE IF EXISTS NAME_TRIGRAMS"));
 
             // drop indexes
             m_db->ExecuteUpdate(wxT("DROP INDEX IF EXISTS FILES_NAME"));
@@ -233,6 +476,8 @@ void TagsStorageSQLite::RecreateDatabase()
             m_db->ExecuteUpdate(wxT("DROP INDEX IF EXISTS SIMPLE_MACROS_FILE"));
             m_db->ExecuteUpdate(wxT("DROP INDEX IF EXISTS GLOBAL_TAGS_IDX_1"));
             m_db->ExecuteUpdate(wxT("DROP INDEX IF EXISTS GLOBAL_TAGS_IDX_2"));
+            m_db->ExecuteUpdate(wxT("DROP INDEX IF EXISTS TAG_NAMES_NAME"));
+            m_db->ExecuteUpdate(wxT("DROP INDEX IF EXISTS NAME_TRIGRAMS_IDX"));
 
             // Recreate the schema
             CreateSchema();
@@ -292,7 +537,10 @@ void TagsStorageSQLite::Store(TagTreePtr tree, const wxFileName& path, bool auto
             DoInsertTagEntry(walker.GetNode()->GetData());
         }
 
-        if(autoCommit) m_db->Commit();
+        if(autoCommit) {
+            DoPruneNamesIndex();
+            m_db->Commit();
+        }
 
     } catch(wxSQLite3Exception& e) {
         try {
@@ -310,8 +558,9 @@ void TagsStorageSQLite::SelectTagsByFile(const wxString& file, std::vector<TagEn
     path.IsOk() == false ? databaseFileName = m_fileName : databaseFileName = path;
     OpenDatabase(databaseFileName);
 
-    wxString query;
-    query << wxT("select * from tags where file='") << file << "' ";
+    clSqliteQuery query;
+    query << wxT("select * from tags where file=? ");
+    query.Bind(file);
     //#ifdef __WXMSW__
     //    // Under Windows, the file-crawler changes the file path
     //    // to lowercase. However, the database matches the file name
@@ -330,11 +579,18 @@ void TagsStorageSQLite::DeleteByFileName(const wxFileName& path, const wxString&
 
         if(autoCommit) { m_db->Begin(); }
 
+        wxString where;
+        where << "File='" << fileName << "'";
+        DoCollectNamesToPrune(where);
+
         wxString sql;
-        sql << "delete from tags where File='" << fileName << "'";
+        sql << "delete from tags where " << where;
         m_db->ExecuteUpdate(sql);
 
-        if(autoCommit) m_db->Commit();
+        if(autoCommit) {
+            DoPruneNamesIndex();
+            m_db->Commit();
+        }
     } catch(wxSQLite3Exception& e) {
         wxUnusedVar(e);
         if(autoCommit) { m_db->Rollback(); }
@@ -367,7 +623,7 @@ const bool TagsStorageSQLite::IsOpen() const { return m_db->IsOpen(); }
 void TagsStorageSQLite::GetFilesForCC(const wxString& userTyped, wxArrayString& matches)
 {
     try {
-        wxString query;
+        clSqliteQuery query;
         wxString tmpName(userTyped);
 
         // Files are kept in native format in the database
@@ -376,13 +632,15 @@ void TagsStorageSQLite::GetFilesForCC(const wxString& userTyped, wxArrayString&
         tmpName.Replace("\\", "/");
         tmpName.Replace("/", wxString() << wxFILE_SEP_PATH);
         tmpName.Replace(wxT("_"), wxT("^_"));
-        query << wxT("select * from files where file like '%%") << tmpName << wxT("%%' ESCAPE '^' ")
-              << wxT("order by file");
+        query << wxT("select * from files where file like ? ESCAPE '^' ") << wxT("order by file");
+        query.Bind("%" + tmpName + "%");
 
         wxString pattern = userTyped;
         pattern.Replace("\\", "/");
 
-        wxSQLite3ResultSet res = m_db->ExecuteQuery(query);
+        clSqliteDB::Statement_t statement = DoPrepareQuery(query);
+        clSqliteStatementResetter resetter(statement);
+        wxSQLite3ResultSet res = statement->ExecuteQuery();
         while(res.NextRow()) {
             // Keep the part from where the user typed and until the end of the file name
             wxString matchedFile = res.GetString(1);
@@ -404,13 +662,15 @@ void TagsStorageSQLite::GetFiles(const wxString& partialName, std::vector<FileEn
     try {
         bool match_path = (!partialName.IsEmpty() && partialName.Last() == wxFileName::GetPathSeparator());
 
-        wxString query;
+        clSqliteQuery query;
         wxString tmpName(partialName);
         tmpName.Replace(wxT("_"), wxT("^_"));
-        query << wxT("select * from files where file like '%%") << tmpName << wxT("%%' ESCAPE '^' ")
-              << wxT("order by file");
+        query << wxT("select * from files where file like ? ESCAPE '^' ") << wxT("order by file");
+        query.Bind("%" + tmpName + "%");
 
-        wxSQLite3ResultSet res = m_db->ExecuteQuery(query);
+        clSqliteDB::Statement_t statement = DoPrepareQuery(query);
+        clSqliteStatementResetter resetter(statement);
+        wxSQLite3ResultSet res = statement->ExecuteQuery();
         while(res.NextRow()) {
 
             FileEntryPtr fe(new FileEntry());
@@ -453,9 +713,16 @@ void TagsStorageSQLite::DeleteByFilePrefix(const wxFileName& dbpath, const wxStr
         wxString name(filePrefix);
         name.Replace(wxT("_"), wxT("^_"));
 
-        sql << wxT("delete from tags where file like '") << name << wxT("%%' ESCAPE '^' ");
+        wxString where;
+        where << wxT("file like '") << name << wxT("%%' ESCAPE '^' ");
+        DoCollectNamesToPrune(where);
+
+        sql << wxT("delete from tags where ") << where;
         m_db->ExecuteUpdate(sql);
 
+        // Not part of a transaction of the caller: prune the names index now
+        if(m_db->GetAutoCommit()) { DoPruneNamesIndex(); }
+
     } catch(wxSQLite3Exception& e) {
         wxUnusedVar(e);
     }
@@ -566,22 +833,32 @@ TagEntry* TagsStorageSQLite::FromSQLite3ResultSet(wxSQLite3ResultSet& rs)
     return entry;
 }
 
-void TagsStorageSQLite::DoFetchTags(const wxString& sql, std::vector<TagEntryPtr>& tags)
+clSqliteDB::Statement_t TagsStorageSQLite::DoPrepareQuery(const clSqliteQuery& query)
+{
+    clSqliteDB::Statement_t statement = m_db->GetCachedStatement(query.GetSQL());
+    query.BindTo(*statement);
+    return statement;
+}
+
+void TagsStorageSQLite::DoFetchTags(const clSqliteQuery& query, std::vector<TagEntryPtr>& tags)
 {
+    wxString cacheKey;
     if(GetUseCache()) {
-        clDEBUG1() << "Testing cache for" << sql << clEndl;
-        if(m_cache.Get(sql, tags) == true) {
-            clDEBUG1() << "[CACHED ITEMS]" << sql << clEndl;
+        cacheKey = query.GetCacheKey();
+        clDEBUG1() << "Testing cache for" << cacheKey << clEndl;
+        if(m_cache.Get(cacheKey, tags) == true) {
+            clDEBUG1() << "[CACHED ITEMS]" << cacheKey << clEndl;
             return;
         }
     }
 
-    clDEBUG1() << "Entry not found in cache" << sql << clEndl;
+    clDEBUG1() << "Entry not found in cache" << query.GetSQL() << clEndl;
     clDEBUG1() << "Fetching from disk..." << clEndl;
     tags.reserve(500);
     try {
-        wxSQLite3ResultSet ex_rs;
-        ex_rs = Query(sql);
+        clSqliteDB::Statement_t statement = DoPrepareQuery(query);
+        clSqliteStatementResetter resetter(statement);
+        wxSQLite3ResultSet ex_rs = statement->ExecuteQuery();
 
         // add results from external database to the workspace database
         while(ex_rs.NextRow()) {
@@ -590,32 +867,35 @@ void TagsStorageSQLite::DoFetchTags(const wxString& sql, std::vector<TagEntryPtr
             // conver the path to be real path
             tags.push_back(tag);
         }
-        ex_rs.Finalize();
     } catch(wxSQLite3Exception& e) {
         clWARNING() << "TagsStorageSQLite::DoFetchTags() error:" << e.GetMessage() << clEndl;
     }
     clDEBUG1() << "Fetching from disk...done" << clEndl;
     if(GetUseCache()) {
         clDEBUG1() << "Updating cache" << clEndl;
-        m_cache.Store(sql, tags);
+        m_cache.Store(cacheKey, tags);
         clDEBUG1() << "Updating cache...done (" << tags.size() << "entries)" << clEndl;
     }
 }
 
-void TagsStorageSQLite::DoFetchTags(const wxString& sql, std::vector<TagEntryPtr>& tags, const wxArrayString& kinds)
+void TagsStorageSQLite::DoFetchTags(const clSqliteQuery& query, std::vector<TagEntryPtr>& tags,
+                                    const wxArrayString& kinds)
 {
+    wxString cacheKey;
     if(GetUseCache()) {
-        CL_DEBUG1(wxT("Testing cache for: %s"), sql);
-        if(m_cache.Get(sql, kinds, tags) == true) {
-            CL_DEBUG1(wxT("[CACHED ITEMS] %s"), sql);
+        cacheKey = query.GetCacheKey();
+        CL_DEBUG1(wxT("Testing cache for: %s"), cacheKey);
+        if(m_cache.Get(cacheKey, kinds, tags) == true) {
+            CL_DEBUG1(wxT("[CACHED ITEMS] %s"), cacheKey);
             return;
         }
     }
 
     CL_DEBUG1("Fetching from disk");
     try {
-        wxSQLite3ResultSet ex_rs;
-        ex_rs = Query(sql);
+        clSqliteDB::Statement_t statement = DoPrepareQuery(query);
+        clSqliteStatementResetter resetter(statement);
+        wxSQLite3ResultSet ex_rs = statement->ExecuteQuery();
 
         // add results from external database to the workspace database
         while(ex_rs.NextRow()) {
@@ -629,7 +909,6 @@ void TagsStorageSQLite::DoFetchTags(const wxString& sql, std::vector<TagEntryPtr
                 tags.push_back(tag);
             }
         }
-        ex_rs.Finalize();
 
     } catch(wxSQLite3Exception& e) {
         wxUnusedVar(e);
@@ -637,7 +916,7 @@ void TagsStorageSQLite::DoFetchTags(const wxString& sql, std::vector<TagEntryPtr
     CL_DEBUG1("Fetching from disk...done");
     if(GetUseCache()) {
         CL_DEBUG1("updating cache");
-        m_cache.Store(sql, kinds, tags);
+        m_cache.Store(cacheKey, kinds, tags);
         CL_DEBUG1("updating cache...done");
     }
 }
@@ -647,88 +926,74 @@ void TagsStorageSQLite::GetTagsByScopeAndName(const wxString& scope, const wxStr
 {
     if(name.IsEmpty()) return;
 
-    wxString sql;
-    sql << wxT("select * from tags where ");
+    clSqliteQuery query;
+    query << wxT("select * from tags where ");
 
     // did we get scope?
     if(scope.IsEmpty() || scope == wxT("<global>")) {
-        sql << wxT("ID IN (select tag_id from global_tags where ");
-        DoAddNamePartToQuery(sql, name, partialNameAllowed, false);
-        sql << wxT(" ) ");
+        query << wxT("ID IN (select tag_id from global_tags where ");
+        DoAddNamePartToQuery(query, name, partialNameAllowed, false);
+        query << wxT(" ) ");
 
     } else {
-        sql << " scope = '" << scope << "' ";
-        DoAddNamePartToQuery(sql, name, partialNameAllowed, true);
+        query << " scope = ? ";
+        query.Bind(scope);
+        DoAddNamePartToQuery(query, name, partialNameAllowed, true);
     }
 
-    sql << wxT(" LIMIT ") << this->GetSingleSearchLimit();
+    query << wxT(" LIMIT ?");
+    query.Bind(this->GetSingleSearchLimit());
 
     // get get the tags
-    DoFetchTags(sql, tags);
+    DoFetchTags(query, tags);
 }
 
 void TagsStorageSQLite::GetTagsByScope(const wxString& scope, std::vector<TagEntryPtr>& tags)
 {
-    wxString sql;
+    clSqliteQuery query;
 
     // Build the SQL statement
-    sql << wxT("select * from tags where scope='") << scope << wxT("' ORDER BY NAME limit ") << GetSingleSearchLimit();
+    query << wxT("select * from tags where scope=? ORDER BY NAME limit ?");
+    query.Bind(scope).Bind(GetSingleSearchLimit());
 
-    DoFetchTags(sql, tags);
+    DoFetchTags(query, tags);
 }
 
 void TagsStorageSQLite::GetTagsByKind(const wxArrayString& kinds, const wxString& orderingColumn, int order,
                                       std::vector<TagEntryPtr>& tags)
 {
-    wxString sql;
-    sql << wxT("select * from tags where kind in (");
-    for(size_t i = 0; i < kinds.GetCount(); i++) {
-        sql << wxT("'") << kinds.Item(i) << wxT("',");
-    }
-    sql.RemoveLast();
-    sql << wxT(") ");
-
-    if(orderingColumn.IsEmpty() == false) {
-        sql << wxT("order by ") << orderingColumn;
-        switch(order) {
-        case ITagsStorage::OrderAsc:
-            sql << wxT(" ASC");
-            break;
-        case ITagsStorage::OrderDesc:
-            sql << wxT(" DESC");
-            break;
-        case ITagsStorage::OrderNone:
-        default:
-            break;
-        }
-    }
+    if(kinds.empty()) { return; }
+
+    clSqliteQuery query;
+    query << wxT("select * from tags where kind in (");
+    query.BindList(kinds);
+    query << wxT(") ");
+    DoAddOrderPartToQuery(query, orderingColumn, order);
 
-    DoFetchTags(sql, tags);
+    DoFetchTags(query, tags);
 }
 
 void TagsStorageSQLite::GetTagsByPath(const wxArrayString& path, std::vector<TagEntryPtr>& tags)
 {
     if(path.empty()) return;
 
-    wxString sql;
+    clSqliteQuery query;
 
-    sql << wxT("select * from tags where path IN(");
-    for(size_t i = 0; i < path.GetCount(); i++) {
-        sql << wxT("'") << path.Item(i) << wxT("',");
-    }
-    sql.RemoveLast();
-    sql << wxT(")");
-    DoFetchTags(sql, tags);
+    query << wxT("select * from tags where path IN(");
+    query.BindList(path);
+    query << wxT(")");
+    DoFetchTags(query, tags);
 }
 
 void TagsStorageSQLite::GetTagsByNameAndParent(const wxString& name, const wxString& parent,
                                                std::vector<TagEntryPtr>& tags)
 {
-    wxString sql;
-    sql << wxT("select * from tags where name='") << name << wxT("' LIMIT ") << GetSingleSearchLimit();
+    clSqliteQuery query;
+    query << wxT("select * from tags where name=? LIMIT ?");
+    query.Bind(name).Bind(GetSingleSearchLimit());
 
     std::vector<TagEntryPtr> tmpResults;
-    DoFetchTags(sql, tmpResults);
+    DoFetchTags(query, tmpResults);
 
     // Filter by parent
     for(size_t i = 0; i < tmpResults.size(); i++) {
@@ -741,25 +1006,28 @@ void TagsStorageSQLite::GetTagsByKindAndPath(const wxArrayString& kinds, const w
 {
     if(kinds.empty()) { return; }
 
-    wxString sql;
-    sql << wxT("select * from tags where path='") << path << wxT("' LIMIT ") << GetSingleSearchLimit();
+    clSqliteQuery query;
+    query << wxT("select * from tags where path=? LIMIT ?");
+    query.Bind(path).Bind(GetSingleSearchLimit());
 
-    DoFetchTags(sql, tags, kinds);
+    DoFetchTags(query, tags, kinds);
 }
 
 void TagsStorageSQLite::GetTagsByFileAndLine(const wxString& file, int line, std::vector<TagEntryPtr>& tags)
 {
-    wxString sql;
-    sql << wxT("select * from tags where file='") << file << wxT("' and line=") << line << wxT(" ");
-    DoFetchTags(sql, tags);
+    clSqliteQuery query;
+    query << wxT("select * from tags where file=? and line=? ");
+    query.Bind(file).Bind(line);
+    DoFetchTags(query, tags);
 }
 
 TagEntryPtr TagsStorageSQLite::GetTagAboveFileAndLine(const wxString& file, int line)
 {
-    wxString sql;
-    sql << wxT("select * from tags where file='") << file << wxT("' and line<=") << line << wxT(" LIMIT 1");
+    clSqliteQuery query;
+    query << wxT("select * from tags where file=? and line<=? LIMIT 1");
+    query.Bind(file).Bind(line);
     TagEntryPtrVector_t tags;
-    DoFetchTags(sql, tags);
+    DoFetchTags(query, tags);
     if(!tags.empty()) { return tags.at(0); }
     return NULL;
 }
@@ -769,10 +1037,14 @@ void TagsStorageSQLite::GetTagsByScopeAndKind(const wxString& scope, const wxArr
 {
     if(kinds.empty()) { return; }
 
-    wxString sql;
-    sql << wxT("select * from tags where scope='") << scope << wxT("' ");
-    if(applyLimit) { sql << wxT(" LIMIT ") << GetSingleSearchLimit(); }
-    DoFetchTags(sql, tags, kinds);
+    clSqliteQuery query;
+    query << wxT("select * from tags where scope=? ");
+    query.Bind(scope);
+    if(applyLimit) {
+        query << wxT(" LIMIT ?");
+        query.Bind(GetSingleSearchLimit());
+    }
+    DoFetchTags(query, tags, kinds);
 }
 
 void TagsStorageSQLite::GetTagsByKindAndFile(const wxArrayString& kind, const wxString& fileName,
@@ -780,30 +1052,13 @@ void TagsStorageSQLite::GetTagsByKindAndFile(const wxArrayString& kind, const wx
 {
     if(kind.empty()) { return; }
 
-    wxString sql;
-    sql << wxT("select * from tags where file='") << fileName << wxT("' and kind in (");
-
-    for(size_t i = 0; i < kind.GetCount(); i++) {
-        sql << wxT("'") << kind.Item(i) << wxT("',");
-    }
-    sql.RemoveLast();
-    sql << wxT(")");
-
-    if(orderingColumn.IsEmpty() == false) {
-        sql << wxT("order by ") << orderingColumn;
-        switch(order) {
-        case ITagsStorage::OrderAsc:
-            sql << wxT(" ASC");
-            break;
-        case ITagsStorage::OrderDesc:
-            sql << wxT(" DESC");
-            break;
-        case ITagsStorage::OrderNone:
-        default:
-            break;
-        }
-    }
-    DoFetchTags(sql, tags);
+    clSqliteQuery query;
+    query << wxT("select * from tags where file=? and kind in (");
+    query.Bind(fileName);
+    query.BindList(kind);
+    query << wxT(") ");
+    DoAddOrderPartToQuery(query, orderingColumn, order);
+    DoFetchTags(query, tags);
 }
 
 int TagsStorageSQLite::DeleteFileEntry(const wxString& filename)
@@ -859,22 +1114,25 @@ int TagsStorageSQLite::DoInsertTagEntry(const TagEntry& tag)
     if(GetUseCache()) { ClearCache(); }
 
     try {
-        wxSQLite3Statement statement = m_db->GetPrepareStatement(
+        // Called once per tag while storing a file: compile the statement only once
+        clSqliteDB::Statement_t statement = m_db->GetCachedStatement(
             wxT("INSERT OR REPLACE INTO TAGS VALUES (NULL, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"));
-        statement.Bind(1, tag.GetName());
-        statement.Bind(2, tag.GetFile());
-        statement.Bind(3, tag.GetLine());
-        statement.Bind(4, tag.GetKind());
-        statement.Bind(5, tag.GetAccess());
-        statement.Bind(6, tag.GetSignature());
-        statement.Bind(7, tag.GetPattern());
-        statement.Bind(8, tag.GetParent());
-        statement.Bind(9, tag.GetInheritsAsString());
-        statement.Bind(10, tag.GetPath());
-        statement.Bind(11, tag.GetTyperef());
-        statement.Bind(12, tag.GetScope());
-        statement.Bind(13, tag.GetReturnValue());
-        statement.ExecuteUpdate();
+        statement->Bind(1, tag.GetName());
+        statement->Bind(2, tag.GetFile());
+        statement->Bind(3, tag.GetLine());
+        statement->Bind(4, tag.GetKind());
+        statement->Bind(5, tag.GetAccess());
+        statement->Bind(6, tag.GetSignature());
+        statement->Bind(7, tag.GetPattern());
+        statement->Bind(8, tag.GetParent());
+        statement->Bind(9, tag.GetInheritsAsString());
+        statement->Bind(10, tag.GetPath());
+        statement->Bind(11, tag.GetTyperef());
+        statement->Bind(12, tag.GetScope());
+        statement->Bind(13, tag.GetReturnValue());
+        statement->ExecuteUpdate();
+
+        DoAddNameToIndex(tag.GetName());
     } catch(wxSQLite3Exception& exc) {
         return TagError;
     }
@@ -883,7 +1141,7 @@ int TagsStorageSQLite::DoInsertTagEntry(const TagEntry& tag)
 
 bool TagsStorageSQLite::IsTypeAndScopeContainer(wxString& typeName, wxString& scope)
 {
-    wxString sql;
+    clSqliteQuery query;
 
     // Break the typename to 'name' and scope
     wxString typeNameNoScope(typeName.AfterLast(wxT(':')));
@@ -900,12 +1158,15 @@ bool TagsStorageSQLite::IsTypeAndScopeContainer(wxString& typeName, wxString& sc
         combinedScope << scopeOne;
     }
 
-    sql << wxT("select scope,kind from tags where name='") << typeNameNoScope << wxT("'");
+    query << wxT("select scope,kind from tags where name=?");
+    query.Bind(typeNameNoScope);
 
     bool found_global(false);
 
     try {
-        wxSQLite3ResultSet rs = Query(sql);
+        clSqliteDB::Statement_t statement = DoPrepareQuery(query);
+        clSqliteStatementResetter resetter(statement);
+        wxSQLite3ResultSet rs = statement->ExecuteQuery();
         while(rs.NextRow()) {
             wxString scopeFounded(rs.GetString(0));
             wxString kindFounded(rs.GetString(1));
@@ -951,7 +1212,7 @@ bool TagsStorageSQLite::IsTypeAndScopeContainer(wxString& typeName, wxString& sc
 
 bool TagsStorageSQLite::IsTypeAndScopeExist(wxString& typeName, wxString& scope)
 {
-    wxString sql;
+    clSqliteQuery query;
     wxString strippedName;
     wxString secondScope;
     wxString bestScope;
@@ -965,8 +1226,8 @@ bool TagsStorageSQLite::IsTypeAndScopeExist(wxString& typeName, wxString& scope)
 
     if(strippedName.IsEmpty()) return false;
 
-    sql << wxT("select scope,parent from tags where name='") << strippedName
-        << wxT("' and kind in ('class', 'struct', 'typedef') LIMIT 50");
+    query << wxT("select scope,parent from tags where name=? and kind in ('class', 'struct', 'typedef') LIMIT 50");
+    query.Bind(strippedName);
     int foundOther(0);
     wxString scopeFounded;
     wxString parentFounded;
@@ -976,7 +1237,9 @@ bool TagsStorageSQLite::IsTypeAndScopeExist(wxString& typeName, wxString& scope)
     parent = tmpScope.AfterLast(wxT(':'));
 
     try {
-        wxSQLite3ResultSet rs = Query(sql);
+        clSqliteDB::Statement_t statement = DoPrepareQuery(query);
+        clSqliteStatementResetter resetter(statement);
+        wxSQLite3ResultSet rs = statement->ExecuteQuery();
         while(rs.NextRow()) {
 
             scopeFounded = rs.GetString(0);
@@ -1016,17 +1279,19 @@ bool TagsStorageSQLite::IsTypeAndScopeExist(wxString& typeName, wxString& scope)
 
 void TagsStorageSQLite::GetScopesFromFileAsc(const wxFileName& fileName, std::vector<wxString>& scopes)
 {
-    wxString sql;
-    sql << wxT("select distinct scope from tags where file = '") << fileName.GetFullPath() << wxT("' ")
-        << wxT(" and kind in('prototype', 'function', 'enum')") << wxT(" order by scope ASC");
+    clSqliteQuery query;
+    query << wxT("select distinct scope from tags where file = ? ")
+          << wxT(" and kind in('prototype', 'function', 'enum')") << wxT(" order by scope ASC");
+    query.Bind(fileName.GetFullPath());
 
     // we take the first entry
     try {
-        wxSQLite3ResultSet rs = Query(sql);
+        clSqliteDB::Statement_t statement = DoPrepareQuery(query);
+        clSqliteStatementResetter resetter(statement);
+        wxSQLite3ResultSet rs = statement->ExecuteQuery();
         while(rs.NextRow()) {
             scopes.push_back(rs.GetString(0));
         }
-        rs.Finalize();
     } catch(wxSQLite3Exception& e) {
         wxUnusedVar(e);
     }
@@ -1035,20 +1300,17 @@ void TagsStorageSQLite::GetScopesFromFileAsc(const wxFileName& fileName, std::ve
 void TagsStorageSQLite::GetTagsByFileScopeAndKind(const wxFileName& fileName, const wxString& scopeName,
                                                   const wxArrayString& kind, std::vector<TagEntryPtr>& tags)
 {
-    wxString sql;
-    sql << wxT("select * from tags where file = '") << fileName.GetFullPath() << wxT("' ") << wxT(" and scope='")
-        << scopeName << wxT("' ");
+    clSqliteQuery query;
+    query << wxT("select * from tags where file = ? ") << wxT(" and scope=? ");
+    query.Bind(fileName.GetFullPath()).Bind(scopeName);
 
     if(kind.IsEmpty() == false) {
-        sql << wxT(" and kind in(");
-        for(size_t i = 0; i < kind.GetCount(); i++) {
-            sql << wxT("'") << kind.Item(i) << wxT("',");
-        }
-        sql.RemoveLast();
-        sql << wxT(")");
+        query << wxT(" and kind in(");
+        query.BindList(kind);
+        query << wxT(")");
     }
 
-    DoFetchTags(sql, tags);
+    DoFetchTags(query, tags);
 }
 
 void TagsStorageSQLite::GetAllTagsNames(wxArrayString& names)
@@ -1074,19 +1336,14 @@ void TagsStorageSQLite::GetTagsNames(const wxArrayString& kind, wxArrayString& n
     if(kind.IsEmpty()) return;
     try {
 
-        wxString whereClause;
-        whereClause << wxT(" kind IN (");
-        for(size_t i = 0; i < kind.GetCount(); i++) {
-            whereClause << wxT("'") << kind.Item(i) << wxT("',");
-        }
-
-        whereClause = whereClause.BeforeLast(wxT(','));
-        whereClause << wxT(") ");
-
-        wxString query(wxT("SELECT distinct name FROM tags WHERE "));
-        query << whereClause << wxT(" order by name ASC LIMIT ") << GetMaxWorkspaceTagToColour();
+        clSqliteQuery query(wxT("SELECT distinct name FROM tags WHERE  kind IN ("));
+        query.BindList(kind);
+        query << wxT(")  order by name ASC LIMIT ?");
+        query.Bind(GetMaxWorkspaceTagToColour());
 
-        wxSQLite3ResultSet res = Query(query);
+        clSqliteDB::Statement_t statement = DoPrepareQuery(query);
+        clSqliteStatementResetter resetter(statement);
+        wxSQLite3ResultSet res = statement->ExecuteQuery();
         while(res.NextRow()) {
             // add unique strings only
             names.Add(res.GetString(0));
@@ -1102,15 +1359,12 @@ void TagsStorageSQLite::GetTagsByScopesAndKind(const wxArrayString& scopes, cons
 {
     if(kinds.empty() || scopes.empty()) { return; }
 
-    wxString sql;
-    sql << wxT("select * from tags where scope in (");
-    for(size_t i = 0; i < scopes.GetCount(); i++) {
-        sql << wxT("'") << scopes.Item(i) << wxT("',");
-    }
-    sql.RemoveLast();
-    sql << wxT(") ORDER BY NAME ");
-    DoAddLimitPartToQuery(sql, tags);
-    DoFetchTags(sql, tags, kinds);
+    clSqliteQuery query;
+    query << wxT("select * from tags where scope in (");
+    query.BindList(scopes);
+    query << wxT(") ORDER BY NAME ");
+    DoAddLimitPartToQuery(query, tags);
+    DoFetchTags(query, tags, kinds);
 }
 
 void TagsStorageSQLite::GetTagsByScopesAndKindNoLimit(const wxArrayString& scopes, const wxArrayString& kinds,
@@ -1118,15 +1372,12 @@ void TagsStorageSQLite::GetTagsByScopesAndKindNoLimit(const wxArrayString& scope
 {
     if(kinds.empty() || scopes.empty()) { return; }
 
-    wxString sql;
-    sql << wxT("select * from tags where scope in (");
-    for(size_t i = 0; i < scopes.GetCount(); i++) {
-        sql << wxT("'") << scopes.Item(i) << wxT("',");
-    }
-    sql.RemoveLast();
-    sql << wxT(") ORDER BY NAME");
+    clSqliteQuery query;
+    query << wxT("select * from tags where scope in (");
+    query.BindList(scopes);
+    query << wxT(") ORDER BY NAME");
 
-    DoFetchTags(sql, tags, kinds);
+    DoFetchTags(query, tags, kinds);
 }
 
 void TagsStorageSQLite::GetTagsByTyperefAndKind(const wxArrayString& typerefs, const wxArrayString& kinds,
@@ -1134,24 +1385,22 @@ void TagsStorageSQLite::GetTagsByTyperefAndKind(const wxArrayString& typerefs, c
 {
     if(kinds.empty() || typerefs.empty()) { return; }
 
-    wxString sql;
-    sql << wxT("select * from tags where typeref in (");
-    for(size_t i = 0; i < typerefs.GetCount(); i++) {
-        sql << wxT("'") << typerefs.Item(i) << wxT("',");
-    }
-    sql.RemoveLast();
-    sql << wxT(") ORDER BY NAME ");
-    DoAddLimitPartToQuery(sql, tags);
-    DoFetchTags(sql, tags, kinds);
+    clSqliteQuery query;
+    query << wxT("select * from tags where typeref in (");
+    query.BindList(typerefs);
+    query << wxT(") ORDER BY NAME ");
+    DoAddLimitPartToQuery(query, tags);
+    DoFetchTags(query, tags, kinds);
 }
 
 void TagsStorageSQLite::GetTagsByPath(const wxString& path, std::vector<TagEntryPtr>& tags, int limit)
 {
     if(path.empty()) return;
 
-    wxString sql;
-    sql << wxT("select * from tags where path ='") << path << wxT("' LIMIT ") << limit;
-    DoFetchTags(sql, tags);
+    clSqliteQuery query;
+    query << wxT("select * from tags where path =? LIMIT ?");
+    query.Bind(path).Bind(limit);
+    DoFetchTags(query, tags);
 }
 
 void TagsStorageSQLite::GetTagsByScopeAndName(const wxArrayString& scope, const wxString& name, bool partialNameAllowed,
@@ -1172,42 +1421,35 @@ void TagsStorageSQLite::GetTagsByScopeAndName(const wxArrayString& scope, const
     }
 
     if(scopes.IsEmpty() == false) {
-        wxString sql;
-        sql << wxT("select * from tags where scope in(");
-
-        for(size_t i = 0; i < scopes.GetCount(); i++) {
-            sql << wxT("'") << scopes.Item(i) << wxT("',");
-        }
-        sql.RemoveLast();
-        sql << wxT(") ");
+        clSqliteQuery query;
+        query << wxT("select * from tags where scope in(");
+        query.BindList(scopes);
+        query << wxT(") ");
 
-        DoAddNamePartToQuery(sql, name, partialNameAllowed, true);
-        DoAddLimitPartToQuery(sql, tags);
+        DoAddNamePartToQuery(query, name, partialNameAllowed, true);
+        DoAddLimitPartToQuery(query, tags);
         // get get the tags
-        DoFetchTags(sql, tags);
+        DoFetchTags(query, tags);
     }
 }
 
 void TagsStorageSQLite::GetGlobalFunctions(std::vector<TagEntryPtr>& tags)
 {
-    wxString sql;
-    sql << wxT("select * from tags where scope = '<global>' AND kind IN ('function', 'prototype')");
-    DoAddLimitPartToQuery(sql, tags);
-    DoFetchTags(sql, tags);
+    clSqliteQuery query;
+    query << wxT("select * from tags where scope = '<global>' AND kind IN ('function', 'prototype')");
+    DoAddLimitPartToQuery(query, tags);
+    DoFetchTags(query, tags);
 }
 
 void TagsStorageSQLite::GetTagsByFiles(const wxArrayString& files, std::vector<TagEntryPtr>& tags)
 {
     if(files.IsEmpty()) return;
 
-    wxString sql;
-    sql << wxT("select * from tags where file in (");
-    for(size_t i = 0; i < files.GetCount(); i++) {
-        sql << wxT("'") << files.Item(i) << wxT("',");
-    }
-    sql.RemoveLast();
-    sql << wxT(")");
-    DoFetchTags(sql, tags);
+    clSqliteQuery query;
+    query << wxT("select * from tags where file in (");
+    query.BindList(files);
+    query << wxT(")");
+    DoFetchTags(query, tags);
 }
 
 void TagsStorageSQLite::GetTagsByFilesAndScope(const wxArrayString& files, const wxString& scope,
@@ -1215,16 +1457,14 @@ void TagsStorageSQLite::GetTagsByFilesAndScope(const wxArrayString& files, const
 {
     if(files.IsEmpty()) return;
 
-    wxString sql;
-    sql << wxT("select * from tags where file in (");
-    for(size_t i = 0; i < files.GetCount(); i++) {
-        sql << wxT("'") << files.Item(i) << wxT("',");
-    }
-    sql.RemoveLast();
-    sql << wxT(")");
+    clSqliteQuery query;
+    query << wxT("select * from tags where file in (");
+    query.BindList(files);
+    query << wxT(")");
 
-    sql << wxT(" AND scope='") << scope << wxT("'");
-    DoFetchTags(sql, tags);
+    query << wxT(" AND scope=?");
+    query.Bind(scope);
+    DoFetchTags(query, tags);
 }
 
 void TagsStorageSQLite::GetTagsByFilesKindAndScope(const wxArrayString& files, const wxArrayString& kinds,
@@ -1232,16 +1472,14 @@ void TagsStorageSQLite::GetTagsByFilesKindAndScope(const wxArrayString& files, c
 {
     if(files.IsEmpty()) return;
 
-    wxString sql;
-    sql << wxT("select * from tags where file in (");
-    for(size_t i = 0; i < files.GetCount(); i++) {
-        sql << wxT("'") << files.Item(i) << wxT("',");
-    }
-    sql.RemoveLast();
-    sql << wxT(")");
+    clSqliteQuery query;
+    query << wxT("select * from tags where file in (");
+    query.BindList(files);
+    query << wxT(")");
 
-    sql << wxT(" AND scope='") << scope << wxT("'");
-    DoFetchTags(sql, tags, kinds);
+    query << wxT(" AND scope=?");
+    query.Bind(scope);
+    DoFetchTags(query, tags, kinds);
 }
 
 void TagsStorageSQLite::GetTagsByFilesScopeTyperefAndKind(const wxArrayString& files, const wxArrayString& kinds,
@@ -1250,64 +1488,53 @@ void TagsStorageSQLite::GetTagsByFilesScopeTyperefAndKind(const wxArrayString& f
 {
     if(files.IsEmpty()) return;
 
-    wxString sql;
-    sql << wxT("select * from tags where file in (");
-    for(size_t i = 0; i < files.GetCount(); i++) {
-        sql << wxT("'") << files.Item(i) << wxT("',");
-    }
-    sql.RemoveLast();
-    sql << wxT(")");
+    clSqliteQuery query;
+    query << wxT("select * from tags where file in (");
+    query.BindList(files);
+    query << wxT(")");
 
-    sql << wxT(" AND scope='") << scope << wxT("'");
-    sql << wxT(" AND typeref='") << typeref << wxT("'");
-    DoFetchTags(sql, tags, kinds);
+    query << wxT(" AND scope=?");
+    query << wxT(" AND typeref=?");
+    query.Bind(scope).Bind(typeref);
+    DoFetchTags(query, tags, kinds);
 }
 
 void TagsStorageSQLite::GetTagsByKindLimit(const wxArrayString& kinds, const wxString& orderingColumn, int order,
                                            int limit, const wxString& partName, std::vector<TagEntryPtr>& tags)
 {
-    wxString sql;
-    sql << wxT("select * from tags where kind in (");
-    for(size_t i = 0; i < kinds.GetCount(); i++) {
-        sql << wxT("'") << kinds.Item(i) << wxT("',");
-    }
-    sql.RemoveLast();
-    sql << wxT(") ");
-
-    if(orderingColumn.IsEmpty() == false) {
-        sql << wxT("order by ") << orderingColumn;
-        switch(order) {
-        case ITagsStorage::OrderAsc:
-            sql << wxT(" ASC");
-            break;
-        case ITagsStorage::OrderDesc:
-            sql << wxT(" DESC");
-            break;
-        case ITagsStorage::OrderNone:
-        default:
-            break;
-        }
-    }
+    if(kinds.empty()) { return; }
 
-    DoAddNamePartToQuery(sql, partName, true, true);
-    if(limit > 0) { sql << wxT(" LIMIT ") << limit; }
+    clSqliteQuery query;
+    query << wxT("select * from tags where kind in (");
+    query.BindList(kinds);
+    query << wxT(") ");
+
+    // the name condition is part of the WHERE clause and must precede the ORDER BY
+    DoAddNamePartToQuery(query, partName, true, true);
+    DoAddOrderPartToQuery(query, orderingColumn, order);
+    if(limit > 0) {
+        query << wxT(" LIMIT ?");
+        query.Bind(limit);
+    }
 
-    DoFetchTags(sql, tags);
+    DoFetchTags(query, tags);
 }
 bool TagsStorageSQLite::IsTypeAndScopeExistLimitOne(const wxString& typeName, const wxString& scope)
 {
-    wxString sql;
+    clSqliteQuery query;
     wxString path;
 
     // Build the path
     if(scope.IsEmpty() == false && scope != wxT("<global>")) path << scope << wxT("::");
 
     path << typeName;
-    sql << wxT("select ID from tags where path='") << path
-        << wxT("' and kind in ('class', 'struct', 'typedef') LIMIT 1");
+    query << wxT("select ID from tags where path=? and kind in ('class', 'struct', 'typedef') LIMIT 1");
+    query.Bind(path);
 
     try {
-        wxSQLite3ResultSet rs = Query(sql);
+        clSqliteDB::Statement_t statement = DoPrepareQuery(query);
+        clSqliteStatementResetter resetter(statement);
+        wxSQLite3ResultSet rs = statement->ExecuteQuery();
         if(rs.NextRow()) { return true; }
 
     } catch(wxSQLite3Exception& e) {
@@ -1318,85 +1545,188 @@ bool TagsStorageSQLite::IsTypeAndScopeExistLimitOne(const wxString& typeName, co
 
 void TagsStorageSQLite::GetDereferenceOperator(const wxString& scope, std::vector<TagEntryPtr>& tags)
 {
-    wxString sql;
-    sql << wxT("select * from tags where scope ='") << scope << wxT("' and name like 'operator%->%' LIMIT 1");
-    DoFetchTags(sql, tags);
+    clSqliteQuery query;
+    query << wxT("select * from tags where scope =? and name like 'operator%->%' LIMIT 1");
+    query.Bind(scope);
+    DoFetchTags(query, tags);
 }
 
 void TagsStorageSQLite::GetSubscriptOperator(const wxString& scope, std::vector<TagEntryPtr>& tags)
 {
-    wxString sql;
-    sql << wxT("select * from tags where scope ='") << scope << wxT("' and name like 'operator%[%]%' LIMIT 1");
-    DoFetchTags(sql, tags);
+    clSqliteQuery query;
+    query << wxT("select * from tags where scope =? and name like 'operator%[%]%' LIMIT 1");
+    query.Bind(scope);
+    DoFetchTags(query, tags);
 }
 
 //---------------------------------------------------------------------
 //-----------------------------TagsStorageSQLiteCache -----------------
 //---------------------------------------------------------------------
 
-TagsStorageSQLiteCache::TagsStorageSQLiteCache() {}
-
-TagsStorageSQLiteCache::~TagsStorageSQLiteCache() { m_cache.clear(); }
+TagsStorageSQLiteCache::TagsStorageSQLiteCache()
+    : m_maxBytes(TAGS_CACHE_DEFAULT_MAX_BYTES)
+{
+}
 
-bool TagsStorageSQLiteCache::Get(const wxString& sql, std::vector<TagEntryPtr>& tags) { return DoGet(sql, tags); }
+TagsStorageSQLiteCache::~TagsStorageSQLiteCache() { Clear(); }
 
-bool TagsStorageSQLiteCache::Get(const wxString& sql, const wxArrayString& kind, std::vector<TagEntryPtr>& tags)
+wxString TagsStorageSQLiteCache::DoMakeKey(const wxString& sql, const wxArrayString& kind) const
 {
     wxString key;
     key << sql;
     for(size_t i = 0; i < kind.GetCount(); i++) {
         key << wxT("@") << kind.Item(i);
     }
+    return key;
+}
+
+bool TagsStorageSQLiteCache::Get(const wxString& sql, std::vector<TagEntryPtr>& tags) { return DoGet(sql, tags); }
 
-    return DoGet(key, tags);
+bool TagsStorageSQLiteCache::Get(const wxString& sql, const wxArrayString& kind, std::vector<TagEntryPtr>& tags)
+{
+    return DoGet(DoMakeKey(sql, kind), tags);
 }
 
 void TagsStorageSQLiteCache::Store(const wxString& sql, const std::vector<TagEntryPtr>& tags) { DoStore(sql, tags); }
 
+void TagsStorageSQLiteCache::Store(const wxString& sql, const wxArrayString& kind, const std::vector<TagEntryPtr>& tags)
+{
+    DoStore(DoMakeKey(sql, kind), tags);
+}
+
 void TagsStorageSQLiteCache::Clear()
 {
-    // CL_DEBUG1(wxT("[CACHE CLEARED]"));
+    if(!m_lru.empty()) {
+        clDEBUG1() << "Tags cache cleared. hits:" << m_stats.hits << "misses:" << m_stats.misses
+                   << "evictions:" << m_stats.evictions << "invalidations:" << m_stats.invalidations
+                   << "entries:" << m_stats.entries << "bytes:" << m_stats.bytes << clEndl;
+    }
+    m_lru.clear();
     m_cache.clear();
+    m_fileKeys.clear();
+    m_stats.entries = 0;
+    m_stats.bytes = 0;
 }
 
-void TagsStorageSQLiteCache::Store(const wxString& sql, const wxArrayString& kind, const std::vector<TagEntryPtr>& tags)
+void TagsStorageSQLiteCache::ClearFile(const wxString& filename)
 {
-    wxString key;
-    key << sql;
-    for(size_t i = 0; i < kind.GetCount(); i++) {
-        key << wxT("@") << kind.Item(i);
+    // Collect the keys first: erasing an entry updates m_fileKeys
+    wxStringSet_t keys;
+    std::unordered_map<wxString, wxStringSet_t>::iterator iter = m_fileKeys.find(filename);
+    if(iter != m_fileKeys.end()) { keys.insert(iter->second.begin(), iter->second.end()); }
+    iter = m_fileKeys.find(wxEmptyString);
+    if(iter != m_fileKeys.end()) { keys.insert(iter->second.begin(), iter->second.end()); }
+
+    for(const wxString& key : keys) {
+        std::unordered_map<wxString, List_t::iterator>::iterator where = m_cache.find(key);
+        if(where != m_cache.end()) {
+            DoErase(where->second);
+            ++m_stats.invalidations;
+        }
+    }
+}
+
+void TagsStorageSQLiteCache::SetMaxSize(size_t maxBytes)
+{
+    m_maxBytes = maxBytes;
+    while(m_stats.bytes > m_maxBytes && !m_lru.empty()) {
+        DoErase(--m_lru.end());
+        ++m_stats.evictions;
     }
-    DoStore(key, tags);
 }
 
 bool TagsStorageSQLiteCache::DoGet(const wxString& key, std::vector<TagEntryPtr>& tags)
 {
-    std::unordered_map<wxString, std::vector<TagEntryPtr> >::iterator iter = m_cache.find(key);
-    if(iter != m_cache.end()) {
-        // Append the results to the output tags
-        tags.insert(tags.end(), iter->second.begin(), iter->second.end());
-        return true;
+    std::unordered_map<wxString, List_t::iterator>::iterator iter = m_cache.find(key);
+    if(iter == m_cache.end()) {
+        ++m_stats.misses;
+        return false;
     }
-    return false;
+
+    // Move the entry to the front of the LRU list
+    m_lru.splice(m_lru.begin(), m_lru, iter->second);
+    ++m_stats.hits;
+
+    // Append the results to the output tags
+    const std::vector<TagEntryPtr>& cached = iter->second->tags;
+    tags.insert(tags.end(), cached.begin(), cached.end());
+    return true;
 }
 
 void TagsStorageSQLiteCache::DoStore(const wxString& key, const std::vector<TagEntryPtr>& tags)
 {
-    m_cache[key].reserve(tags.size());
-    m_cache[key] = tags;
+    std::unordered_map<wxString, List_t::iterator>::iterator iter = m_cache.find(key);
+    if(iter != m_cache.end()) { DoErase(iter->second); }
+
+    // Estimate the memory used by this entry. Tags may be shared between entries,
+    // so this is an upper bound
+    size_t bytes = sizeof(Entry) + key.length() * sizeof(wxChar);
+    for(size_t i = 0; i < tags.size(); ++i) {
+        const TagEntryPtr& tag = tags[i];
+        bytes += sizeof(TagEntry) + sizeof(TagEntryPtr);
+        bytes += (tag->GetName().length() + tag->GetPath().length() + tag->GetFile().length() +
+                  tag->GetParent().length() + tag->GetScope().length() + tag->GetPattern().length() +
+                  tag->GetSignature().length()) *
+                 sizeof(wxChar);
+    }
+
+    // an entry larger than the whole cache is not worth keeping
+    if(bytes > m_maxBytes) { return; }
+
+    m_lru.push_front(Entry());
+    Entry& entry = m_lru.front();
+    entry.key = key;
+    entry.tags = tags;
+    entry.bytes = bytes;
+    for(size_t i = 0; i < tags.size(); ++i) {
+        entry.files.insert(tags[i]->GetFile());
+    }
+    if(entry.files.empty()) { entry.files.insert(wxEmptyString); }
+
+    for(const wxString& file : entry.files) {
+        m_fileKeys[file].insert(key);
+    }
+    m_cache.insert(std::make_pair(key, m_lru.begin()));
+    ++m_stats.entries;
+    m_stats.bytes += bytes;
+
+    // Evict the least recently used entries
+    while(m_stats.bytes > m_maxBytes && m_lru.size() > 1) {
+        DoErase(--m_lru.end());
+        ++m_stats.evictions;
+    }
+}
+
+void TagsStorageSQLiteCache::DoErase(List_t::iterator iter)
+{
+    for(const wxString& file : iter->files) {
+        std::unordered_map<wxString, wxStringSet_t>::iterator where = m_fileKeys.find(file);
+        if(where != m_fileKeys.end()) {
+            where->second.erase(iter->key);
+            if(where->second.empty()) { m_fileKeys.erase(where); }
+        }
+    }
+    m_stats.bytes -= iter->bytes;
+    --m_stats.entries;
+    m_cache.erase(iter->key);
+    m_lru.erase(iter);
 }
 
 void TagsStorageSQLite::ClearCache() { m_cache.Clear(); }
 
+void TagsStorageSQLite::ClearCache(const wxString& filename) { m_cache.ClearFile(filename); }
+
 void TagsStorageSQLite::SetUseCache(bool useCache) { ITagsStorage::SetUseCache(useCache); }
 
 PPToken TagsStorageSQLite::GetMacro(const wxString& name)
 {
     PPToken token;
     try {
-        wxString sql;
-        sql << wxT("select * from MACROS where name = '") << name << wxT("'");
-        wxSQLite3ResultSet res = m_db->ExecuteQuery(sql);
+        clSqliteQuery query(wxT("select * from MACROS where name = ?"));
+        query.Bind(name);
+        clSqliteDB::Statement_t statement = DoPrepareQuery(query);
+        clSqliteStatementResetter resetter(statement);
+        wxSQLite3ResultSet res = statement->ExecuteQuery();
         if(res.NextRow()) {
             PPTokenFromSQlite3ResultSet(res, token);
             return token;
@@ -1497,29 +1827,32 @@ void TagsStorageSQLite::GetTagsByName(const wxString& prefix, std::vector<TagEnt
     try {
         if(prefix.IsEmpty()) return;
 
-        wxString sql;
-        sql << wxT("select * from tags where ");
-        DoAddNamePartToQuery(sql, prefix, !exactMatch, false);
-        DoAddLimitPartToQuery(sql, tags);
-        DoFetchTags(sql, tags);
+        clSqliteQuery query;
+        query << wxT("select * from tags where ");
+        DoAddNamePartToQuery(query, prefix, !exactMatch, false);
+        DoAddLimitPartToQuery(query, tags);
+        DoFetchTags(query, tags);
 
     } catch(wxSQLite3Exception& e) {
         CL_DEBUG(wxT("%s"), e.GetMessage().c_str());
     }
 }
 
-void TagsStorageSQLite::DoAddNamePartToQuery(wxString& sql, const wxString& name, bool partial, bool prependAnd)
+void TagsStorageSQLite::DoAddNamePartToQuery(clSqliteQuery& query, const wxString& name, bool partial,
+                                             bool prependAnd)
 {
     if(name.empty()) return;
-    if(prependAnd) { sql << wxT(" AND "); }
+    if(prependAnd) { query << wxT(" AND "); }
 
     if(m_enableCaseInsensitive) {
         wxString tmpName(name);
         tmpName.Replace(wxT("_"), wxT("^_"));
         if(partial) {
-            sql << wxT(" name LIKE '") << tmpName << wxT("%%' ESCAPE '^' ");
+            query << wxT(" name LIKE ? ESCAPE '^' ");
+            query.Bind(tmpName + "%");
         } else {
-            sql << wxT(" name ='") << name << wxT("' ");
+            query << wxT(" name =? ");
+            query.Bind(name);
         }
     } else {
         // Don't use LIKE
@@ -1531,19 +1864,41 @@ void TagsStorageSQLite::DoAddNamePartToQuery(wxString& sql, const wxString& name
 
         // add the name condition
         if(partial) {
-            sql << wxT(" name >= '") << from << wxT("' AND  name < '") << until << wxT("'");
+            query << wxT(" name >= ? AND  name < ?");
+            query.Bind(from).Bind(until);
         } else {
-            sql << wxT(" name ='") << name << wxT("' ");
+            query << wxT(" name =? ");
+            query.Bind(name);
         }
     }
 }
 
-void TagsStorageSQLite::DoAddLimitPartToQuery(wxString& sql, const std::vector<TagEntryPtr>& tags)
+void TagsStorageSQLite::DoAddLimitPartToQuery(clSqliteQuery& query, const std::vector<TagEntryPtr>& tags)
 {
     if(tags.size() >= (size_t)GetSingleSearchLimit()) {
-        sql << wxT(" LIMIT 1 ");
+        query << wxT(" LIMIT 1 ");
     } else {
-        sql << wxT(" LIMIT ") << (size_t)GetSingleSearchLimit() - tags.size();
+        query << wxT(" LIMIT ?");
+        query.Bind((int)(GetSingleSearchLimit() - tags.size()));
+    }
+}
+
+void TagsStorageSQLite::DoAddOrderPartToQuery(clSqliteQuery& query, const wxString& orderingColumn, int order)
+{
+    // column names can not be bound, they are part of the statement text
+    if(orderingColumn.IsEmpty()) { return; }
+
+    query << wxT("order by ") << orderingColumn;
+    switch(order) {
+    case ITagsStorage::OrderAsc:
+        query << wxT(" ASC");
+        break;
+    case ITagsStorage::OrderDesc:
+        query << wxT(" DESC");
+        break;
+    case ITagsStorage::OrderNone:
+    default:
+        break;
     }
 }
 
@@ -1553,12 +1908,12 @@ TagEntryPtr TagsStorageSQLite::GetTagsByNameLimitOne(const wxString& name)
         if(name.IsEmpty()) return NULL;
 
         std::vector<TagEntryPtr> tags;
-        wxString sql;
-        sql << wxT("select * from tags where ");
-        DoAddNamePartToQuery(sql, name, false, false);
-        sql << wxT(" LIMIT 1 ");
+        clSqliteQuery query;
+        query << wxT("select * from tags where ");
+        DoAddNamePartToQuery(query, name, false, false);
+        query << wxT(" LIMIT 1 ");
 
-        DoFetchTags(sql, tags);
+        DoFetchTags(query, tags);
         if(tags.size() == 1)
             return tags.at(0);
         else
@@ -1578,10 +1933,29 @@ void TagsStorageSQLite::GetTagsByPartName(const wxString& partname, std::vector<
         wxString tmpName(partname);
         tmpName.Replace(wxT("_"), wxT("^_"));
 
-        wxString sql;
-        sql << wxT("select * from tags where name like '%%") << tmpName << wxT("%%' ESCAPE '^' ");
-        DoAddLimitPartToQuery(sql, tags);
-        DoFetchTags(sql, tags);
+        std::vector<wxString> trigrams;
+        if(partname.find_first_of("%^") == wxString::npos) { GetTrigrams(partname, trigrams); }
+
+        clSqliteQuery query;
+        if(trigrams.empty()) {
+            // Too short for the names index (or contains LIKE special characters): scan the table
+            query << wxT("select * from tags where name like ? ESCAPE '^' ");
+            query.Bind("%" + tmpName + "%");
+
+        } else {
+            // Candidate names are the ones that contain all the trigrams of the searched string,
+            // the LIKE filters out the ones that contain them in a different order
+            query << wxT("select * from tags where name in (select name from TAG_NAMES where ID in (");
+            for(size_t i = 0; i < trigrams.size() && i < MAX_SEARCH_TRIGRAMS; ++i) {
+                if(i > 0) { query << wxT(" INTERSECT "); }
+                query << wxT("select name_id from NAME_TRIGRAMS where trigram=?");
+                query.Bind(trigrams[i]);
+            }
+            query << wxT(") and name like ? ESCAPE '^') ");
+            query.Bind("%" + tmpName + "%");
+        }
+        DoAddLimitPartToQuery(query, tags);
+        DoFetchTags(query, tags);
 
     } catch(wxSQLite3Exception& e) {
         CL_DEBUG(wxT("%s"), e.GetMessage().c_str());
@@ -1592,7 +1966,7 @@ void TagsStorageSQLite::RemoveNonWorkspaceSymbols(const std::vector<wxString>& s
                                                   std::vector<wxString>& workspaceSymbols,
                                                   std::vector<wxString>& nonWorkspaceSymbols)
 {
-    wxString sql;
+    clSqliteQuery query;
     try {
         workspaceSymbols.clear();
         nonWorkspaceSymbols.clear();
@@ -1621,19 +1995,19 @@ void TagsStorageSQLite::RemoveNonWorkspaceSymbols(const std::vector<wxString>& s
 
         std::vector<wxString> allSymbols;
         for(size_t i = 0; i < v.size(); ++i) {
-            sql.Clear();
-            sql << "SELECT distinct name,kind FROM tags where name in (";
+            // all chunks but the last one have the same size, so they share a single statement
+            query = clSqliteQuery("SELECT distinct name,kind FROM tags where name in (");
             for(size_t n = 0; n < v[i].size(); ++n) {
-                sql << "'" << v[i][n] << "',";
+                query << (n == 0 ? "?" : ",?");
+                query.Bind(v[i][n]);
             }
-
-            // remove the last comma
-            sql.RemoveLast();
-            sql << ")";
-            sql << kindSQL;
+            query << ")";
+            query << kindSQL;
 
             // Run the query
-            wxSQLite3ResultSet res = m_db->ExecuteQuery(sql);
+            clSqliteDB::Statement_t statement = DoPrepareQuery(query);
+            clSqliteStatementResetter resetter(statement);
+            wxSQLite3ResultSet res = statement->ExecuteQuery();
             while(res.NextRow()) {
                 wxString name = res.GetString(0);
                 wxString kind = res.GetString(1);
@@ -1650,7 +2024,7 @@ void TagsStorageSQLite::RemoveNonWorkspaceSymbols(const std::vector<wxString>& s
                             std::back_inserter(nonWorkspaceSymbols));
 
     } catch(wxSQLite3Exception& e) {
-        clDEBUG() << "SplitSymbols error:" << sql << ":" << e.GetMessage() << clEndl;
+        clDEBUG() << "SplitSymbols error:" << query.GetSQL() << ":" << e.GetMessage() << clEndl;
     }
 }
 
@@ -1662,22 +2036,22 @@ const wxString& TagsStorageSQLite::GetVersion() const
 
 void TagsStorageSQLite::GetTagsByPartName(const wxArrayString& parts, std::vector<TagEntryPtr>& tags)
 {
-    wxString sql;
+    clSqliteQuery query;
     try {
         if(parts.IsEmpty()) { return; }
 
-        wxString filterQuery = "where ";
+        query << "select * from tags where ";
         for(size_t i = 0; i < parts.size(); ++i) {
             wxString tmpName = parts.Item(i);
             tmpName.Replace(wxT("_"), wxT("^_"));
-            filterQuery << "path like '%%" << tmpName << "%%' " << ((i == (parts.size() - 1)) ? "" : "AND ");
+            query << "path like ? ESCAPE '^' " << ((i == (parts.size() - 1)) ? "" : "AND ");
+            query.Bind("%" + tmpName + "%");
         }
 
-        sql << "select * from tags " << filterQuery << " ESCAPE '^' ";
-        DoAddLimitPartToQuery(sql, tags);
-        DoFetchTags(sql, tags);
+        DoAddLimitPartToQuery(query, tags);
+        DoFetchTags(query, tags);
 
     } catch(wxSQLite3Exception& e) {
-        clWARNING() << sql << ":" << e.GetMessage() << clEndl;
+        clWARNING() << query.GetSQL() << ":" << e.GetMessage() << clEndl;
     }
 }
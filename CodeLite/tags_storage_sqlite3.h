@@ -28,7 +28,10 @@
 #include "tag_tree.h"
 #include "entry.h"
 #include <wx/filename.h>
+#include <list>
+#include <memory>
 #include <unordered_map>
+#include "macros.h"
 #include "fileentry.h"
 #include "istorage.h"
 #include <wx/wxsqlite3.h>
@@ -85,18 +88,67 @@
  * | Replacement    | String | the replacement string (processed. i.e. %0..%N as placeholders for the arguments)
  * | Signature      | String | For macro of type 'IsFunctionLike', contains the signature in the form of (%0,...%N)
  *
+ * Table Name: TAG_NAMES
+ *
+ * || Column Name   || Type || Description
+ * | id             | Number | ID
+ * | name           | String | A distinct tag name
+ *
+ * Table Name: NAME_TRIGRAMS
+ *
+ * || Column Name   || Type || Description
+ * | trigram        | Text   | 3 consecutive characters (lower case) of a tag name
+ * | name_id        | Number | The TAG_NAMES entry containing the trigram
+ *
+ * TAG_NAMES and NAME_TRIGRAMS form a substring index used by GetTagsByPartName so that
+ * "name like '%part%'" queries do not scan the whole TAGS table
+ *
  * @date 08-22-2006
  * @author Eran
  * @ingroup CodeLite
  */
 
-class TagsStorageSQLiteCache
+/**
+ * @class TagsStorageSQLiteCache
+ * @brief a least-recently-used cache of query results, bounded by the estimated memory used by
+ * the cached tags. Entries can be invalidated per file: each entry remembers the files of the
+ * tags it holds
+ */
+class WXDLLIMPEXP_CL TagsStorageSQLiteCache
 {
-    std::unordered_map<wxString, std::vector<TagEntryPtr> > m_cache;
+public:
+    struct Stats {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t evictions = 0;
+        size_t invalidations = 0;
+        size_t entries = 0;
+        size_t bytes = 0;
+    };
+
+protected:
+    struct Entry {
+        wxString key;
+        std::vector<TagEntryPtr> tags;
+        wxStringSet_t files;
+        size_t bytes = 0;
+    };
+    typedef std::list<Entry> List_t;
+
+    // Most recently used entries are at the front
+    List_t m_lru;
+    std::unordered_map<wxString, List_t::iterator> m_cache;
+    // file name -> keys of the entries holding tags from that file
+    // the empty file name holds the keys of entries with no tags
+    std::unordered_map<wxString, wxStringSet_t> m_fileKeys;
+    size_t m_maxBytes;
+    Stats m_stats;
 
 protected:
     bool DoGet(const wxString& key, std::vector<TagEntryPtr>& tags);
     void DoStore(const wxString& key, const std::vector<TagEntryPtr>& tags);
+    void DoErase(List_t::iterator iter);
+    wxString DoMakeKey(const wxString& sql, const wxArrayString& kind) const;
 
 public:
     TagsStorageSQLiteCache();
@@ -107,11 +159,111 @@ public:
     void Store(const wxString& sql, const std::vector<TagEntryPtr>& tags);
     void Store(const wxString& sql, const wxArrayString& kind, const std::vector<TagEntryPtr>& tags);
     void Clear();
+
+    /**
+     * @brief drop the entries holding tags of 'filename', and the entries without tags
+     * (a query that found nothing may now find tags of the modified file)
+     */
+    void ClearFile(const wxString& filename);
+
+    /**
+     * @brief set the maximum (estimated) memory in bytes used by the cached tags.
+     * Least recently used entries are evicted when the limit is exceeded
+     */
+    void SetMaxSize(size_t maxBytes);
+    size_t GetMaxSize() const { return m_maxBytes; }
+
+    const Stats& GetStats() const { return m_stats; }
+};
+
+/**
+ * @class clSqliteQuery
+ * @brief an SQL statement with '?' placeholders and the values to bind to them.
+ * Since the values are not part of the SQL text, the same statement text is produced
+ * for every call of a given getter, which allows clSqliteDB to reuse its compiled form
+ */
+class WXDLLIMPEXP_CL clSqliteQuery
+{
+    struct Param {
+        bool isInt;
+        wxString str;
+        int num;
+    };
+
+    wxString m_sql;
+    std::vector<Param> m_params;
+
+public:
+    clSqliteQuery() {}
+    clSqliteQuery(const wxString& sql)
+        : m_sql(sql)
+    {
+    }
+
+    clSqliteQuery& operator<<(const wxString& sql)
+    {
+        m_sql << sql;
+        return *this;
+    }
+
+    /**
+     * @brief bind a value to the next placeholder
+     */
+    clSqliteQuery& Bind(const wxString& value);
+    clSqliteQuery& Bind(int value);
+
+    /**
+     * @brief append a comma separated list of placeholders for 'values' (for the IN operator)
+     * and bind them
+     */
+    clSqliteQuery& BindList(const wxArrayString& values);
+
+    /**
+     * @brief bind the parameters to a prepared statement compiled from GetSQL()
+     */
+    void BindTo(wxSQLite3Statement& statement) const;
+
+    const wxString& GetSQL() const { return m_sql; }
+
+    /**
+     * @brief return a string that uniquely identifies this query and its parameters
+     */
+    wxString GetCacheKey() const;
+};
+
+/**
+ * @class clSqliteStatementResetter
+ * @brief reset a cached statement when going out of scope, so it does not keep a read transaction open
+ */
+class clSqliteStatementResetter
+{
+    std::shared_ptr<wxSQLite3Statement> m_statement;
+
+public:
+    clSqliteStatementResetter(std::shared_ptr<wxSQLite3Statement> statement)
+        : m_statement(statement)
+    {
+    }
+    ~clSqliteStatementResetter()
+    {
+        try {
+            m_statement->Reset();
+        } catch(wxSQLite3Exception& e) {
+            wxUnusedVar(e);
+        }
+    }
 };
 
 class WXDLLIMPEXP_CL clSqliteDB : public wxSQLite3Database
 {
-    std::unordered_map<wxString, wxSQLite3Statement> m_statements;
+public:
+    typedef std::shared_ptr<wxSQLite3Statement> Statement_t;
+
+protected:
+    // the cached statements, the most recently used first
+    typedef std::list<std::pair<wxString, Statement_t> > StatementList_t;
+    StatementList_t m_lru;
+    std::unordered_map<wxString, StatementList_t::iterator> m_statements;
 
 public:
     clSqliteDB()
@@ -121,18 +273,36 @@ public:
 
     void Close()
     {
+        // statements must be finalized before the connection can be closed
+        ClearStatements();
         if(IsOpen()) wxSQLite3Database::Close();
-
-        m_statements.clear();
     }
 
     wxSQLite3Statement GetPrepareStatement(const wxString& sql) { return wxSQLite3Database::PrepareStatement(sql); }
+
+    /**
+     * @brief return a prepared statement for 'sql'. The statement is compiled on first use and kept
+     * in the cache until it is the least recently used one of a full cache. The caller shares its ownership,
+     * so an evicted statement is only finalized once the caller is done with it.
+     * The caller must Reset() the statement once done with it
+     */
+    Statement_t GetCachedStatement(const wxString& sql);
+
+    /**
+     * @brief finalize all cached statements
+     */
+    void ClearStatements()
+    {
+        m_statements.clear();
+        m_lru.clear();
+    }
 };
 
 class WXDLLIMPEXP_CL TagsStorageSQLite : public ITagsStorage
 {
     clSqliteDB* m_db;
     TagsStorageSQLiteCache m_cache;
+    wxStringSet_t m_namesToPrune; // names of deleted tags, removed from the names index on commit if unused
 
 private:
     /**
@@ -140,18 +310,28 @@ private:
      * @param sql
      * @param tags
      */
-    void DoFetchTags(const wxString& sql, std::vector<TagEntryPtr>& tags);
+    void DoFetchTags(const clSqliteQuery& query, std::vector<TagEntryPtr>& tags);
 
     /**
-     * @brief
-     * @param sql
+     * @brief return the cached prepared statement for 'query' with the query parameters bound to it.
+     * Use clSqliteStatementResetter to reset the statement once done with its result set
+     */
+    clSqliteDB::Statement_t DoPrepareQuery(const clSqliteQuery& query);
+
+    /**
+     * @brief fetch tags from the database, keeping only tags of the given kinds
+     * @param query
      * @param tags
      */
-    void DoFetchTags(const wxString& sql, std::vector<TagEntryPtr>& tags, const wxArrayString& kinds);
+    void DoFetchTags(const clSqliteQuery& query, std::vector<TagEntryPtr>& tags, const wxArrayString& kinds);
 
-    void DoAddNamePartToQuery(wxString& sql, const wxString& name, bool partial, bool prependAnd);
-    void DoAddLimitPartToQuery(wxString& sql, const std::vector<TagEntryPtr>& tags);
+    void DoAddNamePartToQuery(clSqliteQuery& query, const wxString& name, bool partial, bool prependAnd);
+    void DoAddLimitPartToQuery(clSqliteQuery& query, const std::vector<TagEntryPtr>& tags);
+    void DoAddOrderPartToQuery(clSqliteQuery& query, const wxString& orderingColumn, int order);
     int DoInsertTagEntry(const TagEntry& tag);
+    void DoAddNameToIndex(const wxString& name);
+    void DoCollectNamesToPrune(const wxString& where);
+    void DoPruneNamesIndex();
 
 public:
     static TagEntry* FromSQLite3ResultSet(wxSQLite3ResultSet& rs);
@@ -179,6 +359,16 @@ public:
 
     virtual void SetUseCache(bool useCache);
 
+    /**
+     * @brief return the cache hit/miss/eviction counters
+     */
+    const TagsStorageSQLiteCache::Stats& GetCacheStats() const { return m_cache.GetStats(); }
+
+    /**
+     * @brief set the maximum memory (in bytes) used by the query results cache
+     */
+    void SetCacheMaxSize(size_t maxBytes) { m_cache.SetMaxSize(maxBytes); }
+
     /**
      * Return the currently opened database.
      * @return Currently open database
@@ -274,6 +464,7 @@ public:
     void Commit()
     {
         try {
+            DoPruneNamesIndex();
             m_db->Commit();
         } catch(wxSQLite3Exception& e) {
             wxUnusedVar(e);
@@ -283,7 +474,11 @@ public:
     /**
      * Rollback transaction.
      */
-    void Rollback() { return m_db->Rollback(); }
+    void Rollback()
+    {
+        m_namesToPrune.clear();
+        return m_db->Rollback();
+    }
 
     /**
      * Test whether the database is opened
@@ -311,6 +506,17 @@ public:
      */
     void RecreateDatabase();
 
+    /**
+     * @brief rebuild the tag names substring index (TAG_NAMES and NAME_TRIGRAMS) from the TAGS table.
+     */
+    void RebuildNamesIndex();
+
+    /**
+     * @brief rebuild the tag names substring index if the database was created before the index existed.
+     * This may take a while, so it is done by the parser thread and not when the database is opened
+     */
+    void RebuildNamesIndexIfNeeded();
+
     /**
      * return list of files from the database. The returned list is ordered
      * by name (ascending)
@@ -541,6 +747,8 @@ public:
      */
     virtual void ClearCache();
 
+    virtual void ClearCache(const wxString& filename);
+
     /**
      * @brief
      * @param fileName
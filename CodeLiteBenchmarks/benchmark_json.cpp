@@ -0,0 +1,115 @@
+#include "JSON.h"
+#include "JSONStreamReader.h"
+#include "benchmarks.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+// Reads the "file" property of every entry of a generated compile_commands.json: visiting the
+// array by index (the way CompilationDatabase used to), iterating over the array and reading the
+// document with the streaming reader, without building the DOM
+namespace
+{
+std::string MakeCompileCommands(size_t numEntries)
+{
+    std::string json = "[\n";
+    for(size_t i = 0; i < numEntries; ++i) {
+        std::string file = "/home/user/project/src/module" + std::to_string(i % 100) + "/file" + std::to_string(i) +
+                           ".cpp";
+        if(i) { json += ",\n"; }
+        json += "  {\n    \"directory\": \"/home/user/project/build\",\n";
+        json += "    \"command\": \"/usr/bin/c++ -DNDEBUG -I/home/user/project/include -I/usr/include/wx-3.0 "
+                "-O2 -g -std=c++11 -o CMakeFiles/file" +
+                std::to_string(i) + ".o -c " + file + "\",\n";
+        json += "    \"file\": \"" + file + "\"\n  }";
+    }
+    json += "\n]\n";
+    return json;
+}
+
+class FileCounter : public JSONStreamReader::Handler
+{
+    int m_depth = 0;
+    bool m_isFile = false;
+
+public:
+    size_t count = 0;
+
+    virtual bool OnStartObject()
+    {
+        ++m_depth;
+        return true;
+    }
+    virtual bool OnEndObject()
+    {
+        --m_depth;
+        return true;
+    }
+    virtual bool OnKey(const std::string& key)
+    {
+        m_isFile = (m_depth == 1 && key == "file");
+        return true;
+    }
+    virtual bool OnString(const std::string& value)
+    {
+        if(m_isFile && !value.empty()) { ++count; }
+        m_isFile = false;
+        return true;
+    }
+};
+} // namespace
+
+int benchmark_json(int argc, char** argv)
+{
+    size_t numEntries = argc > 0 ? strtoul(argv[0], NULL, 10) : 20000;
+    if(numEntries == 0) {
+        printf("Invalid arguments\n");
+        return 1;
+    }
+
+    wxStopWatch sw;
+    std::string json = MakeCompileCommands(numEntries);
+    wxString text = wxString::FromUTF8(json.c_str(), json.length());
+    printf("Generated %lu entries (%lu bytes) in %ldms\n", (unsigned long)numEntries, (unsigned long)json.length(),
+           sw.Time());
+
+    int rc = 0;
+    {
+        sw.Start();
+        JSON root(text);
+        JSONItem arr = root.toElement();
+        size_t count = 0;
+        const int size = arr.arraySize();
+        for(int i = 0; i < size; ++i) {
+            if(!arr.arrayItem(i).namedObject("file").toString().IsEmpty()) { ++count; }
+        }
+        benchmark_report(wxString() << "DOM, arrayItem(i) (" << count << " files)", 1, sw.Time());
+        if(count != numEntries) { rc = 1; }
+    }
+
+    {
+        sw.Start();
+        JSON root(text);
+        size_t count = 0;
+        for(JSONItem element : root.toElement()) {
+            if(!element.namedObject("file").toString().IsEmpty()) { ++count; }
+        }
+        benchmark_report(wxString() << "DOM, iteration (" << count << " files)", 1, sw.Time());
+        if(count != numEntries) { rc = 1; }
+    }
+
+    {
+        sw.Start();
+        FileCounter handler;
+        JSONStreamReader reader(&handler);
+        if(!reader.Parse(json.c_str(), json.length())) {
+            printf("ERROR: %s\n", (const char*)reader.GetError().mb_str(wxConvUTF8).data());
+            return 1;
+        }
+        benchmark_report(wxString() << "Streaming reader (" << handler.count << " files)", 1, sw.Time());
+        if(handler.count != numEntries) { rc = 1; }
+    }
+
+    if(rc != 0) { printf("ERROR: the readers did not find %lu files\n", (unsigned long)numEntries); }
+    return rc;
+}
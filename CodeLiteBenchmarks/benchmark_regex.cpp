@@ -0,0 +1,131 @@
+#include "benchmarks.h"
+#include "clRegexEngine.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <wx/regex.h>
+#include <wx/tokenzr.h>
+
+// Compares the Find in Files regular expression engines on a fixed, generated corpus: wxRegEx
+// invoked once per line (the way SearchThread used to search), wxRegEx over the whole buffer and
+// the linear engine over the whole buffer
+namespace
+{
+const char* words[] = { "int", "value", "std::string", "return", "class", "MyClass", "m_member", "wxString",
+                        "if", "for", "size_t", "GetValue", "const", "auto", "nullptr", "0x1F", "42" };
+
+wxString MakeCorpus(size_t numLines)
+{
+    wxString corpus;
+    unsigned long seed = 7;
+    for(size_t i = 0; i < numLines; ++i) {
+        seed = seed * 1103515245 + 12345;
+        size_t indent = (seed >> 8) % 4;
+        corpus << wxString(' ', indent * 4);
+        if(i % 50 == 0) {
+            corpus << "#include <header" << (i % 700) << ".h>\n";
+            continue;
+        }
+        size_t count = 3 + (seed >> 12) % 8;
+        for(size_t w = 0; w < count; ++w) {
+            seed = seed * 1103515245 + 12345;
+            corpus << words[(seed >> 8) % (sizeof(words) / sizeof(words[0]))] << " ";
+        }
+        corpus << (i % 3 == 0 ? ";\n" : "\n");
+    }
+    // A long run of 'a' to exercise backtracking
+    corpus << wxString('a', 5000) << "\n";
+    return corpus;
+}
+
+size_t CountMatches(clRegexEngine::Ptr_t re, const wxString& text)
+{
+    size_t count = 0;
+    size_t from = 0, start, len;
+    while(from <= text.length() && re->Find(text, from, start, len)) {
+        if(len == 0) {
+            from = start + 1;
+            continue;
+        }
+        ++count;
+        from = start + len;
+    }
+    return count;
+}
+
+size_t CountMatchesPerLine(const wxString& pattern, const wxString& text)
+{
+#ifndef __WXMAC__
+    wxRegEx re(pattern, wxRE_ADVANCED);
+#else
+    wxRegEx re(pattern, wxRE_DEFAULT);
+#endif
+    if(!re.IsValid()) { return 0; }
+
+    size_t count = 0;
+    wxStringTokenizer tkz(text, "\n", wxTOKEN_RET_EMPTY_ALL);
+    while(tkz.HasMoreTokens()) {
+        wxString line = tkz.NextToken();
+        size_t from = 0, start, len;
+        while(from < line.length() && re.Matches(line.wx_str() + from, from ? wxRE_NOTBOL : 0, line.length() - from)) {
+            re.GetMatch(&start, &len);
+            if(len == 0) {
+                from += start + 1;
+                continue;
+            }
+            ++count;
+            from += start + len;
+        }
+    }
+    return count;
+}
+} // namespace
+
+int benchmark_regex(int argc, char** argv)
+{
+    size_t numLines = argc > 0 ? strtoul(argv[0], NULL, 10) : 200000;
+    if(numLines == 0) {
+        printf("Invalid arguments\n");
+        return 1;
+    }
+
+    const char* patterns[] = {
+        "wxString", "m_[a-z]+", "^\\s*#include\\s*<[^>]+>", "\\y(int|size_t|auto)\\s+\\w+",
+        "Get[A-Z][a-zA-Z]*", "0x[0-9A-Fa-f]+", "(a|aa)*b", "(\\w+\\s?)*;",
+    };
+
+    wxStopWatch sw;
+    wxString corpus = MakeCorpus(numLines);
+    printf("Generated %lu lines (%lu characters) in %ldms\n", (unsigned long)numLines,
+           (unsigned long)corpus.length(), sw.Time());
+
+    int rc = 0;
+    for(const char* pattern : patterns) {
+        printf("Pattern: %s\n", pattern);
+
+        sw.Start();
+        size_t perLine = CountMatchesPerLine(pattern, corpus);
+        benchmark_report(wxString() << "  wxRegEx per line (" << perLine << " matches)", 1, sw.Time());
+
+        clRegexEngine::Ptr_t wxre = clRegexEngine::New(clRegexEngine::kWxRegEx);
+        wxre->Compile(pattern, true);
+        sw.Start();
+        size_t wxCount = CountMatches(wxre, corpus);
+        benchmark_report(wxString() << "  wxRegEx whole buffer (" << wxCount << " matches)", 1, sw.Time());
+
+        clRegexEngine::Ptr_t linear = clRegexEngine::New(clRegexEngine::kLinear);
+        if(!linear->Compile(pattern, true)) {
+            printf("  linear engine: pattern not supported\n");
+            continue;
+        }
+        sw.Start();
+        size_t linearCount = CountMatches(linear, corpus);
+        benchmark_report(wxString() << "  linear whole buffer (" << linearCount << " matches)", 1, sw.Time());
+
+        if(linearCount != perLine) {
+            printf("ERROR: the linear engine found %lu matches, expected %lu\n", (unsigned long)linearCount,
+                   (unsigned long)perLine);
+            rc = 1;
+        }
+    }
+    return rc;
+}
@@ -0,0 +1,214 @@
+#include "benchmarks.h"
+#include "tags_storage_sqlite3.h"
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <wx/filename.h>
+#include <wx/stdpaths.h>
+
+// Measures the cost of the code completion lookups of TagsStorageSQLite.
+// The database is populated with synthetic tags, the result cache is disabled
+// so every lookup reaches SQLite, and the prepared statement path is compared
+// against building and compiling the SQL text on every call. Substring searches
+// through the tag names index are compared against a scan of the TAGS table.
+namespace
+{
+const char* kinds[] = { "function", "prototype", "member", "class", "variable" };
+
+wxString MakeScope(size_t i)
+{
+    if(i % 10 == 0) { return "<global>"; }
+    return wxString() << "ns" << (i % 100) << "::Class" << (i % 10000);
+}
+
+wxString MakeName(size_t i) { return wxString() << "Member" << i; }
+
+wxString MakePath(size_t i)
+{
+    wxString scope = MakeScope(i);
+    return scope == "<global>" ? MakeName(i) : scope + "::" + MakeName(i);
+}
+
+void Populate(TagsStorageSQLite& db, size_t numTags)
+{
+    db.Begin();
+    wxSQLite3Statement tagsStmt =
+        db.PrepareStatement("INSERT OR REPLACE INTO TAGS VALUES (NULL, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+    for(size_t i = 0; i < numTags; ++i) {
+        wxString scope = MakeScope(i);
+        tagsStmt.Bind(1, MakeName(i));
+        tagsStmt.Bind(2, wxString() << "/src/file" << (i % 20000) << ".cpp");
+        tagsStmt.Bind(3, (int)(i % 1000));
+        tagsStmt.Bind(4, kinds[i % 5]);
+        tagsStmt.Bind(5, "public");
+        tagsStmt.Bind(6, "(int a, const wxString& b)");
+        tagsStmt.Bind(7, "/^ void Member();$/");
+        tagsStmt.Bind(8, scope.AfterLast(':'));
+        tagsStmt.Bind(9, "");
+        tagsStmt.Bind(10, MakePath(i));
+        tagsStmt.Bind(11, "");
+        tagsStmt.Bind(12, scope);
+        tagsStmt.Bind(13, "void");
+        tagsStmt.ExecuteUpdate();
+    }
+
+    wxSQLite3Statement macrosStmt = db.PrepareStatement("insert or replace into MACROS values(NULL, ?, ?, ?, ?, ?, ?)");
+    for(size_t i = 0; i < numTags / 100; ++i) {
+        macrosStmt.Bind(1, "/src/macros.h");
+        macrosStmt.Bind(2, (int)i);
+        macrosStmt.Bind(3, wxString() << "MACRO_" << i);
+        macrosStmt.Bind(4, 0);
+        macrosStmt.Bind(5, wxString() << "value_" << i);
+        macrosStmt.Bind(6, "");
+        macrosStmt.ExecuteUpdate();
+    }
+    db.Commit();
+}
+
+/// The SQL text the tags storage used to build for GetTagsByScopeAndName
+wxString MakeAdhocSQL(const wxString& scope, const wxString& name, int limit)
+{
+    wxString sql;
+    sql << "select * from tags where ";
+    if(scope == "<global>") {
+        sql << "ID IN (select tag_id from global_tags where  name ='" << name << "'  ) ";
+    } else {
+        sql << " scope = '" << scope << "'  AND  name ='" << name << "' ";
+    }
+    sql << " LIMIT " << limit;
+    return sql;
+}
+} // namespace
+
+int benchmark_tags_storage(int argc, char** argv)
+{
+    size_t numTags = argc > 0 ? strtoul(argv[0], NULL, 10) : 1000000;
+    size_t iterations = argc > 1 ? strtoul(argv[1], NULL, 10) : 20000;
+    if(numTags == 0 || iterations == 0) {
+        printf("Invalid arguments\n");
+        return 1;
+    }
+
+    wxFileName dbfile(wxStandardPaths::Get().GetTempDir(), "codelite_benchmark_tags.db");
+    if(dbfile.FileExists()) { ::wxRemoveFile(dbfile.GetFullPath()); }
+
+    int rc = 0;
+    {
+        TagsStorageSQLite db;
+        db.OpenDatabase(dbfile);
+        if(!db.IsOpen()) {
+            printf("Could not open database %s\n", dbfile.GetFullPath().mb_str(wxConvUTF8).data());
+            return 1;
+        }
+        db.SetUseCache(false);
+
+        wxStopWatch sw;
+        Populate(db, numTags);
+        printf("Populated %lu tags in %ldms\n", (unsigned long)numTags, sw.Time());
+
+        sw.Start();
+        db.RebuildNamesIndex();
+        printf("Built the tag names index in %ldms\n", sw.Time());
+
+        // Use the same sequence of lookups for every variant
+        std::vector<size_t> indexes;
+        indexes.reserve(iterations);
+        unsigned long seed = 42;
+        for(size_t i = 0; i < iterations; ++i) {
+            seed = seed * 1103515245 + 12345;
+            indexes.push_back((seed >> 8) % numTags);
+        }
+
+        size_t found = 0;
+        sw.Start();
+        for(size_t i = 0; i < iterations; ++i) {
+            wxString sql = MakeAdhocSQL(MakeScope(indexes[i]), MakeName(indexes[i]), db.GetSingleSearchLimit());
+            wxSQLite3ResultSet rs = db.Query(sql);
+            while(rs.NextRow()) {
+                TagEntryPtr tag(TagsStorageSQLite::FromSQLite3ResultSet(rs));
+                ++found;
+            }
+        }
+        benchmark_report("GetTagsByScopeAndName (ad-hoc SQL)", iterations, sw.Time());
+        size_t expected = found;
+
+        found = 0;
+        sw.Start();
+        for(size_t i = 0; i < iterations; ++i) {
+            std::vector<TagEntryPtr> tags;
+            db.GetTagsByScopeAndName(MakeScope(indexes[i]), MakeName(indexes[i]), false, tags);
+            found += tags.size();
+        }
+        benchmark_report("GetTagsByScopeAndName (prepared)", iterations, sw.Time());
+        if(found != expected) {
+            printf("ERROR: prepared lookups returned %lu tags, expected %lu\n", (unsigned long)found,
+                   (unsigned long)expected);
+            rc = 1;
+        }
+
+        sw.Start();
+        for(size_t i = 0; i < iterations; ++i) {
+            std::vector<TagEntryPtr> tags;
+            db.GetTagsByPath(MakePath(indexes[i]), tags);
+        }
+        benchmark_report("GetTagsByPath (prepared)", iterations, sw.Time());
+
+        sw.Start();
+        for(size_t i = 0; i < iterations; ++i) {
+            std::vector<TagEntryPtr> tags;
+            db.GetTagsByFileAndLine(wxString() << "/src/file" << (indexes[i] % 20000) << ".cpp",
+                                    indexes[i] % 1000, tags);
+        }
+        benchmark_report("GetTagsByFileAndLine (prepared)", iterations, sw.Time());
+
+        sw.Start();
+        for(size_t i = 0; i < iterations; ++i) {
+            db.GetMacro(wxString() << "MACRO_" << (indexes[i] % (numTags / 100 + 1)));
+        }
+        benchmark_report("GetMacro (prepared)", iterations, sw.Time());
+
+        // Substring searches, as done by Open Resource
+        size_t searches = std::min<size_t>(iterations, 200);
+        sw.Start();
+        for(size_t i = 0; i < searches; ++i) {
+            wxString sql;
+            sql << "select * from tags where name like '%" << MakeName(indexes[i]).Mid(2) << "%' ESCAPE '^'  LIMIT "
+                << db.GetSingleSearchLimit();
+            wxSQLite3ResultSet rs = db.Query(sql);
+            while(rs.NextRow()) {
+                TagEntryPtr tag(TagsStorageSQLite::FromSQLite3ResultSet(rs));
+            }
+        }
+        benchmark_report("name like '%part%' (table scan)", searches, sw.Time());
+
+        sw.Start();
+        for(size_t i = 0; i < searches; ++i) {
+            std::vector<TagEntryPtr> tags;
+            db.GetTagsByPartName(MakeName(indexes[i]).Mid(2), tags);
+            if(tags.empty()) {
+                printf("ERROR: GetTagsByPartName did not find %s\n", MakeName(indexes[i]).mb_str(wxConvUTF8).data());
+                rc = 1;
+                break;
+            }
+        }
+        benchmark_report("GetTagsByPartName (names index)", searches, sw.Time());
+
+        // Results cache: lookups drawn from a working set of 1000 symbols, with a bounded cache
+        db.SetUseCache(true);
+        db.SetCacheMaxSize(1024 * 1024);
+        sw.Start();
+        for(size_t i = 0; i < iterations; ++i) {
+            std::vector<TagEntryPtr> tags;
+            size_t index = indexes[i % 1000];
+            db.GetTagsByScopeAndName(MakeScope(index), MakeName(index), false, tags);
+        }
+        benchmark_report("GetTagsByScopeAndName (cached)", iterations, sw.Time());
+        const TagsStorageSQLiteCache::Stats& stats = db.GetCacheStats();
+        printf("Cache: %lu hits, %lu misses, %lu evictions, %lu entries, %lu bytes\n", (unsigned long)stats.hits,
+               (unsigned long)stats.misses, (unsigned long)stats.evictions, (unsigned long)stats.entries,
+               (unsigned long)stats.bytes);
+    }
+
+    ::wxRemoveFile(dbfile.GetFullPath());
+    return rc;
+}
@@ -0,0 +1,23 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include <wx/stopwatch.h>
+#include <wx/string.h>
+
+/**
+ * @brief every benchmark receives the command line arguments that follow its name
+ * and returns the process exit code
+ */
+typedef int (*BenchmarkFunc_t)(int argc, char** argv);
+
+// Benchmarks
+int benchmark_tags_storage(int argc, char** argv);
+int benchmark_regex(int argc, char** argv);
+int benchmark_json(int argc, char** argv);
+
+/**
+ * @brief print a single result line in the form: <name> <count> iterations in <ms>ms (<us> us/iter)
+ */
+void benchmark_report(const wxString& name, size_t iterations, long elapsedMs);
+
+#endif // BENCHMARKS_H
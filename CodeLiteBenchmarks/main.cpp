@@ -0,0 +1,54 @@
+#include "benchmarks.h"
+#include <stdio.h>
+#include <string.h>
+#include <wx/init.h>
+#include <wx/log.h>
+
+namespace
+{
+struct Benchmark {
+    const char* name;
+    const char* usage;
+    BenchmarkFunc_t func;
+};
+
+const Benchmark benchmarks[] = {
+    { "tags-storage", "[num_tags] [iterations]", benchmark_tags_storage },
+    { "regex", "[num_lines]", benchmark_regex },
+    { "json", "[num_entries]", benchmark_json },
+};
+
+void print_usage(const char* argv0)
+{
+    printf("Usage: %s <benchmark> [args]\n", argv0);
+    printf("Available benchmarks:\n");
+    for(const Benchmark& b : benchmarks) {
+        printf("  %s %s\n", b.name, b.usage);
+    }
+}
+} // namespace
+
+void benchmark_report(const wxString& name, size_t iterations, long elapsedMs)
+{
+    double perIter = iterations ? (elapsedMs * 1000.0) / iterations : 0.0;
+    printf("%-40s %8lu iterations in %6ldms (%.2f us/iter)\n", name.mb_str(wxConvUTF8).data(),
+           (unsigned long)iterations, elapsedMs, perIter);
+}
+
+int main(int argc, char** argv)
+{
+    wxInitializer initializer(argc, argv);
+    wxLogNull NOLOG;
+
+    if(argc < 2) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    for(const Benchmark& b : benchmarks) {
+        if(strcmp(argv[1], b.name) == 0) { return b.func(argc - 2, argv + 2); }
+    }
+
+    print_usage(argv[0]);
+    return 1;
+}
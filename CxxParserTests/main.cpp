@@ -1,12 +1,29 @@
+#include "CxxPreProcessor.h"
+#include "CxxPreProcessorScannerCache.h"
+#include "CxxScannerTokens.h"
 #include "CxxTokenizer.h"
 #include "CxxVariableScanner.h"
+#include "JSONStreamReader.h"
+#include "LSP/CompletionRequest.h"
+#include "LSP/DidChangeTextDocumentRequest.h"
+#include "LSP/GotoDefinitionRequest.h"
+#include "LSP/clJSONRPC.h"
+#include "LanguageServerProtocol.h"
+#include "OutputViewBuffer.h"
+#include "clRegexEngine.h"
+#include "clWorkspaceSnapshot.h"
 #include "ctags_manager.h"
 #include "fileutils.h"
+#include "search_thread.h"
+#include "tags_storage_sqlite3.h"
 #include "tester.h"
+#include <algorithm>
 #include <iostream>
 #include <stdio.h>
+#include <wx/ffile.h>
 #include <wx/init.h>
 #include <wx/log.h>
+#include <wx/stc/stc.h>
 
 TEST_FUNC(test_cxx_normalize_signature)
 {
@@ -188,6 +205,1313 @@ TEST_FUNC(test_local_in_std_for_each)
     return true;
 }
 
+static TagEntryPtrVector_t MakeCacheTags(const wxString& name, const wxString& file, size_t count)
+{
+    TagEntryPtrVector_t tags;
+    for(size_t i = 0; i < count; ++i) {
+        TagEntryPtr tag(new TagEntry());
+        tag->SetName(name);
+        tag->SetFile(file);
+        tags.push_back(tag);
+    }
+    return tags;
+}
+
+TEST_FUNC(test_tags_cache_hit_and_miss)
+{
+    TagsStorageSQLiteCache cache;
+    cache.Store("select foo", MakeCacheTags("foo", "/a.h", 2));
+
+    TagEntryPtrVector_t tags;
+    CHECK_BOOL(cache.Get("select foo", tags));
+    CHECK_SIZE(tags.size(), 2);
+    CHECK_BOOL(!cache.Get("select bar", tags));
+
+    // The kinds are part of the key
+    wxArrayString kinds;
+    kinds.Add("class");
+    CHECK_BOOL(!cache.Get("select foo", kinds, tags));
+    cache.Store("select foo", kinds, MakeCacheTags("foo", "/a.h", 1));
+    tags.clear();
+    CHECK_BOOL(cache.Get("select foo", kinds, tags));
+    CHECK_SIZE(tags.size(), 1);
+    CHECK_SIZE(cache.GetStats().hits, 2);
+    CHECK_SIZE(cache.GetStats().misses, 2);
+    CHECK_SIZE(cache.GetStats().entries, 2);
+    return true;
+}
+
+TEST_FUNC(test_tags_cache_evicts_least_recently_used)
+{
+    TagsStorageSQLiteCache cache;
+    cache.Store("q1", MakeCacheTags("one", "/a.h", 10));
+    size_t entryBytes = cache.GetStats().bytes;
+    cache.Store("q2", MakeCacheTags("two", "/a.h", 10));
+    cache.Store("q3", MakeCacheTags("six", "/a.h", 10));
+
+    // Room for two entries only: "q1" is used last, so "q2" is the one evicted
+    TagEntryPtrVector_t tags;
+    CHECK_BOOL(cache.Get("q1", tags));
+    cache.SetMaxSize(entryBytes * 2 + entryBytes / 2);
+    CHECK_SIZE(cache.GetStats().entries, 2);
+    CHECK_SIZE(cache.GetStats().evictions, 1);
+    CHECK_BOOL(cache.Get("q1", tags));
+    CHECK_BOOL(!cache.Get("q2", tags));
+    CHECK_BOOL(cache.Get("q3", tags));
+
+    // Storing a new entry evicts the least recently used one ("q1")
+    cache.Store("q4", MakeCacheTags("ten", "/a.h", 10));
+    CHECK_SIZE(cache.GetStats().entries, 2);
+    CHECK_BOOL(!cache.Get("q1", tags));
+    CHECK_BOOL(cache.Get("q3", tags));
+    CHECK_BOOL(cache.Get("q4", tags));
+    CHECK_BOOL(cache.GetStats().bytes <= cache.GetMaxSize());
+
+    // An entry larger than the whole cache is not kept
+    cache.Store("q5", MakeCacheTags("big", "/a.h", 100));
+    CHECK_BOOL(!cache.Get("q5", tags));
+    CHECK_BOOL(cache.Get("q4", tags));
+    return true;
+}
+
+TEST_FUNC(test_tags_cache_clear_file)
+{
+    TagsStorageSQLiteCache cache;
+    TagEntryPtrVector_t mixed = MakeCacheTags("foo", "/a.h", 1);
+    TagEntryPtrVector_t other = MakeCacheTags("foo", "/b.h", 1);
+    mixed.insert(mixed.end(), other.begin(), other.end());
+
+    cache.Store("only_a", MakeCacheTags("foo", "/a.h", 3));
+    cache.Store("only_b", MakeCacheTags("bar", "/b.h", 3));
+    cache.Store("a_and_b", mixed);
+    cache.Store("nothing", TagEntryPtrVector_t());
+
+    // Dropping "/a.h" also drops the empty results: they may now match tags of the modified file
+    cache.ClearFile("/a.h");
+    TagEntryPtrVector_t tags;
+    CHECK_BOOL(!cache.Get("only_a", tags));
+    CHECK_BOOL(!cache.Get("a_and_b", tags));
+    CHECK_BOOL(!cache.Get("nothing", tags));
+    CHECK_BOOL(cache.Get("only_b", tags));
+    CHECK_SIZE(cache.GetStats().invalidations, 3);
+    CHECK_SIZE(cache.GetStats().entries, 1);
+
+    cache.ClearFile("/b.h");
+    CHECK_SIZE(cache.GetStats().entries, 0);
+    CHECK_SIZE(cache.GetStats().bytes, 0);
+
+    // The file index must not keep stale keys after an entry is replaced
+    cache.Store("replaced", MakeCacheTags("foo", "/a.h", 1));
+    cache.Store("replaced", MakeCacheTags("foo", "/b.h", 1));
+    cache.ClearFile("/a.h");
+    CHECK_BOOL(cache.Get("replaced", tags));
+    cache.Clear();
+    CHECK_SIZE(cache.GetStats().entries, 0);
+    CHECK_BOOL(!cache.Get("replaced", tags));
+    return true;
+}
+
+// Return all the matches of 'pattern' in 'text' as "start:length" pairs, the way Find in Files iterates them
+static wxString CollectRegexMatches(clRegexEngine::eType type, const wxString& pattern, const wxString& text,
+                                    bool matchCase = true)
+{
+    clRegexEngine::Ptr_t re = clRegexEngine::New(type);
+    if(!re->Compile(pattern, matchCase)) { return "invalid"; }
+    wxString matches;
+    size_t from = 0, start = 0, len = 0;
+    while(from <= text.length() && re->Find(text, from, start, len)) {
+        matches << start << ":" << len << " ";
+        from = start + (len ? len : 1);
+    }
+    return matches;
+}
+
+TEST_FUNC(test_regex_leftmost_longest)
+{
+    // pattern, text, first match
+    const char* cases[][3] = {
+        { "a|ab", "xabc", "1:2" },
+        { "(a|aa)*b", "xaaab", "1:4" },
+        { "foo|foobar", "foobar", "0:6" },
+        { "x*?", "yyx", "0:0" },
+        { "a.*?b", "zaxbxb", "1:3" },
+        { "[0-9]+?", "ab123", "2:1" },
+        { "\\yint\\y", "print int", "6:3" },
+        { "\\mfoo", "barfoo foo", "7:3" },
+        { "foo\\M", "foobar foo", "7:3" },
+        { "\\x41", "xA", "1:1" },
+        { "\\u0041", "xA", "1:1" },
+        { "b{2,3}", "abbbbb", "1:3" },
+        { "^bar", "foo bar\nbar", "8:3" },
+        { "foo$", "foo bar\nfoo", "8:3" },
+        { "[[:digit:]]+", "x42", "1:2" },
+    };
+    for(size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        wxString linear = CollectRegexMatches(clRegexEngine::kLinear, cases[i][0], cases[i][1]).BeforeFirst(' ');
+        wxString wxre = CollectRegexMatches(clRegexEngine::kWxRegEx, cases[i][0], cases[i][1]).BeforeFirst(' ');
+        CHECK_WXSTRING(linear, cases[i][2]);
+        CHECK_WXSTRING(wxre, cases[i][2]);
+    }
+
+    // wxRegEx reads as many hexadecimal digits as there are
+    CHECK_WXSTRING(CollectRegexMatches(clRegexEngine::kLinear, "\\x000041", "xA"), "1:1 ");
+    return true;
+}
+
+TEST_FUNC(test_regex_engines_agree)
+{
+    // pattern, text. The texts have no word character before a match that starts with '\y': wxRegEx does not
+    // see the text before the position it resumes from
+    const char* cases[][2] = {
+        { "a|ab", "xabc ab a" },
+        { "(a|aa)*b", "aaab ab b" },
+        { "foo|foobar", "foobar foo\nfoob" },
+        { "[0-9]+?", "ab123 4" },
+        { "a.*?b", "zaxbxb\naab" },
+        { "\\yint\\y", "print int\nint" },
+        { "foo\\M", "foobar foo" },
+        { "b{2,3}", "abbbbb" },
+        { "^bar", "foo bar\nbar\nbar" },
+        { "foo$", "foo bar\nfoo\nfoo" },
+        { "[[:digit:]]+", "x42 7" },
+        { "(\\w+ ?)*;", "int a ;\nb;" },
+        { "m_[a-z]+", "m_foo m_ m_bar" },
+        { "Get[A-Z][a-zA-Z]*", "GetFoo() + GetBar\nGetx" },
+        { "0x[0-9A-Fa-f]+", "0x1F, 0xg, 0XAB 0xab" },
+        { "[^ ]+", "one two\nthree" },
+    };
+    for(size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        for(int matchCase = 0; matchCase < 2; ++matchCase) {
+            wxString linear = CollectRegexMatches(clRegexEngine::kLinear, cases[i][0], cases[i][1], matchCase);
+            wxString wxre = CollectRegexMatches(clRegexEngine::kWxRegEx, cases[i][0], cases[i][1], matchCase);
+            CHECK_BOOL(linear != "invalid");
+            CHECK_WXSTRING(linear, wxre);
+        }
+    }
+    return true;
+}
+
+TEST_FUNC(test_regex_engine_fallback)
+{
+    // Supported by the linear engine
+    CHECK_BOOL(clRegexEngine::New("a|ab", true)->GetType() == clRegexEngine::kLinear);
+    CHECK_BOOL(clRegexEngine::New("a.*?b", true)->GetType() == clRegexEngine::kLinear);
+    CHECK_BOOL(clRegexEngine::New("\\x000041", true)->GetType() == clRegexEngine::kLinear);
+
+    // Back references, lazy quantifiers mixed with greedy ones or with an alternation
+    CHECK_BOOL(clRegexEngine::New("(a)\\1", true)->GetType() == clRegexEngine::kWxRegEx);
+    CHECK_BOOL(clRegexEngine::New("a+?b*", true)->GetType() == clRegexEngine::kWxRegEx);
+    CHECK_BOOL(clRegexEngine::New("a+?|b", true)->GetType() == clRegexEngine::kWxRegEx);
+
+    // Invalid patterns are reported by wxRegEx
+    CHECK_BOOL(!clRegexEngine::New(clRegexEngine::kLinear)->Compile("a**", true));
+    CHECK_BOOL(!clRegexEngine::New(clRegexEngine::kLinear)->Compile("a{2", true));
+    CHECK_BOOL(!clRegexEngine::New(clRegexEngine::kLinear)->Compile("(a", true));
+    CHECK_BOOL(!clRegexEngine::New("a{2", true)->IsValid());
+    return true;
+}
+
+TEST_FUNC(test_regex_required_literal)
+{
+    // pattern, the literal (lower case) that every match contains
+    const char* cases[][2] = {
+        { "undefined reference to", "undefined reference to" },
+        { "^([^:]+):([0-9]+): ERROR", ": error" },
+        { "^([^:]+):([0-9]+):([0-9]+): (fatal )?error", "error" },
+        { "\\.cpp:", ".cpp:" },
+        { "\\d+: note", ": note" },
+        { "[[:alpha:]]+ fatal", " fatal" },
+        { "[]x]+abc", "abc" },
+        { "x(abcdef)y", "abcdef" },
+        { "ab(cd(efgh))", "efgh" },
+        // The optional atoms are not part of the literal
+        { "abc?def", "def" },
+        { "ab*", "a" },
+        { "a{0,2}bc", "bc" },
+        { "ab{2}cd", "ab" },
+        { "x(abcdef)?y", "x" },
+        { "x(abcdef)*y", "x" },
+        { "x(abcdef){0,1}y", "x" },
+        // Nothing is required
+        { "(error|warning)", "" },
+        { "x(abc|abd)y", "x" },
+        { "[0-9]+", "" },
+        { "(?:error)", "" },
+        { "***=error", "" },
+        { "a|b", "" },
+        { "abc)", "" },
+        { "(abc", "" },
+        { "[abc", "" },
+    };
+    for(size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        CHECK_WXSTRING(clRegexEngine::GetRequiredLiteral(cases[i][0]), cases[i][1]);
+    }
+    return true;
+}
+
+static std::string MakeJSONRPCMessage(const std::string& payload)
+{
+    return "Content-Length: " + std::to_string(payload.length()) + "\r\n\r\n" + payload;
+}
+
+TEST_FUNC(test_jsonrpc_framer_split_headers)
+{
+    // The message arrives one byte at a time: the headers separator is split between reads
+    std::string payload = "{\"jsonrpc\":\"2.0\",\"id\":1}";
+    std::string message = MakeJSONRPCMessage(payload);
+    clJSONRPCFramer framer;
+    std::string out;
+    for(size_t i = 0; i + 1 < message.length(); ++i) {
+        framer.Append(message.c_str() + i, 1);
+        CHECK_BOOL(!framer.Next(out));
+    }
+    framer.Append(message.c_str() + message.length() - 1, 1);
+    CHECK_BOOL(framer.Next(out));
+    CHECK_BOOL(out == payload);
+    CHECK_BOOL(!framer.Next(out));
+    CHECK_SIZE(framer.GetPendingBytes(), 0);
+
+    // Other headers, in any case and order
+    framer.Append("Content-Type: application/vscode-jsonrpc; charset=utf-8\r\ncontent-length:  2\r\n\r\n{}");
+    CHECK_BOOL(framer.Next(out));
+    CHECK_BOOL(out == "{}");
+    return true;
+}
+
+TEST_FUNC(test_jsonrpc_framer_multibyte_payload)
+{
+    // Content-Length counts bytes: "\xC3\xA9" is a single character (e with an acute accent)
+    std::string payload = "{\"text\":\"caf\xC3\xA9 \xE2\x82\xAC\"}";
+    std::string message = MakeJSONRPCMessage(payload);
+
+    // Split the message in the middle of the euro sign
+    size_t split = message.find("\xE2") + 1;
+    clJSONRPCFramer framer;
+    std::string out;
+    framer.Append(message.substr(0, split));
+    CHECK_BOOL(!framer.Next(out));
+    framer.Append(message.substr(split));
+    CHECK_BOOL(framer.Next(out));
+    CHECK_BOOL(out == payload);
+    CHECK_SIZE(out.length(), payload.length());
+    return true;
+}
+
+TEST_FUNC(test_jsonrpc_framer_many_messages_per_read)
+{
+    std::string first = "{\"id\":1}";
+    std::string second = "{\"id\":2,\"result\":[]}";
+    std::string third = "{\"id\":3}";
+    std::string partial = MakeJSONRPCMessage("{\"id\":4}").substr(0, 25);
+
+    // A message without a Content-Length header is skipped
+    clJSONRPCFramer framer;
+    framer.Append(MakeJSONRPCMessage(first) + MakeJSONRPCMessage(second) + "Content-Type: x\r\n\r\n" +
+                  MakeJSONRPCMessage(third) + partial);
+
+    std::string out;
+    CHECK_BOOL(framer.Next(out));
+    CHECK_BOOL(out == first);
+    CHECK_BOOL(framer.Next(out));
+    CHECK_BOOL(out == second);
+    CHECK_BOOL(framer.Next(out));
+    CHECK_BOOL(out == third);
+    CHECK_BOOL(!framer.Next(out));
+    CHECK_SIZE(framer.GetPendingBytes(), partial.length());
+
+    // The rest of the partial message completes it
+    framer.Append(MakeJSONRPCMessage("{\"id\":4}").substr(25));
+    CHECK_BOOL(framer.Next(out));
+    CHECK_BOOL(out == "{\"id\":4}");
+
+    framer.Append(partial);
+    framer.Clear();
+    CHECK_SIZE(framer.GetPendingBytes(), 0);
+    framer.Append(MakeJSONRPCMessage(first));
+    CHECK_BOOL(framer.Next(out));
+    CHECK_BOOL(out == first);
+    return true;
+}
+
+/// Log the events of a JSON document, e.g. '{ k:name s:value ] }'
+class JSONEventsLogger : public JSONStreamReader::Handler
+{
+public:
+    std::string log;
+    std::string stopAt; // stop reading when a string with this value is found
+
+    virtual bool OnStartObject() { return Log("{"); }
+    virtual bool OnEndObject() { return Log("}"); }
+    virtual bool OnStartArray() { return Log("["); }
+    virtual bool OnEndArray() { return Log("]"); }
+    virtual bool OnKey(const std::string& key) { return Log("k:" + key); }
+    virtual bool OnString(const std::string& value)
+    {
+        Log("s:" + value);
+        return value != stopAt;
+    }
+    virtual bool OnNumber(double value) { return Log("n:" + std::to_string((long)value)); }
+    virtual bool OnBool(bool value) { return Log(value ? "true" : "false"); }
+    virtual bool OnNull() { return Log("null"); }
+
+    bool Log(const std::string& event)
+    {
+        if(!log.empty()) { log += " "; }
+        log += event;
+        return true;
+    }
+};
+
+static bool ParseJSON(const std::string& json, JSONEventsLogger& logger, wxString* error = nullptr)
+{
+    JSONStreamReader reader(&logger);
+    bool res = reader.Parse(json.c_str(), json.length());
+    if(error) { *error = reader.GetError(); }
+    return res;
+}
+
+static std::string ParseJSONString(const std::string& json)
+{
+    JSONEventsLogger logger;
+    if(!ParseJSON(json, logger)) { return "<error>"; }
+    return logger.log;
+}
+
+TEST_FUNC(test_json_stream_reader_events)
+{
+    JSONEventsLogger logger;
+    CHECK_BOOL(ParseJSON("\xEF\xBB\xBF {\"a\" : [1, -2.5e1, true, false, null], \"b\":{}, \"c\":\"x\"}\n", logger));
+    CHECK_BOOL(logger.log == "{ k:a [ n:1 n:-25 true false null ] k:b { } k:c s:x }");
+    return true;
+}
+
+TEST_FUNC(test_json_stream_reader_escapes)
+{
+    CHECK_BOOL(ParseJSONString("\"a\\\"b\\\\c\\/d\"") == "s:a\"b\\c/d");
+    CHECK_BOOL(ParseJSONString("\"\\b\\f\\n\\r\\t\"") == "s:\b\f\n\r\t");
+    CHECK_BOOL(ParseJSONString("\"\\u0041\\u00e9\\u20AC\"") == "s:A\xC3\xA9\xE2\x82\xAC");
+    // Raw UTF-8 is kept as it is
+    CHECK_BOOL(ParseJSONString("\"caf\xC3\xA9\"") == "s:caf\xC3\xA9");
+    return true;
+}
+
+TEST_FUNC(test_json_stream_reader_surrogates)
+{
+    // U+1F600, encoded as a surrogate pair
+    CHECK_BOOL(ParseJSONString("\"\\ud83d\\ude00\"") == "s:\xF0\x9F\x98\x80");
+    // Lone surrogates are replaced with U+FFFD
+    CHECK_BOOL(ParseJSONString("\"\\ud83dx\"") == "s:\xEF\xBF\xBDx");
+    CHECK_BOOL(ParseJSONString("\"\\ude00\"") == "s:\xEF\xBF\xBD");
+    CHECK_BOOL(ParseJSONString("\"\\ud83d\\u0041\"") == "s:\xEF\xBF\xBD" "A");
+    return true;
+}
+
+TEST_FUNC(test_json_stream_reader_errors)
+{
+    const char* invalid[] = { "", "{\"a\":}", "{\"a\" 1}", "{a:1}", "[1,2", "[1 2]", "\"abc",
+        "\"\\q\"", "\"\\u12\"", "tru", "-", "1.2.3", "{} x", "[1,]" };
+    for(size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); ++i) {
+        JSONEventsLogger logger;
+        wxString error;
+        CHECK_BOOL(!ParseJSON(invalid[i], logger, &error));
+        CHECK_BOOL(error.Contains("at offset"));
+    }
+
+    // The offset of the error is reported
+    JSONEventsLogger logger;
+    wxString error;
+    CHECK_BOOL(!ParseJSON("[1, 2, x]", logger, &error));
+    CHECK_BOOL(error.EndsWith("at offset 7"));
+
+    // A handler stopping the reading is not an error
+    JSONEventsLogger stopper;
+    stopper.stopAt = "stop";
+    JSONStreamReader reader(&stopper);
+    std::string json = "[\"a\", \"stop\", \"b\"]";
+    CHECK_BOOL(!reader.Parse(json.c_str(), json.length()));
+    CHECK_BOOL(reader.IsStopped());
+    CHECK_BOOL(reader.GetError().IsEmpty());
+    CHECK_BOOL(stopper.log == "[ s:a s:stop");
+    return true;
+}
+
+static std::string GetOutputViewData(const OutputViewLines& lines)
+{
+    return std::string(lines.GetData(), lines.GetDataLength());
+}
+
+TEST_FUNC(test_output_view_lines_sequence)
+{
+    OutputViewLines lines;
+    CHECK_SIZE(lines.Add("a\n", 2, 0), 0);
+    CHECK_SIZE(lines.Add("bb\n", 3, 1), 1);
+    CHECK_SIZE(lines.GetFirstSequence(), 0);
+    CHECK_BOOL(GetOutputViewData(lines) == "a\nbb\n");
+
+    // The dropped lines keep their sequence numbers
+    lines.DropFirst();
+    CHECK_SIZE(lines.GetCount(), 1);
+    CHECK_SIZE(lines.GetFirstSequence(), 1);
+    CHECK_BOOL(GetOutputViewData(lines) == "bb\n");
+    CHECK_SIZE(lines.GetSpans().front().style, 1);
+    CHECK_SIZE(lines.Add("c\n", 2, 0), 2);
+
+    // So do the lines that were written to the view
+    lines.Clear();
+    CHECK_BOOL(lines.IsEmpty());
+    CHECK_SIZE(lines.GetFirstSequence(), 3);
+    CHECK_BOOL(GetOutputViewData(lines).empty());
+    CHECK_SIZE(lines.Add("d\n", 2, 0), 3);
+    CHECK_SIZE(lines.GetFirstSequence(), 3);
+    return true;
+}
+
+TEST_FUNC(test_output_view_lines_compact)
+{
+    // Drop enough lines for the buffer to be compacted: the spans still point to the right lines
+    OutputViewLines lines;
+    std::string expected;
+    for(size_t i = 0; i < 3000; ++i) {
+        std::string line = std::to_string(i) + std::string(1000, 'x') + "\n";
+        lines.Add(line.c_str(), line.length(), (int)(i % 4));
+        if(i >= 2000) { expected += line; }
+    }
+    for(size_t i = 0; i < 2000; ++i) {
+        lines.DropFirst();
+    }
+    CHECK_SIZE(lines.GetCount(), 1000);
+    CHECK_SIZE(lines.GetFirstSequence(), 2000);
+    CHECK_BOOL(GetOutputViewData(lines) == expected);
+
+    std::string data = GetOutputViewData(lines);
+    size_t offset = 0;
+    for(size_t i = 0; i < lines.GetCount(); ++i) {
+        const OutputViewLines::Span& span = lines.GetSpans()[i];
+        CHECK_SIZE(span.style, (2000 + i) % 4);
+        CHECK_BOOL(data.compare(offset, span.length, std::to_string(2000 + i) + std::string(1000, 'x') + "\n") == 0);
+        offset += span.length;
+    }
+    return true;
+}
+
+TEST_FUNC(test_output_view_flush_renumbering)
+{
+    // Lines 10 to 12 were written after the 4 lines of the view, then the view was capped to 5 lines
+    OutputViewBuffer::FlushInfo info;
+    info.firstSequence = 10;
+    info.linesRemoved = 2;
+    info.firstLine = 4 - info.linesRemoved;
+    CHECK_SIZE(info.GetLine(9), wxNOT_FOUND); // dropped before it reached the view
+    CHECK_SIZE(info.GetLine(10), 2);
+    CHECK_SIZE(info.GetLine(12), 4);
+    CHECK_SIZE(info.GetMovedLine(0), wxNOT_FOUND);
+    CHECK_SIZE(info.GetMovedLine(1), wxNOT_FOUND);
+    CHECK_SIZE(info.GetMovedLine(2), 0);
+    CHECK_SIZE(info.GetMovedLine(3), 1);
+
+    // More lines were written than the view keeps: the first ones were removed right away
+    info.firstSequence = 20;
+    info.linesRemoved = 8;
+    info.firstLine = 5 - info.linesRemoved;
+    CHECK_SIZE(info.GetLine(20), wxNOT_FOUND);
+    CHECK_SIZE(info.GetLine(22), wxNOT_FOUND);
+    CHECK_SIZE(info.GetLine(23), 0);
+    CHECK_SIZE(info.GetLine(27), 4);
+    CHECK_SIZE(info.GetMovedLine(4), wxNOT_FOUND);
+
+    // Nothing was removed
+    info.firstSequence = 30;
+    info.linesRemoved = 0;
+    info.firstLine = 0;
+    CHECK_SIZE(info.GetLine(30), 0);
+    CHECK_SIZE(info.GetMovedLine(0), 0);
+    return true;
+}
+
+static bool IsValidUTF8(const std::string& text) { return FileUtils::IsValidUTF8(text.c_str(), text.length()); }
+
+TEST_FUNC(test_is_valid_utf8)
+{
+    CHECK_BOOL(IsValidUTF8(""));
+    CHECK_BOOL(IsValidUTF8("int main() {}\n"));
+    CHECK_BOOL(IsValidUTF8("caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80"));
+    CHECK_BOOL(IsValidUTF8("\xC2\x80\xDF\xBF\xE0\xA0\x80\xED\x9F\xBF\xEE\x80\x80\xF0\x90\x80\x80\xF4\x8F\xBF\xBF"));
+    CHECK_BOOL(IsValidUTF8(std::string("a\0b", 3)));
+
+    // Overlong forms
+    CHECK_BOOL(!IsValidUTF8("\xC0\xAF"));
+    CHECK_BOOL(!IsValidUTF8("\xC1\xBF"));
+    CHECK_BOOL(!IsValidUTF8("\xE0\x80\xAF"));
+    CHECK_BOOL(!IsValidUTF8("\xE0\x9F\xBF"));
+    CHECK_BOOL(!IsValidUTF8("\xF0\x80\x80\xAF"));
+    CHECK_BOOL(!IsValidUTF8("\xF0\x8F\xBF\xBF"));
+
+    // Surrogates (CESU-8), code points above U+10FFFF and bytes that never appear in UTF-8
+    CHECK_BOOL(!IsValidUTF8("\xED\xA0\x80"));
+    CHECK_BOOL(!IsValidUTF8("\xED\xBF\xBF"));
+    CHECK_BOOL(!IsValidUTF8("\xED\xA0\xBD\xED\xB8\x80"));
+    CHECK_BOOL(!IsValidUTF8("\xF4\x90\x80\x80"));
+    CHECK_BOOL(!IsValidUTF8("\xF5\x80\x80\x80"));
+    CHECK_BOOL(!IsValidUTF8("\xFF"));
+
+    // Missing or unexpected continuation bytes, e.g. Latin-1 text
+    CHECK_BOOL(!IsValidUTF8("caf\xE9"));
+    CHECK_BOOL(!IsValidUTF8("caf\xE9 au lait"));
+    CHECK_BOOL(!IsValidUTF8("\x80"));
+    CHECK_BOOL(!IsValidUTF8("\xC3\xA9\xA9"));
+    CHECK_BOOL(!IsValidUTF8("\xE2\x82" "a"));
+
+    // A buffer that starts or ends in the middle of a sequence is rejected
+    std::string text = "a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80";
+    for(size_t len = 0; len <= text.length(); ++len) {
+        bool boundary = (len == 0 || len == 1 || len == 3 || len == 6 || len == 10);
+        CHECK_BOOL(FileUtils::IsValidUTF8(text.c_str(), len) == boundary);
+        CHECK_BOOL(FileUtils::IsValidUTF8(text.c_str() + len, text.length() - len) == boundary);
+    }
+    return true;
+}
+
+/// Return the path of a file in the tests temporary folder
+static wxFileName GetTestTempFile(const wxString& name)
+{
+    wxFileName fn(wxFileName::GetTempDir(), name);
+    fn.AppendDir("codelite-cxx-parser-tests");
+    fn.Mkdir(wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+    return fn;
+}
+
+static bool ReadBinaryFile(const wxFileName& fn, std::string& content)
+{
+    wxFFile fp(fn.GetFullPath(), "rb");
+    if(!fp.IsOpened()) { return false; }
+    content.resize(fp.Length());
+    return content.empty() || fp.Read(&content[0], content.length()) == content.length();
+}
+
+static bool WriteBinaryFile(const wxFileName& fn, const std::string& content)
+{
+    wxFFile fp(fn.GetFullPath(), "wb");
+    return fp.IsOpened() && fp.Write(content.c_str(), content.length()) == content.length();
+}
+
+static wxFileName WritePPTestFiles()
+{
+    wxFileName header = GetTestTempFile("pp_cache_header.h");
+    FileUtils::WriteFileContent(header, "#ifndef PP_CACHE_HEADER_H\n"
+                                        "#define PP_CACHE_HEADER_H\n"
+                                        "#ifdef USE_FAST\n"
+                                        "#define SPEED 10\n"
+                                        "#else\n"
+                                        "#define SPEED 1\n"
+                                        "#endif\n"
+                                        "#if SPEED > 5\n"
+                                        "#define FAST_ENABLED 1\n"
+                                        "#endif\n"
+                                        "#define NAME \"header\"\n"
+                                        "#define FUNC(x) ((x) + 1)\n"
+                                        "int not_a_macro = 0;\n"
+                                        "#endif\n");
+    wxFileName source = GetTestTempFile("pp_cache_source.h");
+    FileUtils::WriteFileContent(source, "#include \"pp_cache_header.h\"\n"
+                                        "#define SOURCE_MACRO 2\n");
+    return source;
+}
+
+static wxArrayString PreProcess(const wxFileName& fn, const wxString& definition = "")
+{
+    CxxPreProcessor pp;
+    if(!definition.IsEmpty()) { pp.AddDefinition(definition); }
+    pp.Parse(fn, kLexerOpt_CollectMacroValueNumbers);
+    wxArrayString definitions = pp.GetDefinitions();
+    definitions.Sort();
+    return definitions;
+}
+
+TEST_FUNC(test_pp_cache_replay)
+{
+    CxxPreProcessorScannerCache& cache = CxxPreProcessorScannerCache::Get();
+    wxFileName source = WritePPTestFiles();
+    wxString header = GetTestTempFile("pp_cache_header.h").GetFullPath();
+    const wxString definitions[] = { "", "USE_FAST" };
+    for(const wxString& definition : definitions) {
+        // Lex the files, then replay them from the cache
+        cache.Clear();
+        wxArrayString lexed = PreProcess(source, definition);
+        CHECK_BOOL(cache.Find(header, CxxPreProcessorScannerCache::GetStamp(header)));
+        wxArrayString replayed = PreProcess(source, definition);
+        CHECK_BOOL(lexed == replayed);
+        CHECK_BOOL(lexed.Index("SOURCE_MACRO=2") != wxNOT_FOUND);
+        CHECK_BOOL((lexed.Index("FAST_ENABLED=1") != wxNOT_FOUND) == !definition.IsEmpty());
+    }
+
+    // The tokens recorded without USE_FAST are replayed with it: the branches taken depend on the current macros
+    cache.Clear();
+    wxArrayString lexed = PreProcess(source, "USE_FAST");
+    cache.Clear();
+    PreProcess(source);
+    CHECK_BOOL(PreProcess(source, "USE_FAST") == lexed);
+    cache.Clear();
+    return true;
+}
+
+TEST_FUNC(test_pp_cache_invalidation)
+{
+    CxxPreProcessorScannerCache& cache = CxxPreProcessorScannerCache::Get();
+    cache.Clear();
+    wxFileName source = WritePPTestFiles();
+    wxFileName header = GetTestTempFile("pp_cache_header.h");
+    PreProcess(source);
+
+    CxxPreProcessorScannerCache::Stamp stamp = CxxPreProcessorScannerCache::GetStamp(header.GetFullPath());
+    CHECK_BOOL(stamp.IsOk());
+    CHECK_BOOL(cache.Find(header.GetFullPath(), stamp));
+
+    // Another size or modification time: the entry is dropped
+    CxxPreProcessorScannerCache::Stamp otherSize = stamp;
+    ++otherSize.fileSize;
+    CHECK_BOOL(!cache.Find(header.GetFullPath(), otherSize));
+    CHECK_BOOL(!cache.Find(header.GetFullPath(), stamp));
+
+    PreProcess(source);
+    CHECK_BOOL(cache.Find(header.GetFullPath(), stamp));
+    wxDateTime modified(stamp.lastModified + 10);
+    CHECK_BOOL(header.SetTimes(nullptr, &modified, nullptr));
+    CHECK_BOOL(!cache.Find(header.GetFullPath(), CxxPreProcessorScannerCache::GetStamp(header.GetFullPath())));
+
+    // A modified file is lexed again
+    PreProcess(source);
+    FileUtils::WriteFileContent(header, "#define MODIFIED_HEADER 1\n");
+    wxArrayString definitions = PreProcess(source);
+    CHECK_BOOL(definitions.Index("MODIFIED_HEADER=1") != wxNOT_FOUND);
+    CHECK_BOOL(definitions.Index("SPEED=1") == wxNOT_FOUND);
+
+    // Files that can not be found are not cached
+    CHECK_BOOL(!CxxPreProcessorScannerCache::GetStamp(GetTestTempFile("no_such_file.h").GetFullPath()).IsOk());
+    cache.Clear();
+    return true;
+}
+
+TEST_FUNC(test_pp_cache_save_load)
+{
+    CxxPreProcessorScannerCache& cache = CxxPreProcessorScannerCache::Get();
+    cache.Clear();
+
+    CxxPreProcessorScannerCache::Entry::Ptr_t entry(new CxxPreProcessorScannerCache::Entry());
+    entry->filename = "/usr/include/caf\u00e9.h";
+    entry->stamp.lastModified = 1234567890;
+    entry->stamp.fileSize = 4096;
+    const int types[] = { T_PP_DEFINE, T_PP_IDENTIFIER, T_PP_DEC_NUMBER, T_PP_STATE_EXIT };
+    const char* texts[] = { "#define", "VERSION", "3", "" };
+    for(size_t i = 0; i < sizeof(types) / sizeof(types[0]); ++i) {
+        CxxPreProcessorScannerCache::Token token;
+        token.type = types[i];
+        token.text = texts[i];
+        entry->tokens.push_back(token);
+    }
+    cache.Insert(entry);
+    CHECK_BOOL(cache.IsModified());
+
+    wxFileName cacheFile = GetTestTempFile("pp_cache.bin");
+    CHECK_BOOL(cache.Save(cacheFile));
+    CHECK_BOOL(!cache.IsModified());
+    cache.Clear();
+    CHECK_BOOL(cache.Load(cacheFile));
+    CxxPreProcessorScannerCache::Entry::Ptr_t loaded = cache.Find(entry->filename, entry->stamp);
+    CHECK_BOOL(loaded);
+    CHECK_SIZE(loaded->tokens.size(), entry->tokens.size());
+    for(size_t i = 0; i < entry->tokens.size(); ++i) {
+        CHECK_SIZE(loaded->tokens[i].type, entry->tokens[i].type);
+        CHECK_BOOL(loaded->tokens[i].text == entry->tokens[i].text);
+    }
+
+    // Truncated files, files of another version and files that are not a cache are rejected
+    std::string content;
+    CHECK_BOOL(ReadBinaryFile(cacheFile, content));
+    wxFileName badFile = GetTestTempFile("pp_cache_bad.bin");
+    for(size_t len = 0; len < content.length(); ++len) {
+        CHECK_BOOL(WriteBinaryFile(badFile, content.substr(0, len)));
+        cache.Clear();
+        CHECK_BOOL(!cache.Load(badFile));
+        CHECK_BOOL(!cache.Find(entry->filename, entry->stamp));
+    }
+    std::string otherVersion = content;
+    otherVersion[6] = (char)(otherVersion[6] + 1); // the version follows the "CXXPPC" magic
+    CHECK_BOOL(WriteBinaryFile(badFile, otherVersion));
+    CHECK_BOOL(!cache.Load(badFile));
+    std::string otherMagic = content;
+    otherMagic[0] = 'X';
+    CHECK_BOOL(WriteBinaryFile(badFile, otherMagic));
+    CHECK_BOOL(!cache.Load(badFile));
+    CHECK_BOOL(!cache.Find(entry->filename, entry->stamp));
+    cache.Clear();
+    return true;
+}
+
+/// Store a tag for each of 'names' in 'file'
+static void StoreNamesIndexTestTags(TagsStorageSQLite& db, const wxString& file, const wxArrayString& names)
+{
+    TagEntry root;
+    root.SetName("<ROOT>");
+    TagTreePtr tree(new TagTree("<ROOT>", root));
+    for(size_t i = 0; i < names.size(); ++i) {
+        TagEntry tag;
+        tag.SetName(names.Item(i));
+        tag.SetPath(names.Item(i));
+        tag.SetKind("function");
+        tag.SetFile(file);
+        tag.SetLine(i + 1);
+        tree->AddEntry(tag);
+    }
+    db.Store(tree, wxFileName());
+}
+
+/// The names of the tags found by their part name, sorted and joined with ','
+static wxString FindTagsByPartName(TagsStorageSQLite& db, const wxString& partname)
+{
+    std::vector<TagEntryPtr> tags;
+    db.GetTagsByPartName(partname, tags);
+    wxArrayString names;
+    for(size_t i = 0; i < tags.size(); ++i) {
+        names.Add(tags[i]->GetName());
+    }
+    names.Sort();
+    return ::wxJoin(names, ',');
+}
+
+static int CountRows(TagsStorageSQLite& db, const wxString& table)
+{
+    wxSQLite3ResultSet res = db.Query("select count(*) from " + table);
+    return res.NextRow() ? res.GetInt(0) : -1;
+}
+
+static wxFileName GetNamesIndexTestDatabase()
+{
+    wxFileName dbFile = GetTestTempFile("names_index.db");
+    if(dbFile.FileExists()) { ::wxRemoveFile(dbFile.GetFullPath()); }
+    return dbFile;
+}
+
+TEST_FUNC(test_tags_names_index_search)
+{
+    TagsStorageSQLite db;
+    db.SetUseCache(false);
+    db.OpenDatabase(GetNamesIndexTestDatabase());
+    wxArrayString names = ::wxSplit("OpenFile,openFolder,CloseFile,ab,xy_z,FileOpen,abcdxbcde", ',');
+    StoreNamesIndexTestTags(db, "/names/a.h", names);
+
+    // Searched through the trigrams, ignoring the case
+    CHECK_WXSTRING(FindTagsByPartName(db, "File"), "CloseFile,FileOpen,OpenFile");
+    CHECK_WXSTRING(FindTagsByPartName(db, "FOLD"), "openFolder");
+    CHECK_WXSTRING(FindTagsByPartName(db, "pen"), "FileOpen,OpenFile,openFolder");
+    CHECK_WXSTRING(FindTagsByPartName(db, "eFi"), "CloseFile");
+    CHECK_WXSTRING(FindTagsByPartName(db, "y_z"), "xy_z");
+
+    // All the trigrams match, but not in this order
+    CHECK_WXSTRING(FindTagsByPartName(db, "ABCDE"), "");
+    CHECK_WXSTRING(FindTagsByPartName(db, "BCDE"), "abcdxbcde");
+    CHECK_WXSTRING(FindTagsByPartName(db, "openfileopen"), "");
+    CHECK_WXSTRING(FindTagsByPartName(db, "missing"), "");
+
+    // Shorter than a trigram: the table is scanned
+    CHECK_WXSTRING(FindTagsByPartName(db, "ab"), "ab,abcdxbcde");
+    CHECK_WXSTRING(FindTagsByPartName(db, "X"), "abcdxbcde,xy_z");
+    CHECK_WXSTRING(FindTagsByPartName(db, "_"), "xy_z");
+    CHECK_WXSTRING(FindTagsByPartName(db, "zz"), "");
+    return true;
+}
+
+TEST_FUNC(test_tags_names_index_pruning)
+{
+    TagsStorageSQLite db;
+    db.SetUseCache(false);
+    db.OpenDatabase(GetNamesIndexTestDatabase());
+    StoreNamesIndexTestTags(db, "/names/a.h", ::wxSplit("SharedName,OnlyInA", ','));
+    StoreNamesIndexTestTags(db, "/names/b.h", ::wxSplit("SharedName,ab", ','));
+    CHECK_SIZE(CountRows(db, "TAG_NAMES"), 3);
+    // "sharedname" and "onlyina" have 8 and 5 distinct trigrams, "ab" has none
+    CHECK_SIZE(CountRows(db, "NAME_TRIGRAMS"), 13);
+
+    // The names still used by another file are kept
+    db.DeleteByFileName(wxFileName(), "/names/a.h");
+    CHECK_SIZE(CountRows(db, "TAG_NAMES"), 2);
+    CHECK_SIZE(CountRows(db, "NAME_TRIGRAMS"), 8);
+    CHECK_WXSTRING(FindTagsByPartName(db, "OnlyIn"), "");
+    CHECK_WXSTRING(FindTagsByPartName(db, "Shared"), "SharedName");
+
+    db.DeleteByFileName(wxFileName(), "/names/b.h");
+    CHECK_SIZE(CountRows(db, "TAG_NAMES"), 0);
+    CHECK_SIZE(CountRows(db, "NAME_TRIGRAMS"), 0);
+    CHECK_WXSTRING(FindTagsByPartName(db, "Shared"), "");
+
+    // A pruned name is indexed again once a tag uses it
+    StoreNamesIndexTestTags(db, "/names/a.h", ::wxSplit("OnlyInA", ','));
+    CHECK_SIZE(CountRows(db, "NAME_TRIGRAMS"), 5);
+    CHECK_WXSTRING(FindTagsByPartName(db, "lyIn"), "OnlyInA");
+    return true;
+}
+
+static LSP::RequestMessage::Ptr_t MakeCompletionRequest(const wxString& file)
+{
+    return LSP::RequestMessage::MakeRequest(
+        new LSP::CompletionRequest(LSP::TextDocumentIdentifier(wxFileName(file)), LSP::Position(1, 1)));
+}
+
+static LSP::RequestMessage::Ptr_t MakeDidChangeRequest(const wxString& file)
+{
+    return LSP::RequestMessage::MakeRequest(
+        new LSP::DidChangeTextDocumentRequest(wxFileName(file), std::vector<LSP::TextDocumentContentChangeEvent>()));
+}
+
+TEST_FUNC(test_lsp_queue_replaces_queued_requests)
+{
+    LSP::RequestMessage::Ptr_t completeA1 = MakeCompletionRequest("/lsp/a.cpp");
+    LSP::RequestMessage::Ptr_t changeA1 = MakeDidChangeRequest("/lsp/a.cpp");
+    LSP::RequestMessage::Ptr_t changeA2 = MakeDidChangeRequest("/lsp/a.cpp");
+    LSP::RequestMessage::Ptr_t completeB = MakeCompletionRequest("/lsp/b.cpp");
+    LSP::RequestMessage::Ptr_t definitionA =
+        LSP::RequestMessage::MakeRequest(new LSP::GotoDefinitionRequest(wxFileName("/lsp/a.cpp"), 1, 1));
+    LSP::RequestMessage::Ptr_t completeA2 = MakeCompletionRequest("/lsp/a.cpp");
+    CHECK_BOOL(completeA1->GetUID() == completeA2->GetUID());
+    CHECK_BOOL(changeA1->GetUID() == changeA2->GetUID());
+
+    LSPRequestMessageQueue queue;
+    queue.Push(completeA1);
+    queue.Push(changeA1);
+    queue.Push(changeA2);
+    queue.Push(completeB);
+    queue.Push(definitionA);
+    queue.Push(completeA2);
+
+    // The completion for "a.cpp" queued first is dropped, the notifications are all kept
+    std::vector<LSP::RequestMessage*> sent;
+    while(!queue.IsEmpty()) {
+        sent.push_back(queue.Get().get());
+        queue.Pop();
+    }
+    CHECK_SIZE(sent.size(), 5);
+    CHECK_BOOL(sent[0] == changeA1.get());
+    CHECK_BOOL(sent[1] == changeA2.get());
+    CHECK_BOOL(sent[2] == completeB.get());
+    CHECK_BOOL(sent[3] == definitionA.get());
+    CHECK_BOOL(sent[4] == completeA2.get());
+    CHECK_BOOL(queue.Get().get() == nullptr);
+    return true;
+}
+
+TEST_FUNC(test_lsp_queue_supersedes_pending_replies)
+{
+    LSP::RequestMessage::Ptr_t completeA1 = MakeCompletionRequest("/lsp/a.cpp");
+    LSP::RequestMessage::Ptr_t completeB = MakeCompletionRequest("/lsp/b.cpp");
+    LSP::RequestMessage::Ptr_t definitionA =
+        LSP::RequestMessage::MakeRequest(new LSP::GotoDefinitionRequest(wxFileName("/lsp/a.cpp"), 1, 1));
+    LSP::RequestMessage::Ptr_t completeA2 = MakeCompletionRequest("/lsp/a.cpp");
+
+    LSPRequestMessageQueue queue;
+    std::vector<int> supersededIds;
+    queue.AddPendingReply(completeA1, supersededIds);
+    queue.AddPendingReply(completeB, supersededIds);
+    queue.AddPendingReply(definitionA, supersededIds);
+    CHECK_SIZE(supersededIds.size(), 0);
+    CHECK_SIZE(queue.GetPendingRepliesCount(), 3);
+
+    // A newer completion for the same file: the reply of the previous one is no longer waited for
+    queue.AddPendingReply(completeA2, supersededIds);
+    CHECK_SIZE(supersededIds.size(), 1);
+    CHECK_BOOL(supersededIds[0] == completeA1->GetId());
+    CHECK_SIZE(queue.GetPendingRepliesCount(), 3);
+    CHECK_BOOL(queue.TakePendingReplyMessage(completeA1->GetId()).get() == nullptr);
+    CHECK_BOOL(queue.TakePendingReplyMessage(completeA2->GetId()).get() == completeA2.get());
+    CHECK_BOOL(queue.TakePendingReplyMessage(completeA2->GetId()).get() == nullptr);
+    CHECK_SIZE(queue.GetPendingRepliesCount(), 2);
+
+    const LSPRequestStats& stats = queue.GetStats().find("textDocument/completion")->second;
+    CHECK_SIZE(stats.cancelled, 1);
+    CHECK_SIZE(stats.replies, 1);
+
+    queue.Clear();
+    CHECK_SIZE(queue.GetPendingRepliesCount(), 0);
+    return true;
+}
+
+/**
+ * A UTF-8 document, modified the way the editor reports it: positions are in bytes and the
+ * "before delete" notification comes while the deleted text is still in the document
+ */
+struct LSPTestDocument {
+    std::string text;
+    LSPDocumentChanges changes;
+
+    LSP::Position GetPosition(int pos) const
+    {
+        int line = std::count(text.begin(), text.begin() + pos, '\n');
+        size_t lineStart = text.find_last_of('\n', pos - 1);
+        lineStart = (pos == 0 || lineStart == std::string::npos) ? 0 : lineStart + 1;
+        wxString prefix = wxString::FromUTF8(text.c_str() + lineStart, pos - lineStart);
+        return LSP::Position(line, LSPDocumentChanges::GetUTF16Length(prefix));
+    }
+
+    void Add(int type, int pos, int length, const std::string& str)
+    {
+        changes.Add(type, pos, length, wxString::FromUTF8(str.c_str()),
+                    [this](int p) { return GetPosition(p); }, true);
+    }
+
+    void Insert(int pos, const std::string& str)
+    {
+        text.insert(pos, str);
+        Add(wxSTC_MOD_INSERTTEXT, pos, str.length(), str);
+    }
+
+    void Delete(int pos, int length)
+    {
+        Add(wxSTC_MOD_BEFOREDELETE, pos, length, "");
+        text.erase(pos, length);
+        Add(wxSTC_MOD_DELETETEXT, pos, length, "");
+    }
+
+    /// The changes as "line:character-line:character=text", one per line
+    wxString Dump() const
+    {
+        wxString dump;
+        for(const LSP::TextDocumentContentChangeEvent& change : changes.GetChanges()) {
+            const LSP::Range& range = change.GetRange();
+            dump << range.GetStart().GetLine() << ":" << range.GetStart().GetCharacter() << "-"
+                 << range.GetEnd().GetLine() << ":" << range.GetEnd().GetCharacter() << "=" << change.GetText()
+                 << "\n";
+        }
+        return dump;
+    }
+};
+
+TEST_FUNC(test_lsp_document_changes_ranges)
+{
+    LSPTestDocument doc;
+    doc.text = "int main()\n{\n}\n";
+
+    // Typing is merged into a single insertion
+    doc.Insert(12, "r");
+    doc.Insert(13, "e");
+    doc.Insert(14, "t");
+    CHECK_WXSTRING(doc.Dump(), "1:1-1:1=ret\n");
+
+    // Deleted text: its range is taken before it is removed, typing after it starts a new change
+    doc.Insert(0, "x");
+    doc.Delete(1, 4);
+    doc.Insert(1, "y");
+    doc.Insert(2, "z");
+    CHECK_WXSTRING(doc.Dump(), "1:1-1:1=ret\n0:0-0:0=x\n0:1-0:5=\n0:1-0:1=yz\n");
+    CHECK_BOOL(doc.text == "xyzmain()\n{ret\n}\n");
+
+    // A deletion spanning lines
+    doc.Delete(9, 5);
+    CHECK_WXSTRING(doc.Dump(), "1:1-1:1=ret\n0:0-0:0=x\n0:1-0:5=\n0:1-0:1=yz\n0:9-1:4=\n");
+    CHECK_BOOL(doc.text == "xyzmain()\n}\n");
+    CHECK_BOOL(doc.changes.IsModified());
+    CHECK_BOOL(!doc.changes.IsFullSync());
+    CHECK_SIZE(doc.changes.GetChanges().size(), 5);
+
+    doc.changes.Clear();
+    CHECK_BOOL(!doc.changes.IsModified());
+    CHECK_SIZE(doc.changes.GetChanges().size(), 0);
+
+    // Other modifications are ignored
+    doc.Add(wxSTC_MOD_CHANGESTYLE, 0, 1, "");
+    CHECK_BOOL(!doc.changes.IsModified());
+
+    // Without incremental sync, only the modification is recorded
+    doc.changes.Add(wxSTC_MOD_INSERTTEXT, 0, 1, "a", [&](int p) { return doc.GetPosition(p); }, false);
+    CHECK_BOOL(doc.changes.IsModified());
+    CHECK_SIZE(doc.changes.GetChanges().size(), 0);
+    return true;
+}
+
+TEST_FUNC(test_lsp_document_changes_full_sync)
+{
+    LSPTestDocument doc;
+    doc.text = "abc\n";
+    doc.Insert(3, "d");
+
+    // A deletion without its "before delete" notification can not be tracked: the whole text is sent
+    doc.text.erase(0, 1);
+    doc.Add(wxSTC_MOD_DELETETEXT, 0, 1, "");
+    CHECK_BOOL(doc.changes.IsModified());
+    CHECK_BOOL(doc.changes.IsFullSync());
+    CHECK_SIZE(doc.changes.GetChanges().size(), 0);
+    doc.Insert(0, "x");
+    CHECK_SIZE(doc.changes.GetChanges().size(), 0);
+
+    doc.changes.Clear();
+    CHECK_BOOL(!doc.changes.IsFullSync());
+    doc.Insert(0, "y");
+    CHECK_WXSTRING(doc.Dump(), "0:0-0:0=y\n");
+    return true;
+}
+
+TEST_FUNC(test_lsp_document_changes_utf16_columns)
+{
+    // "\u00e9" is 2 bytes in UTF-8 and 1 UTF-16 code unit, U+1F600 is 4 bytes and 2 UTF-16 code units
+    const std::string eAcute = "\xc3\xa9";
+    const std::string smiley = "\xf0\x9f\x98\x80";
+    CHECK_SIZE(LSPDocumentChanges::GetUTF16Length(wxString::FromUTF8((eAcute + smiley + "x").c_str())), 4);
+
+    LSPTestDocument doc;
+    doc.text = "a\n" + eAcute + smiley + "x\n";
+    doc.Insert(2 + 6, "!");
+    doc.Insert(2 + 7, "?");
+    doc.Delete(2 + 2, 4);
+    doc.Insert(2 + 2 + 2, smiley);
+    doc.Insert(2 + 2 + 2 + 4, "y");
+    doc.Insert(2 + 2 + 2 + 4 + 2, "z");
+    CHECK_WXSTRING(doc.Dump(),
+                   "1:3-1:3=!?\n1:1-1:3=\n1:3-1:3=" + wxString::FromUTF8(smiley.c_str()) + "y\n1:7-1:7=z\n");
+    CHECK_BOOL(doc.text == "a\n" + eAcute + "!?" + smiley + "yxz\n");
+    return true;
+}
+
+/// Search 'content' for 'findWhat', the matches as "line:column:len:columnInChars:lenInChars:position", one per line
+static wxString SearchTestFile(const std::string& content, const wxString& findWhat, size_t flags)
+{
+    wxFileName fn = GetTestTempFile("search_test.txt");
+    if(!WriteBinaryFile(fn, content)) { return "write error"; }
+
+    SearchData data;
+    data.SetFindString(findWhat);
+    data.SetMatchCase(flags & wxSD_MATCHCASE);
+    data.SetMatchWholeWord(flags & wxSD_MATCHWHOLEWORD);
+    data.SetEncoding("UTF-8");
+
+    SearchResultList results;
+    if(!SearchThreadST::Get()->SearchFile(fn.GetFullPath(), data, results)) { return "read error"; }
+
+    wxString dump;
+    for(const SearchResult& result : results) {
+        dump << result.GetLineNumber() << ":" << result.GetColumn() << ":" << result.GetLen() << ":"
+             << result.GetColumnInChars() << ":" << result.GetLenInChars() << ":" << result.GetPosition() << "\n";
+    }
+    return dump;
+}
+
+// "\u00e9" and "\u00f1" are 2 bytes in UTF-8, U+1F600 is 4 bytes (and 2 wxString characters where wchar_t is
+// 16 bits)
+#define SEARCH_E_ACUTE "\xc3\xa9"
+#define SEARCH_N_TILDE "\xc3\xb1"
+#define SEARCH_SMILEY "\xf0\x9f\x98\x80"
+#define SEARCH_TEST_FILE SEARCH_E_ACUTE SEARCH_SMILEY " foo;\nFoo FOO foobar\n" SEARCH_N_TILDE "foo_ foo."
+
+TEST_FUNC(test_search_utf8_columns)
+{
+#if SIZEOF_WCHAR_T == 2
+    // The smiley is a surrogate pair: every column and position in characters after it is one more
+    CHECK_WXSTRING(SearchTestFile(SEARCH_TEST_FILE, "foo", wxSD_MATCHCASE),
+                   "1:7:3:4:3:4\n2:8:3:8:3:17\n3:2:3:1:3:25\n3:7:3:6:3:30\n");
+#else
+    // The columns are in bytes, the positions count the '\n' of the previous lines
+    CHECK_WXSTRING(SearchTestFile(SEARCH_TEST_FILE, "foo", wxSD_MATCHCASE),
+                   "1:7:3:3:3:3\n2:8:3:8:3:16\n3:2:3:1:3:24\n3:7:3:6:3:29\n");
+    // A pattern long enough for the skip table
+    CHECK_WXSTRING(SearchTestFile(SEARCH_TEST_FILE, "foobar", wxSD_MATCHCASE), "2:8:6:8:6:16\n");
+    CHECK_WXSTRING(SearchTestFile(SEARCH_TEST_FILE, "FOOBAR", wxSD_MATCHCASE), "");
+    // A multibyte pattern
+    CHECK_WXSTRING(SearchTestFile(SEARCH_TEST_FILE, wxString::FromUTF8(SEARCH_SMILEY " f"), wxSD_MATCHCASE),
+                   "1:2:6:1:3:1\n");
+#endif
+    CHECK_WXSTRING(SearchTestFile(SEARCH_TEST_FILE, "missing", wxSD_MATCHCASE), "");
+    CHECK_WXSTRING(SearchTestFile("", "foo", wxSD_MATCHCASE), "");
+    return true;
+}
+
+TEST_FUNC(test_search_utf8_ignore_case)
+{
+#if SIZEOF_WCHAR_T == 4
+    CHECK_WXSTRING(SearchTestFile(SEARCH_TEST_FILE, "FoO", 0),
+                   "1:7:3:3:3:3\n2:0:3:0:3:8\n2:4:3:4:3:12\n2:8:3:8:3:16\n3:2:3:1:3:24\n3:7:3:6:3:29\n");
+    CHECK_WXSTRING(SearchTestFile(SEARCH_TEST_FILE, "FOOBAR", 0), "2:8:6:8:6:16\n");
+    // Only ASCII is folded by the byte search: a non ASCII pattern is searched in the decoded lines
+    CHECK_WXSTRING(SearchTestFile(SEARCH_TEST_FILE, wxString::FromUTF8(SEARCH_N_TILDE "FOO"), 0), "3:0:5:0:4:23\n");
+#endif
+    return true;
+}
+
+TEST_FUNC(test_search_utf8_whole_word)
+{
+#if SIZEOF_WCHAR_T == 4
+    // "foobar" and "foo_" are part of longer words, non ASCII characters are not word characters
+    CHECK_WXSTRING(SearchTestFile(SEARCH_TEST_FILE, "foo", wxSD_MATCHWHOLEWORD),
+                   "1:7:3:3:3:3\n2:0:3:0:3:8\n2:4:3:4:3:12\n3:7:3:6:3:29\n");
+    CHECK_WXSTRING(SearchTestFile(SEARCH_TEST_FILE, "foo", wxSD_MATCHWHOLEWORD | wxSD_MATCHCASE),
+                   "1:7:3:3:3:3\n3:7:3:6:3:29\n");
+#endif
+    return true;
+}
+
+TEST_FUNC(test_search_invalid_utf8)
+{
+    // "\xe9" alone is not UTF-8: the file is searched again once converted, the matches of its first
+    // lines are not reported twice
+    CHECK_WXSTRING(SearchTestFile("foo\ncaf\xe9 foo\n", "foo", wxSD_MATCHCASE), "1:0:3:0:3:0\n2:6:3:5:3:9\n");
+    // The invalid byte is on a line without a match
+    CHECK_WXSTRING(SearchTestFile("foo\ncaf\xe9\nfoo", "foo", wxSD_MATCHCASE), "1:0:3:0:3:0\n3:0:3:0:3:9\n");
+    return true;
+}
+
+static bool IsSameXmlTree(const wxXmlNode* a, const wxXmlNode* b)
+{
+    if(!a || !b) { return a == b; }
+    if(a->GetType() != b->GetType() || a->GetName() != b->GetName() || a->GetContent() != b->GetContent()) {
+        return false;
+    }
+    const wxXmlAttribute* attrA = a->GetAttributes();
+    const wxXmlAttribute* attrB = b->GetAttributes();
+    for(; attrA && attrB; attrA = attrA->GetNext(), attrB = attrB->GetNext()) {
+        if(attrA->GetName() != attrB->GetName() || attrA->GetValue() != attrB->GetValue()) { return false; }
+    }
+    if(attrA || attrB) { return false; }
+
+    const wxXmlNode* childA = a->GetChildren();
+    const wxXmlNode* childB = b->GetChildren();
+    for(; childA && childB; childA = childA->GetNext(), childB = childB->GetNext()) {
+        if(childB->GetParent() != b || !IsSameXmlTree(childA, childB)) { return false; }
+    }
+    return !childA && !childB;
+}
+
+static wxArrayString GetSortedProjectFiles(const Project& project)
+{
+    wxArrayString files;
+    project.GetFilesAsStringArray(files);
+    files.Sort();
+    return files;
+}
+
+/// Write a project whose virtual folders are nested 'depth' levels deep and load it
+static ProjectPtr LoadSnapshotTestProject(const wxString& name, int depth)
+{
+    wxString xml;
+    xml << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        << "<CodeLite_Project Name=\"" << name << "\" InternalType=\"Console\" Version=\"11000\">\n"
+        << "  <Description>caf\u00e9 &amp; &lt;more&gt;</Description>\n"
+        << "  <VirtualDirectory Name=\"src\">\n"
+        << "    <File Name=\"main.cpp\"/>\n"
+        << "    <File Name=\"../outside/other.h\" ExcludeProjConfig=\"Debug;Release\"/>\n";
+    for(int i = 0; i < depth; ++i) {
+        xml << "<VirtualDirectory Name=\"sub" << i << "\"><File Name=\"sub/file" << i << ".cpp\"/>";
+    }
+    for(int i = 0; i < depth; ++i) {
+        xml << "</VirtualDirectory>";
+    }
+    xml << "\n  </VirtualDirectory>\n"
+        << "  <Dependencies Name=\"Debug\"/>\n"
+        << "</CodeLite_Project>\n";
+
+    wxFileName projectFile = GetTestTempFile(name + ".project");
+    FileUtils::WriteFileContent(projectFile, xml);
+    ProjectPtr project(new Project());
+    if(!project->LoadXml(projectFile.GetFullPath())) { return ProjectPtr(nullptr); }
+    return project;
+}
+
+static bool SaveSnapshot(const wxFileName& snapshotFile, ProjectPtr project)
+{
+    std::vector<clWorkspaceSnapshot::ProjectEntry> entries;
+    clWorkspaceSnapshot::ProjectEntry entry;
+    entry.project = project;
+    entry.stamp = clWorkspaceSnapshot::Stamp::Get(project->GetFileName().GetFullPath());
+    entries.push_back(entry);
+    return clWorkspaceSnapshot::Save(snapshotFile, entries);
+}
+
+TEST_FUNC(test_workspace_snapshot_round_trip)
+{
+    ProjectPtr project = LoadSnapshotTestProject("snapshot_test", 3);
+    CHECK_BOOL(project);
+    wxString path = project->GetFileName().GetFullPath();
+    clWorkspaceSnapshot::Stamp stamp = clWorkspaceSnapshot::Stamp::Get(path);
+    CHECK_BOOL(stamp.IsOk());
+    wxFileName snapshotFile = GetTestTempFile("workspace.snapshot");
+    CHECK_BOOL(SaveSnapshot(snapshotFile, project));
+
+    clWorkspaceSnapshot snapshot;
+    CHECK_BOOL(snapshot.Open(snapshotFile));
+    CHECK_BOOL(snapshot.HasProject(path, stamp));
+    Project restored;
+    CHECK_BOOL(snapshot.LoadProject(path, stamp, &restored));
+    CHECK_BOOL(IsSameXmlTree(project->GetXmlDocument().GetRoot(), restored.GetXmlDocument().GetRoot()));
+    CHECK_BOOL(restored.GetFileName() == project->GetFileName());
+    CHECK_BOOL(restored.GetName() == "snapshot_test");
+    CHECK_BOOL(restored.GetDescription() == project->GetDescription());
+    CHECK_SIZE(GetSortedProjectFiles(restored).GetCount(), 5);
+    CHECK_BOOL(GetSortedProjectFiles(restored) == GetSortedProjectFiles(*project));
+
+    // The files of the nested virtual folders are found by their virtual folder
+    wxArrayString files;
+    restored.GetFilesByVirtualDir("src:sub0:sub1", files, true);
+    CHECK_SIZE(files.GetCount(), 2);
+
+    // Another version of the project file
+    clWorkspaceSnapshot::Stamp otherStamp = stamp;
+    ++otherStamp.lastModified;
+    CHECK_BOOL(!snapshot.HasProject(path, otherStamp));
+    Project notRestored;
+    CHECK_BOOL(!snapshot.LoadProject(path, otherStamp, &notRestored));
+    otherStamp = stamp;
+    ++otherStamp.fileSize;
+    CHECK_BOOL(!snapshot.LoadProject(path, otherStamp, &notRestored));
+    CHECK_BOOL(!snapshot.LoadProject(path + ".other", stamp, &notRestored));
+    snapshot.Close();
+    return true;
+}
+
+TEST_FUNC(test_workspace_snapshot_rejects_bad_files)
+{
+    ProjectPtr project = LoadSnapshotTestProject("snapshot_test", 3);
+    CHECK_BOOL(project);
+    wxString path = project->GetFileName().GetFullPath();
+    clWorkspaceSnapshot::Stamp stamp = clWorkspaceSnapshot::Stamp::Get(path);
+    wxFileName snapshotFile = GetTestTempFile("workspace.snapshot");
+    CHECK_BOOL(SaveSnapshot(snapshotFile, project));
+
+    // Truncated snapshots
+    std::string content;
+    CHECK_BOOL(ReadBinaryFile(snapshotFile, content));
+    wxFileName badFile = GetTestTempFile("workspace_bad.snapshot");
+    for(size_t len = 0; len < content.length(); ++len) {
+        CHECK_BOOL(WriteBinaryFile(badFile, content.substr(0, len)));
+        clWorkspaceSnapshot snapshot;
+        CHECK_BOOL(!snapshot.Open(badFile));
+        CHECK_BOOL(!snapshot.HasProject(path, stamp));
+    }
+
+    // Another version of the snapshot file, the version follows the "CLWSNAP" magic
+    std::string otherVersion = content;
+    otherVersion[7] = (char)(otherVersion[7] + 1);
+    CHECK_BOOL(WriteBinaryFile(badFile, otherVersion));
+    clWorkspaceSnapshot snapshot;
+    CHECK_BOOL(!snapshot.Open(badFile));
+
+    // The virtual folders are nested deeper than a snapshot allows
+    ProjectPtr deepProject = LoadSnapshotTestProject("snapshot_deep", 300);
+    CHECK_BOOL(deepProject);
+    wxString deepPath = deepProject->GetFileName().GetFullPath();
+    clWorkspaceSnapshot::Stamp deepStamp = clWorkspaceSnapshot::Stamp::Get(deepPath);
+    CHECK_BOOL(SaveSnapshot(snapshotFile, deepProject));
+    CHECK_BOOL(snapshot.Open(snapshotFile));
+    Project notRestored;
+    CHECK_BOOL(!snapshot.LoadProject(deepPath, deepStamp, &notRestored));
+    snapshot.Close();
+
+    // But not too deep
+    ProjectPtr nestedProject = LoadSnapshotTestProject("snapshot_nested", 200);
+    CHECK_BOOL(nestedProject);
+    wxString nestedPath = nestedProject->GetFileName().GetFullPath();
+    CHECK_BOOL(SaveSnapshot(snapshotFile, nestedProject));
+    CHECK_BOOL(snapshot.Open(snapshotFile));
+    Project restored;
+    CHECK_BOOL(snapshot.LoadProject(nestedPath, clWorkspaceSnapshot::Stamp::Get(nestedPath), &restored));
+    CHECK_BOOL(IsSameXmlTree(nestedProject->GetXmlDocument().GetRoot(), restored.GetXmlDocument().GetRoot()));
+    snapshot.Close();
+    return true;
+}
+
 int main(int argc, char** argv)
 {
     wxInitializer initializer(argc, argv);
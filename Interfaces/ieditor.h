@@ -534,6 +534,12 @@ public:
      * @return number of bookmarks found
      */
     virtual size_t GetFindMarkers(std::vector<std::pair<int, wxString> >& bookmarksVector) = 0;
+
+    /**
+     * @brief is the file opened in the large file mode? (no syntax highlight, no folding)
+     * Plugins should avoid copying or parsing the whole text of such editors
+     */
+    virtual bool IsLargeFile() const = 0;
 };
 
 #endif // IEDITOR_H
@@ -0,0 +1,249 @@
+#include "BuildOutputClassifier.h"
+#include "clRegexEngine.h"
+#include "file_logger.h"
+#include "globals.h"
+#include <wx/regex.h>
+
+// Deliver the classified lines at least every this many lines, even if more output is waiting
+#define MAX_LINES_PER_BATCH 500
+
+BuildOutputMatcher::BuildOutputMatcher() {}
+
+BuildOutputMatcher::~BuildOutputMatcher() {}
+
+void BuildOutputMatcher::DoAddPatterns(const Compiler::CmpListInfoPattern& patterns, LINE_SEVERITY severity)
+{
+    for(const Compiler::CmpInfoPattern& info : patterns) {
+        CmpPatternPtr compiledPatternPtr(new CmpPattern(new wxRegEx(info.pattern, wxRE_ADVANCED | wxRE_ICASE),
+                                                        info.fileNameIndex, info.lineNumberIndex, info.columnIndex,
+                                                        severity));
+        if(!compiledPatternPtr->GetRegex()->IsValid()) { continue; }
+
+        Pattern p;
+        p.pattern = compiledPatternPtr;
+        p.literal = clRegexEngine::GetRequiredLiteral(info.pattern);
+        m_patterns.push_back(p);
+    }
+}
+
+void BuildOutputMatcher::SetPatterns(const Compiler::CmpListInfoPattern& errors,
+                                     const Compiler::CmpListInfoPattern& warnings)
+{
+    m_patterns.clear();
+    // Warnings are tested first
+    DoAddPatterns(warnings, SV_WARNING);
+    DoAddPatterns(errors, SV_ERROR);
+}
+
+LINE_SEVERITY BuildOutputMatcher::Match(const wxString& line, BuildLineInfo& lineInfo)
+{
+    wxString lcLine = line.Lower();
+    if(lcLine.Contains("entering directory") || lcLine.Contains("leaving directory")) {
+        return SV_DIR_CHANGE;
+
+    } else if(line.StartsWith("====")) {
+        return SV_NONE;
+    }
+
+    for(Pattern& p : m_patterns) {
+        if(!p.literal.IsEmpty() && !lcLine.Contains(p.literal)) { continue; }
+        if(p.pattern->Matches(line, lineInfo)) { return p.pattern->GetSeverity(); }
+    }
+    return SV_NONE;
+}
+
+//////////////////////////////////////////////////////////////////
+
+BuildOutputBatch::~BuildOutputBatch()
+{
+    for(BuildOutputLine& line : lines) {
+        wxDELETE(line.info);
+    }
+}
+
+BuildOutputClassifier::BuildOutputClassifier(const Callback_t& callback)
+    : m_callback(callback)
+    , m_thread(nullptr)
+    , m_generation(0)
+    , m_errorCount(0)
+    , m_warningCount(0)
+{
+    m_thread = new std::thread(&BuildOutputClassifier::Process, this);
+}
+
+BuildOutputClassifier::~BuildOutputClassifier()
+{
+    Request* req = new Request();
+    req->type = Request::kStop;
+    m_queue.Post(req);
+    m_thread->join();
+    wxDELETE(m_thread);
+
+    // Free the requests that were not processed
+    while(m_queue.ReceiveTimeout(0, req) == wxMSGQUEUE_NO_ERROR) {
+        wxDELETE(req);
+    }
+}
+
+void BuildOutputClassifier::StartBuild(CompilerPtr compiler, const wxString& cygwinRoot, bool clear)
+{
+    Request* req = new Request();
+    req->type = Request::kStart;
+    req->clear = clear;
+    req->cygwinRoot = cygwinRoot;
+    req->generation = GetGeneration();
+    if(compiler) {
+        req->errorPatterns = compiler->GetErrPatterns();
+        req->warningPatterns = compiler->GetWarnPatterns();
+    }
+    m_queue.Post(req);
+}
+
+void BuildOutputClassifier::AddText(const wxString& text)
+{
+    Request* req = new Request();
+    req->type = Request::kText;
+    req->text = text;
+    req->generation = GetGeneration();
+    m_queue.Post(req);
+}
+
+void BuildOutputClassifier::EndBuild()
+{
+    Request* req = new Request();
+    req->type = Request::kEnd;
+    req->generation = GetGeneration();
+    m_queue.Post(req);
+}
+
+void BuildOutputClassifier::Process()
+{
+    while(true) {
+        // While there are lines to deliver, only check whether more output is already waiting
+        Request* req = nullptr;
+        wxMessageQueueError rc = m_batch ? m_queue.ReceiveTimeout(0, req) : m_queue.Receive(req);
+        if(rc == wxMSGQUEUE_TIMEOUT) {
+            Deliver(false, m_batch->generation);
+            continue;
+        }
+        if(rc != wxMSGQUEUE_NO_ERROR) { break; }
+
+        std::unique_ptr<Request> request(req);
+        if(request->type == Request::kStop) { break; }
+
+        // Lines cleared by the receiver must not be mixed with the new ones
+        if(m_batch && m_batch->generation != request->generation) { Deliver(false, m_batch->generation); }
+
+        switch(request->type) {
+        case Request::kStart:
+            if(m_batch) { Deliver(false, m_batch->generation); }
+            if(request->clear) {
+                m_directories.Clear();
+                m_partialLine.Clear();
+                m_errorCount = 0;
+                m_warningCount = 0;
+            }
+            m_cygwinRoot = request->cygwinRoot;
+            m_matcher.SetPatterns(request->errorPatterns, request->warningPatterns);
+            break;
+
+        case Request::kText: {
+            // Process only completed lines (i.e. a line that ends with '\n')
+            m_partialLine << request->text;
+            size_t start = 0;
+            size_t where = m_partialLine.find('\n');
+            while(where != wxString::npos) {
+                ProcessLine(m_partialLine.Mid(start, where - start + 1), request->generation);
+                start = where + 1;
+                where = m_partialLine.find('\n', start);
+            }
+            m_partialLine.Remove(0, start);
+            if(m_batch && m_batch->lines.size() >= MAX_LINES_PER_BATCH) { Deliver(false, m_batch->generation); }
+            break;
+        }
+
+        case Request::kEnd:
+            if(!m_partialLine.IsEmpty()) {
+                ProcessLine(m_partialLine, request->generation);
+                m_partialLine.Clear();
+            }
+            Deliver(true, request->generation);
+            break;
+
+        case Request::kStop:
+            break;
+        }
+    }
+    clDEBUG1() << "Build output classifier thread is going down" << clEndl;
+}
+
+void BuildOutputClassifier::ProcessLine(const wxString& line, size_t generation)
+{
+    // If this is a line similar to 'Entering directory `'
+    // add the path in the directories array
+    SearchForDirectory(line);
+
+    wxString text = line;
+    text.Trim();
+    BuildOutputLine l;
+    ::clStripTerminalColouring(text, l.text);
+
+    BuildLineInfo bli;
+    LINE_SEVERITY severity = m_matcher.Match(line, bli);
+    l.severity = severity;
+    if(severity == SV_WARNING || severity == SV_ERROR) {
+        BuildLineInfo* info = new BuildLineInfo();
+        info->SetSeverity(severity);
+        info->SetFilename(bli.GetFilename());
+        info->SetLineNumber(bli.GetLineNumber());
+        info->NormalizeFilename(m_directories, m_cygwinRoot);
+        info->SetRegexLineMatch(bli.GetRegexLineMatch());
+        info->SetColumn(bli.GetColumn());
+        info->SetLineText(l.text);
+        if(severity == SV_WARNING) {
+            ++m_warningCount;
+        } else {
+            ++m_errorCount;
+        }
+        l.info = info;
+    }
+
+    if(!m_batch) {
+        m_batch.reset(new BuildOutputBatch());
+        m_batch->generation = generation;
+    }
+
+    m_batch->lines.push_back(l);
+}
+
+void BuildOutputClassifier::SearchForDirectory(const wxString& line)
+{
+    // Check for makefile directory changes lines
+    if(line.Contains(wxT("Entering directory `"))) {
+        wxString currentDir = line.AfterFirst(wxT('`'));
+        currentDir = currentDir.BeforeLast(wxT('\''));
+        m_directories.Add(currentDir);
+
+    } else if(line.Contains(wxT("Entering directory '"))) {
+        wxString currentDir = line.AfterFirst(wxT('\''));
+        currentDir = currentDir.BeforeLast(wxT('\''));
+        m_directories.Add(currentDir);
+    }
+}
+
+void BuildOutputClassifier::Deliver(bool buildEnded, size_t generation)
+{
+    if(!m_batch) {
+        // An empty batch only matters when it reports the end of the build
+        if(!buildEnded) { return; }
+        m_batch.reset(new BuildOutputBatch());
+        m_batch->generation = generation;
+    }
+
+    BuildOutputBatch::Ptr_t batch = m_batch;
+    m_batch.reset();
+    batch->buildEnded = buildEnded;
+    batch->errorCount = m_errorCount;
+    batch->warningCount = m_warningCount;
+    m_callback(batch);
+}
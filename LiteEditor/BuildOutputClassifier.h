@@ -0,0 +1,145 @@
+#ifndef BUILDOUTPUTCLASSIFIER_H
+#define BUILDOUTPUTCLASSIFIER_H
+
+#include "compiler.h"
+#include "new_build_tab.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <wx/msgqueue.h>
+#include <wx/string.h>
+
+/**
+ * @class BuildOutputMatcher
+ * @brief match build output lines against the error and warning patterns of a compiler.
+ * Each pattern is guarded by a literal it requires (e.g. ": " or "undefined reference to") and a line
+ * is only run through the regular expressions whose literal it contains. This way most of the lines
+ * of a build are classified without running any regular expression
+ */
+class BuildOutputMatcher
+{
+    struct Pattern {
+        CmpPatternPtr pattern;
+        wxString literal; // lower case. Empty when the pattern does not require a literal
+    };
+    std::vector<Pattern> m_patterns; // the warnings first, then the errors
+
+protected:
+    void DoAddPatterns(const Compiler::CmpListInfoPattern& patterns, LINE_SEVERITY severity);
+
+public:
+    BuildOutputMatcher();
+    virtual ~BuildOutputMatcher();
+
+    /**
+     * @brief compile the patterns of a compiler. Invalid patterns are ignored
+     */
+    void SetPatterns(const Compiler::CmpListInfoPattern& errors, const Compiler::CmpListInfoPattern& warnings);
+    void Clear() { m_patterns.clear(); }
+
+    /**
+     * @brief classify 'line'. When the line is a warning or an error, 'lineInfo' holds the file, line
+     * and column reported by the compiler
+     */
+    LINE_SEVERITY Match(const wxString& line, BuildLineInfo& lineInfo);
+};
+
+/**
+ * @brief a line of the build output, classified
+ */
+struct BuildOutputLine {
+    wxString text; // without the terminal colouring and the trailing white spaces
+    LINE_SEVERITY severity = SV_NONE;
+    BuildLineInfo* info = nullptr; // warnings and errors only. Owned by the batch until the receiver takes it
+};
+
+/**
+ * @brief classified lines, delivered together to the receiver
+ */
+struct BuildOutputBatch {
+    size_t generation = 0;
+    std::vector<BuildOutputLine> lines;
+    bool buildEnded = false;
+    // The totals of the build so far
+    int errorCount = 0;
+    int warningCount = 0;
+
+    ~BuildOutputBatch();
+    typedef std::shared_ptr<BuildOutputBatch> Ptr_t;
+};
+
+/**
+ * @class BuildOutputClassifier
+ * @brief classify the build output in a worker thread. The text is received as it is produced by the
+ * build, split into lines and each line is matched against the compiler patterns. The classified lines are
+ * delivered in batches: a batch is sent when there is no more output waiting or when it is full
+ */
+class BuildOutputClassifier
+{
+public:
+    // Called from the worker thread
+    typedef std::function<void(BuildOutputBatch::Ptr_t)> Callback_t;
+
+protected:
+    struct Request {
+        enum eType { kStart, kText, kEnd, kStop };
+        eType type = kText;
+        size_t generation = 0;
+        wxString text;
+        bool clear = false;
+        Compiler::CmpListInfoPattern errorPatterns;
+        Compiler::CmpListInfoPattern warningPatterns;
+        wxString cygwinRoot;
+    };
+
+    Callback_t m_callback;
+    wxMessageQueue<Request*> m_queue;
+    std::thread* m_thread;
+    std::atomic_size_t m_generation;
+
+    // Used by the worker thread only
+    BuildOutputMatcher m_matcher;
+    wxString m_partialLine;
+    wxArrayString m_directories;
+    wxString m_cygwinRoot;
+    int m_errorCount;
+    int m_warningCount;
+    BuildOutputBatch::Ptr_t m_batch;
+
+protected:
+    void Process();
+    void ProcessLine(const wxString& line, size_t generation);
+    void SearchForDirectory(const wxString& line);
+    void Deliver(bool buildEnded, size_t generation);
+
+public:
+    BuildOutputClassifier(const Callback_t& callback);
+    virtual ~BuildOutputClassifier();
+
+    /**
+     * @brief a build started. Its output is matched against the patterns of 'compiler' (may be null)
+     * @param clear when false, the build continues the previous one: its totals and its directories are kept
+     */
+    void StartBuild(CompilerPtr compiler, const wxString& cygwinRoot, bool clear);
+
+    /**
+     * @brief classify more output. Only complete lines are delivered until EndBuild() is called
+     */
+    void AddText(const wxString& text);
+
+    /**
+     * @brief the build ended: the last (incomplete) line is classified and the last batch is sent with
+     * its 'buildEnded' flag set
+     */
+    void EndBuild();
+
+    /**
+     * @brief the receiver should discard the batches classified so far (e.g. its view was cleared)
+     */
+    void Discard() { ++m_generation; }
+    size_t GetGeneration() const { return m_generation.load(); }
+};
+
+#endif // BUILDOUTPUTCLASSIFIER_H
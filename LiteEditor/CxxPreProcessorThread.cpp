@@ -1,11 +1,15 @@
 #include "CxxPreProcessorThread.h"
 #include "CxxPreProcessor.h"
 #include "CxxLexerAPI.h"
+#include "CxxPreProcessorScannerCache.h"
+#include "cl_standard_paths.h"
 #include "code_completion_manager.h"
 #include "file_logger.h"
 
 CxxPreProcessorThread::CxxPreProcessorThread()
+    : m_cacheLoaded(false)
 {
+    m_cacheFile = wxFileName(clStandardPaths::Get().GetUserDataDir(), "CxxPreProcessor.cache");
 }
 
 CxxPreProcessorThread::~CxxPreProcessorThread()
@@ -17,6 +21,12 @@ void CxxPreProcessorThread::ProcessRequest(ThreadRequest* request)
     CxxPreProcessorThread::Request* req = dynamic_cast<CxxPreProcessorThread::Request*>(request);
     CHECK_PTR_RET(req);
 
+    if(!m_cacheLoaded) {
+        // Load the headers scanned in the previous sessions
+        m_cacheLoaded = true;
+        CxxPreProcessorScannerCache::Get().Load(m_cacheFile);
+    }
+
     CxxPreProcessor pp;
     for(size_t i = 0; i < req->includePaths.GetCount(); ++i) {
         pp.AddIncludePath(req->includePaths.Item(i));
@@ -44,3 +54,13 @@ void CxxPreProcessorThread::QueueFile(const wxString& filename,
     req->filename = filename;
     Add(req);
 }
+
+void CxxPreProcessorThread::SaveCache()
+{
+    if(!CxxPreProcessorScannerCache::Get().IsModified()) {
+        return;
+    }
+    if(!CxxPreProcessorScannerCache::Get().Save(m_cacheFile)) {
+        CL_WARNING("Failed to save the pre processor cache: %s", m_cacheFile.GetFullPath());
+    }
+}
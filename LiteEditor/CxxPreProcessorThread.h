@@ -27,6 +27,7 @@
 #define CXXPREPROCESSORTHREAD_H
 
 #include "worker_thread.h" // Base class: WorkerThread
+#include <wx/filename.h>
 
 class CxxPreProcessorThread : public WorkerThread
 {
@@ -42,6 +43,10 @@ public:
         }
     };
 
+protected:
+    wxFileName m_cacheFile;
+    bool m_cacheLoaded;
+
 public:
     CxxPreProcessorThread();
     virtual ~CxxPreProcessorThread();
@@ -50,6 +55,12 @@ public:
     virtual void ProcessRequest(ThreadRequest* request);
 
     void QueueFile(const wxString& filename, const wxArrayString& definitions, const wxArrayString& includePaths);
+
+    /**
+     * @brief save the headers scanned in this session, so the next session does not need to scan them again.
+     * Call it once the thread is stopped
+     */
+    void SaveCache();
 };
 
 #endif // CXXPREPROCESSORTHREAD_H
@@ -398,6 +398,8 @@ bool CodeLiteApp::OnInit()
     // Set the log file verbosity. NB Doing this earlier seems to break wxGTK debug output when debugging CodeLite
     // itself :/
     FileLogger::OpenLog("codelite.log", clConfig::Get().Read(kConfigLogVerbosity, FileLogger::Error));
+    // Logging threads (the UI thread included) must not wait for the disk
+    FileLogger::SetAsync(true);
     CL_DEBUG(wxT("Starting codelite..."));
 
     // Copy gdb pretty printers from the installation folder to a writeable location
@@ -694,6 +696,8 @@ int CodeLiteApp::OnExit()
     CL_DEBUG(wxT("Bye"));
     EditorConfigST::Free();
     ConfFileLocator::Release();
+    // Write the lines still queued
+    FileLogger::SetAsync(false);
     return 0;
 }
 
@@ -30,9 +30,11 @@
 #include "buildtabsettingsdata.h"
 #include "cc_box_tip_window.h"
 #include "clEditorStateLocker.h"
+#include "clFileContent.h"
 #include "clPrintout.h"
 #include "clResizableTooltip.h"
 #include "clSTCLineKeeper.h"
+#include "clTrace.h"
 #include "cl_command_event.h"
 #include "cl_editor.h"
 #include "cl_editor_tip_window.h"
@@ -67,11 +69,13 @@
 #include "parse_thread.h"
 #include "pluginmanager.h"
 #include "precompiled_header.h"
+#include "progress_dialog.h"
 #include "quickfindbar.h"
 #include "simpletable.h"
 #include "stringhighlighterjob.h"
 #include "stringsearcher.h"
 #include "wxCodeCompletionBoxManager.h"
+#include <climits>
 #include <wx/dataobj.h>
 #include <wx/dcmemory.h>
 #include <wx/log.h>
@@ -100,6 +104,11 @@
 #define CL_LINE_MODIFIED_STYLE 200
 #define CL_LINE_SAVED_STYLE 201
 
+// Files larger than this (in MB) are opened without syntax highlight and folding
+#define LARGE_FILE_DEFAULT_THRESHOLD_MB 50
+// Large files are loaded in chunks of this size
+#define LARGE_FILE_CHUNK_SIZE (8 * 1024 * 1024)
+
 // debugger line marker xpms
 extern const char* arrow_right_green_xpm[];
 extern const char* stop_xpm[]; // Breakpoint
@@ -438,6 +447,7 @@ clEditor::~clEditor()
     Disconnect(m_timerHighlightMarkers->GetId(), wxEVT_TIMER, wxTimerEventHandler(clEditor::OnTimer), NULL, this);
     m_timerHighlightMarkers->Stop();
     wxDELETE(m_timerHighlightMarkers);
+    DoCancelHighlightWord();
 
     // find deltas
     wxDELETE(m_deltas);
@@ -469,7 +479,12 @@ void clEditor::SetSyntaxHighlight(const wxString& lexerName)
 void clEditor::SetSyntaxHighlight(bool bUpdateColors)
 {
     ClearDocumentStyle();
-    m_context = ContextManager::Get()->NewContextByFileName(this, m_fileName);
+    if(m_largeFileMode) {
+        // Lexing a large file takes longer than loading it
+        m_context = ContextManager::Get()->NewContext(this, "text");
+    } else {
+        m_context = ContextManager::Get()->NewContextByFileName(this, m_fileName);
+    }
 
     SetProperties();
 
@@ -567,10 +582,11 @@ void clEditor::SetProperties()
     SetVirtualSpaceOptions(options->GetOptions() & OptionsConfig::Opt_AllowCaretAfterEndOfLine ? 2 : 1);
     SetCaretStyle(options->GetOptions() & OptionsConfig::Opt_UseBlockCaret ? wxSTC_CARETSTYLE_BLOCK
                                                                            : wxSTC_CARETSTYLE_LINE);
-    SetWrapMode(options->GetWordWrap() ? wxSTC_WRAP_WORD : wxSTC_WRAP_NONE);
+    // Word wrap requires the layout of the whole document, this is too slow for large files
+    SetWrapMode((options->GetWordWrap() && !m_largeFileMode) ? wxSTC_WRAP_WORD : wxSTC_WRAP_NONE);
     SetViewWhiteSpace(options->GetShowWhitspaces());
     SetMouseDwellTime(500);
-    SetProperty(wxT("fold"), wxT("1"));
+    SetProperty(wxT("fold"), m_largeFileMode ? wxT("0") : wxT("1"));
     SetProperty(wxT("fold.html"), wxT("1"));
     SetProperty(wxT("fold.comment"), wxT("1"));
 
@@ -658,7 +674,7 @@ void clEditor::SetProperties()
     SetMarginWidth(NUMBER_MARGIN_ID, options->GetDisplayLineNumbers() ? pixelWidth : 0);
 
     // Show the fold margin
-    SetMarginWidth(FOLD_MARGIN_ID, options->GetDisplayFoldMargin() ? 16 : 0); // Fold margin
+    SetMarginWidth(FOLD_MARGIN_ID, (options->GetDisplayFoldMargin() && !m_largeFileMode) ? 16 : 0); // Fold margin
 
     // Mark fold margin & symbols margins as sensetive
     SetMarginSensitive(FOLD_MARGIN_ID, true);
@@ -926,6 +942,7 @@ void clEditor::OnSavePoint(wxStyledTextEvent& event)
 
 void clEditor::OnCharAdded(wxStyledTextEvent& event)
 {
+    CL_TRACE_SCOPE("editor", "clEditor::OnCharAdded");
     OptionsConfigPtr options = GetOptions();
     if(m_prevSelectionInfo.IsOk()) {
         if(event.GetKey() == '"' && options->IsWrapSelectionWithQuotes()) {
@@ -1200,6 +1217,7 @@ void clEditor::DoEnsureCaretIsVisible(int pos, bool preserveSelection)
 
 void clEditor::OnSciUpdateUI(wxStyledTextEvent& event)
 {
+    CL_TRACE_SCOPE("editor", "clEditor::OnSciUpdateUI");
     event.Skip();
 
     // Update the line numbers if needed (only when using custom drawing line numbers)
@@ -1291,6 +1309,7 @@ void clEditor::OnSciUpdateUI(wxStyledTextEvent& event)
 
 void clEditor::OnMarginClick(wxStyledTextEvent& event)
 {
+    CL_TRACE_SCOPE("editor", "clEditor::OnMarginClick");
     int nLine = LineFromPosition(event.GetPosition());
     switch(event.GetMargin()) {
     case SYMBOLS_MARGIN_ID:
@@ -1493,9 +1512,14 @@ bool clEditor::SaveToFile(const wxFileName& fileName)
     // trim lines / append LF if needed
     TrimText(GetOptions()->GetTrimLine(), GetOptions()->GetAppendLF());
 
+    // A large file loaded without conversion is written back the same way: converting its text to a
+    // wxString and back costs two copies of the whole file and may alter it
+    bool rawContent = m_largeFileRawContent;
+
     // BUG#2982452
     // try to manually convert the text to make sure that the conversion does not fail
-    wxString theText = GetText();
+    wxString theText;
+    if(!rawContent) { theText = GetText(); }
 
     // If the intermediate file exists, it means that we got problems deleting it (usually permissions)
     // Notify the user and continue
@@ -1516,30 +1540,39 @@ bool clEditor::SaveToFile(const wxFileName& fileName)
         return false;
     }
 
-    // Convert the text
-    const wxWX2MBbuf buf = theText.mb_str(useBuiltIn ? (const wxMBConv&)wxConvUTF8 : (const wxMBConv&)fontEncConv);
-    if(!buf.data()) {
-        wxMessageBox(wxString::Format(wxT("%s\n%s '%s'"), _("Save file failed!"),
-                                      _("Could not convert the file to the requested encoding"),
-                                      wxFontMapper::GetEncodingName(GetOptions()->GetFileFontEncoding())),
-                     "CodeLite", wxOK | wxICON_WARNING);
-        return false;
-    }
+    if(rawContent) {
+        if(!DoSaveRawContent(file)) {
+            wxMessageBox(wxString::Format(_("Failed to write file\n'%s'"), intermediateFile.GetFullPath()),
+                         "CodeLite", wxOK | wxCENTER | wxICON_ERROR);
+            return false;
+        }
+    } else {
+        // Convert the text
+        const wxWX2MBbuf buf =
+            theText.mb_str(useBuiltIn ? (const wxMBConv&)wxConvUTF8 : (const wxMBConv&)fontEncConv);
+        if(!buf.data()) {
+            wxMessageBox(wxString::Format(wxT("%s\n%s '%s'"), _("Save file failed!"),
+                                          _("Could not convert the file to the requested encoding"),
+                                          wxFontMapper::GetEncodingName(GetOptions()->GetFileFontEncoding())),
+                         "CodeLite", wxOK | wxICON_WARNING);
+            return false;
+        }
 
-    if((buf.length() == 0) && !theText.IsEmpty()) {
-        // something went wrong in the conversion process
-        wxString errmsg;
-        errmsg << _(
-            "File text conversion failed!\nCheck your file font encoding from\nSettings | Preferences | Misc | Locale");
-        wxMessageBox(errmsg, "CodeLite", wxOK | wxICON_ERROR | wxCENTER, wxTheApp->GetTopWindow());
-        return false;
-    }
+        if((buf.length() == 0) && !theText.IsEmpty()) {
+            // something went wrong in the conversion process
+            wxString errmsg;
+            errmsg << _("File text conversion failed!\nCheck your file font encoding from\nSettings | Preferences | "
+                        "Misc | Locale");
+            wxMessageBox(errmsg, "CodeLite", wxOK | wxICON_ERROR | wxCENTER, wxTheApp->GetTopWindow());
+            return false;
+        }
 
-    if(!m_fileBom.IsEmpty()) {
-        // restore the BOM
-        file.Write(m_fileBom.GetData(), m_fileBom.Len());
+        if(!m_fileBom.IsEmpty()) {
+            // restore the BOM
+            file.Write(m_fileBom.GetData(), m_fileBom.Len());
+        }
+        file.Write(buf.data(), strlen(buf.data()));
     }
-    file.Write(buf.data(), strlen(buf.data()));
     file.Close();
 
     wxFileName symlinkedFile = fileName;
@@ -1732,6 +1765,7 @@ void clEditor::GotoDefinition()
 
 void clEditor::OnDwellStart(wxStyledTextEvent& event)
 {
+    CL_TRACE_SCOPE("editor", "clEditor::OnDwellStart");
     // First see if we're hovering over a breakpoint or build marker
     // Assume anywhere to the left of the fold margin qualifies
     int margin = 0;
@@ -3013,6 +3047,7 @@ void clEditor::UpdateLineNumbers()
 
 void clEditor::OpenFile()
 {
+    CL_TRACE_SCOPE("editor", "clEditor::OpenFile");
     wxWindowUpdateLocker locker(this);
     SetReloadingFile(true);
 
@@ -3031,14 +3066,18 @@ void clEditor::OpenFile()
     int lineNumber = GetCurrentLine();
     m_mgr->GetStatusBar()->SetMessage(_("Loading file..."));
 
-    wxString text;
+    DoUpdateLargeFileMode();
+    if(!m_largeFileMode || !DoLoadLargeFile(false)) {
+        wxString text;
 
-    // Read the file we currently support:
-    // BOM, Auto-Detect encoding & User defined encoding
-    m_fileBom.Clear();
-    ReadFileWithConversion(m_fileName.GetFullPath(), text, DetectEncoding(m_fileName.GetFullPath()), &m_fileBom);
+        // Read the file we currently support:
+        // BOM, Auto-Detect encoding & User defined encoding
+        m_largeFileRawContent = false;
+        m_fileBom.Clear();
+        ReadFileWithConversion(m_fileName.GetFullPath(), text, DetectEncoding(m_fileName.GetFullPath()), &m_fileBom);
 
-    SetText(text);
+        SetText(text);
+    }
 
     m_modifyTime = GetFileLastModifiedTime();
 
@@ -3072,6 +3111,106 @@ void clEditor::OpenFile()
     m_mgr->GetStatusBar()->SetMessage(_("Ready"));
 }
 
+bool clEditor::IsLargeFileOnDisk(const wxFileName& filename)
+{
+    long threshold = EditorConfigST::Get()->GetInteger("large_file_threshold_mb", LARGE_FILE_DEFAULT_THRESHOLD_MB);
+    if(threshold <= 0) { return false; }
+    wxULongLong size = filename.GetSize();
+    return size != wxInvalidSize && size >= wxULongLong(threshold) * 1024 * 1024;
+}
+
+void clEditor::DoUpdateLargeFileMode()
+{
+    bool largeFile = IsLargeFileOnDisk(m_fileName);
+    if(largeFile == m_largeFileMode) { return; }
+    m_largeFileMode = largeFile;
+    SetSyntaxHighlight(false);
+}
+
+bool clEditor::DoLoadLargeFile(bool keepUndoHistory)
+{
+    m_largeFileRawContent = false;
+    clFileContent file;
+    if(!file.Open(m_fileName.GetFullPath())) { return false; }
+    const char* data = file.GetData();
+    size_t size = file.GetSize();
+    if(size >= (size_t)INT_MAX) {
+        clWARNING() << "File" << m_fileName << "is too large to be edited" << clEndl;
+        return false;
+    }
+
+    // The content is passed to the editor as it is, without any conversion: only UTF-8 (or ASCII) files
+    // can be loaded this way. Files with another BOM are converted and loaded as usual
+    size_t offset = 0;
+    m_fileBom.Clear();
+    if(size >= 4) {
+        m_fileBom.SetData(data, 4);
+        wxFontEncoding encoding = m_fileBom.Encoding();
+        if(encoding == wxFONTENCODING_UTF8) {
+            offset = m_fileBom.Len();
+        } else {
+            m_fileBom.Clear();
+            if(encoding != wxFONTENCODING_SYSTEM) { return false; }
+        }
+    }
+
+    if(!FileUtils::IsValidUTF8(data + offset, size - offset)) {
+        clDEBUG() << "Large file" << m_fileName << "is not a valid UTF-8 file, it is converted" << clEndl;
+        return false;
+    }
+
+    clDEBUG() << "Loading large file" << m_fileName << "(" << size << "bytes)" << clEndl;
+
+    if(keepUndoHistory) {
+        // The reload can be undone (the undo action holds a copy of the previous text)
+        BeginUndoAction();
+    } else {
+        // Do not keep an undo action holding a copy of the whole text
+        SetUndoCollection(false);
+    }
+    ClearAll();
+    Allocate(size - offset + 1);
+
+    // Appending the text in chunks gives the progress dialog a chance to update. A chunk may end in the
+    // middle of a UTF-8 sequence, this is fine since the editor stores bytes
+    clProgressDlg* dlg = nullptr;
+    if((size - offset) > LARGE_FILE_CHUNK_SIZE) {
+        dlg = new clProgressDlg(NULL, _("Loading file..."), m_fileName.GetFullName(), 100);
+    }
+    while(offset < size) {
+        size_t len = std::min((size_t)LARGE_FILE_CHUNK_SIZE, size - offset);
+        AppendTextRaw(data + offset, (int)len);
+        offset += len;
+        if(dlg) { dlg->Update((int)((offset * 100) / size), m_fileName.GetFullName()); }
+    }
+    if(dlg) { dlg->Destroy(); }
+
+    if(keepUndoHistory) {
+        EndUndoAction();
+    } else {
+        SetUndoCollection(true);
+        EmptyUndoBuffer();
+    }
+    m_largeFileRawContent = true;
+    return true;
+}
+
+bool clEditor::DoSaveRawContent(wxFFile& file)
+{
+    if(!m_fileBom.IsEmpty() && file.Write(m_fileBom.GetData(), m_fileBom.Len()) != (size_t)m_fileBom.Len()) {
+        return false;
+    }
+    int length = GetLength();
+    int pos = 0;
+    while(pos < length) {
+        int end = (length - pos > LARGE_FILE_CHUNK_SIZE) ? pos + LARGE_FILE_CHUNK_SIZE : length;
+        wxCharBuffer chunk = GetTextRangeRaw(pos, end);
+        if(file.Write(chunk.data(), end - pos) != (size_t)(end - pos)) { return false; }
+        pos = end;
+    }
+    return true;
+}
+
 void clEditor::SetEditorText(const wxString& text)
 {
     wxWindowUpdateLocker locker(this);
@@ -3087,6 +3226,7 @@ void clEditor::Create(const wxString& project, const wxFileName& fileName)
     SetFileName(fileName);
     // set the project name
     SetProject(project);
+    m_largeFileMode = IsLargeFileOnDisk(fileName);
     // let the editor choose the syntax highlight to use according to file extension
     // and set the editor properties to default
     SetSyntaxHighlight(false); // Dont call 'UpdateColors' it is called in 'OpenFile'
@@ -3237,6 +3377,7 @@ void clEditor::OnContextMenu(wxContextMenuEvent& event)
 
 void clEditor::OnKeyDown(wxKeyEvent& event)
 {
+    CL_TRACE_SCOPE("editor", "clEditor::OnKeyDown");
     // always cancel the tip
     DoCancelCodeCompletionBox();
 
@@ -3888,6 +4029,7 @@ int clEditor::GetCurrLineHeight()
 
 void clEditor::DoHighlightWord()
 {
+    CL_TRACE_SCOPE("editor", "clEditor::DoHighlightWord");
     // Read the primary selected text
     int mainSelectionStart = GetSelectionNStart(GetMainSelection());
     int mainSelectionEnd = GetSelectionNEnd(GetMainSelection());
@@ -3897,62 +4039,61 @@ void clEditor::DoHighlightWord()
     selectedTextTrimmed.Trim().Trim(false);
     if(selectedTextTrimmed.IsEmpty()) { return; }
 
-    // Search only the visible areas
-    StringHighlighterJob j;
-    int firstVisibleLine = GetFirstVisibleLine();
-    int lastDocLine = LineFromPosition(GetLength());
-    int offset = PositionFromLine(firstVisibleLine);
-
-    if(GetAllLinesVisible()) {
-        // The simple case: there aren't any folds
-        int lastLine = firstVisibleLine + LinesOnScreen();
-        if(lastLine > lastDocLine) { lastLine = lastDocLine; }
-        int lastPos = PositionFromLine(lastLine) + LineLength(lastLine);
-        wxString text = GetTextRange(offset, lastPos);
-        j.Set(text, word, offset);
-        j.Process();
-    } else {
+    // Drop the markers of the previous word, including the ones still being searched
+    DoCancelHighlightWord();
+    SetIndicatorCurrent(MARKER_WORD_HIGHLIGHT);
+    IndicatorClearRange(0, GetLength());
+    m_highlightedWordInfo.Clear();
+    m_highlightedWordInfo.SetWord(word);
+    m_highlightedWordInfo.SetHasMarkers(true);
+    // Large files are not searched in the background (this requires a copy of the text), only the visible
+    // lines are marked. OnTimer() searches them again when other lines are scrolled into view
+    if(m_largeFileMode) { m_highlightedWordInfo.SetVisibleLines(GetFirstVisibleLine(), LinesOnScreen()); }
 
-        // There are folds, so we have to process each visible section separately
-        firstVisibleLine = DocLineFromVisible(firstVisibleLine); // This copes with folds above the displayed lines
-        int lineCount(0);
-        int nextLineToProcess(firstVisibleLine);
-        int screenLines(LinesOnScreen());
-        while(lineCount < screenLines && nextLineToProcess <= lastDocLine) {
-            int offset(-1);
-            int line = nextLineToProcess;
-
-            // Skip over any invisible lines
-            while(!GetLineVisible(line) && line < lastDocLine) {
-                ++line;
-            }
+    // The matches are searched in the editor bytes, so search the word bytes as well
+    wxCharBuffer rawWord = GetTextRangeRaw(mainSelectionStart, mainSelectionEnd);
+    std::string utf8Word(rawWord.data(), rawWord.length());
 
-            // EOF?
-            if(line >= lastDocLine) break;
+    // Search the visible lines first, directly in the editor buffer. Lines hidden by folds in this
+    // range are searched as well
+    int firstLine = DocLineFromVisible(GetFirstVisibleLine());
+    int lastLine = DocLineFromVisible(GetFirstVisibleLine() + LinesOnScreen());
+    if(lastLine >= GetLineCount()) { lastLine = GetLineCount() - 1; }
+    int visibleStart = PositionFromLine(firstLine);
+    int visibleEnd = GetLineEndPosition(lastLine);
 
-            while(GetLineVisible(line) && line <= lastDocLine) {
-                if(offset == -1) {
-                    offset = PositionFromLine(line); // Get offset value the first time through
-                }
-                ++line;
-                ++lineCount;
-                if(lineCount >= screenLines) { break; }
-            }
-            if(line > lastDocLine) { line = lastDocLine; }
-            nextLineToProcess = line;
+    StringHighlighterJob::Matches_t matches;
+    if(visibleEnd > visibleStart) {
+        const char* text = GetRangePointer(visibleStart, visibleEnd - visibleStart);
+        StringHighlighterJob::Search(text, visibleEnd - visibleStart, 0, visibleEnd - visibleStart, utf8Word,
+                                     visibleStart, matches);
+    }
+    HighlightWordMatches(matches);
 
-            int lastPos = PositionFromLine(nextLineToProcess) + LineLength(nextLineToProcess);
-            wxString text = GetTextRange(offset, lastPos);
-            j.Set(text, word, offset);
-            j.Process();
-        }
+    // The rest of the document is searched in the background. The worker gets a copy of the text: Scintilla
+    // may move its buffer whenever the text changes, it can not be read outside of the main thread
+    int length = GetLength();
+    if(!m_largeFileMode && (visibleStart > 0 || visibleEnd < length)) {
+        std::string buffer(GetCharacterPointer(), length);
+        size_t generation = m_highlightGeneration;
+        m_highlighterJob.Start(std::move(buffer), utf8Word, visibleStart, visibleEnd,
+                               [this, generation](const StringHighlighterJob::Matches_t& found) {
+                                   CallAfter(&clEditor::OnHighlightWordMatches, found, generation);
+                               });
     }
+}
 
-    // Keep the first offset
-    m_highlightedWordInfo.Clear();
-    m_highlightedWordInfo.SetFirstOffset(offset);
-    m_highlightedWordInfo.SetWord(word);
-    HighlightWord((StringHighlightOutput*)&j.GetOutput());
+void clEditor::DoCancelHighlightWord()
+{
+    m_highlighterJob.Cancel();
+    // Ignore the matches already sent by the worker
+    ++m_highlightGeneration;
+}
+
+void clEditor::OnHighlightWordMatches(const StringHighlighterJob::Matches_t& matches, size_t generation)
+{
+    if(generation != m_highlightGeneration) { return; }
+    HighlightWordMatches(matches);
 }
 
 void clEditor::HighlightWord(bool highlight)
@@ -3961,6 +4102,7 @@ void clEditor::HighlightWord(bool highlight)
         DoHighlightWord();
 
     } else {
+        DoCancelHighlightWord();
         SetIndicatorCurrent(MARKER_WORD_HIGHLIGHT);
         IndicatorClearRange(0, GetLength());
         m_highlightedWordInfo.Clear();
@@ -4342,6 +4484,7 @@ void clEditor::SetEOL()
 
 void clEditor::OnChange(wxStyledTextEvent& event)
 {
+    CL_TRACE_SCOPE("editor", "clEditor::OnChange");
     event.Skip();
     ++m_modificationCount;
 
@@ -4351,6 +4494,12 @@ void clEditor::OnChange(wxStyledTextEvent& event)
     bool isUndo = event.GetModificationType() & wxSTC_PERFORMED_UNDO;
     bool isRedo = event.GetModificationType() & wxSTC_PERFORMED_REDO;
 
+    // The positions of the matches being searched are no longer valid, search again
+    if((isInsert || isDelete) && m_highlightedWordInfo.IsValid()) {
+        DoCancelHighlightWord();
+        m_highlightedWordInfo.Clear();
+    }
+
     // Remove any code completion annotations if we have some...
     if(m_hasCCAnnotation) {
         CallAfter(&clEditor::AnnotationClearAll);
@@ -4693,25 +4842,15 @@ bool clEditor::ReplaceAllExactMatch(const wxString& what, const wxString& replac
 
 void clEditor::SetLexerName(const wxString& lexerName) { SetSyntaxHighlight(lexerName); }
 
-void clEditor::HighlightWord(StringHighlightOutput* highlightOutput)
+void clEditor::HighlightWordMatches(const StringHighlighterJob::Matches_t& matches)
 {
-    // the search highlighter thread has completed the calculations, fetch the results and mark them in the editor
-    const std::vector<std::pair<int, int> >& matches = highlightOutput->matches;
     SetIndicatorCurrent(MARKER_WORD_HIGHLIGHT);
+    int selStart = GetSelectionStart();
+    for(size_t i = 0; i < matches.size(); i++) {
+        const std::pair<int, int>& p = matches.at(i);
 
-    // clear the old markers
-    IndicatorClearRange(0, GetLength());
-    if(!highlightOutput->matches.empty()) {
-        m_highlightedWordInfo.SetHasMarkers(true);
-        int selStart = GetSelectionStart();
-        for(size_t i = 0; i < matches.size(); i++) {
-            const std::pair<int, int>& p = matches.at(i);
-
-            // Dont highlight the current selection
-            if(p.first != selStart) { IndicatorFillRange(p.first, p.second); }
-        }
-    } else {
-        m_highlightedWordInfo.Clear();
+        // Dont highlight the current selection
+        if(p.first != selStart) { IndicatorFillRange(p.first, p.second); }
     }
 }
 
@@ -5049,6 +5188,7 @@ void clEditor::DoWrapPrevSelectionWithChars(wxChar first, wxChar last)
 
 void clEditor::OnTimer(wxTimerEvent& event)
 {
+    CL_TRACE_SCOPE("editor", "clEditor::OnTimer");
     event.Skip();
     m_timerHighlightMarkers->Start(100, true);
     if(!HasFocus()) return;
@@ -5068,7 +5208,7 @@ void clEditor::OnTimer(wxTimerEvent& event)
             int mainSelectionEnd = GetSelectionNEnd(GetMainSelection());
 
             wxString selectedText = GetTextRange(mainSelectionStart, mainSelectionEnd);
-            if(!m_highlightedWordInfo.IsValid(this)) {
+            if(!m_highlightedWordInfo.IsValid()) {
 
                 // Check to see if we have marker already on
                 // we got a selection
@@ -5085,6 +5225,9 @@ void clEditor::OnTimer(wxTimerEvent& event)
                 // we got the markers on, check that they still matches the highlighted word
                 if(selectedText != m_highlightedWordInfo.GetWord()) {
                     HighlightWord(false);
+                } else if(m_highlightedWordInfo.IsVisibleLinesChanged(GetFirstVisibleLine(), LinesOnScreen())) {
+                    // Only the visible lines were marked and the editor was scrolled
+                    DoHighlightWord();
                 } else {
                     // clDEBUG1() << "Markers are valid - nothing more to be done" << clEndl;
                 }
@@ -5510,14 +5653,18 @@ void clEditor::ReloadFromDisk(bool keepUndoHistory)
 
     clEditorStateLocker stateLocker(GetCtrl());
 
-    wxString text;
+    DoUpdateLargeFileMode();
+    if(!m_largeFileMode || !DoLoadLargeFile(keepUndoHistory)) {
+        wxString text;
 
-    // Read the file we currently support:
-    // BOM, Auto-Detect encoding & User defined encoding
-    m_fileBom.Clear();
-    ReadFileWithConversion(m_fileName.GetFullPath(), text, GetOptions()->GetFileFontEncoding(), &m_fileBom);
+        // Read the file we currently support:
+        // BOM, Auto-Detect encoding & User defined encoding
+        m_largeFileRawContent = false;
+        m_fileBom.Clear();
+        ReadFileWithConversion(m_fileName.GetFullPath(), text, GetOptions()->GetFileFontEncoding(), &m_fileBom);
 
-    SetText(text);
+        SetText(text);
+    }
     m_modifyTime = GetFileLastModifiedTime();
     SetSavePoint();
 
@@ -77,6 +77,7 @@ class CCBox;
 class clEditorTipWindow;
 class DisplayVariableDlg;
 class EditorDeltasHolder;
+class wxFFile;
 
 enum sci_annotation_styles { eAnnotationStyleError = 128, eAnnotationStyleWarning };
 
@@ -167,33 +168,53 @@ private:
     struct MarkWordInfo {
     private:
         bool m_hasMarkers;
-        int m_firstOffset;
         wxString m_word;
+        int m_firstVisibleLine; // wxNOT_FOUND when the whole document is marked
+        int m_linesOnScreen;
 
     public:
         MarkWordInfo()
             : m_hasMarkers(false)
-            , m_firstOffset(wxNOT_FOUND)
+            , m_firstVisibleLine(wxNOT_FOUND)
+            , m_linesOnScreen(0)
         {
         }
 
         void Clear()
         {
             m_hasMarkers = false;
-            m_firstOffset = wxNOT_FOUND;
             m_word.Clear();
+            m_firstVisibleLine = wxNOT_FOUND;
+            m_linesOnScreen = 0;
         }
 
-        bool IsValid(wxStyledTextCtrl* ctrl) const
+        /**
+         * @brief the word is marked: in the whole document (or it is being marked in the background), or in the
+         * visible lines only. See IsVisibleLinesChanged()
+         */
+        bool IsValid() const { return m_hasMarkers; }
+
+        /**
+         * @brief only the lines visible on screen were marked (large files)
+         */
+        void SetVisibleLines(int firstVisibleLine, int linesOnScreen)
+        {
+            m_firstVisibleLine = firstVisibleLine;
+            m_linesOnScreen = linesOnScreen;
+        }
+
+        /**
+         * @brief when only the visible lines were marked: were other lines scrolled into view since?
+         */
+        bool IsVisibleLinesChanged(int firstVisibleLine, int linesOnScreen) const
         {
-            return ctrl->PositionFromLine(ctrl->GetFirstVisibleLine()) == m_firstOffset && m_hasMarkers;
+            return m_firstVisibleLine != wxNOT_FOUND &&
+                   (m_firstVisibleLine != firstVisibleLine || m_linesOnScreen != linesOnScreen);
         }
 
         // setters/getters
-        void SetFirstOffset(int firstOffset) { this->m_firstOffset = firstOffset; }
         void SetHasMarkers(bool hasMarkers) { this->m_hasMarkers = hasMarkers; }
         void SetWord(const wxString& word) { this->m_word = word; }
-        int GetFirstOffset() const { return m_firstOffset; }
         bool IsHasMarkers() const { return m_hasMarkers; }
         const wxString& GetWord() const { return m_word; }
     };
@@ -252,6 +273,8 @@ protected:
     SelectionInfo m_prevSelectionInfo;
     MarkWordInfo m_highlightedWordInfo;
     wxTimer* m_timerHighlightMarkers;
+    StringHighlighterJob m_highlighterJob;
+    size_t m_highlightGeneration = 0; // matches reported for an older generation are ignored
     IManager* m_mgr;
     OptionsConfigPtr m_options;
     bool m_hasCCAnnotation;
@@ -266,6 +289,8 @@ protected:
     int m_lastLine = wxNOT_FOUND;
     int m_lastEndLine;
     int m_lastLineCount;
+    bool m_largeFileMode = false;
+    bool m_largeFileRawContent = false; // the document holds the file bytes as they are (see DoLoadLargeFile)
     wxColour m_selTextColour;
     wxColour m_selTextBgColour;
 
@@ -336,6 +361,7 @@ public:
     virtual const wxString& GetKeywordLocals() const { return m_keywordLocals; }
     virtual void SetKeywordClasses(const wxString& keywordClasses) { this->m_keywordClasses = keywordClasses; }
     virtual void SetKeywordLocals(const wxString& keywordLocals) { this->m_keywordLocals = keywordLocals; }
+    virtual bool IsLargeFile() const { return m_largeFileMode; }
 
     /**
      * @brief split the current selection into multiple carets.
@@ -954,7 +980,7 @@ public:
     const bool& GetIsVisible() const { return m_isVisible; }
 
     wxString GetEolString();
-    void HighlightWord(StringHighlightOutput* highlightOutput);
+    void HighlightWordMatches(const StringHighlighterJob::Matches_t& matches);
 
     /**
      * Get a vector of relevant position changes. Used for 'GoTo next/previous FindInFiles match'
@@ -989,6 +1015,23 @@ private:
     void BraceMatch(const bool& bSelRegion);
     void BraceMatch(long pos);
     void DoHighlightWord();
+    /**
+     * @brief files larger than the "large_file_threshold_mb" setting are opened in the large file mode
+     */
+    static bool IsLargeFileOnDisk(const wxFileName& filename);
+    void DoUpdateLargeFileMode();
+    /**
+     * @brief load the file content as raw UTF-8 bytes, a chunk at a time
+     * @param keepUndoHistory when true, the reload is added to the undo history as a single action
+     * @return false if the file can not be loaded this way (e.g. it is not a valid UTF-8 file)
+     */
+    bool DoLoadLargeFile(bool keepUndoHistory);
+    /**
+     * @brief write the document bytes as they are, a chunk at a time. Used for files loaded by DoLoadLargeFile()
+     */
+    bool DoSaveRawContent(wxFFile& file);
+    void DoCancelHighlightWord();
+    void OnHighlightWordMatches(const StringHighlighterJob::Matches_t& matches, size_t generation);
     bool IsOpenBrace(int position);
     bool IsCloseBrace(int position);
     size_t GetCodeNavModifier();
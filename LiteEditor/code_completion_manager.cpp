@@ -108,6 +108,7 @@ CodeCompletionManager::CodeCompletionManager()
 CodeCompletionManager::~CodeCompletionManager()
 {
     m_preProcessorThread.Stop();
+    m_preProcessorThread.SaveCache();
     m_usingNamespaceThread.Stop();
     EventNotifier::Get()->Unbind(wxEVT_PROJ_FILE_ADDED, &CodeCompletionManager::OnFilesAdded, this);
     EventNotifier::Get()->Unbind(wxEVT_WORKSPACE_LOADED, &CodeCompletionManager::OnWorkspaceLoaded, this);
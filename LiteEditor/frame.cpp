@@ -40,6 +40,7 @@
 #include "clMainFrameHelper.h"
 #include "clSingleChoiceDialog.h"
 #include "clToolBarButtonBase.h"
+#include "clTrace.h"
 #include "clWorkspaceManager.h"
 #include "cl_aui_dock_art.h"
 #include "cl_aui_tb_are.h"
@@ -591,6 +592,9 @@ EVT_MENU(XRCID("tags_options"), clMainFrame::OnCtagsOptions)
 EVT_MENU(wxID_ABOUT, clMainFrame::OnAbout)
 EVT_MENU(XRCID("check_for_update"), clMainFrame::OnCheckForUpdate)
 EVT_MENU(XRCID("run_setup_wizard"), clMainFrame::OnRunSetupWizard)
+EVT_MENU(XRCID("trace_record"), clMainFrame::OnTraceRecord)
+EVT_UPDATE_UI(XRCID("trace_record"), clMainFrame::OnTraceRecordUI)
+EVT_MENU(XRCID("trace_export"), clMainFrame::OnTraceExport)
 
 //-------------------------------------------------------
 // Perspective menu
@@ -1195,6 +1199,7 @@ void clMainFrame::CreateGUIControls()
 
     // Update the parser thread search paths
     ParseThreadST::Get()->SetCrawlerEnabeld(m_tagsOptionsData.GetParserEnabled());
+    ParseThreadST::Get()->SetParserWorkers(m_tagsOptionsData.GetParserThreads());
     ParseThreadST::Get()->SetSearchPaths(m_tagsOptionsData.GetParserSearchPaths(),
                                          m_tagsOptionsData.GetParserExcludePaths());
 
@@ -2125,6 +2130,9 @@ void clMainFrame::OnCtagsOptions(wxCommandEvent& event)
 
         TagsManagerST::Get()->SetCtagsOptions(m_tagsOptionsData);
         TagsManagerST::Get()->GetDatabase()->SetEnableCaseInsensitive(!caseSensitive);
+        ParseThreadST::Get()->SetParserWorkers(m_tagsOptionsData.GetParserThreads());
+        // Start the indexer processes of the new parser threads, if any
+        TagsManagerST::Get()->StartCodeLiteIndexer();
 
         clConfig ccConfig("code-completion.conf");
         ccConfig.WriteItem(&m_tagsOptionsData);
@@ -4561,7 +4569,12 @@ void clMainFrame::SelectBestEnvSet()
 void clMainFrame::OnClearTagsCache(wxCommandEvent& e)
 {
     e.Skip();
-    TagsManagerST::Get()->ClearTagsCache();
+    // When the event carries a file name, only that file was re-parsed
+    if(e.GetString().IsEmpty()) {
+        TagsManagerST::Get()->ClearTagsCache();
+    } else {
+        TagsManagerST::Get()->ClearTagsCache(e.GetString());
+    }
     GetStatusBar()->SetMessage(_("Tags cache cleared"));
 }
 
@@ -5240,6 +5253,21 @@ void clMainFrame::OnRunSetupWizard(wxCommandEvent& e)
     if(!StartSetupWizard()) { GetMainBook()->ApplySettingsChanges(); }
 }
 
+void clMainFrame::OnTraceRecord(wxCommandEvent& e) { clTrace::Enable(e.IsChecked()); }
+
+void clMainFrame::OnTraceRecordUI(wxUpdateUIEvent& e) { e.Check(clTrace::IsEnabled()); }
+
+void clMainFrame::OnTraceExport(wxCommandEvent& e)
+{
+    wxUnusedVar(e);
+    wxString filename = ::wxFileSelector(_("Save performance trace"), wxEmptyString, "codelite-trace.json", "json",
+                                         "Chrome trace files (*.json)|*.json", wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+    if(filename.IsEmpty()) { return; }
+    if(!clTrace::Export(filename)) {
+        ::wxMessageBox(_("Failed to write the performance trace to:\n") + filename, "CodeLite", wxOK | wxICON_ERROR);
+    }
+}
+
 void clMainFrame::OnCloseTabsToTheRight(wxCommandEvent& e)
 {
     wxUnusedVar(e);
@@ -420,6 +420,9 @@ protected:
     void OnAbout(wxCommandEvent& event);
     void OnCheckForUpdate(wxCommandEvent& e);
     void OnRunSetupWizard(wxCommandEvent& e);
+    void OnTraceRecord(wxCommandEvent& e);
+    void OnTraceRecordUI(wxUpdateUIEvent& e);
+    void OnTraceExport(wxCommandEvent& e);
     void OnFileNew(wxCommandEvent& event);
     void OnFileOpen(wxCommandEvent& event);
     void OnFileOpenFolder(wxCommandEvent& event);
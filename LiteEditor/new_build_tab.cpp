@@ -23,6 +23,7 @@
 //////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////
 
+#include "BuildOutputClassifier.h"
 #include "BuildTabTopPanel.h"
 #include "ColoursAndFontsManager.h"
 #include "Notebook.h"
@@ -89,6 +90,26 @@ typedef std::map<int, AnnotationInfo> AnnotationInfoByLineMap_t;
 
 #define LEX_GCC_MARKER 1
 
+// The lines kept in the view (the complete output goes to a log file beyond that) and how often it is updated
+#define BUILD_OUTPUT_MAX_LINES 100000
+#define BUILD_OUTPUT_FLUSH_INTERVAL 100
+
+static int GetStyleForSeverity(LINE_SEVERITY severity)
+{
+    switch(severity) {
+    case SV_WARNING:
+        return LEX_GCC_WARNING;
+    case SV_ERROR:
+        return LEX_GCC_ERROR;
+    case SV_DIR_CHANGE:
+        return LEX_GCC_INFO;
+    case SV_SUCCESS:
+    case SV_NONE:
+    default:
+        return LEX_GCC_DEFAULT;
+    }
+}
+
 NewBuildTab::NewBuildTab(wxWindow* parent)
     : wxPanel(parent)
     , m_warnCount(0)
@@ -100,7 +121,6 @@ NewBuildTab::NewBuildTab(wxWindow* parent)
     , m_buildpaneScrollTo(ScrollToFirstError)
     , m_buildInProgress(false)
     , m_maxlineWidth(wxNOT_FOUND)
-    , m_lastLineColoured(wxNOT_FOUND)
 {
     SetSize(wxNOT_FOUND, 400);
     m_curError = m_errorsAndWarningsList.end();
@@ -110,7 +130,14 @@ NewBuildTab::NewBuildTab(wxWindow* parent)
     m_view = new wxStyledTextCtrl(this, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxBORDER_NONE);
     // We dont really want to collect undo in the output tabs...
     InitView();
-    Bind(wxEVT_IDLE, &NewBuildTab::OnIdle, this);
+
+    // The output is classified in a worker thread and appended to the view in batches
+    m_buffer = new OutputViewBuffer(m_view, "build-output",
+                                    clConfig::Get().Read(kConfigBuildOutputMaxLines, BUILD_OUTPUT_MAX_LINES),
+                                    BUILD_OUTPUT_FLUSH_INTERVAL);
+    m_buffer->SetFlushCallback([this](const OutputViewBuffer::FlushInfo& info) { OnViewFlushed(info); });
+    m_classifier = new BuildOutputClassifier(
+        [this](BuildOutputBatch::Ptr_t batch) { CallAfter(&NewBuildTab::OnOutputClassified, batch); });
 
     m_view->Bind(wxEVT_STC_HOTSPOT_CLICK, &NewBuildTab::OnHotspotClicked, this);
     EventNotifier::Get()->Bind(wxEVT_CL_THEME_CHANGED, &NewBuildTab::OnThemeChanged, this);
@@ -142,6 +169,8 @@ NewBuildTab::NewBuildTab(wxWindow* parent)
 
 NewBuildTab::~NewBuildTab()
 {
+    wxDELETE(m_classifier);
+    wxDELETE(m_buffer);
     EventNotifier::Get()->Unbind(wxEVT_CL_THEME_CHANGED, &NewBuildTab::OnThemeChanged, this);
     EventNotifier::Get()->Disconnect(wxEVT_SHELL_COMMAND_STARTED, clCommandEventHandler(NewBuildTab::OnBuildStarted),
                                      NULL, this);
@@ -163,8 +192,12 @@ void NewBuildTab::OnBuildEnded(clCommandEvent& e)
     CL_DEBUG("Build Ended!");
     m_buildInProgress = false;
 
-    DoProcessOutput(true, false);
+    // The build is reported as ended once its last lines were classified
+    m_classifier->EndBuild();
+}
 
+void NewBuildTab::DoBuildEnded()
+{
     std::vector<clEditor*> editors;
     clMainFrame::Get()->GetMainBook()->GetAllEditors(editors, MainBook::kGetAll_Default);
     for(size_t i = 0; i < editors.size(); i++) {
@@ -183,15 +216,21 @@ void NewBuildTab::OnBuildEnded(clCommandEvent& e)
         term << wxString::Format(wxT(", %s: %02ld:%02ld:%02ld %s"), _("total time"), hours, minutes, sec, _("seconds"));
     }
 
-    m_output = term;
-    DoProcessOutput(true, true);
-
+    wxArrayString summaryLines;
+    summaryLines.Add("====" + term + "====");
     if(m_buildInterrupted) {
-        wxString InterruptedMsg;
-        InterruptedMsg << _("(Build Cancelled)") << wxT("\n\n");
-        m_output = InterruptedMsg;
-        DoProcessOutput(true, false);
+        summaryLines.Add(_("(Build Cancelled)"));
+        summaryLines.Add("");
+    }
+
+    BuildOutputBatch summary;
+    for(size_t i = 0; i < summaryLines.size(); ++i) {
+        BuildOutputLine line;
+        line.text = summaryLines.Item(i);
+        summary.lines.push_back(line);
     }
+    DoAppendLines(summary);
+    m_buffer->Flush();
 
     // Hide / Show the build tab according to the settings
     DoToggleWindow();
@@ -246,11 +285,10 @@ void NewBuildTab::OnBuildStarted(clCommandEvent& e)
     m_autoHide = m_buildTabSettings.GetAutoHide();
     m_showMe = (BuildTabSettingsData::ShowBuildPane)m_buildTabSettings.GetShowBuildPane();
     m_skipWarnings = m_buildTabSettings.GetSkipWarnings();
+    m_buffer->SetMaxLines(clConfig::Get().Read(kConfigBuildOutputMaxLines, BUILD_OUTPUT_MAX_LINES));
 
-    if(e.GetEventType() != wxEVT_SHELL_COMMAND_STARTED_NOCLEAN) {
-        DoClear();
-        DoCacheRegexes();
-    }
+    bool clean = e.GetEventType() != wxEVT_SHELL_COMMAND_STARTED_NOCLEAN;
+    if(clean) { DoClear(); }
 
     // Show the tab if needed
     OutputPane* opane = clMainFrame::Get()->GetOutputPane();
@@ -282,102 +320,128 @@ void NewBuildTab::OnBuildStarted(clCommandEvent& e)
         buildEvent.SetConfigurationName(bed->GetConfiguration());
         EventNotifier::Get()->AddPendingEvent(buildEvent);
     }
+    m_classifier->StartBuild(m_cmp, m_cygwinRoot, clean);
 }
 
 void NewBuildTab::OnBuildAddLine(clCommandEvent& e)
 {
     e.Skip(); // Always call skip..
-    m_output << e.GetString();
-    DoProcessOutput(false, false);
+    m_classifier->AddText(e.GetString());
 }
 
-BuildLineInfo* NewBuildTab::DoProcessLine(const wxString& line)
+void NewBuildTab::OnOutputClassified(std::shared_ptr<BuildOutputBatch> batch)
 {
-    BuildLineInfo* buildLineInfo = new BuildLineInfo();
-    LINE_SEVERITY severity;
-    // Get the matching regex for this line
-    CmpPatternPtr cmpPatterPtr = GetMatchingRegex(line, severity);
-    buildLineInfo->SetSeverity(severity);
-    BuildLineInfo bli;
-    if(cmpPatterPtr && cmpPatterPtr->Matches(line, bli)) {
-        buildLineInfo->SetFilename(bli.GetFilename());
-        buildLineInfo->SetSeverity(bli.GetSeverity());
-        buildLineInfo->SetLineNumber(bli.GetLineNumber());
-        buildLineInfo->NormalizeFilename(m_directories, m_cygwinRoot);
-        buildLineInfo->SetRegexLineMatch(bli.GetRegexLineMatch());
-        buildLineInfo->SetColumn(bli.GetColumn());
-        if(severity == SV_WARNING) {
-            // Warning
-            m_errorsAndWarningsList.push_back(buildLineInfo);
+    if(batch->generation != m_classifier->GetGeneration()) {
+        // The view was cleared since these lines were produced. Still let the plugins know that the build ended
+        if(batch->buildEnded) {
+            clBuildEvent buildEvent(wxEVT_BUILD_ENDED);
+            buildEvent.SetErrorCount(batch->errorCount);
+            buildEvent.SetWarningCount(batch->warningCount);
+            EventNotifier::Get()->AddPendingEvent(buildEvent);
+        }
+        return;
+    }
+
+    DoAppendLines(*batch);
+    if(batch->buildEnded) { DoBuildEnded(); }
+}
+
+void NewBuildTab::DoAppendLines(BuildOutputBatch& batch)
+{
+    if(batch.lines.empty()) { return; }
+
+    size_t longest = 0;
+    for(size_t i = 0; i < batch.lines.size(); ++i) {
+        BuildOutputLine& line = batch.lines[i];
+        size_t sequence = m_buffer->Add(line.text + "\n", GetStyleForSeverity(line.severity));
+        if(line.text.length() > batch.lines[longest].text.length()) { longest = i; }
+        // The view is styled again when its lexer is reset, and these lines have no line info to tell their style
+        if(line.severity == SV_DIR_CHANGE) { m_pendingInfoLines.push_back(sequence); }
+
+        // Only the warnings and errors have a line info. Their line in the view is known once it is flushed
+        if(!line.info) { continue; }
+
+        // We own the line info from now on
+        BuildLineInfo* buildLineInfo = line.info;
+        line.info = nullptr;
+
+        if(buildLineInfo->GetFilename().IsEmpty() == false) {
+            m_buildInfoPerFile.insert(std::make_pair(buildLineInfo->GetFilename(), buildLineInfo));
+        }
+        m_errorsAndWarningsList.push_back(buildLineInfo);
+        if(buildLineInfo->GetSeverity() == SV_WARNING) {
             m_warnCount++;
         } else {
-            // Error
-            m_errorsAndWarningsList.push_back(buildLineInfo);
             m_errorsList.push_back(buildLineInfo);
             m_errorCount++;
         }
+        m_pendingLines.push_back(std::make_pair(sequence, buildLineInfo));
     }
-    return buildLineInfo;
+
+    int curLen = m_view->TextWidth(LEX_GCC_DEFAULT, batch.lines[longest].text) + 10;
+    m_maxlineWidth = wxMax(m_maxlineWidth, curLen);
+    if(m_maxlineWidth > 0) { m_view->SetScrollWidth(m_maxlineWidth); }
 }
 
-void NewBuildTab::DoCacheRegexes()
+void NewBuildTab::OnViewFlushed(const OutputViewBuffer::FlushInfo& info)
 {
-    m_cmpPatterns.clear();
-
-    // Loop over all known compilers and cache the regular expressions
-    BuildSettingsConfigCookie cookie;
-    CompilerPtr cmp = BuildSettingsConfigST::Get()->GetFirstCompiler(cookie);
-    while(cmp) {
-        CmpPatterns cmpPatterns;
-        const Compiler::CmpListInfoPattern& errPatterns = cmp->GetErrPatterns();
-        const Compiler::CmpListInfoPattern& warnPatterns = cmp->GetWarnPatterns();
-        Compiler::CmpListInfoPattern::const_iterator iter;
-        for(iter = errPatterns.begin(); iter != errPatterns.end(); iter++) {
-
-            CmpPatternPtr compiledPatternPtr(new CmpPattern(new wxRegEx(iter->pattern, wxRE_ADVANCED | wxRE_ICASE),
-                                                            iter->fileNameIndex, iter->lineNumberIndex,
-                                                            iter->columnIndex, SV_ERROR));
-            if(compiledPatternPtr->GetRegex()->IsValid()) { cmpPatterns.errorsPatterns.push_back(compiledPatternPtr); }
+    if(info.linesRemoved > 0) {
+        // Lines were removed from the top of the view
+        std::map<int, BuildLineInfo*> viewData;
+        for(const std::pair<int, BuildLineInfo*>& p : m_viewData) {
+            int line = info.GetMovedLine(p.first);
+            p.second->SetLineInBuildTab(line);
+            if(line != wxNOT_FOUND) { viewData.insert(std::make_pair(line, p.second)); }
         }
+        m_viewData.swap(viewData);
 
-        for(iter = warnPatterns.begin(); iter != warnPatterns.end(); iter++) {
-
-            CmpPatternPtr compiledPatternPtr(new CmpPattern(new wxRegEx(iter->pattern, wxRE_ADVANCED | wxRE_ICASE),
-                                                            iter->fileNameIndex, iter->lineNumberIndex,
-                                                            iter->columnIndex, SV_WARNING));
-            if(compiledPatternPtr->GetRegex()->IsValid()) { cmpPatterns.warningPatterns.push_back(compiledPatternPtr); }
+        std::set<int> infoLines;
+        for(int line : m_infoLines) {
+            line = info.GetMovedLine(line);
+            if(line != wxNOT_FOUND) { infoLines.insert(line); }
         }
+        m_infoLines.swap(infoLines);
+    }
 
-        m_cmpPatterns.insert(std::make_pair(cmp->GetName(), cmpPatterns));
-        cmp = BuildSettingsConfigST::Get()->GetNextCompiler(cookie);
+    for(const std::pair<size_t, BuildLineInfo*>& p : m_pendingLines) {
+        // The line may have been dropped before it reached the view
+        int line = info.GetLine(p.first);
+        p.second->SetLineInBuildTab(line);
+        if(line != wxNOT_FOUND) { m_viewData.insert(std::make_pair(line, p.second)); }
     }
-}
+    m_pendingLines.clear();
 
-bool NewBuildTab::DoGetCompilerPatterns(const wxString& compilerName, CmpPatterns& patterns)
-{
-    MapCmpPatterns_t::iterator iter = m_cmpPatterns.find(compilerName);
-    if(iter == m_cmpPatterns.end()) { return false; }
-    patterns = iter->second;
-    return true;
+    for(size_t sequence : m_pendingInfoLines) {
+        int line = info.GetLine(sequence);
+        if(line != wxNOT_FOUND) { m_infoLines.insert(line); }
+    }
+    m_pendingInfoLines.clear();
+
+    if(clConfig::Get().Read(kConfigBuildAutoScroll, true)) { m_view->ScrollToEnd(); }
 }
 
 void NewBuildTab::DoClear()
 {
     wxFont font = DoGetFont();
-    m_lastLineColoured = wxNOT_FOUND;
     m_maxlineWidth = wxNOT_FOUND;
     m_buildInterrupted = false;
-    m_directories.Clear();
     m_buildInfoPerFile.clear();
     m_warnCount = 0;
     m_errorCount = 0;
-    m_errorsAndWarningsList.clear();
-    m_errorsList.clear();
-    m_cmpPatterns.clear();
+
+    // Lines classified before this point must not be added to the view
+    m_classifier->Discard();
+    m_buffer->Clear();
 
     // Delete all the user data
-    std::for_each(m_viewData.begin(), m_viewData.end(), [&](std::pair<int, BuildLineInfo*> p) { delete p.second; });
+    std::for_each(m_errorsAndWarningsList.begin(), m_errorsAndWarningsList.end(),
+                  [&](BuildLineInfo* bli) { delete bli; });
+    m_errorsAndWarningsList.clear();
+    m_errorsList.clear();
     m_viewData.clear();
+    m_pendingLines.clear();
+    m_infoLines.clear();
+    m_pendingInfoLines.clear();
 
     m_view->SetEditable(true);
     m_view->ClearAll();
@@ -425,7 +489,8 @@ void NewBuildTab::MarkEditor(clEditor* editor)
 
     for(; iter.first != iter.second; ++iter.first) {
         BuildLineInfo* bli = iter.first->second;
-        wxString text = m_view->GetLine(bli->GetLineInBuildTab()).Trim().Trim(false);
+        wxString text = bli->GetLineText();
+        text.Trim().Trim(false);
 
         // remove the line part from the text
         text = text.Mid(bli->GetRegexLineMatch());
@@ -479,25 +544,6 @@ void NewBuildTab::MarkEditor(clEditor* editor)
     editor->Refresh();
 }
 
-void NewBuildTab::DoSearchForDirectory(const wxString& line)
-{
-    // Check for makefile directory changes lines
-    if(line.Contains(wxT("Entering directory `"))) {
-        wxString currentDir = line.AfterFirst(wxT('`'));
-        currentDir = currentDir.BeforeLast(wxT('\''));
-
-        // Collect the m_baseDir
-        m_directories.Add(currentDir);
-
-    } else if(line.Contains(wxT("Entering directory '"))) {
-        wxString currentDir = line.AfterFirst(wxT('\''));
-        currentDir = currentDir.BeforeLast(wxT('\''));
-
-        // Collect the m_baseDir
-        m_directories.Add(currentDir);
-    }
-}
-
 void NewBuildTab::OnWorkspaceClosed(wxCommandEvent& e)
 {
     e.Skip();
@@ -512,75 +558,9 @@ void NewBuildTab::OnWorkspaceLoaded(wxCommandEvent& e)
     InitView();
 }
 
-void NewBuildTab::DoProcessOutput(bool compilationEnded, bool isSummaryLine)
-{
-    wxUnusedVar(isSummaryLine);
-    if(!compilationEnded && m_output.Find(wxT("\n")) == wxNOT_FOUND) {
-        // still dont have a complete line
-        return;
-    }
-
-    wxArrayString lines = ::wxStringTokenize(m_output, wxT("\n"), wxTOKEN_RET_DELIMS);
-    m_output.Clear();
-
-    // Process only completed lines (i.e. a line that ends with '\n')
-    for(size_t i = 0; i < lines.GetCount(); ++i) {
-        if(!compilationEnded && !lines.Item(i).EndsWith(wxT("\n"))) {
-            m_output << lines.Item(i);
-            return;
-        }
-
-        wxString buildLine = lines.Item(i); //.Trim().Trim(false);
-        // If this is a line similar to 'Entering directory `'
-        // add the path in the directories array
-        DoSearchForDirectory(buildLine);
-        BuildLineInfo* buildLineInfo = DoProcessLine(buildLine);
-
-        // keep the line info
-        if(buildLineInfo->GetFilename().IsEmpty() == false) {
-            m_buildInfoPerFile.insert(std::make_pair(buildLineInfo->GetFilename(), buildLineInfo));
-        }
-
-        if(isSummaryLine) {
-            buildLine.Trim();
-            buildLine.Prepend("====");
-            buildLine.Append("====");
-            buildLineInfo->SetSeverity(SV_NONE);
-        }
-
-        // Keep the line number in the build tab
-        buildLineInfo->SetLineInBuildTab(m_view->GetLineCount() - 1); // -1 because the view always has 1 extra "\n"
-        // Store the line info *before* we add the text
-        // it is needed in the OnStyle function
-        m_viewData.insert(std::make_pair(buildLineInfo->GetLineInBuildTab(), buildLineInfo));
-
-        m_view->SetEditable(true);
-        buildLine.Trim();
-        wxString modText;
-        ::clStripTerminalColouring(buildLine, modText);
-
-        int curline = m_view->GetLineCount() - 1;
-        m_view->AppendText(modText + "\n");
-
-        // get the newly added line width
-        int endPosition = m_view->GetLineEndPosition(curline); // get character position from begin
-        int beginPosition = m_view->PositionFromLine(curline); // and end of line
-
-        wxPoint beginPos = m_view->PointFromPosition(beginPosition);
-        wxPoint endPos = m_view->PointFromPosition(endPosition);
-
-        int curLen = (endPos.x - beginPos.x) + 10;
-        m_maxlineWidth = wxMax(m_maxlineWidth, curLen);
-        if(m_maxlineWidth > 0) { m_view->SetScrollWidth(m_maxlineWidth); }
-        m_view->SetEditable(false);
-
-        if(clConfig::Get().Read(kConfigBuildAutoScroll, true)) { m_view->ScrollToEnd(); }
-    }
-}
-
 void NewBuildTab::CenterLineInView(int line)
 {
-    if(line > m_view->GetLineCount()) return;
+    if(line < 0 || line > m_view->GetLineCount()) return;
     int linesOnScreen = m_view->LinesOnScreen();
     // To place our line in the middle, the first visible line should be
     // the: line - (linesOnScreen / 2)
@@ -648,9 +628,10 @@ void NewBuildTab::OnNextBuildError(wxCommandEvent& e)
             if((*m_curError)->GetSeverity() == SV_ERROR) {
                 // get the wxDataViewItem
                 int line = (*m_curError)->GetLineInBuildTab();
+                ++m_curError;
+                // The line may no longer be in the view
                 if(IS_VALID_LINE(line)) {
                     DoSelectAndOpen(line, true);
-                    ++m_curError;
                     return;
                 }
 
@@ -662,10 +643,8 @@ void NewBuildTab::OnNextBuildError(wxCommandEvent& e)
 
     } else {
         int line = (*m_curError)->GetLineInBuildTab();
-        if(IS_VALID_LINE(line)) {
-            DoSelectAndOpen(line, true);
-            ++m_curError;
-        }
+        ++m_curError;
+        if(IS_VALID_LINE(line)) { DoSelectAndOpen(line, true); }
     }
 }
 
@@ -755,7 +734,7 @@ bool NewBuildTab::DoSelectAndOpen(int buildViewLine, bool centerLine)
     return false;
 }
 
-wxString NewBuildTab::GetBuildContent() const { return m_view->GetText(); }
+wxString NewBuildTab::GetBuildContent() { return m_buffer->GetContent(); }
 
 wxFont NewBuildTab::DoGetFont() const
 {
@@ -796,11 +775,7 @@ void NewBuildTab::OnClearUI(wxUpdateUIEvent& e) { e.Enable(!m_buildInProgress &&
 
 void NewBuildTab::ScrollToBottom() { m_view->ScrollToEnd(); }
 
-void NewBuildTab::AppendLine(const wxString& text)
-{
-    m_output << text;
-    DoProcessOutput(false, false);
-}
+void NewBuildTab::AppendLine(const wxString& text) { m_classifier->AddText(text); }
 
 void NewBuildTab::OnStyleNeeded(wxStyledTextEvent& event)
 {
@@ -823,29 +798,13 @@ void NewBuildTab::OnStyleNeeded(wxStyledTextEvent& event)
 
     for(size_t i = 0; i < lines.size(); ++i) {
         const wxString& strLine = lines.Item(i);
+        int style = LEX_GCC_DEFAULT;
         if(m_viewData.count(curline)) {
-            BuildLineInfo* b = m_viewData.find(curline)->second;
-            switch(b->GetSeverity()) {
-            case SV_WARNING:
-                m_view->SetStyling(strLine.length(), LEX_GCC_WARNING);
-                break;
-            case SV_ERROR:
-                m_view->SetStyling(strLine.length(), LEX_GCC_ERROR);
-                break;
-            case SV_SUCCESS:
-                m_view->SetStyling(strLine.length(), LEX_GCC_DEFAULT);
-                break;
-            case SV_DIR_CHANGE:
-                m_view->SetStyling(strLine.length(), LEX_GCC_INFO);
-                break;
-            case SV_NONE:
-            default:
-                m_view->SetStyling(strLine.length(), LEX_GCC_DEFAULT);
-                break;
-            }
-        } else {
-            m_view->SetStyling(strLine.length(), LEX_GCC_DEFAULT);
+            style = GetStyleForSeverity(m_viewData.find(curline)->second->GetSeverity());
+        } else if(m_infoLines.count(curline)) {
+            style = LEX_GCC_INFO;
         }
+        m_view->SetStyling(strLine.length(), style);
         ++curline;
     }
 }
@@ -937,109 +896,6 @@ void NewBuildTab::DoCentreErrorLine(BuildLineInfo* bli, clEditor* editor, bool c
     SetActive(editor);
 }
 
-void NewBuildTab::ColourOutput()
-{
-    // Loop over the lines and colour them
-    int fromLine = (m_lastLineColoured == wxNOT_FOUND) ? 0 : m_lastLineColoured;
-    int untilLine = (m_view->GetLineCount() - 1);
-
-    if(fromLine == untilLine) { return; }
-
-    for(int i = fromLine; (i < untilLine) && (untilLine >= fromLine); ++i) {
-        int startPos = m_view->PositionFromLine(i);
-        int lineEndPos = m_view->GetLineEndPosition(i);
-
-#if wxCHECK_VERSION(3, 1, 1) && !defined(__WXOSX__)
-        // The scintilla syntax in e.g. wx3.1.1 changed
-        m_view->StartStyling(startPos);
-#else
-        m_view->StartStyling(startPos, 0x1f);
-#endif
-
-        // Run the regexes
-        wxString lineText = m_view->GetLine(i);
-        LINE_SEVERITY severity;
-        GetMatchingRegex(lineText, severity);
-        switch(severity) {
-        case SV_WARNING:
-            m_view->SetStyling((lineEndPos - startPos), LEX_GCC_WARNING);
-            break;
-        case SV_ERROR:
-            m_view->SetStyling((lineEndPos - startPos), LEX_GCC_ERROR);
-            break;
-        case SV_SUCCESS:
-            m_view->SetStyling((lineEndPos - startPos), LEX_GCC_DEFAULT);
-            break;
-        case SV_DIR_CHANGE:
-            m_view->SetStyling((lineEndPos - startPos), LEX_GCC_INFO);
-            break;
-        case SV_NONE:
-        default:
-            m_view->SetStyling((lineEndPos - startPos), LEX_GCC_DEFAULT);
-            break;
-        }
-    }
-    m_lastLineColoured = untilLine;
-}
-
-CmpPatternPtr NewBuildTab::GetMatchingRegex(const wxString& lineText, LINE_SEVERITY& severity)
-{
-    if(lineText.Lower().Contains("entering directory") || lineText.Lower().Contains("leaving directory")) {
-        severity = SV_DIR_CHANGE;
-        return NULL;
-
-    } else if(lineText.StartsWith("====")) {
-        severity = SV_NONE;
-        return NULL;
-
-    } else {
-
-        // Find *warnings* first
-        bool isWarning = false;
-
-        if(!m_cmp) {
-            severity = SV_NONE;
-            return NULL;
-        }
-
-        CmpPatterns cmpPatterns;
-        if(!DoGetCompilerPatterns(m_cmp->GetName(), cmpPatterns)) {
-            severity = SV_NONE;
-            return NULL;
-        }
-
-        // If it is not an error, maybe it's a warning
-        for(size_t i = 0; i < cmpPatterns.warningPatterns.size(); i++) {
-            CmpPatternPtr cmpPatterPtr = cmpPatterns.warningPatterns.at(i);
-            BuildLineInfo bli;
-            if(cmpPatterPtr->Matches(lineText, bli)) {
-                severity = SV_WARNING;
-                return cmpPatterPtr;
-            }
-        }
-        if(!isWarning) {
-            for(size_t i = 0; i < cmpPatterns.errorsPatterns.size(); i++) {
-                BuildLineInfo bli;
-                CmpPatternPtr cmpPatterPtr = cmpPatterns.errorsPatterns.at(i);
-                if(cmpPatterPtr->Matches(lineText, bli)) {
-                    severity = SV_ERROR;
-                    return cmpPatterPtr;
-                }
-            }
-        }
-    }
-
-    // Default
-    severity = SV_NONE;
-    return NULL;
-}
-
-void NewBuildTab::OnIdle(wxIdleEvent& event)
-{
-    if(m_view->IsEmpty()) { return; }
-    ColourOutput();
-}
-
 ////////////////////////////////////////////
 // CmpPatter
 
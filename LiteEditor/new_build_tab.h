@@ -36,8 +36,11 @@
 #include "buildtabsettingsdata.h"
 #include "compiler.h"
 #include <map>
+#include <memory>
+#include <set>
 #include <wx/regex.h>
 #include "cl_command_event.h"
+#include "OutputViewBuffer.h"
 #include <wx/stc/stc.h>
 
 class wxDataViewListCtrl;
@@ -62,6 +65,7 @@ protected:
     LINE_SEVERITY m_severity;
     int m_lineInBuildTab;
     int m_regexLineMatch;
+    wxString m_lineText;
 
 public:
     BuildLineInfo()
@@ -91,6 +95,12 @@ public:
     LINE_SEVERITY GetSeverity() const { return m_severity; }
     void SetLineInBuildTab(int lineInBuildTab) { this->m_lineInBuildTab = lineInBuildTab; }
     int GetLineInBuildTab() const { return m_lineInBuildTab; }
+    /**
+     * @brief the line as displayed in the build tab. Kept for warnings and errors only: their line may no
+     * longer be in the build tab
+     */
+    void SetLineText(const wxString& lineText) { this->m_lineText = lineText; }
+    const wxString& GetLineText() const { return m_lineText; }
 };
 
 /////////////////////////////////////////////////////////////////
@@ -135,27 +145,25 @@ public:
 };
 typedef SmartPtr<CmpPattern> CmpPatternPtr;
 
-//////////////////////////////////////////////////////////////////
-
-struct CmpPatterns {
-    std::vector<CmpPatternPtr> errorsPatterns;
-    std::vector<CmpPatternPtr> warningPatterns;
-};
-
 ///////////////////////////////////////////////////////////////////
 class clEditor;
+class BuildOutputClassifier;
+struct BuildOutputBatch;
 class NewBuildTab : public wxPanel
 {
     enum BuildpaneScrollTo { ScrollToFirstError, ScrollToFirstItem, ScrollToEnd };
 
-    typedef std::map<wxString, CmpPatterns> MapCmpPatterns_t;
     typedef std::multimap<wxString, BuildLineInfo*> MultimapBuildInfo_t;
     typedef std::list<BuildLineInfo*> BuildInfoList_t;
 
-    wxString m_output;
     wxStyledTextCtrl* m_view;
     CompilerPtr m_cmp;
-    MapCmpPatterns_t m_cmpPatterns;
+    BuildOutputClassifier* m_classifier;
+    OutputViewBuffer* m_buffer;
+    // The warnings and errors of the lines that were not written to the view yet, by line sequence number
+    std::vector<std::pair<size_t, BuildLineInfo*> > m_pendingLines;
+    // The same for the lines styled as information (e.g. "Entering directory")
+    std::vector<size_t> m_pendingInfoLines;
     int m_warnCount;
     int m_errorCount;
     BuildTabSettingsData m_buildTabSettings;
@@ -164,7 +172,6 @@ class NewBuildTab : public wxPanel
     BuildTabSettingsData::ShowBuildPane m_showMe;
     wxStopWatch m_sw;
     MultimapBuildInfo_t m_buildInfoPerFile;
-    wxArrayString m_directories;
     bool m_skipWarnings;
     BuildpaneScrollTo m_buildpaneScrollTo;
     BuildInfoList_t m_errorsAndWarningsList;
@@ -172,26 +179,21 @@ class NewBuildTab : public wxPanel
     BuildInfoList_t::iterator m_curError;
     bool m_buildInProgress;
     wxString m_cygwinRoot;
-    std::map<int, BuildLineInfo*> m_viewData;
+    std::map<int, BuildLineInfo*> m_viewData; // the warnings and errors displayed in the view
+    std::set<int> m_infoLines;                // the lines of the view styled as information
     int m_maxlineWidth;
-    int m_lastLineColoured;
 
 protected:
     void InitView(const wxString& theme = "");
     void CenterLineInView(int line);
-    void DoCacheRegexes();
-    BuildLineInfo* DoProcessLine(const wxString& line);
-    void DoProcessOutput(bool compilationEnded, bool isSummaryLine);
-    void DoSearchForDirectory(const wxString& line);
-    bool DoGetCompilerPatterns(const wxString& compilerName, CmpPatterns& patterns);
+    void DoAppendLines(BuildOutputBatch& batch);
+    void DoBuildEnded();
     void DoClear();
     void MarkEditor(clEditor* editor);
     void DoToggleWindow();
     bool DoSelectAndOpen(int buildViewLine, bool centerLine);
     wxFont DoGetFont() const;
     void DoCentreErrorLine(BuildLineInfo* bli, clEditor* editor, bool centerLine);
-    void ColourOutput();
-    CmpPatternPtr GetMatchingRegex(const wxString& lineText, LINE_SEVERITY& severity);
 
 public:
     NewBuildTab(wxWindow* parent);
@@ -207,7 +209,10 @@ public:
 
     void Clear() { DoClear(); }
 
-    wxString GetBuildContent() const;
+    /**
+     * @brief return the complete build output, including the lines that no longer fit in the view
+     */
+    wxString GetBuildContent();
     void AppendLine(const wxString& text);
 
 protected:
@@ -226,7 +231,8 @@ protected:
     void OnClearUI(wxUpdateUIEvent& e);
     void OnStyleNeeded(wxStyledTextEvent& event);
     void OnHotspotClicked(wxStyledTextEvent& event);
-    void OnIdle(wxIdleEvent& event);
+    void OnOutputClassified(std::shared_ptr<BuildOutputBatch> batch);
+    void OnViewFlushed(const OutputViewBuffer::FlushInfo& info);
 };
 
 #endif // NEWBUILDTAB_H
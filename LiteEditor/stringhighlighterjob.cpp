@@ -22,46 +22,95 @@
 //
 //////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////
-#include "search_thread.h"
 #include "stringhighlighterjob.h"
-#include "stringsearcher.h"
-#include <vector>
+#include <algorithm>
+#include <string.h>
 
-StringHighlighterJob::StringHighlighterJob(const wxString& str, const wxString& word, int offset)
-    : m_str(str)
-    , m_word(word)
-    , m_offset(offset)
+// Cancelling is checked and the matches are reported after each chunk
+#define HIGHLIGHT_CHUNK_SIZE (1024 * 1024)
+
+namespace
+{
+// Same as StringFindReplacer: non ASCII characters are not part of a word
+inline bool IsWordChar(char ch)
 {
+    return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') || ch == '_';
 }
+} // namespace
 
-StringHighlighterJob::~StringHighlighterJob() {}
-
-void StringHighlighterJob::Set(const wxString& str, const wxString& word, int offset)
+StringHighlighterJob::StringHighlighterJob()
+    : m_skipFrom(0)
+    , m_skipTo(0)
+    , m_thread(nullptr)
+    , m_cancelled(false)
 {
-    SetStr(str);
-    SetWord(word);
-    SetOffset(offset);
 }
 
-void StringHighlighterJob::Process()
+StringHighlighterJob::~StringHighlighterJob() { Cancel(); }
+
+void StringHighlighterJob::Search(const char* buffer, size_t length, size_t from, size_t to, const std::string& word,
+                                  int offset, Matches_t& matches)
 {
-    if(m_str.IsEmpty() || m_word.IsEmpty()) { return; }
+    const size_t wordLen = word.length();
+    if(wordLen == 0 || wordLen > length) { return; }
+    // A match can not start after this position
+    to = std::min(to, length - wordLen + 1);
+
+    size_t pos = from;
+    while(pos < to) {
+        const char* p = (const char*)memchr(buffer + pos, word[0], to - pos);
+        if(!p) { break; }
+        pos = p - buffer;
+        if(memcmp(p, word.c_str(), wordLen) == 0 && (pos == 0 || !IsWordChar(buffer[pos - 1])) &&
+           (pos + wordLen == length || !IsWordChar(buffer[pos + wordLen]))) {
+            matches.push_back({ offset + (int)pos, (int)wordLen });
+            pos += wordLen;
+        } else {
+            ++pos;
+        }
+    }
+}
 
-    int pos(0);
-    int match_len(0);
+void StringHighlighterJob::Start(std::string&& buffer, const std::string& word, size_t skipFrom, size_t skipTo,
+                                 const Callback_t& callback)
+{
+    Cancel();
+    m_buffer.swap(buffer);
+    m_word = word;
+    m_skipFrom = std::min(skipFrom, m_buffer.length());
+    m_skipTo = std::max(m_skipFrom, std::min(skipTo, m_buffer.length()));
+    m_callback = callback;
+    m_cancelled.store(false);
+    m_thread = new std::thread(&StringHighlighterJob::Process, this);
+}
 
-    // remove reverse search
-    int offset(0);
+void StringHighlighterJob::Cancel()
+{
+    if(!m_thread) { return; }
+    m_cancelled.store(true);
+    m_thread->join();
+    delete m_thread;
+    m_thread = nullptr;
+    // Release the snapshot
+    std::string().swap(m_buffer);
+    m_callback = nullptr;
+}
 
-    const wchar_t* pin = m_str.c_str().AsWChar();
-    const wchar_t* pwo = m_word.c_str().AsWChar();
+void StringHighlighterJob::Process()
+{
+    // Below the visible lines first, then wrap to the top
+    ProcessRange(m_skipTo, m_buffer.length());
+    ProcessRange(0, m_skipFrom);
+}
 
-    while(StringFindReplacer::Search(pin, offset, pwo, wxSD_MATCHCASE | wxSD_MATCHWHOLEWORD, pos, match_len)) {
-        // add result pair(offset, len)
-        std::pair<int, int> match;
-        match.first = pos + m_offset; // add the offset
-        match.second = match_len;
-        m_output.matches.push_back(match);
-        offset = pos + match_len;
+void StringHighlighterJob::ProcessRange(size_t from, size_t to)
+{
+    Matches_t matches;
+    while(from < to && !m_cancelled.load()) {
+        size_t chunkEnd = std::min(to, from + HIGHLIGHT_CHUNK_SIZE);
+        matches.clear();
+        Search(m_buffer.c_str(), m_buffer.length(), from, chunkEnd, m_word, 0, matches);
+        if(!matches.empty() && !m_cancelled.load()) { m_callback(matches); }
+        from = chunkEnd;
     }
 }
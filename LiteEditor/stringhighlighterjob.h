@@ -25,43 +25,62 @@
 #ifndef __stringhighlighterjob__
 #define __stringhighlighterjob__
 
-#include "job.h"
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
 #include <vector>
 
-struct StringHighlightOutput {
-    wxString filename;
-    std::vector<std::pair<int, int> > matches;
-
-    StringHighlightOutput()
-        : filename(wxT(""))
-    {
-    }
-
-    ~StringHighlightOutput() {}
-};
-
+/**
+ * @brief find the whole word, case sensitive, occurrences of a word in the editor text.
+ * The text is searched as UTF-8 bytes (the way Scintilla stores it) so the matches are editor positions.
+ * Start() searches a snapshot of the text in a worker thread and reports the matches a chunk at a time,
+ * this way the editor can highlight the visible lines first and fill the rest as the matches arrive
+ */
 class StringHighlighterJob
 {
-    wxString m_str;
-    wxString m_word;
-    int m_offset;
-    StringHighlightOutput m_output;
+public:
+    // pair of (position, length)
+    typedef std::vector<std::pair<int, int> > Matches_t;
+    // Called from the worker thread
+    typedef std::function<void(const Matches_t& matches)> Callback_t;
+
+protected:
+    std::string m_buffer;
+    std::string m_word;
+    size_t m_skipFrom;
+    size_t m_skipTo;
+    Callback_t m_callback;
+    std::thread* m_thread;
+    std::atomic_bool m_cancelled;
+
+protected:
+    void Process();
+    void ProcessRange(size_t from, size_t to);
 
 public:
-    StringHighlighterJob() {}
-    StringHighlighterJob(const wxString& str, const wxString& word, int offset);
-    void Set(const wxString& str, const wxString& word, int offset);
+    StringHighlighterJob();
     virtual ~StringHighlighterJob();
 
-    void SetOffset(int offset) { this->m_offset = offset; }
-    void SetStr(const wxString& str) { this->m_str = str; }
-    void SetWord(const wxString& word) { this->m_word = word; }
-    int GetOffset() const { return m_offset; }
-    const StringHighlightOutput& GetOutput() const { return m_output; }
-    const wxString& GetStr() const { return m_str; }
-    const wxString& GetWord() const { return m_word; }
+    /**
+     * @brief search the matches of 'word' that start in [from, to) of 'buffer'. The bytes outside of this
+     * range are only used to check that the match is a whole word. The matches positions are relative
+     * to 'offset', the editor position of buffer[0]
+     */
+    static void Search(const char* buffer, size_t length, size_t from, size_t to, const std::string& word,
+                       int offset, Matches_t& matches);
 
-public:
-    virtual void Process();
+    /**
+     * @brief search 'buffer' (the whole editor text) in the background, except for [skipFrom, skipTo)
+     * which the caller already searched. The search starts at 'skipTo' and wraps to the top of the text.
+     * Any search in progress is cancelled first
+     */
+    void Start(std::string&& buffer, const std::string& word, size_t skipFrom, size_t skipTo,
+               const Callback_t& callback);
+
+    /**
+     * @brief stop the search. The callback is not called once this function returns
+     */
+    void Cancel();
 };
 #endif // __stringhighlighterjob__
@@ -72,6 +72,18 @@ TagsOptionsBaseDlg::TagsOptionsBaseDlg(wxWindow* parent, wxWindowID id, const wx
     
     flexGridSizer12->Add(m_textCtrlFileSpec, 0, wxALL|wxEXPAND, WXC_FROM_DIP(5));
     
+    m_staticTextParserThreads = new wxStaticText(m_paneDisplayAndBehavior, wxID_ANY, _("Number of parser threads:"), wxDefaultPosition, wxDLG_UNIT(m_paneDisplayAndBehavior, wxSize(-1,-1)), 0);
+    
+    flexGridSizer12->Add(m_staticTextParserThreads, 0, wxALL, WXC_FROM_DIP(5));
+    
+    m_textCtrlParserThreads = new wxTextCtrl(m_paneDisplayAndBehavior, wxID_ANY, wxT("0"), wxDefaultPosition, wxDLG_UNIT(m_paneDisplayAndBehavior, wxSize(-1,-1)), 0);
+    m_textCtrlParserThreads->SetToolTip(_("The number of threads (and codelite_indexer processes) used to parse the files when retagging the workspace.\n0 means: the number of CPUs, up to 4"));
+    #if wxVERSION_NUMBER >= 3000
+    m_textCtrlParserThreads->SetHint(wxT(""));
+    #endif
+    
+    flexGridSizer12->Add(m_textCtrlParserThreads, 0, wxALL|wxEXPAND, WXC_FROM_DIP(5));
+    
     m_staticLine129 = new wxStaticLine(m_paneDisplayAndBehavior, wxID_ANY, wxDefaultPosition, wxDLG_UNIT(m_paneDisplayAndBehavior, wxSize(-1,-1)), wxLI_HORIZONTAL);
     
     bSizer19->Add(m_staticLine129, 0, wxALL|wxEXPAND, WXC_FROM_DIP(5));
@@ -129,6 +141,12 @@ TagsOptionsBaseDlg::TagsOptionsBaseDlg(wxWindow* parent, wxWindowID id, const wx
     
     flexGridSizer127->Add(m_checkBoxDeepUsingNamespaceResolving, 0, wxALL, WXC_FROM_DIP(5));
     
+    m_checkBoxParseInProcess = new wxCheckBox(m_paneDisplayAndBehavior, wxID_ANY, _("Parse files in-process (faster, less isolated)"), wxDefaultPosition, wxDLG_UNIT(m_paneDisplayAndBehavior, wxSize(-1, -1)), 0);
+    m_checkBoxParseInProcess->SetValue(false);
+    m_checkBoxParseInProcess->SetToolTip(_("Parse the files inside CodeLite instead of sending them to the codelite_indexer process.\nThis is faster, but a crash while parsing a file takes CodeLite down with it"));
+    
+    flexGridSizer127->Add(m_checkBoxParseInProcess, 0, wxALL, WXC_FROM_DIP(5));
+    
     m_paneColouring = new wxPanel(m_notebook87, wxID_ANY, wxDefaultPosition, wxDLG_UNIT(m_notebook87, wxSize(-1,-1)), wxTAB_TRAVERSAL);
     m_notebook87->AddPage(m_paneColouring, _("Colouring"), false);
     
@@ -59,6 +59,8 @@ protected:
     wxTextCtrl* m_spinCtrlNumberOfCCItems;
     wxStaticText* m_staticText123;
     wxTextCtrl* m_textCtrlFileSpec;
+    wxStaticText* m_staticTextParserThreads;
+    wxTextCtrl* m_textCtrlParserThreads;
     wxStaticLine* m_staticLine129;
     wxCheckBox* m_checkDisplayTypeInfo;
     wxCheckBox* m_checkBoxEnableCaseSensitiveCompletion;
@@ -68,6 +70,7 @@ protected:
     wxCheckBox* m_checkBoxretagWorkspaceOnStartup;
     wxCheckBox* m_checkDisableParseOnSave;
     wxCheckBox* m_checkBoxDeepUsingNamespaceResolving;
+    wxCheckBox* m_checkBoxParseInProcess;
     wxPanel* m_paneColouring;
     wxPropertyGridManager* m_pgMgrColouring;
     wxPGProperty* m_pgPropTrackPreProcessors;
@@ -136,6 +139,8 @@ public:
     wxTextCtrl* GetSpinCtrlNumberOfCCItems() { return m_spinCtrlNumberOfCCItems; }
     wxStaticText* GetStaticText123() { return m_staticText123; }
     wxTextCtrl* GetTextCtrlFileSpec() { return m_textCtrlFileSpec; }
+    wxStaticText* GetStaticTextParserThreads() { return m_staticTextParserThreads; }
+    wxTextCtrl* GetTextCtrlParserThreads() { return m_textCtrlParserThreads; }
     wxStaticLine* GetStaticLine129() { return m_staticLine129; }
     wxCheckBox* GetCheckDisplayTypeInfo() { return m_checkDisplayTypeInfo; }
     wxCheckBox* GetCheckBoxEnableCaseSensitiveCompletion() { return m_checkBoxEnableCaseSensitiveCompletion; }
@@ -145,6 +150,7 @@ public:
     wxCheckBox* GetCheckBoxretagWorkspaceOnStartup() { return m_checkBoxretagWorkspaceOnStartup; }
     wxCheckBox* GetCheckDisableParseOnSave() { return m_checkDisableParseOnSave; }
     wxCheckBox* GetCheckBoxDeepUsingNamespaceResolving() { return m_checkBoxDeepUsingNamespaceResolving; }
+    wxCheckBox* GetCheckBoxParseInProcess() { return m_checkBoxParseInProcess; }
     wxPanel* GetPaneDisplayAndBehavior() { return m_paneDisplayAndBehavior; }
     wxPropertyGridManager* GetPgMgrColouring() { return m_pgMgrColouring; }
     wxPanel* GetPaneColouring() { return m_paneColouring; }
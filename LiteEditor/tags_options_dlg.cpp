@@ -80,8 +80,10 @@ CodeCompletionSettingsDialog::CodeCompletionSettingsDialog(wxWindow* parent, con
                                                                                                                : false);
     m_checkBoxEnableCaseSensitiveCompletion->SetValue(m_data.GetFlags() & CC_IS_CASE_SENSITIVE ? true : false);
     m_checkBoxKeepFunctionSignature->SetValue(m_data.GetFlags() & CC_KEEP_FUNCTION_SIGNATURE_UNFORMATTED);
+    m_checkBoxParseInProcess->SetValue(m_data.GetFlags() & CC_PARSE_IN_PROCESS ? true : false);
     m_spinCtrlNumberOfCCItems->ChangeValue(::wxIntToString(m_data.GetCcNumberOfDisplayItems()));
     m_textCtrlFileSpec->ChangeValue(m_data.GetFileSpec());
+    m_textCtrlParserThreads->ChangeValue(::wxIntToString(m_data.GetParserThreads()));
 
     //------------------------------------------------------------------
     // Colouring
@@ -154,8 +156,10 @@ void CodeCompletionSettingsDialog::CopyData()
     SetFlag(CC_DISABLE_AUTO_PARSING, m_checkDisableParseOnSave->IsChecked());
     SetFlag(CC_IS_CASE_SENSITIVE, m_checkBoxEnableCaseSensitiveCompletion->IsChecked());
     SetFlag(CC_KEEP_FUNCTION_SIGNATURE_UNFORMATTED, m_checkBoxKeepFunctionSignature->IsChecked());
+    SetFlag(CC_PARSE_IN_PROCESS, m_checkBoxParseInProcess->IsChecked());
     m_data.SetCcNumberOfDisplayItems(::wxStringToInt(m_spinCtrlNumberOfCCItems->GetValue(), 100));
     m_data.SetFileSpec(m_textCtrlFileSpec->GetValue());
+    m_data.SetParserThreads(::wxStringToInt(m_textCtrlParserThreads->GetValue(), 0, 0, 256));
 
     //----------------------------------------------------
     // Colouring
@@ -8,10 +8,9 @@ CompileCommandsJSON::CompileCommandsJSON(const wxString& filename)
     if(m_filename.FileExists()) {
         JSON json(m_filename);
         JSONItem arr = json.toElement();
-        const int count = arr.arraySize();
-        for(int i = 0; i < count; ++i) {
-            wxString command = arr.arrayItem(i).namedObject("command").toString();
-            wxString workingDirectory = arr.arrayItem(i).namedObject("directory").toString();
+        for(JSONItem item : arr) {
+            wxString command = item.namedObject("command").toString();
+            wxString workingDirectory = item.namedObject("directory").toString();
             
             // Use the workingDirectory to convert all paths to full path
             CompilerCommandLineParser cclp(command, workingDirectory);
@@ -170,6 +170,7 @@ void LSPNetworkSocket::OnSocketData(clCommandEvent& event)
 {
     clCommandEvent evt(wxEVT_LSP_NET_DATA_READY);
     evt.SetString(event.GetString());
+    evt.SetStringRaw(event.GetStringRaw());
     AddPendingEvent(evt);
 }
 
@@ -10,6 +10,7 @@
 #include "LSP/DidChangeTextDocumentRequest.h"
 #include "LSP/CompletionRequest.h"
 #include "LSP/InitializeRequest.h"
+#include "LSP/CancelRequest.h"
 #include "LSP/ResponseMessage.h"
 #include "LSP/ResponseError.h"
 #include "event_notifier.h"
@@ -21,13 +22,98 @@
 #include <wx/stc/stc.h>
 #include "LSP/LSPEvent.h"
 #include "clWorkspaceManager.h"
+#include "clTrace.h"
 #include <wx/stc/stc.h>
 #include <wx/filesys.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <iomanip>
+#include <mutex>
 #include <sstream>
+#include <thread>
 #include "LSPNetworkSocket.h"
 
 #define PORT 12989
+// Changes made to the editors are sent at most once in this period (in milliseconds)
+#define LSP_CHANGES_DELAY 300
+
+namespace
+{
+/// Convert a Scintilla position into an LSP position: LSP counts characters in UTF-16 code units
+LSP::Position GetLSPPosition(wxStyledTextCtrl* ctrl, int pos)
+{
+    int line = ctrl->LineFromPosition(pos);
+    wxString text = ctrl->GetTextRange(ctrl->PositionFromLine(line), pos);
+    return LSP::Position(line, LSPDocumentChanges::GetUTF16Length(text));
+}
+} // namespace
+
+/**
+ * @brief parse the JSON payloads received from a language server on a worker thread. The payloads
+ * are parsed in the order they are received, and each result is passed to the callback (on the worker thread)
+ */
+class LSPResponseParser
+{
+public:
+    typedef std::function<void(LSP::ResponseMessage::Ptr_t, size_t)> Callback_t;
+
+protected:
+    struct Payload {
+        std::string json;
+        size_t connectionID = 0;
+    };
+    Callback_t m_callback;
+    std::deque<Payload> m_queue;
+    std::mutex m_lock;
+    std::condition_variable m_cond;
+    bool m_shutdown = false;
+    std::thread m_thread;
+
+    void Run()
+    {
+        std::unique_lock<std::mutex> locker(m_lock);
+        while(true) {
+            m_cond.wait(locker, [&]() { return m_shutdown || !m_queue.empty(); });
+            if(m_shutdown) { break; }
+            Payload payload = std::move(m_queue.front());
+            m_queue.pop_front();
+            locker.unlock();
+
+            LSP::ResponseMessage::Ptr_t res(new LSP::ResponseMessage(payload.json));
+            m_callback(res, payload.connectionID);
+            locker.lock();
+        }
+    }
+
+public:
+    LSPResponseParser(const Callback_t& callback)
+        : m_callback(callback)
+    {
+        m_thread = std::thread([this]() { Run(); });
+    }
+
+    ~LSPResponseParser()
+    {
+        {
+            std::lock_guard<std::mutex> locker(m_lock);
+            m_shutdown = true;
+            m_cond.notify_one();
+        }
+        m_thread.join();
+    }
+
+    void Parse(std::string&& json, size_t connectionID)
+    {
+        Payload payload;
+        payload.json = std::move(json);
+        payload.connectionID = connectionID;
+        std::lock_guard<std::mutex> locker(m_lock);
+        m_queue.push_back(std::move(payload));
+        m_cond.notify_one();
+    }
+};
 
 LanguageServerProtocol::LanguageServerProtocol(const wxString& name, wxEvtHandler* owner)
     : m_name(name)
@@ -44,6 +130,13 @@ LanguageServerProtocol::LanguageServerProtocol(const wxString& name, wxEvtHandle
     m_network->Bind(wxEVT_LSP_NET_DATA_READY, &LanguageServerProtocol::OnNetDataReady, this);
     m_network->Bind(wxEVT_LSP_NET_ERROR, &LanguageServerProtocol::OnNetError, this);
     m_network->Bind(wxEVT_LSP_NET_CONNECTED, &LanguageServerProtocol::OnNetConnected, this);
+
+    m_changesTimer = new wxTimer(this);
+    Bind(wxEVT_TIMER, &LanguageServerProtocol::OnChangesTimer, this, m_changesTimer->GetId());
+
+    m_parser = new LSPResponseParser([this](LSP::ResponseMessage::Ptr_t res, size_t connectionID) {
+        CallAfter(&LanguageServerProtocol::OnResponseParsed, res, connectionID);
+    });
 }
 
 LanguageServerProtocol::~LanguageServerProtocol()
@@ -54,6 +147,9 @@ LanguageServerProtocol::~LanguageServerProtocol()
     EventNotifier::Get()->Unbind(wxEVT_WORKSPACE_CLOSED, &LanguageServerProtocol::OnWorkspaceClosed, this);
     EventNotifier::Get()->Unbind(wxEVT_WORKSPACE_LOADED, &LanguageServerProtocol::OnWorkspaceOpen, this);
     DoClear();
+    Unbind(wxEVT_TIMER, &LanguageServerProtocol::OnChangesTimer, this, m_changesTimer->GetId());
+    wxDELETE(m_changesTimer);
+    wxDELETE(m_parser);
 }
 
 wxString LanguageServerProtocol::GetLanguageId(const wxString& fn)
@@ -153,8 +249,11 @@ void LanguageServerProtocol::Start()
 
 void LanguageServerProtocol::DoClear()
 {
-    m_filesSent.clear();
-    m_outputBuffer.clear();
+    m_documents.clear();
+    m_incrementalSync = false;
+    m_changesTimer->Stop();
+    m_framer.Clear();
+    ++m_connectionID;
     m_state = kUnInitialized;
     m_initializeRequestID = wxNOT_FOUND;
     m_Queue.Clear();
@@ -191,14 +290,8 @@ void LanguageServerProtocol::FindDefinition(IEditor* editor)
     CHECK_PTR_RET(editor);
     CHECK_COND_RET(ShouldHandleFile(editor));
 
-    // If the editor is modified, we need to tell the LSP to reparse the source file
-    const wxFileName& filename = editor->GetFileName();
-    if(m_filesSent.count(filename.GetFullPath()) && editor->IsModified()) {
-        // we already sent this file over, ask for change parse
-        SendChangeRequest(filename, editor->GetTextRange(0, editor->GetLength()));
-    } else if(m_filesSent.count(filename.GetFullPath()) == 0) {
-        SendOpenRequest(filename, editor->GetTextRange(0, editor->GetLength()), GetLanguageId(filename));
-    }
+    // Make sure the server parses the current content of the editor
+    SyncEditor(editor);
 
     LSP::GotoDefinitionRequest::Ptr_t req = LSP::RequestMessage::MakeRequest(new LSP::GotoDefinitionRequest(
         editor->GetFileName(), editor->GetCurrentLine(), editor->GetCtrl()->GetColumn(editor->GetCurrentPosition())));
@@ -216,7 +309,7 @@ void LanguageServerProtocol::SendOpenRequest(const wxFileName& filename, const w
 
 void LanguageServerProtocol::SendCloseRequest(const wxFileName& filename)
 {
-    if(m_filesSent.count(filename.GetFullPath()) == 0) {
+    if(m_documents.count(filename.GetFullPath()) == 0) {
         clDEBUG() << GetLogPrefix() << "LanguageServerProtocol::FileClosed(): file" << filename << "is not opened";
         return;
     }
@@ -224,7 +317,7 @@ void LanguageServerProtocol::SendCloseRequest(const wxFileName& filename)
     LSP::DidCloseTextDocumentRequest::Ptr_t req =
         LSP::RequestMessage::MakeRequest(new LSP::DidCloseTextDocumentRequest(filename));
     QueueMessage(req);
-    m_filesSent.erase(filename.GetFullPath());
+    m_documents.erase(filename.GetFullPath());
 }
 
 void LanguageServerProtocol::SendChangeRequest(const wxFileName& filename, const wxString& fileContent)
@@ -235,14 +328,10 @@ void LanguageServerProtocol::SendChangeRequest(const wxFileName& filename, const
     QueueMessage(req);
 }
 
-void LanguageServerProtocol::SendSaveRequest(const wxFileName& filename, const wxString& fileContent)
+void LanguageServerProtocol::SendCancelRequest(int requestId)
 {
-    // LSP::DidSaveTextDocumentRequest req(filename, fileContent);
-    // req.Send(this);
-    // clGetManager()->SetStatusMessage(wxString() << "[LSP] re-parsing file: " << filename.GetFullName(), 1);
-
-    // For now: report a change event
-    SendChangeRequest(filename, fileContent);
+    LSP::RequestMessage::Ptr_t req = LSP::RequestMessage::MakeRequest(new LSP::CancelRequest(requestId));
+    m_network->Send(req->ToString());
 }
 
 void LanguageServerProtocol::SendCodeCompleteRequest(const wxFileName& filename, size_t line, size_t column)
@@ -273,9 +362,9 @@ void LanguageServerProtocol::OnFileClosed(clCommandEvent& event)
 void LanguageServerProtocol::OnFileSaved(clCommandEvent& event)
 {
     event.Skip();
-    // For now, it does the same as 'OnFileLoaded'
+    // The server already follows the changes made to the editor, make sure it has all of them
     IEditor* editor = clGetManager()->GetActiveEditor();
-    if(editor && ShouldHandleFile(editor)) { SendSaveRequest(editor->GetFileName(), editor->GetCtrl()->GetText()); }
+    if(editor && ShouldHandleFile(editor)) { SyncEditor(editor); }
 }
 
 wxString LanguageServerProtocol::GetLogPrefix() const { return wxString() << "LSP [" << GetName() << "]:"; }
@@ -283,15 +372,7 @@ wxString LanguageServerProtocol::GetLogPrefix() const { return wxString() << "LS
 void LanguageServerProtocol::OpenEditor(IEditor* editor)
 {
     if(!IsInitialized()) { return; }
-    if(editor && ShouldHandleFile(editor)) {
-        if(m_filesSent.count(editor->GetFileName().GetFullPath())) {
-            clDEBUG() << "OpenEditor->SendChangeRequest called for:" << editor->GetFileName().GetFullName();
-            SendChangeRequest(editor->GetFileName(), editor->GetCtrl()->GetText());
-        } else {
-            clDEBUG() << "OpenEditor->SendOpenRequest called for:" << editor->GetFileName().GetFullName();
-            SendOpenRequest(editor->GetFileName(), editor->GetCtrl()->GetText(), GetLanguageId(editor->GetFileName()));
-        }
-    }
+    if(editor && ShouldHandleFile(editor)) { SyncEditor(editor); }
 }
 
 void LanguageServerProtocol::CodeComplete(IEditor* editor)
@@ -300,14 +381,8 @@ void LanguageServerProtocol::CodeComplete(IEditor* editor)
     CHECK_PTR_RET(editor);
     CHECK_COND_RET(ShouldHandleFile(editor));
 
-    // If the editor is modified, we need to tell the LSP to reparse the source file
-    const wxFileName& filename = editor->GetFileName();
-    if(m_filesSent.count(filename.GetFullPath()) && editor->IsModified()) {
-        // we already sent this file over, ask for change parse
-        SendChangeRequest(filename, editor->GetTextRange(0, editor->GetLength()));
-    } else if(m_filesSent.count(filename.GetFullPath()) == 0) {
-        SendOpenRequest(filename, editor->GetTextRange(0, editor->GetLength()), GetLanguageId(filename));
-    }
+    // Make sure the server parses the current content of the editor
+    SyncEditor(editor);
     // Now request the for code completion
     SendCodeCompleteRequest(editor->GetFileName(), editor->GetCurrentLine(),
                             editor->GetCtrl()->GetColumn(editor->GetCurrentPosition()));
@@ -316,21 +391,103 @@ void LanguageServerProtocol::CodeComplete(IEditor* editor)
 void LanguageServerProtocol::ProcessQueue()
 {
     if(m_Queue.IsEmpty()) { return; }
-    if(m_Queue.IsWaitingReponse()) {
-        clDEBUG() << "LSP is busy, will not send message";
-        return;
-    }
-    LSP::RequestMessage::Ptr_t req = m_Queue.Get();
     if(!IsRunning()) {
         clDEBUG() << GetLogPrefix() << "is down.";
         return;
     }
 
-    // Write the message length as string of 10 bytes
-    m_network->Send(req->ToString());
-    m_Queue.SetWaitingReponse(true);
-    m_Queue.Pop();
-    if(!req->GetStatusMessage().IsEmpty()) { clGetManager()->SetStatusMessage(req->GetStatusMessage(), 1); }
+    // Requests are pipelined: the whole queue is sent now. Requests that need a reply are matched with
+    // it by their id, so notifications (e.g. didChange) never wait behind a slow reply
+    while(!m_Queue.IsEmpty()) {
+        LSP::RequestMessage::Ptr_t req = m_Queue.Get();
+        m_Queue.Pop();
+        if(req->IsNeedsReply()) {
+            // Earlier requests replaced by this one (e.g. completion for the same file) are cancelled
+            std::vector<int> supersededIds;
+            m_Queue.AddPendingReply(req, supersededIds);
+            for(int id : supersededIds) {
+                clDEBUG1() << GetLogPrefix() << "cancelling request" << id << clEndl;
+                SendCancelRequest(id);
+            }
+        }
+        m_network->Send(req->ToString());
+        if(!req->GetStatusMessage().IsEmpty()) { clGetManager()->SetStatusMessage(req->GetStatusMessage(), 1); }
+    }
+}
+
+void LanguageServerProtocol::SyncEditor(IEditor* editor)
+{
+    if(!IsInitialized()) { return; }
+    const wxFileName& filename = editor->GetFileName();
+    if(m_documents.count(filename.GetFullPath())) {
+        // The server has this file: only send what changed since
+        SendPendingChanges(filename.GetFullPath());
+        return;
+    }
+
+    clDEBUG() << GetLogPrefix() << "Opening file:" << filename.GetFullName();
+    wxStyledTextCtrl* ctrl = editor->GetCtrl();
+    SendOpenRequest(filename, ctrl->GetText(), GetLanguageId(filename));
+
+    // From now on, follow the changes made to the editor
+    Document& doc = m_documents[filename.GetFullPath()];
+    doc.ctrl = ctrl;
+    ctrl->Unbind(wxEVT_STC_MODIFIED, &LanguageServerProtocol::OnEditorModified, this);
+    ctrl->Bind(wxEVT_STC_MODIFIED, &LanguageServerProtocol::OnEditorModified, this);
+}
+
+void LanguageServerProtocol::SendPendingChanges(const wxString& filename)
+{
+    for(std::unordered_map<wxString, Document>::value_type& p : m_documents) {
+        LSPDocumentChanges& changes = p.second.changes;
+        if(!changes.IsModified() || (!filename.IsEmpty() && p.first != filename)) { continue; }
+
+        if(m_incrementalSync && !changes.IsFullSync()) {
+            LSP::RequestMessage::Ptr_t req = LSP::RequestMessage::MakeRequest(
+                new LSP::DidChangeTextDocumentRequest(p.first, changes.GetChanges()));
+            QueueMessage(req);
+        } else {
+            IEditor* editor = clGetManager()->FindEditor(p.first);
+            if(!editor) {
+                // Keep the changes: they are sent once the editor is found again (its closing removes the
+                // document), clearing them would leave the server with an outdated copy of the file
+                clDEBUG() << GetLogPrefix() << "no editor for modified file" << p.first << clEndl;
+                continue;
+            }
+            SendChangeRequest(p.first, editor->GetCtrl()->GetText());
+        }
+        changes.Clear();
+    }
+}
+
+void LanguageServerProtocol::OnEditorModified(wxStyledTextEvent& event)
+{
+    event.Skip();
+    int type = event.GetModificationType();
+    if(!(type & (wxSTC_MOD_BEFOREDELETE | wxSTC_MOD_DELETETEXT | wxSTC_MOD_INSERTTEXT))) { return; }
+
+    wxStyledTextCtrl* ctrl = dynamic_cast<wxStyledTextCtrl*>(event.GetEventObject());
+    std::unordered_map<wxString, Document>::iterator iter = std::find_if(
+        m_documents.begin(), m_documents.end(),
+        [&](const std::unordered_map<wxString, Document>::value_type& p) { return p.second.ctrl == ctrl; });
+    if(!ctrl || iter == m_documents.end()) { return; }
+
+    // Bursts of changes (e.g. typing) are sent together
+    iter->second.changes.Add(type, event.GetPosition(), event.GetLength(), event.GetText(),
+                             [&](int pos) { return GetLSPPosition(ctrl, pos); }, m_incrementalSync);
+    if(!m_changesTimer->IsRunning()) { m_changesTimer->Start(LSP_CHANGES_DELAY, true); }
+}
+
+void LanguageServerProtocol::OnChangesTimer(wxTimerEvent& event) { SendPendingChanges(); }
+
+void LanguageServerProtocol::LogStats() const
+{
+    for(const LSPRequestStats::Map_t::value_type& p : m_Queue.GetStats()) {
+        const LSPRequestStats& stats = p.second;
+        clDEBUG() << GetLogPrefix() << p.first << ":" << stats.replies << "replies, average"
+                  << wxString::Format("%.1fms,", stats.GetAverageMs()) << "max"
+                  << wxString::Format("%.1fms,", stats.maxMs) << stats.cancelled << "cancelled" << clEndl;
+    }
 }
 
 void LanguageServerProtocol::CloseEditor(IEditor* editor)
@@ -344,14 +501,8 @@ void LanguageServerProtocol::FindDeclaration(IEditor* editor)
     CHECK_PTR_RET(editor);
     CHECK_COND_RET(ShouldHandleFile(editor));
 
-    // If the editor is modified, we need to tell the LSP to reparse the source file
-    const wxFileName& filename = editor->GetFileName();
-    if(m_filesSent.count(filename.GetFullPath()) && editor->IsModified()) {
-        // we already sent this file over, ask for change parse
-        SendChangeRequest(filename, editor->GetTextRange(0, editor->GetLength()));
-    } else if(m_filesSent.count(filename.GetFullPath()) == 0) {
-        SendOpenRequest(filename, editor->GetTextRange(0, editor->GetLength()), GetLanguageId(filename));
-    }
+    // Make sure the server parses the current content of the editor
+    SyncEditor(editor);
 
     LSP::GotoDeclarationRequest::Ptr_t req = LSP::RequestMessage::MakeRequest(new LSP::GotoDeclarationRequest(
         editor->GetFileName(), editor->GetCurrentLine(), editor->GetCtrl()->GetColumn(editor->GetCurrentPosition())));
@@ -383,74 +534,85 @@ void LanguageServerProtocol::OnNetError(clCommandEvent& event)
 
 void LanguageServerProtocol::OnNetDataReady(clCommandEvent& event)
 {
-    clDEBUG() << GetLogPrefix() << event.GetString();
-    wxString buffer = std::move(event.GetString());
-    m_outputBuffer << buffer;
-    m_Queue.SetWaitingReponse(false);
-
-    while(true) {
-        // Did we get a complete message?
-        LSP::ResponseMessage res(m_outputBuffer);
-        if(res.IsOk()) {
-            clDEBUG() << GetLogPrefix() << "received a complete message";
-
-            if(IsInitialized()) {
-                LSP::RequestMessage::Ptr_t msg_ptr = m_Queue.TakePendingReplyMessage(res.GetId());
-                // Is this an error message?
-                if(res.Has("error")) {
-                    LSP::ResponseError errMsg(res.GetMessageString());
-                    switch(errMsg.GetErrorCode()) {
-                    case LSP::ResponseError::kErrorCodeInternalError:
-                    case LSP::ResponseError::kErrorCodeInvalidRequest: {
-                        // Restart this server
-                        LSPEvent restartEvent(wxEVT_LSP_RESTART_NEEDED);
-                        restartEvent.SetServerName(GetName());
-                        m_owner->AddPendingEvent(restartEvent);
-                        break;
-                    }
-                    case LSP::ResponseError::kErrorCodeInvalidParams: {
-                        // Recreate this AST (in other words: reparse), by default we reparse the current editor
-                        LSPEvent reparseEvent(wxEVT_LSP_REPARSE_NEEDED);
-                        reparseEvent.SetServerName(GetName());
-                        m_owner->AddPendingEvent(reparseEvent);
-                        break;
-                    }
-                    default:
-                        break;
-                    }
-                } else {
-                    if(msg_ptr) {
-                        // let the originating request to handle it
-                        msg_ptr->OnResponse(res, m_owner);
-
-                        // If we got more in the buffer, try to process another message
-                        if(!m_outputBuffer.IsEmpty()) { continue; }
-
-                    } else if(res.IsPushDiagnostics()) {
-                        // Get the URI
-                        JSONItem params = res.Get("params");
-                        JSONItem uri = params.namedObject("uri");
-                        wxFileName fn(wxFileSystem::URLToFileName(uri.toString()));
-                        fn.Normalize();
-                        clGetManager()->SetStatusMessage(
-                            wxString() << "[LSP] parsing of file: " << fn.GetFullName() << " is completed", 1);
-                    }
-                }
-            } else {
-                // we only accept initialization responses here
-                if(res.GetId() == m_initializeRequestID) {
-                    clDEBUG() << GetLogPrefix() << "initialization completed";
-                    m_initializeRequestID = wxNOT_FOUND;
-                    m_state = kInitialized;
-
-                    // Notify about this
-                    LSPEvent initEvent(wxEVT_LSP_INITIALIZED);
-                    initEvent.SetServerName(GetName());
-                    m_owner->AddPendingEvent(initEvent);
-                }
+    clDEBUG1() << GetLogPrefix() << event.GetString();
+    m_framer.Append(event.GetStringRaw());
+
+    // Several messages may arrive at once: hand all the complete ones to the parser
+    std::string payload;
+    while(m_framer.Next(payload)) {
+        m_parser->Parse(std::move(payload), m_connectionID);
+    }
+}
+
+void LanguageServerProtocol::OnResponseParsed(LSP::ResponseMessage::Ptr_t res, size_t connectionID)
+{
+    if(connectionID != m_connectionID) { return; } // parsed before the server was restarted
+    if(!res->IsOk()) {
+        clWARNING() << GetLogPrefix() << "received an invalid JSON message" << clEndl;
+        return;
+    }
+    clDEBUG() << GetLogPrefix() << "received a complete message";
+
+    if(IsInitialized()) {
+        // Requests sent by the server carry ids of their own
+        LSP::RequestMessage::Ptr_t msg_ptr(nullptr);
+        if(!res->Has("method")) { msg_ptr = m_Queue.TakePendingReplyMessage(res->GetId()); }
+        // Is this an error message?
+        if(res->Has("error")) {
+            LSP::ResponseError errMsg(res->GetMessageString());
+            switch(errMsg.GetErrorCode()) {
+            case LSP::ResponseError::kErrorCodeInternalError:
+            case LSP::ResponseError::kErrorCodeInvalidRequest: {
+                // Restart this server
+                LSPEvent restartEvent(wxEVT_LSP_RESTART_NEEDED);
+                restartEvent.SetServerName(GetName());
+                m_owner->AddPendingEvent(restartEvent);
+                break;
             }
+            case LSP::ResponseError::kErrorCodeInvalidParams: {
+                // Recreate this AST (in other words: reparse), by default we reparse the current editor
+                LSPEvent reparseEvent(wxEVT_LSP_REPARSE_NEEDED);
+                reparseEvent.SetServerName(GetName());
+                m_owner->AddPendingEvent(reparseEvent);
+                break;
+            }
+            default:
+                break;
+            }
+        } else {
+            if(msg_ptr) {
+                // let the originating request to handle it
+                msg_ptr->OnResponse(*res, m_owner);
+
+            } else if(res->IsPushDiagnostics()) {
+                // Get the URI
+                JSONItem params = res->Get("params");
+                JSONItem uri = params.namedObject("uri");
+                wxFileName fn(wxFileSystem::URLToFileName(uri.toString()));
+                fn.Normalize();
+                clGetManager()->SetStatusMessage(
+                    wxString() << "[LSP] parsing of file: " << fn.GetFullName() << " is completed", 1);
+            }
+        }
+    } else {
+        // we only accept initialization responses here
+        if(res->GetId() == m_initializeRequestID) {
+            clDEBUG() << GetLogPrefix() << "initialization completed";
+            m_Queue.TakePendingReplyMessage(res->GetId());
+            m_initializeRequestID = wxNOT_FOUND;
+            m_state = kInitialized;
+
+            // "textDocumentSync" is either a TextDocumentSyncKind or an object holding it in "change"
+            JSONItem sync = res->Get("result").namedObject("capabilities").namedObject("textDocumentSync");
+            int syncKind = sync.isNumber() ? sync.toInt() : sync.namedObject("change").toInt();
+            m_incrementalSync = (syncKind == 2); // TextDocumentSyncKind.Incremental
+            clDEBUG() << GetLogPrefix() << "incremental sync:" << (m_incrementalSync ? "yes" : "no");
+
+            // Notify about this
+            LSPEvent initEvent(wxEVT_LSP_INITIALIZED);
+            initEvent.SetServerName(GetName());
+            m_owner->AddPendingEvent(initEvent);
         }
-        break;
     }
     ProcessQueue();
 }
@@ -458,6 +620,7 @@ void LanguageServerProtocol::OnNetDataReady(clCommandEvent& event)
 void LanguageServerProtocol::Stop()
 {
     clDEBUG() << GetLogPrefix() << "Going down";
+    LogStats();
     m_network->Close();
 }
 
@@ -483,14 +646,20 @@ void LanguageServerProtocol::OnWorkspaceOpen(wxCommandEvent& event)
 
 void LSPRequestMessageQueue::Push(LSP::RequestMessage::Ptr_t message)
 {
-    m_Queue.push(message);
-    if(message->IsNeedsReply()) { m_pendingReplyMessages.insert({ message->GetId(), message }); }
+    if(message->IsNeedsReply()) {
+        // A request that was not sent yet and is replaced by this one is simply dropped
+        std::deque<LSP::RequestMessage::Ptr_t>::iterator iter =
+            std::remove_if(m_Queue.begin(), m_Queue.end(), [&](LSP::RequestMessage::Ptr_t queued) {
+                return queued->IsNeedsReply() && queued->GetUID() == message->GetUID();
+            });
+        m_Queue.erase(iter, m_Queue.end());
+    }
+    m_Queue.push_back(message);
 }
 
 void LSPRequestMessageQueue::Pop()
 {
-    if(!m_Queue.empty()) { m_Queue.pop(); }
-    SetWaitingReponse(false);
+    if(!m_Queue.empty()) { m_Queue.pop_front(); }
 }
 
 LSP::RequestMessage::Ptr_t LSPRequestMessageQueue::Get()
@@ -501,18 +670,106 @@ LSP::RequestMessage::Ptr_t LSPRequestMessageQueue::Get()
 
 void LSPRequestMessageQueue::Clear()
 {
-    while(!m_Queue.empty()) {
-        m_Queue.pop();
-    }
-    SetWaitingReponse(false);
+    m_Queue.clear();
     m_pendingReplyMessages.clear();
 }
 
+void LSPRequestMessageQueue::AddPendingReply(LSP::RequestMessage::Ptr_t message, std::vector<int>& supersededIds)
+{
+    std::unordered_map<int, PendingReply>::iterator iter = m_pendingReplyMessages.begin();
+    while(iter != m_pendingReplyMessages.end()) {
+        if(iter->second.message->GetUID() == message->GetUID()) {
+            supersededIds.push_back(iter->first);
+            m_stats[iter->second.message->GetMethod()].cancelled++;
+            iter = m_pendingReplyMessages.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+
+    PendingReply pending;
+    pending.message = message;
+    pending.sentTime = std::chrono::steady_clock::now();
+    pending.traceStart = clTrace::Now();
+    m_pendingReplyMessages.insert({ message->GetId(), pending });
+}
+
 LSP::RequestMessage::Ptr_t LSPRequestMessageQueue::TakePendingReplyMessage(int msgid)
 {
-    if(m_pendingReplyMessages.empty()) { return LSP::RequestMessage::Ptr_t(nullptr); }
-    if(m_pendingReplyMessages.count(msgid) == 0) { return LSP::RequestMessage::Ptr_t(nullptr); }
-    LSP::RequestMessage::Ptr_t msgptr = m_pendingReplyMessages[msgid];
-    m_pendingReplyMessages.erase(msgid);
+    std::unordered_map<int, PendingReply>::iterator iter = m_pendingReplyMessages.find(msgid);
+    if(iter == m_pendingReplyMessages.end()) { return LSP::RequestMessage::Ptr_t(nullptr); }
+
+    LSP::RequestMessage::Ptr_t msgptr = iter->second.message;
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - iter->second.sentTime;
+    double ms = elapsed.count();
+    clTrace::RecordAsync("lsp", msgptr->GetMethod(), iter->second.traceStart, clTrace::Now() - iter->second.traceStart);
+    m_pendingReplyMessages.erase(iter);
+
+    LSPRequestStats& stats = m_stats[msgptr->GetMethod()];
+    stats.replies++;
+    stats.totalMs += ms;
+    stats.lastMs = ms;
+    stats.maxMs = std::max(stats.maxMs, ms);
+    clDEBUG1() << "LSP:" << msgptr->GetMethod() << "request" << msgid << "replied in" << wxString::Format("%.1fms", ms)
+               << clEndl;
     return msgptr;
 }
+
+//===------------------------------------------------------------------
+// LSPDocumentChanges
+//===------------------------------------------------------------------
+void LSPDocumentChanges::Add(int modificationType, int pos, int length, const wxString& text,
+                             const PositionFunc_t& getPosition, bool incremental)
+{
+    if(!(modificationType & (wxSTC_MOD_BEFOREDELETE | wxSTC_MOD_DELETETEXT | wxSTC_MOD_INSERTTEXT))) { return; }
+    m_modified = true;
+    if(!incremental || m_fullSync) { return; }
+
+    if(modificationType & wxSTC_MOD_BEFOREDELETE) {
+        // The range of the deleted text is computed while it is still in the document
+        LSP::Range range(getPosition(pos), getPosition(pos + length));
+        m_changes.push_back(LSP::TextDocumentContentChangeEvent(range, ""));
+        m_insertEnd = wxNOT_FOUND;
+        m_deletePending = true;
+
+    } else if(modificationType & wxSTC_MOD_DELETETEXT) {
+        // Without the "before delete" notification we don't know what was deleted: send the whole text
+        if(!m_deletePending) {
+            m_fullSync = true;
+            m_changes.clear();
+        }
+        m_deletePending = false;
+
+    } else if(m_insertEnd == pos && !m_changes.empty()) {
+        // Typing: extend the previous insertion
+        LSP::TextDocumentContentChangeEvent& last = m_changes.back();
+        last.SetText(last.GetText() + text);
+        m_insertEnd = pos + length;
+
+    } else {
+        LSP::Position where = getPosition(pos);
+        m_changes.push_back(LSP::TextDocumentContentChangeEvent(LSP::Range(where, where), text));
+        m_insertEnd = pos + length;
+    }
+}
+
+void LSPDocumentChanges::Clear()
+{
+    m_changes.clear();
+    m_modified = false;
+    m_fullSync = false;
+    m_insertEnd = wxNOT_FOUND;
+    m_deletePending = false;
+}
+
+int LSPDocumentChanges::GetUTF16Length(const wxString& text)
+{
+    int length = text.length();
+#if SIZEOF_WCHAR_T == 4
+    // Characters outside the BMP take two UTF-16 code units
+    for(wxString::const_iterator iter = text.begin(); iter != text.end(); ++iter) {
+        if((*iter).GetValue() > 0xFFFF) { ++length; }
+    }
+#endif
+    return length;
+}
@@ -8,33 +8,124 @@
 #include <wxStringHash.h>
 #include <wx/sharedptr.h>
 #include "macros.h"
+#include <chrono>
+#include <deque>
+#include <functional>
 #include <map>
-#include <queue>
 #include <string>
 #include "LSP/RequestMessage.h"
+#include "LSP/ResponseMessage.h"
+#include "LSP/basic_types.h"
 #include <unordered_map>
+#include <vector>
 #include "SocketAPI/clSocketClientAsync.h"
 #include "LSPNetwork.h"
+#include <wx/timer.h>
 
 class IEditor;
+class LSPResponseParser;
+class wxStyledTextCtrl;
+class wxStyledTextEvent;
+
+/**
+ * @brief reply latency of the requests sent to a language server, per method
+ */
+struct WXDLLIMPEXP_SDK LSPRequestStats {
+    size_t replies = 0;   // number of replies received
+    size_t cancelled = 0; // requests superseded by a newer request before their reply arrived
+    double totalMs = 0;
+    double maxMs = 0;
+    double lastMs = 0;
+
+    double GetAverageMs() const { return replies ? (totalMs / replies) : 0; }
+    typedef std::map<wxString, LSPRequestStats> Map_t;
+};
+
 class WXDLLIMPEXP_SDK LSPRequestMessageQueue
 {
-    std::queue<LSP::RequestMessage::Ptr_t> m_Queue;
-    std::unordered_map<int, LSP::RequestMessage::Ptr_t> m_pendingReplyMessages;
-    bool m_waitingReponse = false;
+    struct PendingReply {
+        LSP::RequestMessage::Ptr_t message;
+        std::chrono::steady_clock::time_point sentTime;
+        uint64_t traceStart = 0;
+    };
+
+    std::deque<LSP::RequestMessage::Ptr_t> m_Queue;
+    std::unordered_map<int, PendingReply> m_pendingReplyMessages;
+    LSPRequestStats::Map_t m_stats;
 
 public:
     LSPRequestMessageQueue() {}
     virtual ~LSPRequestMessageQueue() {}
 
+    /**
+     * @brief return the request waiting for reply 'msgid' and stop waiting for it
+     */
     LSP::RequestMessage::Ptr_t TakePendingReplyMessage(int msgid);
+
+    /**
+     * @brief 'message' was sent, wait for its reply. Requests with the same UID sent earlier (e.g. a completion
+     * request for the same file) are superseded: we stop waiting for them and return their ids in 'supersededIds'
+     */
+    void AddPendingReply(LSP::RequestMessage::Ptr_t message, std::vector<int>& supersededIds);
+
+    /**
+     * @brief add a message to the outgoing queue. A request that needs a reply replaces any request with the same
+     * UID still in the queue
+     */
     void Push(LSP::RequestMessage::Ptr_t message);
     void Pop();
     LSP::RequestMessage::Ptr_t Get();
     void Clear();
     bool IsEmpty() const { return m_Queue.empty(); }
-    void SetWaitingReponse(bool waitingReponse) { this->m_waitingReponse = waitingReponse; }
-    bool IsWaitingReponse() const { return m_waitingReponse; }
+    size_t GetPendingRepliesCount() const { return m_pendingReplyMessages.size(); }
+    const LSPRequestStats::Map_t& GetStats() const { return m_stats; }
+};
+
+/**
+ * @brief the changes made to a document since they were last sent to the server, built from the
+ * wxEVT_STC_MODIFIED notifications of its editor
+ */
+class WXDLLIMPEXP_SDK LSPDocumentChanges
+{
+public:
+    // Convert a position of the editor into an LSP position
+    typedef std::function<LSP::Position(int)> PositionFunc_t;
+
+protected:
+    std::vector<LSP::TextDocumentContentChangeEvent> m_changes;
+    bool m_modified = false;
+    bool m_fullSync = false;       // the changes could not be tracked, send the whole text
+    int m_insertEnd = wxNOT_FOUND; // end of the last insertion, so typing is merged into a single change
+    bool m_deletePending = false;  // waiting for the delete notification following a "before delete"
+
+public:
+    LSPDocumentChanges() {}
+    virtual ~LSPDocumentChanges() {}
+
+    /**
+     * @brief record a modification of the editor ('modificationType' holds wxSTC_MOD_* flags). 'getPosition' is
+     * called right away, so the editor must hold the text of the notification. When 'incremental' is false,
+     * only the fact that the document was modified is recorded
+     */
+    void Add(int modificationType, int pos, int length, const wxString& text, const PositionFunc_t& getPosition,
+             bool incremental);
+
+    /**
+     * @brief the changes were sent
+     */
+    void Clear();
+
+    bool IsModified() const { return m_modified; }
+    /**
+     * @brief could the changes be tracked? if not, the whole text must be sent
+     */
+    bool IsFullSync() const { return m_fullSync; }
+    const std::vector<LSP::TextDocumentContentChangeEvent>& GetChanges() const { return m_changes; }
+
+    /**
+     * @brief the length of 'text' in UTF-16 code units, the unit of the LSP columns
+     */
+    static int GetUTF16Length(const wxString& text);
 };
 
 class WXDLLIMPEXP_SDK LanguageServerProtocol : public wxEvtHandler
@@ -49,9 +140,19 @@ class WXDLLIMPEXP_SDK LanguageServerProtocol : public wxEvtHandler
     LSPNetwork::Ptr_t m_network;
     wxString m_lspCommand;
     wxString m_lspCommandWorkingDirectory;
-    wxStringSet_t m_filesSent;
+    // A document sent to the server, with the changes not sent yet
+    struct Document {
+        wxStyledTextCtrl* ctrl = nullptr;
+        LSPDocumentChanges changes;
+    };
+    std::unordered_map<wxString, Document> m_documents;
+    bool m_incrementalSync = false;
+    wxTimer* m_changesTimer = nullptr;
     wxStringSet_t m_languages;
-    wxString m_outputBuffer;
+    // The server output is split into messages here, their JSON is parsed by m_parser off the main thread
+    clJSONRPCFramer m_framer;
+    LSPResponseParser* m_parser = nullptr;
+    size_t m_connectionID = 0; // replies parsed for a previous connection are ignored
     wxString m_rootFolder;
     wxString m_helperCommand;
 
@@ -70,12 +171,15 @@ protected:
     void OnNetConnected(clCommandEvent& event);
     void OnNetError(clCommandEvent& event);
     void OnNetDataReady(clCommandEvent& event);
+    void OnResponseParsed(LSP::ResponseMessage::Ptr_t res, size_t connectionID);
 
     void OnFileLoaded(clCommandEvent& event);
     void OnFileClosed(clCommandEvent& event);
     void OnFileSaved(clCommandEvent& event);
     void OnWorkspaceClosed(wxCommandEvent& event);
     void OnWorkspaceOpen(wxCommandEvent& event);
+    void OnEditorModified(wxStyledTextEvent& event);
+    void OnChangesTimer(wxTimerEvent& event);
 
 protected:
     void DoClear();
@@ -83,6 +187,18 @@ protected:
     bool ShouldHandleFile(IEditor* editor) const;
     wxString GetLogPrefix() const;
     void ProcessQueue();
+    void LogStats() const;
+
+    /**
+     * @brief make sure the server has the current content of the editor: open it or send the pending changes
+     */
+    void SyncEditor(IEditor* editor);
+
+    /**
+     * @brief send the changes made to a document (all documents when 'filename' is empty) since they were last sent
+     */
+    void SendPendingChanges(const wxString& filename = wxEmptyString);
+
     static wxString GetLanguageId(const wxFileName& fn) { return GetLanguageId(fn.GetFullName()); }
     static wxString GetLanguageId(const wxString& fn);
 
@@ -103,9 +219,9 @@ protected:
     void SendChangeRequest(const wxFileName& filename, const wxString& fileContent);
 
     /**
-     * @brief report a file-save notification
+     * @brief tell the server that we no longer need the reply of a given request
      */
-    void SendSaveRequest(const wxFileName& filename, const wxString& fileContent);
+    void SendCancelRequest(int requestId);
 
     /**
      * @brief request for a code completion at a given doc/position
@@ -158,6 +274,11 @@ public:
      */
     bool IsRunning() const;
 
+    /**
+     * @brief return the reply latency statistics of the requests sent to this server, per method
+     */
+    const LSPRequestStats::Map_t& GetRequestsStats() const { return m_Queue.GetStats(); }
+
     /**
      * @brief stop the language server
      */
@@ -0,0 +1,198 @@
+#include "OutputViewBuffer.h"
+#include "cl_standard_paths.h"
+#include "file_logger.h"
+#include "fileutils.h"
+
+// Compact the buffer once the dropped lines take more than this
+#define OUTPUT_BUFFER_COMPACT_SIZE (1024 * 1024)
+
+OutputViewLines::OutputViewLines()
+    : m_nextSequence(0)
+{
+}
+
+OutputViewLines::~OutputViewLines() {}
+
+size_t OutputViewLines::Add(const char* data, size_t length, int style)
+{
+    Span span;
+    span.offset = m_data.length();
+    span.length = length;
+    span.style = style;
+    m_data.append(data, length);
+    m_spans.push_back(span);
+    return m_nextSequence++;
+}
+
+void OutputViewLines::DropFirst()
+{
+    if(m_spans.empty()) { return; }
+    m_spans.pop_front();
+    DoCompact();
+}
+
+void OutputViewLines::Clear()
+{
+    m_spans.clear();
+    m_data.clear();
+}
+
+void OutputViewLines::DoCompact()
+{
+    if(m_spans.empty()) {
+        m_data.clear();
+        return;
+    }
+
+    size_t dropped = m_spans.front().offset;
+    if(dropped < OUTPUT_BUFFER_COMPACT_SIZE || dropped < (m_data.length() / 2)) { return; }
+    m_data.erase(0, dropped);
+    for(Span& span : m_spans) {
+        span.offset -= dropped;
+    }
+}
+
+//////////////////////////////////////////////////////////////////
+
+int OutputViewBuffer::FlushInfo::GetLine(size_t sequence) const
+{
+    if(sequence < firstSequence) { return wxNOT_FOUND; }
+    int line = firstLine + (int)(sequence - firstSequence);
+    return line < 0 ? wxNOT_FOUND : line;
+}
+
+int OutputViewBuffer::FlushInfo::GetMovedLine(int line) const
+{
+    line -= linesRemoved;
+    return line < 0 ? wxNOT_FOUND : line;
+}
+
+OutputViewBuffer::OutputViewBuffer(wxStyledTextCtrl* ctrl, const wxString& logName, size_t maxLines,
+                                   int flushInterval)
+    : m_ctrl(ctrl)
+    , m_maxLines(maxLines)
+    , m_flushInterval(flushInterval)
+    , m_timer(nullptr)
+    , m_logName(logName)
+    , m_truncated(false)
+{
+    m_timer = new wxTimer(this);
+    Bind(wxEVT_TIMER, &OutputViewBuffer::OnTimer, this, m_timer->GetId());
+}
+
+OutputViewBuffer::~OutputViewBuffer()
+{
+    m_timer->Stop();
+    Unbind(wxEVT_TIMER, &OutputViewBuffer::OnTimer, this, m_timer->GetId());
+    wxDELETE(m_timer);
+    Clear();
+}
+
+wxFileName OutputViewBuffer::DoGetLogFile() const
+{
+    return wxFileName(clStandardPaths::Get().GetTempDir(), m_logName + ".log");
+}
+
+size_t OutputViewBuffer::Add(const wxString& text, int style)
+{
+    const wxCharBuffer utf8 = text.mb_str(wxConvUTF8);
+    size_t sequence = m_lines.Add(utf8.data(), utf8.length(), style);
+
+    if(m_log.IsOpened()) {
+        m_log.Write(utf8.data(), utf8.length());
+
+    } else if(m_lines.GetCount() > m_maxLines) {
+        // The oldest line will never reach the control: keep the complete output in the log file first
+        DoStartLog();
+    }
+
+    if(m_lines.GetCount() > m_maxLines) {
+        m_lines.DropFirst();
+        m_truncated = true;
+    }
+
+    if(!m_timer->IsRunning()) { m_timer->StartOnce(m_flushInterval); }
+    return sequence;
+}
+
+void OutputViewBuffer::DoStartLog()
+{
+    wxFileName logFile = DoGetLogFile();
+    logFile.Mkdir(wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+    if(!m_log.Open(logFile.GetFullPath(), "wb")) {
+        clWARNING() << "Failed to create output log file" << logFile << clEndl;
+        return;
+    }
+
+    // What the control holds, followed by the lines that were not written to it yet
+    const wxCharBuffer content = m_ctrl->GetTextRaw();
+    m_log.Write(content.data(), content.length());
+    m_log.Write(m_lines.GetData(), m_lines.GetDataLength());
+}
+
+void OutputViewBuffer::Flush()
+{
+    m_timer->Stop();
+    if(m_lines.IsEmpty()) { return; }
+
+    FlushInfo info;
+    info.firstSequence = m_lines.GetFirstSequence();
+
+    bool readOnly = m_ctrl->GetReadOnly();
+    m_ctrl->SetReadOnly(false);
+
+    // The pending lines are contiguous: write them with a single call
+    int startPos = m_ctrl->GetLength();
+    info.firstLine = m_ctrl->LineFromPosition(startPos);
+    m_ctrl->AppendTextRaw(m_lines.GetData(), (int)m_lines.GetDataLength());
+
+    if(m_ctrl->GetLexer() == wxSTC_LEX_CONTAINER) {
+#if wxCHECK_VERSION(3, 1, 1) && !defined(__WXOSX__)
+        // The scintilla syntax in e.g. wx3.1.1 changed
+        m_ctrl->StartStyling(startPos);
+#else
+        m_ctrl->StartStyling(startPos, 0x1f);
+#endif
+        for(const OutputViewLines::Span& span : m_lines.GetSpans()) {
+            m_ctrl->SetStyling((int)span.length, span.style);
+        }
+    }
+    m_lines.Clear();
+
+    // Cap the history (the number of complete lines)
+    int lineCount = m_ctrl->LineFromPosition(m_ctrl->GetLength());
+    if(lineCount > (int)m_maxLines) {
+        if(!m_log.IsOpened()) { DoStartLog(); }
+        info.linesRemoved = lineCount - m_maxLines;
+        info.firstLine -= info.linesRemoved;
+        m_ctrl->DeleteRange(0, m_ctrl->PositionFromLine(info.linesRemoved));
+        m_truncated = true;
+    }
+    m_ctrl->SetReadOnly(readOnly);
+
+    if(m_onFlush) { m_onFlush(info); }
+}
+
+void OutputViewBuffer::Clear()
+{
+    m_timer->Stop();
+    m_lines.Clear();
+    m_truncated = false;
+    if(m_log.IsOpened()) {
+        m_log.Close();
+        clRemoveFile(DoGetLogFile());
+    }
+}
+
+wxString OutputViewBuffer::GetContent()
+{
+    Flush();
+    if(!m_log.IsOpened()) { return m_ctrl->GetText(); }
+
+    m_log.Flush();
+    wxString content;
+    FileUtils::ReadFileContent(DoGetLogFile(), content);
+    return content;
+}
+
+void OutputViewBuffer::OnTimer(wxTimerEvent& event) { Flush(); }
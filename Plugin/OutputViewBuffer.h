@@ -0,0 +1,158 @@
+#ifndef OUTPUTVIEWBUFFER_H
+#define OUTPUTVIEWBUFFER_H
+
+#include "codelite_exports.h"
+#include <deque>
+#include <functional>
+#include <string>
+#include <wx/event.h>
+#include <wx/ffile.h>
+#include <wx/filename.h>
+#include <wx/stc/stc.h>
+#include <wx/timer.h>
+
+/**
+ * @class OutputViewLines
+ * @brief the lines waiting to be written to the control of an OutputViewBuffer, kept as UTF-8 spans of a
+ * single buffer. Each line added gets the next sequence number, the lines dropped keep theirs
+ */
+class WXDLLIMPEXP_SDK OutputViewLines
+{
+public:
+    struct Span {
+        size_t offset = 0; // in m_data
+        size_t length = 0; // in bytes, including the line terminator
+        int style = 0;
+    };
+
+protected:
+    std::string m_data;
+    std::deque<Span> m_spans;
+    size_t m_nextSequence;
+
+protected:
+    void DoCompact();
+
+public:
+    OutputViewLines();
+    virtual ~OutputViewLines();
+
+    /**
+     * @brief add a line of 'length' bytes
+     * @return the sequence number of the line
+     */
+    size_t Add(const char* data, size_t length, int style);
+
+    /**
+     * @brief drop the oldest line
+     */
+    void DropFirst();
+
+    /**
+     * @brief drop all the lines. The sequence numbers are not reused
+     */
+    void Clear();
+
+    size_t GetCount() const { return m_spans.size(); }
+    bool IsEmpty() const { return m_spans.empty(); }
+    const std::deque<Span>& GetSpans() const { return m_spans; }
+
+    /**
+     * @brief the sequence number of the oldest line (or of the next line to be added when there are none)
+     */
+    size_t GetFirstSequence() const { return m_nextSequence - m_spans.size(); }
+
+    /**
+     * @brief the lines, one after the other
+     */
+    const char* GetData() const { return m_spans.empty() ? "" : m_data.c_str() + m_spans.front().offset; }
+    size_t GetDataLength() const { return m_spans.empty() ? 0 : m_data.length() - m_spans.front().offset; }
+};
+
+/**
+ * @class OutputViewBuffer
+ * @brief feed a read only wxStyledTextCtrl with a large amount of output.
+ * The lines are kept as UTF-8 spans of a single buffer and written to the control together, at most once
+ * every 'flushInterval' milliseconds. The control keeps the last 'maxLines' lines only: once older lines are
+ * removed, the complete output is kept in a log file and GetContent() reads it from there
+ */
+class WXDLLIMPEXP_SDK OutputViewBuffer : public wxEvtHandler
+{
+public:
+    struct FlushInfo {
+        size_t firstSequence = 0; // the sequence number of the first line written to the control
+        int firstLine = 0;        // and its line in the control. Negative if it was removed right away
+        int linesRemoved = 0;     // the lines removed from the top of the control
+
+        /**
+         * @brief the line in the control of the line numbered 'sequence', written by this flush.
+         * wxNOT_FOUND if the line was dropped before it reached the control or removed right away
+         */
+        int GetLine(size_t sequence) const;
+
+        /**
+         * @brief the new number of a line that was in the control before this flush, wxNOT_FOUND if it was removed
+         */
+        int GetMovedLine(int line) const;
+    };
+    typedef std::function<void(const FlushInfo&)> FlushCallback_t;
+
+protected:
+    wxStyledTextCtrl* m_ctrl;
+    FlushCallback_t m_onFlush;
+    size_t m_maxLines;
+    int m_flushInterval;
+    wxTimer* m_timer;
+
+    // The lines waiting to be written to the control. When there are more than 'maxLines' of them, the oldest
+    // are dropped: the control would remove them anyway
+    OutputViewLines m_lines;
+
+    wxString m_logName;
+    wxFFile m_log;
+    bool m_truncated;
+
+protected:
+    void OnTimer(wxTimerEvent& event);
+    void DoStartLog();
+    wxFileName DoGetLogFile() const;
+
+public:
+    OutputViewBuffer(wxStyledTextCtrl* ctrl, const wxString& logName, size_t maxLines, int flushInterval);
+    virtual ~OutputViewBuffer();
+
+    /**
+     * @brief called after lines were written to the control
+     */
+    void SetFlushCallback(const FlushCallback_t& onFlush) { m_onFlush = onFlush; }
+    void SetMaxLines(size_t maxLines) { m_maxLines = maxLines; }
+
+    /**
+     * @brief add a line ('text' includes its terminator). The line is styled with 'style' when the control
+     * uses the container lexer
+     * @return the sequence number of the line
+     */
+    size_t Add(const wxString& text, int style);
+
+    /**
+     * @brief write the pending lines to the control now
+     */
+    void Flush();
+
+    /**
+     * @brief drop the pending lines and the log file. The control itself is not cleared
+     */
+    void Clear();
+
+    /**
+     * @brief were lines removed from the control?
+     */
+    bool IsTruncated() const { return m_truncated; }
+
+    /**
+     * @brief return the complete output
+     */
+    wxString GetContent();
+};
+
+#endif // OUTPUTVIEWBUFFER_H
@@ -0,0 +1,276 @@
+#include "clWorkspaceSnapshot.h"
+#include "file_logger.h"
+#include <string.h>
+#include <wx/ffile.h>
+#include <wx/filefn.h>
+#include <wx/xml/xml.h>
+
+// The snapshot is a local file: numbers are written in the native byte order
+#define SNAPSHOT_FILE_MAGIC "CLWSNAP"
+#define SNAPSHOT_FILE_VERSION 1
+// A corrupted snapshot must not overflow the stack
+#define SNAPSHOT_MAX_XML_DEPTH 256
+
+namespace
+{
+template <typename T> void Write(std::string& buffer, T value) { buffer.append((const char*)&value, sizeof(T)); }
+
+void WriteString(std::string& buffer, const wxString& str)
+{
+    const wxCharBuffer utf8 = str.mb_str(wxConvUTF8);
+    uint32_t len = utf8.length();
+    Write<uint32_t>(buffer, len);
+    buffer.append(utf8.data(), len);
+}
+
+void WriteNode(std::string& buffer, const wxXmlNode* node, const Project::FilePathsMap_t& fullpaths)
+{
+    Write<uint8_t>(buffer, node->GetType());
+    WriteString(buffer, node->GetName());
+    WriteString(buffer, node->GetContent());
+
+    uint32_t numAttributes = 0;
+    for(wxXmlAttribute* attr = node->GetAttributes(); attr; attr = attr->GetNext()) {
+        ++numAttributes;
+    }
+    Write<uint32_t>(buffer, numAttributes);
+    for(wxXmlAttribute* attr = node->GetAttributes(); attr; attr = attr->GetNext()) {
+        WriteString(buffer, attr->GetName());
+        WriteString(buffer, attr->GetValue());
+    }
+
+    if(node->GetType() == wxXML_ELEMENT_NODE && node->GetName() == "File") {
+        // An empty path means: compute it when restoring
+        Project::FilePathsMap_t::const_iterator iter = fullpaths.find(node);
+        WriteString(buffer, iter == fullpaths.end() ? wxString() : iter->second);
+    }
+
+    uint32_t numChildren = 0;
+    for(wxXmlNode* child = node->GetChildren(); child; child = child->GetNext()) {
+        ++numChildren;
+    }
+    Write<uint32_t>(buffer, numChildren);
+    for(wxXmlNode* child = node->GetChildren(); child; child = child->GetNext()) {
+        WriteNode(buffer, child, fullpaths);
+    }
+}
+
+struct Reader {
+    const char* data;
+    size_t length;
+    size_t pos = 0;
+    bool ok = true;
+
+    Reader(const char* d, size_t len)
+        : data(d)
+        , length(len)
+    {
+    }
+
+    template <typename T> T Read()
+    {
+        T value = 0;
+        if(!ok || (length - pos) < sizeof(T)) {
+            ok = false;
+            return value;
+        }
+        memcpy(&value, data + pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+    wxString ReadString()
+    {
+        uint32_t len = Read<uint32_t>();
+        if(!ok || (length - pos) < len) {
+            ok = false;
+            return wxString();
+        }
+        wxString str = wxString::FromUTF8(data + pos, len);
+        pos += len;
+        return str;
+    }
+
+    void Skip(size_t len)
+    {
+        if(!ok || (length - pos) < len) {
+            ok = false;
+            return;
+        }
+        pos += len;
+    }
+
+    wxXmlNode* ReadNode(Project::FilePathsMap_t& fullpaths, int depth)
+    {
+        if(depth > SNAPSHOT_MAX_XML_DEPTH) {
+            ok = false;
+            return nullptr;
+        }
+        uint8_t type = Read<uint8_t>();
+        wxString name = ReadString();
+        wxString content = ReadString();
+        if(!ok) { return nullptr; }
+
+        wxXmlNode* node = new wxXmlNode((wxXmlNodeType)type, name, content);
+        uint32_t numAttributes = Read<uint32_t>();
+        for(uint32_t i = 0; ok && i < numAttributes; ++i) {
+            wxString attrName = ReadString();
+            wxString attrValue = ReadString();
+            node->AddAttribute(attrName, attrValue);
+        }
+
+        if(type == wxXML_ELEMENT_NODE && name == "File") {
+            wxString fullpath = ReadString();
+            if(!fullpath.IsEmpty()) { fullpaths.insert({ node, fullpath }); }
+        }
+
+        // Link the children directly: AddChild() walks the list of children on every call
+        uint32_t numChildren = Read<uint32_t>();
+        wxXmlNode* last = nullptr;
+        for(uint32_t i = 0; ok && i < numChildren; ++i) {
+            wxXmlNode* child = ReadNode(fullpaths, depth + 1);
+            if(!child) { break; }
+            child->SetParent(node);
+            if(last) {
+                last->SetNext(child);
+            } else {
+                node->SetChildren(child);
+            }
+            last = child;
+        }
+
+        if(!ok) { wxDELETE(node); }
+        return node;
+    }
+};
+} // namespace
+
+clWorkspaceSnapshot::Stamp clWorkspaceSnapshot::Stamp::Get(const wxString& filename)
+{
+    Stamp stamp;
+    wxStructStat buff;
+    if(wxStat(filename, &buff) == 0) {
+        stamp.lastModified = buff.st_mtime;
+        stamp.fileSize = buff.st_size;
+    }
+    return stamp;
+}
+
+clWorkspaceSnapshot::clWorkspaceSnapshot() {}
+
+clWorkspaceSnapshot::~clWorkspaceSnapshot() {}
+
+bool clWorkspaceSnapshot::Open(const wxFileName& snapshotFile)
+{
+    m_projects.clear();
+    if(!snapshotFile.FileExists() || !m_file.Open(snapshotFile.GetFullPath())) { return false; }
+
+    Reader reader(m_file.GetData(), m_file.GetSize());
+    if(m_file.GetSize() < strlen(SNAPSHOT_FILE_MAGIC) ||
+       memcmp(m_file.GetData(), SNAPSHOT_FILE_MAGIC, strlen(SNAPSHOT_FILE_MAGIC)) != 0) {
+        return false;
+    }
+    reader.pos = strlen(SNAPSHOT_FILE_MAGIC);
+    if(reader.Read<uint32_t>() != SNAPSHOT_FILE_VERSION) {
+        clDEBUG() << "Workspace snapshot" << snapshotFile << "was written by another version. Ignoring it" << clEndl;
+        return false;
+    }
+
+    // Only index the projects here, their data is read when they are loaded
+    uint32_t count = reader.Read<uint32_t>();
+    for(uint32_t i = 0; reader.ok && i < count; ++i) {
+        wxString path = reader.ReadString();
+        Location location;
+        location.stamp.lastModified = reader.Read<int64_t>();
+        location.stamp.fileSize = reader.Read<int64_t>();
+        location.length = reader.Read<uint64_t>();
+        location.offset = reader.pos;
+        reader.Skip(location.length);
+        m_projects.insert({ path, location });
+    }
+
+    if(!reader.ok) {
+        clWARNING() << "Workspace snapshot" << snapshotFile << "is corrupted. Ignoring it" << clEndl;
+        m_projects.clear();
+        return false;
+    }
+    clDEBUG() << "Workspace snapshot" << snapshotFile << "holds" << m_projects.size() << "projects" << clEndl;
+    return true;
+}
+
+void clWorkspaceSnapshot::Close()
+{
+    m_projects.clear();
+    m_file.Close();
+}
+
+bool clWorkspaceSnapshot::HasProject(const wxString& path, const Stamp& stamp) const
+{
+    std::unordered_map<wxString, Location>::const_iterator iter = m_projects.find(path);
+    return stamp.IsOk() && iter != m_projects.end() && iter->second.stamp == stamp;
+}
+
+bool clWorkspaceSnapshot::LoadProject(const wxString& path, const Stamp& stamp, Project* project) const
+{
+    if(!HasProject(path, stamp)) { return false; }
+    const Location& location = m_projects.find(path)->second;
+
+    Reader reader(m_file.GetData() + location.offset, location.length);
+    wxString version = reader.ReadString();
+    wxString encoding = reader.ReadString();
+    Project::FilePathsMap_t fullpaths;
+    wxXmlNode* root = reader.ReadNode(fullpaths, 0);
+    if(!reader.ok || !root) {
+        clWARNING() << "Workspace snapshot entry for" << path << "is corrupted" << clEndl;
+        return false;
+    }
+
+    project->m_doc.SetRoot(root);
+    project->m_doc.SetVersion(version);
+    project->m_doc.SetFileEncoding(encoding);
+    project->DoLoadSnapshot(path, fullpaths);
+    return true;
+}
+
+bool clWorkspaceSnapshot::Save(const wxFileName& snapshotFile, const std::vector<ProjectEntry>& projects)
+{
+    std::string buffer(SNAPSHOT_FILE_MAGIC);
+    Write<uint32_t>(buffer, SNAPSHOT_FILE_VERSION);
+    Write<uint32_t>(buffer, projects.size());
+
+    Project::FilePathsMap_t fullpaths;
+    std::string data;
+    for(const ProjectEntry& entry : projects) {
+        Project* project = entry.project.Get();
+        const wxXmlDocument& doc = project->m_doc;
+
+        fullpaths.clear();
+        for(const Project::FilesMap_t::value_type& vt : project->m_filesTable) {
+            fullpaths.insert({ vt.second->GetXmlNode(), vt.second->GetFilename() });
+        }
+
+        data.clear();
+        WriteString(data, doc.GetVersion());
+        WriteString(data, doc.GetFileEncoding());
+        WriteNode(data, doc.GetRoot(), fullpaths);
+
+        WriteString(buffer, project->GetFileName().GetFullPath());
+        Write<int64_t>(buffer, entry.stamp.lastModified);
+        Write<int64_t>(buffer, entry.stamp.fileSize);
+        Write<uint64_t>(buffer, data.length());
+        buffer.append(data);
+    }
+
+    // Write to a temporary file first, so a crash can not leave a truncated snapshot behind
+    wxFileName tmpFile(snapshotFile);
+    tmpFile.SetFullName(snapshotFile.GetFullName() + ".tmp");
+    {
+        wxFFile fp(tmpFile.GetFullPath(), "wb");
+        if(!fp.IsOpened() || fp.Write(buffer.c_str(), buffer.length()) != buffer.length()) {
+            clWARNING() << "Failed to write the workspace snapshot" << tmpFile << clEndl;
+            return false;
+        }
+    }
+    clDEBUG() << "Saved" << projects.size() << "projects into the workspace snapshot" << snapshotFile << clEndl;
+    return ::wxRenameFile(tmpFile.GetFullPath(), snapshotFile.GetFullPath(), true);
+}
@@ -0,0 +1,88 @@
+#ifndef CLWORKSPACESNAPSHOT_H
+#define CLWORKSPACESNAPSHOT_H
+
+#include "clFileContent.h"
+#include "codelite_exports.h"
+#include "project.h"
+#include "wxStringHash.h"
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+#include <wx/filename.h>
+
+/**
+ * @class clWorkspaceSnapshot
+ * @brief a binary copy of the projects of a C++ workspace: the XML tree of each project (which holds its
+ * virtual folders and build configurations) and the full path of each of its files. When the workspace is
+ * opened again, the projects that were not modified since are restored from the snapshot
+ * instead of being parsed from their XML file.
+ * A project is identified by its path and is valid as long as its modification time and size match.
+ */
+class WXDLLIMPEXP_SDK clWorkspaceSnapshot
+{
+public:
+    struct Stamp {
+        int64_t lastModified = 0;
+        int64_t fileSize = 0;
+
+        bool IsOk() const { return lastModified != 0; }
+        bool operator==(const Stamp& other) const
+        {
+            return lastModified == other.lastModified && fileSize == other.fileSize;
+        }
+        static Stamp Get(const wxString& filename);
+    };
+
+    /**
+     * @brief a loaded project to write into the snapshot
+     */
+    struct ProjectEntry {
+        ProjectPtr project;
+        Stamp stamp; // taken before the project file was read
+    };
+
+protected:
+    struct Location {
+        Stamp stamp;
+        size_t offset = 0;
+        size_t length = 0;
+    };
+
+    clFileContent m_file;
+    std::unordered_map<wxString, Location> m_projects;
+
+public:
+    clWorkspaceSnapshot();
+    virtual ~clWorkspaceSnapshot();
+
+    /**
+     * @brief read the snapshot file and index its projects
+     * @return false if there is no snapshot, or it is corrupted or was written by another version
+     */
+    bool Open(const wxFileName& snapshotFile);
+
+    /**
+     * @brief release the snapshot file content
+     */
+    void Close();
+
+    /**
+     * @brief does the snapshot hold this version of the project?
+     */
+    bool HasProject(const wxString& path, const Stamp& stamp) const;
+
+    /**
+     * @brief restore 'project' from the snapshot. This method only reads the snapshot and can be called by
+     * several threads at once
+     * @return false if the project is not in the snapshot or its data is corrupted. 'project' must then be
+     * loaded from its XML file
+     */
+    bool LoadProject(const wxString& path, const Stamp& stamp, Project* project) const;
+
+    /**
+     * @brief write the snapshot of 'projects' into 'snapshotFile'
+     */
+    static bool Save(const wxFileName& snapshotFile, const std::vector<ProjectEntry>& projects);
+};
+
+#endif // CLWORKSPACESNAPSHOT_H
@@ -28,9 +28,11 @@
 #include "fileextmanager.h"
 #include "fileutils.h"
 #include "JSON.h"
+#include "JSONStreamReader.h"
 #include "project.h"
 #include "workspace.h"
 #include <algorithm>
+#include <functional>
 #include <wx/dir.h>
 #include <wx/ffile.h>
 #include <wx/filename.h>
@@ -312,11 +314,97 @@ FileNameVector_t CompilationDatabase::GetCompileCommandsFiles() const
     return files;
 }
 
-void CompilationDatabase::ProcessCMakeCompilationDatabase(const wxFileName& compile_commands)
+namespace
+{
+/**
+ * @brief read the entries of a compile_commands.json file without building its DOM. The file
+ * can be hundreds of MBs for large projects. Each entry is passed to the callback as it is read
+ */
+class CompileCommandsHandler : public JSONStreamReader::Handler
 {
-    JSON root(compile_commands);
-    JSONItem arr = root.toElement();
+public:
+    typedef std::function<void(const wxString&, const wxString&, const wxString&)> Callback_t;
+
+protected:
+    Callback_t m_callback;
+    int m_depth = 0;
+    std::string m_key;
+    std::string m_file;
+    std::string m_directory;
+    std::string m_command;
+    int m_found = 0;
+
+    enum {
+        kFile = (1 << 0),
+        kDirectory = (1 << 1),
+        kCommand = (1 << 2),
+    };
+
+public:
+    CompileCommandsHandler(const Callback_t& callback)
+        : m_callback(callback)
+    {
+    }
+
+    virtual bool OnStartObject()
+    {
+        if(++m_depth == 2) {
+            m_found = 0;
+            m_key.clear();
+        }
+        return true;
+    }
+
+    virtual bool OnEndObject()
+    {
+        // Each object has 3 properties:
+        // directory, command, file
+        if(m_depth-- == 2 && m_found == (kFile | kDirectory | kCommand)) {
+            m_callback(wxString::FromUTF8(m_file.c_str(), m_file.length()),
+                       wxString::FromUTF8(m_directory.c_str(), m_directory.length()),
+                       wxString::FromUTF8(m_command.c_str(), m_command.length()));
+        }
+        return true;
+    }
 
+    virtual bool OnStartArray()
+    {
+        ++m_depth;
+        return true;
+    }
+
+    virtual bool OnEndArray()
+    {
+        --m_depth;
+        return true;
+    }
+
+    virtual bool OnKey(const std::string& key)
+    {
+        if(m_depth == 2) { m_key = key; }
+        return true;
+    }
+
+    virtual bool OnString(const std::string& value)
+    {
+        if(m_depth != 2) { return true; }
+        if(m_key == "file") {
+            m_file = value;
+            m_found |= kFile;
+        } else if(m_key == "directory") {
+            m_directory = value;
+            m_found |= kDirectory;
+        } else if(m_key == "command") {
+            m_command = value;
+            m_found |= kCommand;
+        }
+        return true;
+    }
+};
+} // namespace
+
+void CompilationDatabase::ProcessCMakeCompilationDatabase(const wxFileName& compile_commands)
+{
     try {
 
         wxString sql;
@@ -324,26 +412,23 @@ void CompilationDatabase::ProcessCMakeCompilationDatabase(const wxFileName& comp
         wxSQLite3Statement st = m_db->PrepareStatement(sql);
         m_db->ExecuteUpdate("BEGIN");
 
-        for(int i = 0; i < arr.arraySize(); ++i) {
-            // Each object has 3 properties:
-            // directory, command, file
-            JSONItem element = arr.arrayItem(i);
-            if(element.hasNamedObject("file") && element.hasNamedObject("directory") &&
-               element.hasNamedObject("command")) {
-                wxString cmd = element.namedObject("command").toString();
-                wxString file = element.namedObject("file").toString();
-                wxString path = wxFileName(file).GetPath();
-                wxString cwd = element.namedObject("directory").toString();
-
-                cwd = wxFileName(cwd, "").GetPath();
-                file = wxFileName(file).GetFullPath();
-
-                st.Bind(1, file);
-                st.Bind(2, path);
-                st.Bind(3, cwd);
-                st.Bind(4, cmd);
-                st.ExecuteUpdate();
-            }
+        CompileCommandsHandler handler([&](const wxString& filename, const wxString& directory, const wxString& cmd) {
+            wxString file = filename;
+            wxString path = wxFileName(file).GetPath();
+            wxString cwd = wxFileName(directory, "").GetPath();
+            file = wxFileName(file).GetFullPath();
+
+            st.Bind(1, file);
+            st.Bind(2, path);
+            st.Bind(3, cwd);
+            st.Bind(4, cmd);
+            st.ExecuteUpdate();
+        });
+
+        JSONStreamReader reader(&handler);
+        if(!reader.ParseFile(compile_commands.GetFullPath())) {
+            // Keep the entries read so far
+            clWARNING() << "Failed to read" << compile_commands << ":" << reader.GetError() << clEndl;
         }
 
         m_db->ExecuteUpdate("COMMIT");
@@ -411,21 +496,16 @@ wxArrayString CompilationDatabase::FindIncludePaths(const wxString& rootFolder,
     lastCompileCommandsModified = compile_commands.GetModificationTime().GetTicks();
 
     wxStringSet_t paths;
-    JSON root(compile_commands);
-    JSONItem arr = root.toElement();
-    const int file_size = arr.arraySize();
-    for(int i = 0; i < file_size; ++i) {
-        // Each object has 3 properties:
-        // directory, command, file
-        JSONItem element = arr.arrayItem(i);
-        if(element.hasNamedObject("file") && element.hasNamedObject("directory") && element.hasNamedObject("command")) {
-            wxString cmd = element.namedObject("command").toString();
-            wxString cwd = element.namedObject("directory").toString();
-            CompilerCommandLineParser cclp(cmd, cwd);
-            const wxArrayString& includes = cclp.GetIncludes();
-            std::for_each(includes.begin(), includes.end(),
-                          [&](const wxString& includePath) { paths.insert(includePath); });
-        }
+    CompileCommandsHandler handler([&](const wxString& file, const wxString& cwd, const wxString& cmd) {
+        wxUnusedVar(file);
+        CompilerCommandLineParser cclp(cmd, cwd);
+        const wxArrayString& includes = cclp.GetIncludes();
+        std::for_each(includes.begin(), includes.end(),
+                      [&](const wxString& includePath) { paths.insert(includePath); });
+    });
+    JSONStreamReader reader(&handler);
+    if(!reader.ParseFile(compile_commands.GetFullPath())) {
+        clWARNING() << "Failed to read" << compile_commands << ":" << reader.GetError() << clEndl;
     }
     // Convert the set back to array
     wxArrayString includePaths;
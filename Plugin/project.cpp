@@ -118,6 +118,13 @@ bool Project::Create(const wxString& name, const wxString& description, const wx
 }
 
 bool Project::Load(const wxString& path)
+{
+    if(!LoadXml(path)) { return false; }
+    FinishLoad();
+    return true;
+}
+
+bool Project::LoadXml(const wxString& path)
 {
     if(!m_doc.Load(path)) { return false; }
 
@@ -136,11 +143,21 @@ bool Project::Load(const wxString& path)
     DoBuildCacheFromXml();
     SetModified(true);
     SetProjectLastModifiedTime(GetFileLastModifiedTime());
-
-    DoUpdateProjectSettings();
     return true;
 }
 
+void Project::FinishLoad() { DoUpdateProjectSettings(); }
+
+void Project::DoLoadSnapshot(const wxString& path, const FilePathsMap_t& fullpaths)
+{
+    m_fileName = path;
+    m_projectPath = m_fileName.GetPath();
+
+    DoBuildCacheFromXml(&fullpaths);
+    SetModified(true);
+    SetProjectLastModifiedTime(GetFileLastModifiedTime());
+}
+
 wxXmlNode* Project::GetVirtualDir(const wxString& vdFullPath)
 {
     if(m_virtualFoldersTable.count(vdFullPath) == 0) { return nullptr; }
@@ -547,7 +564,7 @@ void Project::CopyTo(const wxString& new_path, const wxString& new_name, const w
     doc.Save(newFile.GetFullPath());
 }
 
-clProjectFile::Ptr_t Project::FileFromXml(wxXmlNode* node, const wxString& vd)
+clProjectFile::Ptr_t Project::FileFromXml(wxXmlNode* node, const wxString& vd, const wxString& fullpath)
 {
     clProjectFile::Ptr_t file(new clProjectFile());
 
@@ -566,11 +583,14 @@ clProjectFile::Ptr_t Project::FileFromXml(wxXmlNode* node, const wxString& vd)
         props = props->GetNext();
     }
 
-    wxFileName tmp(fileName);
-    tmp.MakeAbsolute(GetProjectPath());
-
     file->SetFilenameRelpath(fileName);
-    file->SetFilename(tmp.GetFullPath());
+    if(fullpath.IsEmpty()) {
+        wxFileName tmp(fileName);
+        tmp.MakeAbsolute(GetProjectPath());
+        file->SetFilename(tmp.GetFullPath());
+    } else {
+        file->SetFilename(fullpath);
+    }
     file->SetFlags(XmlUtils::ReadLong(node, "Flags", 0));
     file->SetXmlNode(node);
 
@@ -580,7 +600,7 @@ clProjectFile::Ptr_t Project::FileFromXml(wxXmlNode* node, const wxString& vd)
     return file;
 }
 
-void Project::DoBuildCacheFromXml()
+void Project::DoBuildCacheFromXml(const FilePathsMap_t* fullpaths)
 {
     m_filesTable.clear();
     m_virtualFoldersTable.clear();
@@ -596,7 +616,12 @@ void Project::DoBuildCacheFromXml()
         wxXmlNode* child = node->GetChildren();
         while(child) {
             if(child->GetName() == "File" && folder) {
-                clProjectFile::Ptr_t file = FileFromXml(child, folder->GetFullpath());
+                wxString fullpath;
+                if(fullpaths) {
+                    FilePathsMap_t::const_iterator iter = fullpaths->find(child);
+                    if(iter != fullpaths->end()) { fullpath = iter->second; }
+                }
+                clProjectFile::Ptr_t file = FileFromXml(child, folder->GetFullpath(), fullpath);
                 // Cache the file
                 m_filesTable.insert({ file->GetFilename(), file });
                 // Add this file to the folder
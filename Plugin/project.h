@@ -302,10 +302,13 @@ class WXDLLIMPEXP_SDK Project
 public:
     typedef std::unordered_map<wxString, clProjectFile::Ptr_t> FilesMap_t;
     typedef std::unordered_map<wxString, clProjectFolder::Ptr_t> FoldersMap_t;
+    // The full path of the "File" nodes of the project XML
+    typedef std::unordered_map<const wxXmlNode*, wxString> FilePathsMap_t;
 
     friend class clCxxWorkspace;
     friend class clProjectFolder;
     friend class clProjectFile;
+    friend class clWorkspaceSnapshot;
 
 private:
     wxXmlDocument m_doc;
@@ -325,8 +328,16 @@ private:
 
 private:
     void DoUpdateProjectSettings();
-    void DoBuildCacheFromXml();
-    clProjectFile::Ptr_t FileFromXml(wxXmlNode* node, const wxString& vd);
+    /**
+     * @brief rebuild the files and folders tables from the XML. When 'fullpaths' is provided, the files
+     * full path is taken from it instead of being computed
+     */
+    void DoBuildCacheFromXml(const FilePathsMap_t* fullpaths = nullptr);
+    clProjectFile::Ptr_t FileFromXml(wxXmlNode* node, const wxString& vd, const wxString& fullpath = wxEmptyString);
+    /**
+     * @brief complete the load of a project whose XML tree was restored from a workspace snapshot
+     */
+    void DoLoadSnapshot(const wxString& path, const FilePathsMap_t& fullpaths);
     wxArrayString DoGetCompilerOptions(bool cxxOptions, bool clearCache = false, bool noDefines = true,
                                        bool noIncludePaths = true);
     wxArrayString DoGetUnPreProcessors(bool clearCache, const wxString& cmpOptions);
@@ -447,6 +458,11 @@ public:
      */
     wxString GetDescription() const;
 
+    /**
+     * @brief the project XML document
+     */
+    const wxXmlDocument& GetXmlDocument() const { return m_doc; }
+
     //-----------------------------------
     // Project operations
     //-----------------------------------
@@ -456,6 +472,18 @@ public:
      * \return
      */
     bool Load(const wxString& path);
+    /**
+     * @brief the first part of Load(): read the XML file and build the files cache. This part only
+     * touches this project, so projects can be loaded by worker threads. Call FinishLoad() afterwards
+     * from the main thread
+     * @param path the project file absolute path
+     */
+    bool LoadXml(const wxString& path);
+    /**
+     * @brief the second part of Load(): create the project settings. A project without settings
+     * gets the default settings, which depend on the global compilers configuration
+     */
+    void FinishLoad();
     /**
      * \brief Create new project
      * \param name project name
@@ -22,6 +22,8 @@
 //
 //////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////
+#include "clTrace.h"
+#include "clWorkspaceSnapshot.h"
 #include "cl_command_event.h"
 #include "codelite_events.h"
 #include "ctags_manager.h"
@@ -37,9 +39,13 @@
 #include "wx/regex.h"
 #include "wx_xml_compatibility.h"
 #include "xmlutils.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
 #include <wx/app.h>
 #include <wx/log.h>
 #include <wx/msgdlg.h>
+#include <wx/stopwatch.h>
 #include <wx/thread.h>
 #include <wx/tokenzr.h>
 #include "file_logger.h"
@@ -1204,20 +1210,114 @@ void clCxxWorkspace::DoUnselectActiveProject()
 
 void clCxxWorkspace::DoLoadProjectsFromXml(wxXmlNode* parentNode, const wxString& folder,
                                            std::vector<wxXmlNode*>& removedChildren)
+{
+    CL_TRACE_SCOPE("workspace", "clCxxWorkspace::DoLoadProjectsFromXml");
+    std::vector<ProjectToLoad> projects;
+    DoCollectProjectsFromXml(parentNode, folder, projects);
+    if(projects.empty()) { return; }
+
+    // The projects are created here: a new project gets default settings, which are not thread safe
+    for(ProjectToLoad& p : projects) {
+        wxFileName projectFile(p.path);
+        if(projectFile.IsRelative()) { projectFile.MakeAbsolute(m_fileName.GetPath()); }
+        p.path = projectFile.GetFullPath();
+        p.stamp = clWorkspaceSnapshot::Stamp::Get(p.path);
+        p.project.Reset(new Project());
+    }
+
+    // Projects that did not change since the last time the workspace was opened are restored from the
+    // snapshot instead of their XML file
+    wxFileName snapshotFile = DoGetSnapshotFileName();
+    clWorkspaceSnapshot snapshot;
+    snapshot.Open(snapshotFile);
+
+    int cpus = wxThread::GetCPUCount();
+    size_t workers = (cpus > 0) ? std::min((size_t)cpus, projects.size()) : 1;
+    clDEBUG() << "Loading" << projects.size() << "projects using" << workers << "threads" << clEndl;
+
+    // Parsing the project files is the expensive part, the workers do it
+    wxStopWatch sw;
+    std::atomic_size_t nextProject(0);
+    auto loadProjects = [&]() {
+        while(true) {
+            size_t index = nextProject.fetch_add(1);
+            if(index >= projects.size()) { break; }
+
+            CL_TRACE_SCOPE("workspace", "Load project");
+            ProjectToLoad& p = projects[index];
+            wxStopWatch projectSw;
+            p.fromSnapshot = snapshot.LoadProject(p.path, p.stamp, p.project.Get());
+            p.loaded = p.fromSnapshot || p.project->LoadXml(p.path);
+            clDEBUG1() << "Loaded project" << p.path << (p.fromSnapshot ? "from the snapshot in" : "in")
+                       << projectSw.Time() << "ms" << clEndl;
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(workers - 1);
+    for(size_t w = 1; w < workers; ++w) {
+        pool.push_back(std::thread(loadProjects));
+    }
+    // This thread works too
+    loadProjects();
+    for(std::thread& t : pool) {
+        t.join();
+    }
+    // Release the snapshot file, it might be replaced below
+    snapshot.Close();
+
+    std::vector<clWorkspaceSnapshot::ProjectEntry> snapshotEntries;
+    bool snapshotIsStale = false;
+    for(ProjectToLoad& p : projects) {
+        if(!p.loaded) {
+            clWARNING() << "Corrupted project file" << p.path << clEndl;
+            removedChildren.push_back(p.node);
+            continue;
+        }
+        p.project->FinishLoad();
+
+        if(!p.fromSnapshot) { snapshotIsStale = true; }
+        clWorkspaceSnapshot::ProjectEntry entry;
+        entry.project = p.project;
+        entry.stamp = p.stamp;
+        snapshotEntries.push_back(entry);
+
+        // Add an entry to the projects map
+        m_projects.insert(std::make_pair(p.project->GetName(), p.project));
+        p.project->AssociateToWorkspace(this);
+        p.project->SetWorkspaceFolder(p.folder);
+    }
+    clDEBUG() << "Loaded" << projects.size() << "projects in" << sw.Time() << "ms" << clEndl;
+
+    if(snapshotIsStale) { clWorkspaceSnapshot::Save(snapshotFile, snapshotEntries); }
+}
+
+wxFileName clCxxWorkspace::DoGetSnapshotFileName() const
+{
+    wxFileName snapshotFile(GetPrivateFolder(), GetWorkspaceFileName().GetFullName());
+    snapshotFile.SetName(snapshotFile.GetName() + "-" + ::clGetUserName());
+    snapshotFile.SetExt("snapshot");
+    return snapshotFile;
+}
+
+void clCxxWorkspace::DoCollectProjectsFromXml(wxXmlNode* parentNode, const wxString& folder,
+                                              std::vector<ProjectToLoad>& projects)
 {
     wxXmlNode* child = parentNode->GetChildren();
     while(child) {
         if(child->GetName() == wxT("Project")) {
-            wxString projectPath = child->GetPropVal(wxT("Path"), wxEmptyString);
-            wxString errmsg;
-            if(!DoAddProject(projectPath, folder, errmsg)) { removedChildren.push_back(child); }
+            ProjectToLoad p;
+            p.node = child;
+            p.path = child->GetPropVal(wxT("Path"), wxEmptyString);
+            p.folder = folder;
+            projects.push_back(p);
         } else if(child->GetName() == wxT("VirtualDirectory")) {
             // Virtual directory
             wxString currentFolder = folder;
             wxString vdName = child->GetAttribute("Name", wxEmptyString);
             if(!currentFolder.IsEmpty()) { currentFolder << "/"; }
             currentFolder << vdName;
-            DoLoadProjectsFromXml(child, currentFolder, removedChildren);
+            DoCollectProjectsFromXml(child, currentFolder, projects);
         } else if((child->GetName() == wxT("WorkspaceParserPaths")) ||
                   (child->GetName() == wxT("WorkspaceParserMacros"))) {
             wxString swtlw = XmlUtils::ReadString(m_doc.GetRoot(), "SWTLW");
@@ -30,6 +30,7 @@
 #include <wx/xml/xml.h>
 #include "wx/filename.h"
 #include "project.h"
+#include "clWorkspaceSnapshot.h"
 #include <map>
 #include "JSON.h"
 #include <wx/event.h>
@@ -99,10 +100,34 @@ private:
     void DoUnselectActiveProject();
 
     /**
-     * @brief load projects from the XML file
+     * @brief a project listed in the workspace XML file
+     */
+    struct ProjectToLoad {
+        wxXmlNode* node = nullptr;
+        wxString path;
+        wxString folder;
+        ProjectPtr project;
+        clWorkspaceSnapshot::Stamp stamp;
+        bool loaded = false;
+        bool fromSnapshot = false;
+    };
+
+    /**
+     * @brief load projects from the XML file. The project files are parsed in parallel, the projects
+     * are then added to the workspace in the order they appear in the XML file
      */
     void DoLoadProjectsFromXml(wxXmlNode* parentNode, const wxString& folder, std::vector<wxXmlNode*>& removedChildren);
 
+    /**
+     * @brief collect the projects listed under 'parentNode' (recursively)
+     */
+    void DoCollectProjectsFromXml(wxXmlNode* parentNode, const wxString& folder, std::vector<ProjectToLoad>& projects);
+
+    /**
+     * @brief the file holding the snapshot of the workspace projects
+     */
+    wxFileName DoGetSnapshotFileName() const;
+
     // return the wxXmlNode instance for the give path
     // the path is separated by "/"
     // return NULL if no such virtual directory exists
@@ -88,6 +88,9 @@ void WordCompletionDictionary::DoCacheActiveEditor(bool overwrite)
     IEditor* activeEditor = ::clGetManager()->GetActiveEditor();
     CHECK_PTR_RET(activeEditor);
 
+    // Do not copy and tokenize the whole text of large files
+    if(activeEditor->IsLargeFile()) { return; }
+
     if(!overwrite && m_files.count(activeEditor->GetFileName().GetFullPath()))
         return; // we already have this file in the cache
         
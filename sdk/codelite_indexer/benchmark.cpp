@@ -0,0 +1,127 @@
+#include "benchmark.h"
+#include "workerthread.h"
+#include "network/cl_indexer_request.h"
+#include "libctags/libctags.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef __WXMSW__
+#	include <direct.h>
+#	include <process.h>
+#	define BENCH_MKDIR(path) _mkdir(path)
+#	define BENCH_RMDIR(path) _rmdir(path)
+#	define BENCH_GETPID() _getpid()
+#else
+#	include <sys/stat.h>
+#	include <sys/types.h>
+#	include <unistd.h>
+#	define BENCH_MKDIR(path) mkdir(path, 0755)
+#	define BENCH_RMDIR(path) rmdir(path)
+#	define BENCH_GETPID() getpid()
+#endif
+
+static std::string get_temp_dir()
+{
+	const char* vars[] = { "TMPDIR", "TEMP", "TMP" };
+	for (size_t i=0; i<sizeof(vars)/sizeof(vars[0]); i++) {
+		const char* dir = getenv(vars[i]);
+		if (dir && *dir) {
+			return dir;
+		}
+	}
+#ifdef __WXMSW__
+	return ".";
+#else
+	return "/tmp";
+#endif
+}
+
+// produce a header with a mix of the constructs ctags emits tags for
+static std::string make_synthetic_source(int file_index)
+{
+	std::stringstream ss;
+	ss << "#ifndef BENCH_FILE_" << file_index << "_H\n";
+	ss << "#define BENCH_FILE_" << file_index << "_H\n\n";
+	ss << "#define BENCH_MACRO_" << file_index << "(x) ((x) + " << file_index << ")\n\n";
+	ss << "namespace bench" << file_index << " {\n";
+	for (int c=0; c<20; c++) {
+		ss << "enum Kind" << c << " { kFirst" << c << ", kSecond" << c << ", kThird" << c << " };\n";
+		ss << "class Class" << c << " : public Base" << c << "\n{\n";
+		ss << "    int m_value" << c << ";\n";
+		ss << "    std::string m_name" << c << ";\n";
+		ss << "public:\n";
+		ss << "    Class" << c << "();\n";
+		ss << "    virtual ~Class" << c << "();\n";
+		for (int m=0; m<10; m++) {
+			ss << "    int Method" << m << "(int arg" << m << ", const std::string& name) const;\n";
+		}
+		ss << "};\n\n";
+		ss << "typedef Class" << c << "* Class" << c << "Ptr;\n";
+		ss << "inline int function" << c << "(int a, int b) { return a + b; }\n\n";
+	}
+	ss << "} // namespace bench" << file_index << "\n";
+	ss << "#endif\n";
+	return ss.str();
+}
+
+int run_benchmark(int num_files)
+{
+	if (num_files < 1) {
+		num_files = 500;
+	}
+
+	std::stringstream dir_ss;
+	dir_ss << get_temp_dir() << "/codelite_indexer_bench." << BENCH_GETPID();
+	std::string dir = dir_ss.str();
+	BENCH_MKDIR(dir.c_str());
+
+	// generate the input files
+	std::vector<std::string> files;
+	size_t input_bytes = 0;
+	for (int i=0; i<num_files; i++) {
+		std::stringstream name;
+		name << dir << "/bench_" << i << ".h";
+
+		std::string content = make_synthetic_source(i);
+		FILE* fp = fopen(name.str().c_str(), "wb");
+		if (!fp) {
+			fprintf(stderr, "ERROR: failed to create file %s\n", name.str().c_str());
+			return 1;
+		}
+		fwrite(content.c_str(), 1, content.length(), fp);
+		fclose(fp);
+
+		input_bytes += content.length();
+		files.push_back(name.str());
+	}
+
+	clIndexerRequest req;
+	req.setCmd(clIndexerRequest::CLI_PARSE);
+	req.setCtagOptions(" --excmd=pattern --sort=no --fields=aKmSsnit --c-kinds=+p --C++-kinds=+p ");
+	req.setFiles(files);
+
+	std::string tags;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	make_tags_for_request(req, tags);
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+	double seconds = std::chrono::duration<double>(end - start).count();
+	double mb_in  = (double)input_bytes / (1024.0 * 1024.0);
+	double mb_out = (double)tags.length() / (1024.0 * 1024.0);
+
+	printf("INFO: parsed %d files in %.3f seconds\n", num_files, seconds);
+	printf("INFO: input : %.2f MB (%.2f MB/s)\n", mb_in, seconds > 0.0 ? mb_in / seconds : 0.0);
+	printf("INFO: output: %.2f MB (%.2f MB/s)\n", mb_out, seconds > 0.0 ? mb_out / seconds : 0.0);
+
+	// cleanup
+	for (size_t i=0; i<files.size(); i++) {
+		remove(files.at(i).c_str());
+	}
+	BENCH_RMDIR(dir.c_str());
+	ctags_shutdown();
+	return 0;
+}
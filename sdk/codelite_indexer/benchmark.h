@@ -0,0 +1,12 @@
+#ifndef __indexer_benchmark__
+#define __indexer_benchmark__
+
+/**
+ * @brief generate 'num_files' synthetic C++ headers, parse them using a single
+ * multi-file request (the same code path used by the worker thread) and print
+ * the throughput
+ * @return 0 on success
+ */
+int run_benchmark(int num_files);
+
+#endif // __indexer_benchmark__
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "workerthread.h"
+#include "benchmark.h"
 #include "utils.h"
 #include "equeue.h"
 #include "network/named_pipe_client.h"
@@ -32,22 +33,30 @@ int main(int argc, char **argv)
 	if(argc < 2){
 		printf("Usage: %s <string> [--pid]\n",    argv[0]);
 		printf("Usage: %s --batch <file_list> <output file>\n", argv[0]);
+		printf("Usage: %s --benchmark [num_files]\n", argv[0]);
 		printf("   <string> - a unique string that identifies this indexer from other instances               \n");
 		printf("   --pid    - when set, <string> is handled as process number and the indexer will            \n");
 		printf("              check if this process alive. If it is down, the indexer will go down as well\n");
 		printf("   --batch  - when set, batch parsing is done using list of files set in file_list argument   \n");
+		printf("   --benchmark - parse num_files (default: 500) generated files and report the throughput     \n");
 		return 1;
 	}
 
+	if ( strcmp( argv[1], "--benchmark") == 0 ) {
+		return run_benchmark( argc > 2 ? atoi( argv[2] ) : 500 );
+	}
+
 	if ( argc == 4 && strcmp( argv[1], "--batch") == 0 ) {
 		// Batch mode
 		ctags_batch_parse(argv[2], argv[3]);
 		return 0;
 	}
 
-	if ( argc == 3 && strcmp( argv[2], "--pid") == 0 ) {
-		parent_pid = atol( argv[1] );
-		printf("INFO: parent PID is set on %s\n", argv[1]);
+	for ( int i = 2; i < argc; ++i ) {
+		if ( strcmp( argv[i], "--pid") == 0 ) {
+			parent_pid = atol( argv[1] );
+			printf("INFO: parent PID is set on %s\n", argv[1]);
+		}
 	}
 
 	// create the connection factory
@@ -56,7 +65,8 @@ int main(int argc, char **argv)
 
 	clNamedPipeConnectionsServer server(channel_name);
 
-	// start the worker thread
+	// start the worker thread. libctags is not thread safe: codelite
+	// starts several indexer processes to parse files in parallel
 	WorkerThread  worker( &g_connectionQueue );
 
 	// start the 'is alive thread'
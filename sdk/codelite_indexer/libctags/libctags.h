@@ -9,9 +9,13 @@ extern "C" {
 typedef char* (*CTAGS_MAKE_TAGS_FUNC)(const char*, const char*);
 typedef void  (*CTAGS_SHUDOWN_FUNC)();
 typedef void (*CTAGS_FREE_FUNC)(char *);
+typedef char* (*CTAGS_MAKE_TAGS_EX_FUNC)(const char*, const char*, const char*);
 
 /** standard incudes **/
 char *ctags_make_tags (const char *cmd, const char *infile);
+/** same as ctags_make_tags, but use 'tagsfile' as the intermediate tags file
+ ** instead of 'tags' in the current working directory **/
+char *ctags_make_tags_ex (const char *cmd, const char *infile, const char *tagsfile);
 void ctags_shutdown();
 void ctags_free(char *ptr);
 void ctags_batch_parse(const char* filelist, const char * outputfile);
@@ -90,6 +90,7 @@ extern struct DosLibrary *DOSBase;
 static list_t *gList = NULL;
 static char  **gArgv = NULL;
 static char  **tmp_gArgv = NULL;
+static const char *gTagsFile = NULL; /* when set, passed to ctags as '-f <file>' */
 static int     gArgc = 0;
 
 /*
@@ -560,6 +561,13 @@ extern char *ctags_make_tags (const char *cmd, const char *infile)
 
 	ctags_init( cmd, infile );
 
+	/* '-f' is passed on every call: forget the value of the previous call
+	 * so ctags does not warn about the option being specified more than once */
+	if ( gTagsFile && Option.tagFileName ) {
+		eFree (Option.tagFileName);
+		Option.tagFileName = NULL;
+	}
+
 	cookedArgs *args = cArgNewFromArgv (gArgv);
 
 	previewFirstOption (args);
@@ -573,6 +581,11 @@ extern char *ctags_make_tags (const char *cmd, const char *infile)
 		stringListClear(Option.ignore);
 	}
 
+	/* an explicit tags file was requested */
+	if ( gTagsFile ) {
+		return load_file(gTagsFile);
+	}
+
 	/* open the tags file, read it and convert it into char* */
 	file_name = (char*)malloc(strlen(TagFile.directory) + 6);
 	memset(file_name, 0, strlen(TagFile.directory) + 6);
@@ -584,6 +597,16 @@ extern char *ctags_make_tags (const char *cmd, const char *infile)
 	return tags;
 }
 
+extern char *ctags_make_tags_ex (const char *cmd, const char *infile, const char *tagsfile)
+{
+	char *tags = NULL;
+
+	gTagsFile = tagsfile;
+	tags = ctags_make_tags(cmd, infile);
+	gTagsFile = NULL;
+	return tags;
+}
+
 void ctags_init(const char *options, const char *filename)
 {
 	/* convert options to **argv */
@@ -677,6 +700,12 @@ void ctags_make_argv(const char *str, const char *filename)
 		token = strtok(NULL, " ");
 	}
 
+	/* the tags file name is added as a separate argument so it may contain spaces */
+	if (gTagsFile) {
+		list_append(gList, strdup("-f"));
+		list_append(gList, strdup(gTagsFile));
+	}
+
 	list_append(gList, strdup(filename));
 	list_append(gList, NULL);
 
@@ -26,6 +26,7 @@
 #ifndef __clindexerreply__
 #define __clindexerreply__
 #include <string>
+#include <utility>
 
 class clIndexerReply
 {
@@ -49,6 +50,9 @@ public:
 	void setTags(const std::string& tags) {
 		this->m_tags = tags;
 	}
+	void setTags(std::string&& tags) {
+		this->m_tags = std::move(tags);
+	}
 	const size_t& getCompletionCode() const {
 		return m_completionCode;
 	}
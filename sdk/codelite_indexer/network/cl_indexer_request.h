@@ -38,7 +38,10 @@ class clIndexerRequest
 public:
 	enum {
 		CLI_PARSE,
-		CLI_PARSE_AND_SAVE
+		CLI_PARSE_AND_SAVE,
+		// parse each file separately: the indexer sends back one clIndexerReply
+		// per file (in the request order) with the file name set
+		CLI_PARSE_BATCH
 	};
 
 public:
@@ -11,6 +11,72 @@
 #include <cstdio>
 #include <memory>
 
+// libctags keeps its state in global variables: an indexer process
+// runs a single worker thread. To parse files in parallel, codelite
+// starts several indexer processes
+static char* parse_file(const clIndexerRequest& req, const std::string& file)
+{
+	return ctags_make_tags(req.getCtagOptions().c_str(), file.c_str());
+}
+
+/**
+ * @brief handle CLI_PARSE_BATCH request: send back a reply per file
+ * @return false on protocol error
+ */
+static bool process_batch_request(clNamedPipe* conn, const clIndexerRequest& req)
+{
+	for (size_t i=0; i<req.getFiles().size(); i++) {
+		const std::string& file = req.getFiles().at(i);
+		char *tags = parse_file(req, file);
+
+		clIndexerReply reply;
+		reply.setFileName(file);
+		if (tags) {
+			reply.setCompletionCode(1);
+			reply.setTags(tags);
+			ctags_free(tags);
+		} else {
+			reply.setCompletionCode(0);
+		}
+
+		if ( !clIndexerProtocol::SendReply(conn, reply) ) {
+			fprintf(stderr, "ERROR: Protocol error: failed to send reply for file %s\n", file.c_str());
+			return false;
+		}
+	}
+	return true;
+}
+
+bool make_tags_for_request(const clIndexerRequest& req, std::string& tags)
+{
+	bool has_tags = false;
+	for (size_t i=0; i<req.getFiles().size(); i++) {
+
+#ifdef __DEBUG
+		printf("------------------------------------------------------------------\n");
+		printf("INFO: Source        : %s\n", req.getFiles().at(i).c_str());
+		printf("INFO: Command       : %d\n", (int)req.getCmd());
+		printf("INFO: CTAGS options : %s\n", req.getCtagOptions().c_str());
+		printf("INFO: Database      : %s\n", req.getDatabaseFileName().c_str());
+#endif
+
+		char *new_tags = parse_file(req, req.getFiles().at(i));
+		if (!new_tags) {
+			continue;
+		}
+
+		// append the new tags to the output buffer. std::string grows geometrically
+		// so the total cost is linear in the size of the output
+		if (has_tags) {
+			tags.append("\n");
+		}
+		tags.append(new_tags);
+		has_tags = true;
+		ctags_free(new_tags);
+	}
+	return has_tags;
+}
+
 WorkerThread::WorkerThread(eQueue<clNamedPipe*> *queue)
 		: m_queue(queue)
 {
@@ -37,40 +103,15 @@ void WorkerThread::start()
 				continue;
 			}
 
-			char *tags(NULL);
-			// create fies for the requested files
-			for (size_t i=0; i<req.getFiles().size(); i++) {
-
-#ifdef __DEBUG
-				printf("------------------------------------------------------------------\n");
-				printf("INFO: Source        : %s\n", req.getFiles().at(i).c_str());
-				printf("INFO: Command       : %d\n", req.getCmd());
-				printf("INFO: CTAGS options : %s\n", req.getCtagOptions().c_str());
-				printf("INFO: Database      : %s\n", req.getDatabaseFileName().c_str());
-#endif
-
-				char *new_tags = ctags_make_tags(req.getCtagOptions().c_str(), req.getFiles().at(i).c_str());
-				if (tags && new_tags) {
-					// re-allocate the buffer to containt the new tags + 2 chars: 1 for terminating null and one for the '\n'
-					// that will be appended
-					char *ptmp = (char*)malloc(strlen(tags) + strlen(new_tags) + 2);
-					memset(ptmp, 0, strlen(tags) + strlen(new_tags) + 2);
-					strcat(ptmp, tags);
-					strcat(ptmp, "\n");
-					strcat(ptmp, new_tags);
-
-					ctags_free(new_tags);
-					ctags_free(tags);
-
-					tags = ptmp;
-
-				} else if(new_tags) {
-					// first time
-					tags = new_tags;
-					new_tags = NULL;
-				}
+			if ( req.getCmd() == clIndexerRequest::CLI_PARSE_BATCH ) {
+				// on error, the client is dropped (its connection is closed by 'p')
+				process_batch_request(conn, req);
+				continue;
 			}
 
+			std::string tags;
+			bool has_tags = make_tags_for_request(req, tags);
+
 			// prepare the reply
 #ifdef __DEBUG
 			std::vector<std::string> lines = string_tokenize(tags, "\n");
@@ -80,25 +121,22 @@ void WorkerThread::start()
 #endif
 
 			clIndexerReply reply;
-			if (tags) {
+			if (has_tags) {
 				// prepare reply
 				reply.setCompletionCode(1);
-				reply.setTags(tags);
+				reply.setTags(std::move(tags));
 			} else {
 				reply.setCompletionCode(0);
 			}
 
-			ctags_free(tags);
-
-			// send the reply
+			// send the reply. On error, drop this client and serve the next one
 			if ( !clIndexerProtocol::SendReply(conn, reply) ) {
 				fprintf(stderr, "ERROR: Protocol error: failed to send reply for file %s\n", reply.getFileName().c_str());
-				break;
+				continue;
 			}
 		}
 	}
 	printf("INFO: WorkerThread: Going down\n");
-	exit(-1);
 }
 
 // ---------------------------------------------
@@ -2,8 +2,17 @@
 #define __workerthread__
 
 #include "network/named_pipe.h"
+#include "network/cl_indexer_request.h"
 #include "ethread.h"
 #include "equeue.h"
+#include <string>
+
+/**
+ * @brief run ctags on every file of the request and append the output to 'tags'
+ * (the output of each file is separated by a new line)
+ * @return true if ctags produced any output
+ */
+bool make_tags_for_request(const clIndexerRequest& req, std::string& tags);
 
 // ---------------------------------------------
 // parsing thread
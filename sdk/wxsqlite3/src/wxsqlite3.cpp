@@ -651,7 +651,13 @@ bool wxSQLite3ResultSet::NextRow()
     {
         return true;
     } else {
-        rc = sqlite3_finalize((sqlite3_stmt*)m_stmt);
+        // A statement owned by a wxSQLite3Statement must not be finalized here,
+        // its owner would finalize it again
+        if(m_ownStmt) {
+            rc = sqlite3_finalize((sqlite3_stmt*)m_stmt);
+        } else {
+            rc = sqlite3_reset((sqlite3_stmt*)m_stmt);
+        }
         m_stmt = 0;
         const char* localError = sqlite3_errmsg((sqlite3*)m_db);
         throw wxSQLite3Exception(rc, UTF8toWxString(localError));